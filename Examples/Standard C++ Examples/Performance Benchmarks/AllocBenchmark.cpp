@@ -0,0 +1,105 @@
+// ------------------------------------
+// Temporary Buffer Allocation Benchmark
+// ------------------------------------
+//
+// Per-frame temporary buffers -- a 1920x1080 RGB bitmap, a 1920x1080 float plane and a 640x480 RGB bitmap, allocated, touched
+// and freed each frame as MemT<> objects (128-byte aligned, as MemA<>) -- with each CMemAllocator (see CMemAllocator.h):
+//
+//      heap        -- CHeapAllocator (_aligned_malloc()/_aligned_free(), what MemA uses)
+//      pool        -- CPoolAllocator::GetBitmapPool() (freed blocks kept and reused by size class)
+//      scratch     -- the thread's CScratchArena, released once per frame with a CScratchScope
+//
+// Each test runs 1 to N threads (each with its own frames) for kRunMs; the result is total frames per second across all
+// threads (higher is better).  Touching one byte per page makes the cost of newly committed memory (page faults on every
+// frame, when the heap returns large blocks to the OS) part of the result.  The heap and pool counters are printed at the end
+// (scratch arenas are per thread, and went with the benchmark threads).
+
+#include "Benchmarks.h"
+#include "CMemAllocator.h"
+#include <thread>
+#include <atomic>
+#include <vector>
+
+using namespace Sage;
+
+namespace
+{
+    static constexpr int kRunMs = 300;
+
+    enum class Alloc { Heap, Pool, Scratch };
+
+    void Touch(unsigned char * pMem,long long llBytes)
+    {
+        for (long long i=0;i<llBytes;i += 4096) pMem[i] = (unsigned char) i;
+    }
+
+    template<class Allocator>
+    void RunFrame(Allocator & cAllocator)
+    {
+        MemT<unsigned char,Allocator,128> cFrame(1920*1080*3,cAllocator);
+        MemT<float,Allocator,128> fPlane(1920*1080,cAllocator);
+        MemT<unsigned char,Allocator,128> cSmall(640*480*3,cAllocator);
+
+        if (cFrame.pMem)    Touch(cFrame.pMem,cFrame.GetMemSize());
+        if (fPlane.pMem)    Touch((unsigned char *) fPlane.pMem,fPlane.GetMemSize());
+        if (cSmall.pMem)    Touch(cSmall.pMem,cSmall.GetMemSize());
+    }
+
+    double FramesPerSecond(Alloc eAlloc,int iThreads)
+    {
+        std::atomic<bool> bStop{false};
+        std::atomic<long long> llFrames{0};
+        std::vector<std::thread> vThreads;
+
+        CSageTimer cTimer;
+        for (int i=0;i<iThreads;i++) vThreads.emplace_back([&]
+        {
+            long long llCount = 0;
+            while (!bStop.load(std::memory_order_relaxed))
+            {
+                if (eAlloc == Alloc::Scratch)
+                {
+                    CScratchScope cScope;
+                    RunFrame(CScratchArena::GetThread());
+                }
+                else if (eAlloc == Alloc::Pool) RunFrame(CPoolAllocator::GetBitmapPool());
+                else RunFrame(CMemAllocator::GetHeap());
+                llCount++;
+            }
+            llFrames += llCount;
+        });
+
+        while (cTimer.ElapsedMs() < kRunMs) std::this_thread::yield();
+        bStop = true;
+        for (auto & cThread : vThreads) cThread.join();
+
+        return (double) llFrames*1000000.0/cTimer.ElapsedUsf();
+    }
+
+    void PrintCounters(const char * sName,CMemAllocator & cAllocator)
+    {
+        auto stCounters = cAllocator.GetCounters();
+        printf("    %-8s %12llu allocs %12llu frees    peak %8.1f MB\n",sName,stCounters.ullAllocs,stCounters.ullFrees,stCounters.ullPeakBytes/(1024.0*1024.0));
+    }
+}
+
+void AllocBenchmark()
+{
+    int iMaxThreads = (int) std::thread::hardware_concurrency();
+    if (iMaxThreads < 1) iMaxThreads = 1;
+
+    printf("Frames per second (3 temporary buffers per frame, %.1f MB):\n\n",(1920*1080*3 + 1920*1080*4 + 640*480*3)/(1024.0*1024.0));
+    printf("    %-8s %12s %12s %12s\n","threads","heap","pool","scratch");
+
+    for (int iThreads=1;iThreads <= iMaxThreads;iThreads *= 2)
+    {
+        printf("    %-8d %12.0f %12.0f %12.0f\n",iThreads,FramesPerSecond(Alloc::Heap,iThreads),FramesPerSecond(Alloc::Pool,iThreads),
+                                                  FramesPerSecond(Alloc::Scratch,iThreads));
+    }
+
+    printf("\nAllocator counters:\n\n");
+    PrintCounters("heap",CMemAllocator::GetHeap());
+    PrintCounters("pool",CPoolAllocator::GetBitmapPool());
+    auto & cPool = CPoolAllocator::GetBitmapPool();
+    printf("\nPool: %llu hits, %llu misses, %.1f MB cached\n",cPool.GetHits(),cPool.GetMisses(),cPool.GetCached()/(1024.0*1024.0));
+}
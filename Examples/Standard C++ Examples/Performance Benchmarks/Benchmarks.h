@@ -0,0 +1,36 @@
+// ---------------------------------------
+// Sagebox Performance Benchmarks -- Shared
+// ---------------------------------------
+//
+// Each benchmark lives in its own .cpp file and is listed in the benchmark table in main.cpp.
+// Benchmarks print their results to the console as plain text columns so they can be pasted or diffed between machines.
+
+#pragma once
+#include "Sagebox.h"
+#include <cstdio>
+
+// Run fFunction until at least iMinMs milliseconds have elapsed (and at least once), returning the average time per call in microseconds.
+//
+template<typename F>
+double TimeAvgUs(F && fFunction,int iMinMs = 250)
+{
+    Sage::CSageTimer cTimer;
+    int iCount = 0;
+    do { fFunction(); iCount++; } while (cTimer.ElapsedMs() < iMinMs);
+    return cTimer.ElapsedUsf()/(double) iCount;
+}
+
+void BlendBenchmark();
+void SimdBenchmark();
+void HitTestBenchmark();
+void ResizeBenchmark();
+void BlurBenchmark();
+void LockBenchmark();
+void AviWriteBenchmark();
+void OffscreenBenchmark();
+void Project3DBenchmark();
+void OptionsBenchmark();
+void ControlsBenchmark();
+void AllocBenchmark();
+void ParseBenchmark();
+void ExprBenchmark();
@@ -0,0 +1,51 @@
+// ------------------------------------
+// Blur Benchmark
+// ------------------------------------
+//
+// Time (in milliseconds) of the CSageBlur box-approximation Gaussian blur (GaussianBlurStd() with BlurMode::Box) against the
+// radius, for 1080p and 4K frames, with 1 thread up to all threads in the default thread pool.
+//
+// The time for each row should be about the same from a radius of 2 to 200, since each box pass is a running sum.
+
+#include "Benchmarks.h"
+#include "CSageBlur.h"
+
+using namespace Sage;
+
+void BlurBenchmark()
+{
+    static constexpr SIZE szSizes[] = { { 1920,1080 }, { 3840,2160 } };
+    static constexpr double fRadii[] = { 2, 8, 32, 100, 200 };
+
+    auto & cBlur    = CSageBlur::GetDefault();
+    int iMaxThreads = CThreadPool::GetDefault().GetThreads();
+
+    std::vector<int> vThreads;
+    for (int i=1;i<iMaxThreads;i *= 2) vThreads.push_back(i);
+    vThreads.push_back(iMaxThreads);
+
+    printf("Threads in pool: %d, %d passes\n\n",iMaxThreads,CSageBlur::kDefaultPasses);
+    printf("%-12s %8s","Size","Radius");
+    for (int iThreads : vThreads) printf(" %7d thr",iThreads);
+    printf("   (ms)\n");
+
+    for (auto & szSize : szSizes)
+    {
+        CBitmap cSource((int) szSize.cx,(int) szSize.cy), cDest;
+        for (int i=0;i<cSource.stBitmap.iTotalSize;i++) cSource.stBitmap.stMem[i] = (unsigned char) ((i*7) ^ (i >> 11));
+
+        char sName[32];
+        snprintf(sName,sizeof(sName),"%dx%d",(int) szSize.cx,(int) szSize.cy);
+
+        for (double fRadius : fRadii)
+        {
+            printf("%-12s %8.0f",sName,fRadius);
+            for (int iThreads : vThreads)
+            {
+                double fUs = TimeAvgUs([&]{ cBlur.Blur(cSource,cDest,fRadius,CSageBlur::kDefaultPasses,iThreads); });
+                printf(" %11.2f",fUs/1000.0);
+            }
+            printf("\n");
+        }
+    }
+}
@@ -0,0 +1,265 @@
+// ------------------------------------
+// Expression Evaluation Benchmark: Tree Walk vs. Bytecode VM
+// ------------------------------------
+//
+// A Mandelbrot inner loop, written as the stNODE expression trees the CToken parser produces:
+//
+//      zr = 0; zi = 0; n = 0;
+//      while (zr*zr + zi*zi < 4 && n < kMaxIter)
+//      {
+//          t  = zr*zr - zi*zi + cr;
+//          zi = (1 + 1)*zr*zi + ci;                // (1 + 1) is folded to 2 by the compiler
+//          zr = t;
+//          n  = n + 1;
+//          if (kDebug) n += 1000;                  // kDebug is 0, so the compiler drops the branch
+//      }
+//
+// and run over a 320x240 image:
+//
+//      tree walk               CExprTree::Evaluate() on each tree, with the loop and if() in C++ (as trees are run today)
+//      VM, per statement       The same C++ loop, with each statement compiled to its own CExprProgram
+//      VM, whole kernel        The loop and if() compiled too (CExprCompiler::While()/If()), one CExprVM::Run() per pixel
+//      native C++              The same loop compiled by the C++ compiler, for reference
+//
+// Results are in millions of loop iterations per second (higher is better); all checksums should match.
+
+#include "Benchmarks.h"
+#include "CExprVM.h"
+#include <deque>
+#include <memory>
+
+using namespace Sage;
+
+namespace
+{
+    constexpr int kWidth    = 320;
+    constexpr int kHeight   = 240;
+    constexpr int kMaxIter  = 256;
+
+    enum { vZr, vZi, vCr, vCi, vN, vT, vCount };
+
+    // Builds stNODE trees by hand (the parser's CTree would normally produce them)
+
+    class CTreeBuilder
+    {
+        std::deque<stNODE> m_dNodes;
+        std::deque<stNODEDATA> m_dNodeData;
+        std::deque<stVARSTRUCT> m_dVars;
+        stVARSTRUCT * m_stVars[vCount]{};
+
+    public:
+        CTreeBuilder()
+        {
+            for (int i=0;i<vCount;i++)
+            {
+                m_dVars.emplace_back();
+                m_stVars[i] = &m_dVars.back();
+                m_stVars[i]->iAddress = i;       // The index in the benchmark's fVars[] (see VarValue())
+            }
+        }
+
+        stNODE * Node(eNODETYPE eNodeType,stNODE * tLeft = nullptr,stNODE * tRight = nullptr)
+        {
+            m_dNodeData.emplace_back();
+            m_dNodes.emplace_back();
+            auto stNode = &m_dNodes.back();
+            stNode->stNodeData = &m_dNodeData.back();
+            stNode->stNodeData->eNodeType = eNodeType;
+            stNode->tLeft   = tLeft;
+            stNode->tRight  = tRight;
+            if (tLeft) tLeft->tParent = stNode;
+            if (tRight) tRight->tParent = stNode;
+            return stNode;
+        }
+
+        stNODE * Var(int iVar)
+        {
+            auto stNode = Node(nVar);
+            stNode->stNodeData->suTokenData.stVar = m_stVars[iVar];
+            return stNode;
+        }
+
+        stNODE * Int(int iValue)
+        {
+            auto stNode = Node(nNum);
+            stNode->stNodeData->suTokenData.stNumber.stNumber.LSW = (unsigned long) iValue;
+            return stNode;
+        }
+
+        stNODE * Float(float fValue)
+        {
+            auto stNode = Node(nFloat);
+            stNode->stNodeData->suTokenData.stNumber.stNumber.fFloat = fValue;
+            return stNode;
+        }
+
+        stNODE * Assign(int iVar,stNODE * stValue) { return Node(nAssign,Var(iVar),stValue); }
+    };
+
+    struct Kernel_t
+    {
+        CTreeBuilder cTrees;
+        stNODE * stInit[3];
+        stNODE * stCondition;
+        stNODE * stBody[4];
+        stNODE * stDebug;
+        stNODE * stDebugBody;
+
+        Kernel_t()
+        {
+            auto & t = cTrees;
+            stInit[0]   = t.Assign(vZr,t.Float(0));
+            stInit[1]   = t.Assign(vZi,t.Float(0));
+            stInit[2]   = t.Assign(vN,t.Int(0));
+
+            stCondition = t.Node(nlogAnd,t.Node(nLessThan,t.Node(nFadd,t.Node(nFmul,t.Var(vZr),t.Var(vZr)),t.Node(nFmul,t.Var(vZi),t.Var(vZi))),t.Float(4)),
+                                         t.Node(nLessThan,t.Var(vN),t.Int(kMaxIter)));
+
+            stBody[0]   = t.Assign(vT,t.Node(nFadd,t.Node(nFsub,t.Node(nFmul,t.Var(vZr),t.Var(vZr)),t.Node(nFmul,t.Var(vZi),t.Var(vZi))),t.Var(vCr)));
+            stBody[1]   = t.Assign(vZi,t.Node(nFadd,t.Node(nFmul,t.Node(nFmul,t.Node(nAdd,t.Int(1),t.Int(1)),t.Var(vZr)),t.Var(vZi)),t.Var(vCi)));
+            stBody[2]   = t.Assign(vZr,t.Var(vT));
+            stBody[3]   = t.Assign(vN,t.Node(nAdd,t.Var(vN),t.Int(1)));
+
+            stDebug     = t.Int(0);
+            stDebugBody = t.Node(nPlusEqual,t.Var(vN),t.Int(1000));
+        }
+    };
+
+    // The benchmark keeps variable i in fVars[i], and gave each stVARSTRUCT its index as iAddress
+
+    double & VarValue(double * fVars,const stVARSTRUCT * stVar) { return fVars[stVar->iAddress]; }
+
+    double PixelCr(int x) { return -2.2 + 3.2*x/kWidth; }
+    double PixelCi(int y) { return -1.2 + 2.4*y/kHeight; }
+
+    // Runs fnPixel(fVars) for each pixel, returning the total iterations (the checksum)
+
+    template<typename F>
+    long long Image(double * fVars,F && fnPixel)
+    {
+        for (int i=0;i<vCount;i++) fVars[i] = 0;
+        long long llIterations = 0;
+
+        for (int y=0;y<kHeight;y++)
+            for (int x=0;x<kWidth;x++)
+            {
+                fVars[vCr] = PixelCr(x);
+                fVars[vCi] = PixelCi(y);
+                fnPixel(fVars);
+                llIterations += (long long) fVars[vN];
+            }
+        return llIterations;
+    }
+
+    // Times fnTest (which returns the checksum from Image()), and prints the rate
+
+    template<typename F>
+    void RunTest(const char * sTest,F && fnTest)
+    {
+        long long llIterations = 0;
+        double fUs = TimeAvgUs([&] { llIterations = fnTest(); });
+        printf("    %-28s %10.1f M iterations/s    (checksum %lld)\n",sTest,llIterations/fUs,llIterations);
+    }
+}
+
+void ExprBenchmark()
+{
+    Kernel_t stKernel;
+
+    // Each statement as its own program, for the C++ loop
+
+    CExprProgram cStatement[9];
+    stNODE * stStatements[9] = { stKernel.stInit[0],stKernel.stInit[1],stKernel.stInit[2],stKernel.stCondition,
+                                 stKernel.stBody[0],stKernel.stBody[1],stKernel.stBody[2],stKernel.stBody[3],stKernel.stDebug };
+    for (int i=0;i<9;i++)
+    {
+        CExprCompiler cCompiler;
+        if (!cCompiler.AddStatement(stStatements[i]) || !cCompiler.Compile(cStatement[i]))
+        {
+            printf("Error compiling statement %d: %s\n",i,cCompiler.GetError());
+            return;
+        }
+    }
+
+    // The whole kernel as one program
+
+    CExprCompiler cCompiler;
+    for (auto stInit : stKernel.stInit) cCompiler.AddStatement(stInit);
+    cCompiler.While(stKernel.stCondition);
+    for (auto stBody : stKernel.stBody) cCompiler.AddStatement(stBody);
+    cCompiler.If(stKernel.stDebug);
+    cCompiler.AddStatement(stKernel.stDebugBody);
+    cCompiler.EndIf();
+    cCompiler.EndWhile();
+
+    CExprProgram cKernel;
+    if (!cCompiler.Compile(cKernel))
+    {
+        printf("Error compiling kernel: %s\n",cCompiler.GetError());
+        return;
+    }
+
+    printf("Mandelbrot %dx%d, up to %d iterations per pixel\n",kWidth,kHeight,kMaxIter);
+    printf("Kernel bytecode: %d instructions, %d registers, %d constants (%d folded, %d dead branches dropped)\n\n",
+            (int) cKernel.vCode.size(),cKernel.iRegisters,(int) cKernel.vConstants.size(),cCompiler.GetFolded(),cCompiler.GetDeadBranches());
+
+    // Variable values, which the tree walk reads through fnVar and the VMs are bound to
+
+    double fVars[vCount] = {};
+    auto fnVar = [&](const stVARSTRUCT * stVar) -> double & { return VarValue(fVars,stVar); };
+    auto fnBind = [&](const stVARSTRUCT * stVar) { return &VarValue(fVars,stVar); };
+
+    RunTest("tree walk",[&]
+    {
+        return Image(fVars,[&](double *)
+        {
+            for (auto stInit : stKernel.stInit) CExprTree::Evaluate(stInit,fnVar);
+            while (CExprTree::Evaluate(stKernel.stCondition,fnVar) != 0.0)
+            {
+                for (auto stBody : stKernel.stBody) CExprTree::Evaluate(stBody,fnVar);
+                if (CExprTree::Evaluate(stKernel.stDebug,fnVar) != 0.0) CExprTree::Evaluate(stKernel.stDebugBody,fnVar);
+            }
+        });
+    });
+
+    std::unique_ptr<CExprVM> cVM[9];
+    for (int i=0;i<9;i++)
+    {
+        cVM[i] = std::make_unique<CExprVM>(cStatement[i]);
+        cVM[i]->BindAll(fnBind);
+    }
+
+    RunTest("VM, per statement",[&]
+    {
+        return Image(fVars,[&](double *)
+        {
+            for (int i=0;i<3;i++) cVM[i]->Run();
+            while (cVM[3]->Run() != 0.0)
+            {
+                for (int i=4;i<8;i++) cVM[i]->Run();
+                if (cVM[8]->Run() != 0.0) CExprTree::Evaluate(stKernel.stDebugBody,fnVar);
+            }
+        });
+    });
+
+    CExprVM cKernelVM(cKernel);
+    cKernelVM.BindAll(fnBind);
+    RunTest("VM, whole kernel",[&] { return Image(fVars,[&](double *) { cKernelVM.Run(); }); });
+
+    RunTest("native C++",[&]
+    {
+        return Image(fVars,[&](double * fVars)
+        {
+            double zr = 0,zi = 0,cr = fVars[vCr],ci = fVars[vCi];
+            int n = 0;
+            while (zr*zr + zi*zi < 4 && n < kMaxIter)
+            {
+                double t = zr*zr - zi*zi + cr;
+                zi = 2*zr*zi + ci;
+                zr = t;
+                n++;
+            }
+            fVars[vN] = n;
+        });
+    });
+}
@@ -0,0 +1,142 @@
+// ------------------------------------
+// Mouse Region Hit-Test Benchmark
+// ------------------------------------
+//
+// Measures the time to find the topmost point/region under the mouse against the number of points, for:
+//
+//      walk    -- the display-list walk MouseRegion::UpdatePoints() uses by default (top to bottom, first hit wins)
+//      index   -- the CRegionIndex grid used when MouseRegion::EnableHitIndex() is on
+//
+// Points are 8x8 to 24x24 squares scattered over a 1920x1080 area (i.e. a schematic with many connection points), with
+// the display order shuffled by bringing random points to the top, as clicking on points does.
+//
+// The display list is a copy of MouseRegion's (same linked-list walk and hit rectangle), since MouseRegion itself
+// needs a window.  Every hit from the index is checked against the walk.
+
+#include "Benchmarks.h"
+#include "CRegionIndex.h"
+#include <vector>
+#include <random>
+
+using namespace Sage;
+
+namespace
+{
+    struct TestRegion_t
+    {
+        float fx, fy, fWidth, fHeight;
+        int iIndex;
+        TestRegion_t * pDisplayPrev;
+        TestRegion_t * pDisplayNext;
+    };
+
+    struct TestRegions_t
+    {
+        std::vector<TestRegion_t> vRegions;
+        TestRegion_t * pDisplayTop = nullptr;
+
+        void Add(float fx,float fy,float fWidth,float fHeight)
+        {
+            vRegions.push_back({ fx,fy,fWidth,fHeight,(int) vRegions.size(),nullptr,nullptr });
+        }
+
+        // Link in add order (last added is on top), after vRegions has stopped growing
+
+        void Link()
+        {
+            pDisplayTop = nullptr;
+            for (auto & r : vRegions)
+            {
+                r.pDisplayPrev = nullptr;
+                r.pDisplayNext = pDisplayTop;
+                if (pDisplayTop) pDisplayTop->pDisplayPrev = &r;
+                pDisplayTop = &r;
+            }
+        }
+
+        void BringtoTop(TestRegion_t & r)
+        {
+            if (pDisplayTop == &r) return;
+            if (r.pDisplayPrev) r.pDisplayPrev->pDisplayNext = r.pDisplayNext;
+            if (r.pDisplayNext) r.pDisplayNext->pDisplayPrev = r.pDisplayPrev;
+            r.pDisplayPrev = nullptr;
+            r.pDisplayNext = pDisplayTop;
+            pDisplayTop->pDisplayPrev = &r;
+            pDisplayTop = &r;
+        }
+
+        // Same walk and hit rectangle as MouseRegion::UpdatePoints()
+
+        int Walk(POINT pMouse) const
+        {
+            for (auto * pr = pDisplayTop;pr;pr = pr->pDisplayNext)
+            {
+                int iX = (int) pr->fx, iY = (int) pr->fy, iWidth = (int) pr->fWidth, iHeight = (int) pr->fHeight;
+                if (pMouse.x >= iX && pMouse.x < iX + iWidth && pMouse.y >= iY && pMouse.y < iY + iHeight) return pr->iIndex;
+            }
+            return -1;
+        }
+    };
+}
+
+void HitTestBenchmark()
+{
+    static constexpr int iCounts[] = { 100, 1000, 10000, 50000, 100000 };
+    static constexpr int kMousePoints = 4096;
+
+    printf("%-9s %12s %12s %9s %14s %14s\n","Regions","Walk(ns)","Index(ns)","Speedup","Move(ns/pt)","Raise(ns/pt)");
+
+    for (int iCount : iCounts)
+    {
+        std::mt19937 cRand(1234);
+        std::uniform_real_distribution<float> cX(0,1920),cY(0,1080),cSize(8,24);
+
+        TestRegions_t stRegions;
+        CRegionIndex cIndex(32);                // About twice the typical point size
+
+        stRegions.vRegions.reserve(iCount);
+        for (int i=0;i<iCount;i++) { float fSize = cSize(cRand); stRegions.Add(cX(cRand),cY(cRand),fSize,fSize); }
+        stRegions.Link();
+
+        for (auto & r : stRegions.vRegions) cIndex.Update(r.iIndex,(int) r.fx,(int) r.fy,(int) r.fWidth,(int) r.fHeight);
+
+        // Shuffle the display order, the same way in both
+
+        for (int i=0;i<iCount/4;i++)
+        {
+            int iIndex = (int) (cRand() % iCount);
+            stRegions.BringtoTop(stRegions.vRegions[iIndex]);
+            cIndex.Raise(iIndex);
+        }
+
+        std::vector<POINT> vMouse(kMousePoints);
+        for (auto & p : vMouse) p = { (int) cX(cRand), (int) cY(cRand) };
+
+        int iErrors = 0;
+        for (auto & p : vMouse) if (stRegions.Walk(p) != cIndex.HitTest(p.x,p.y)) iErrors++;
+        if (iErrors) printf("** Error: %d of %d index hits do not match the display-list walk\n",iErrors,kMousePoints);
+
+        volatile int iSink = 0;
+        double fWalk    = TimeAvgUs([&]{ for (auto & p : vMouse) iSink += stRegions.Walk(p); },100)*1000.0/kMousePoints;
+        double fIndex   = TimeAvgUs([&]{ for (auto & p : vMouse) iSink += cIndex.HitTest(p.x,p.y); },100)*1000.0/kMousePoints;
+
+        // Index maintenance: dragging points by a few pixels, and bringing points to the top
+
+        int iMoves = iCount < kMousePoints ? iCount : kMousePoints;
+        int iStep = 0;
+        double fMove = TimeAvgUs([&]
+        {
+            int iDelta = (iStep++ & 1) ? -3 : 3;
+            for (int i=0;i<iMoves;i++)
+            {
+                auto & r = stRegions.vRegions[i];
+                r.fx += (float) iDelta;
+                cIndex.Update(i,(int) r.fx,(int) r.fy,(int) r.fWidth,(int) r.fHeight);
+            }
+        },100)*1000.0/iMoves;
+
+        double fRaise = TimeAvgUs([&]{ for (int i=0;i<iMoves;i++) cIndex.Raise(i); },100)*1000.0/iMoves;
+
+        printf("%-9d %12.1f %12.1f %8.1fx %14.1f %14.1f\n",iCount,fWalk,fIndex,fWalk/fIndex,fMove,fRaise);
+    }
+}
@@ -0,0 +1,125 @@
+// ------------------------------------
+// Lock Contention Benchmark
+// ------------------------------------
+//
+// 1 to 64 threads hammering one lock through Lock(std::function) with a short critical section (a few counter updates,
+// like CDataStore's), for:
+//
+//      spin    -- CLockProcess's loop (compare-exchange in a loop, no pause, backoff or yield)
+//      adapt   -- CAdaptiveLock (spin-then-park)
+//      mutex   -- std::mutex, for reference
+//
+// Each test runs for kRunMs; the result is total lock acquisitions per second across all threads (higher is better).  With
+// more threads than cores, the spin-only lock wastes whole time slices spinning behind a thread that has been switched out.
+// The adaptive lock's contention counters (EnableStats()) are printed for the 64-thread case.
+
+#include "Benchmarks.h"
+#include "CAdaptiveLock.h"
+#include <thread>
+#include <atomic>
+#include <mutex>
+#include <vector>
+
+using namespace Sage;
+
+namespace
+{
+    static constexpr int kRunMs = 300;
+
+    // CLockProcess::FastLock()/Unlock() loop (CLockProcess.h uses MSVC intrinsics, so it is reproduced here)
+
+    class SpinOnlyLock
+    {
+        std::atomic<long> m_lLock{0};
+    public:
+        bool FastLock()
+        {
+            long lExpected;
+            do lExpected = 0; while (!m_lLock.compare_exchange_strong(lExpected,1,std::memory_order_acquire));
+            return true;
+        }
+        void Unlock() { m_lLock.store(0,std::memory_order_release); }
+
+        int Lock(std::function<int()> const & Execute)
+        {
+            int iValue = 0;
+            if (FastLock()) iValue = Execute();
+            Unlock();
+            return iValue;
+        }
+    };
+
+    class MutexLock
+    {
+        std::mutex m_mLock;
+    public:
+        int Lock(std::function<int()> const & Execute)
+        {
+            std::lock_guard<std::mutex> lock(m_mLock);
+            return Execute();
+        }
+    };
+
+    struct Shared_t
+    {
+        long long iCounter = 0;
+        int iValues[16] = {};
+    };
+
+    // Returns acquisitions per second (millions)
+
+    template<typename Lock_t>
+    double RunContention(Lock_t & cLock,int iThreads)
+    {
+        Shared_t stShared;
+        std::atomic<bool> bStart{false}, bStop{false};
+        std::vector<long long> vCount(iThreads,0);
+        std::vector<std::thread> vThreads;
+
+        for (int i=0;i<iThreads;i++) vThreads.emplace_back([&,i]
+        {
+            std::function<int()> fnWork = [&] { stShared.iValues[stShared.iCounter & 15]++; return (int) ++stShared.iCounter; };
+            while (!bStart.load()) std::this_thread::yield();
+
+            long long iCount = 0;
+            while (!bStop.load(std::memory_order_relaxed)) { cLock.Lock(fnWork); iCount++; }
+            vCount[i] = iCount;
+        });
+
+        CSageTimer cTimer;
+        bStart = true;
+        std::this_thread::sleep_for(std::chrono::milliseconds(kRunMs));
+        bStop = true;
+        for (auto & cThread : vThreads) cThread.join();
+        double fUs = cTimer.ElapsedUsf();
+
+        long long iTotal = 0;
+        for (auto iCount : vCount) iTotal += iCount;
+        if (iTotal != stShared.iCounter) printf("** Error: %lld acquisitions, counter = %lld\n",iTotal,stShared.iCounter);
+        return (double) iTotal/fUs;
+    }
+}
+
+void LockBenchmark()
+{
+    static constexpr int iThreadCounts[] = { 1, 2, 4, 8, 16, 32, 64 };
+
+    printf("Cores: %d, %d ms per test\n\n",(int) std::thread::hardware_concurrency(),kRunMs);
+    printf("%-8s %12s %12s %12s   (M acquisitions/s)\n","Threads","spin","adapt","mutex");
+
+    for (int iThreads : iThreadCounts)
+    {
+        SpinOnlyLock cSpin;
+        CAdaptiveLock cAdaptive;
+        MutexLock cMutex;
+
+        if (iThreads == 64) cAdaptive.EnableStats();
+
+        double fSpin    = RunContention(cSpin,iThreads);
+        double fAdapt   = RunContention(cAdaptive,iThreads);
+        double fMutex   = RunContention(cMutex,iThreads);
+
+        printf("%-8d %12.2f %12.2f %12.2f\n",iThreads,fSpin,fAdapt,fMutex);
+        if (iThreads == 64) { printf("\n"); cAdaptive.PrintStats("adapt, 64 threads"); }
+    }
+}
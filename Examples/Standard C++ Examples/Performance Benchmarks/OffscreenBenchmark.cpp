@@ -0,0 +1,90 @@
+// ------------------------------------
+// Offscreen Drawing Benchmark
+// ------------------------------------
+//
+// Drawing throughput of the headless COffscreenWindow renderer on a 1920x1080 canvas: primitives per second for each of the
+// CWindow-style drawing functions, and full report-style frames per second.
+//
+// The hash printed for the test scene is the same on every machine and build, so it can be compared between runs to check
+// that drawing output hasn't changed.
+
+#include "Benchmarks.h"
+#include "COffscreenWindow.h"
+#include "CRawBitmap.h"
+#include <functional>
+#include <cmath>
+
+using namespace Sage;
+
+// A report-style frame: gradient background, bar chart, polygon, curves, circles and text
+
+static void DrawScene(COffscreenWindow & cWin)
+{
+    struct Point_t { int x, y; };
+
+    cWin.Cls({ 20,30,70 },{ 0,0,0 });
+    for (int i=0;i<24;i++) cWin.FillRectangle(100 + i*60,900 - i*30,40,i*30 + 20,{ 40 + i*8,200 - i*5,120 });
+    cWin.DrawRectangle(80,100,1500,840,{ 255,255,255 },2);
+
+    Point_t pStar[10];
+    for (int i=0;i<10;i++)
+    {
+        double fAngle = i*3.14159265358979/5, fRadius = (i & 1) ? 80 : 200;
+        pStar[i] = { 1700 + (int) (fRadius*sin(fAngle)),300 - (int) (fRadius*cos(fAngle)) };
+    }
+    cWin.FillPolygonFast(pStar,10,{ 255,200,0 },{ 255,255,255 },3);
+
+    for (int i=0;i<8;i++) cWin.DrawBezier(Point_t{ 100,600 + i*20 },Point_t{ 500,100 },Point_t{ 1000,1000 },Point_t{ 1500,400 + i*20 },{ 0,255,255 },1 + i % 3);
+    for (int i=0;i<12;i++) cWin.FillCircle(1700,800,120 - i*10,{ i*20,255 - i*20,128 });
+    cWin.DrawCircle(1700,800,130,{ 255,255,255 },4);
+
+    cWin.Write(100,40,"Quarterly Report -- Region 7",{ 255,255,255 },3);
+    for (int i=0;i<24;i++)
+    {
+        char sLabel[16];
+        snprintf(sLabel,sizeof(sLabel),"Q%d",i + 1);
+        cWin.Write(100 + i*60,930,sLabel,{ 200,200,200 });
+    }
+}
+
+void OffscreenBenchmark()
+{
+    struct Point_t { int x, y; };
+
+    COffscreenWindow cWin(1920,1080);
+
+    DrawScene(cWin);
+    printf("Test scene hash: %016llx\n\n",(unsigned long long) cWin.GetHash());
+
+    CBitmap cSprite(256,256);
+    for (int i=0;i<cSprite.stBitmap.iTotalSize;i++) cSprite.stBitmap.stMem[i] = (unsigned char) (i*13);
+
+    Point_t pPoly[] = { { 100,100 }, { 400,80 }, { 500,300 }, { 300,450 }, { 80,350 } };
+    Point_t pLines[64];
+    for (int i=0;i<64;i++) pLines[i] = { 100 + i*25,500 + ((i*37) % 200) };
+
+    struct Test_t { const char * sName; std::function<void()> fnDraw; };
+    Test_t stTests[] =
+    {
+        { "Cls (gradient)",             [&] { cWin.Cls({ 0,0,64 },{ 0,0,0 }); } },
+        { "FillRectangle 200x200",      [&] { cWin.FillRectangle(500,300,200,200,{ 255,0,0 }); } },
+        { "DrawLine 1000px",            [&] { cWin.DrawLine(100,100,1100,700,{ 0,255,0 }); } },
+        { "DrawLine 1000px, pen 5",     [&] { cWin.DrawLine(100,100,1100,700,{ 0,255,0 },5); } },
+        { "DrawLines 64 points",        [&] { cWin.DrawLines(pLines,64,{ 255,255,0 }); } },
+        { "FillPolygonFast 5 vertices", [&] { cWin.FillPolygonFast(pPoly,5,{ 0,0,255 }); } },
+        { "FillCircle r=100",           [&] { cWin.FillCircle(960,540,100,{ 255,0,255 }); } },
+        { "DrawBezier, pen 1",          [&] { cWin.DrawBezier(Point_t{ 100,800 },Point_t{ 600,100 },Point_t{ 1200,1000 },Point_t{ 1800,300 },{ 0,255,255 }); } },
+        { "DrawBezier, pen 4",          [&] { cWin.DrawBezier(Point_t{ 100,800 },Point_t{ 600,100 },Point_t{ 1200,1000 },Point_t{ 1800,300 },{ 0,255,255 },4); } },
+        { "Write 40 chars",             [&] { cWin.Write(100,100,"The quick brown fox jumps over the lazy",{ 255,255,255 }); } },
+        { "Write 40 chars, scale 3",    [&] { cWin.Write(100,100,"The quick brown fox jumps over the lazy",{ 255,255,255 },3); } },
+        { "DisplayBitmap 256x256",      [&] { cWin.DisplayBitmap(800,400,cSprite.stBitmap); } },
+        { "Full report frame",          [&] { DrawScene(cWin); } },
+    };
+
+    printf("%-30s %12s %14s\n","Function","us/call","calls/sec");
+    for (auto & stTest : stTests)
+    {
+        double fUs = TimeAvgUs(stTest.fnDraw);
+        printf("%-30s %12.2f %14.0f\n",stTest.sName,fUs,1000000.0/fUs);
+    }
+}
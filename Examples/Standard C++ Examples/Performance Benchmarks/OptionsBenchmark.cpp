@@ -0,0 +1,139 @@
+// ------------------------------------
+// Control Options Benchmark
+// ------------------------------------
+//
+// The cost of the options passed to each control when creating many identical controls, before and after building the options
+// once (see COptCache.h):
+//
+//      options     -- (console) building and parsing the option set for 10,000 controls:
+//
+//                      kw per call         kw:: chain built for each control, then FillKeyValues() (what the control does)
+//                      kw compiled         CCompiledKeys built once: FillKeyValues() on the copy, and GetKeyValues()
+//                      opt per call        opt:: string built for each control
+//                      opt interned        COptCache::Intern() of the string, and the interned object reused directly
+//
+//      controls    -- (opens a hidden window, so it is only run by name) creation rate of 2,000 sliders and 2,000 buttons,
+//                     with keywords built per control vs. CCompiledKeys.
+//
+// Results are in thousands of controls per second (higher is better).
+
+#include "Benchmarks.h"
+#include "COptCache.h"
+
+using namespace Sage;
+
+namespace
+{
+    constexpr int kOptionControls   = 10000;
+    constexpr int kCreateControls   = 2000;
+
+    const CCompiledKeys<> & CompiledSliderKeys()
+    {
+        static const CCompiledKeys<> cKeys(kw::Range(0,100) | kw::Default(50) | kw::fgColor("Yellow") | kw::ShowValue());
+        return cKeys;
+    }
+
+    const CCompiledKeys<> & CompiledButtonKeys()
+    {
+        static const CCompiledKeys<> cKeys(kw::fgColor("White") | kw::bgColor("Blue") | kw::Font("Arial,14"));
+        return cKeys;
+    }
+
+    cwfOpt & SliderOpt() { return opt::Range(0,100) | opt::Default(50) | opt::fgColor("Yellow") | opt::ShowValue(); }
+
+    void PrintRate(const char * sTest,int iControls,double fUs)
+    {
+        printf("    %-44s %10.1f K/s\n",sTest,iControls*1000.0/fUs);
+    }
+}
+
+void OptionsBenchmark()
+{
+    volatile size_t uSink = 0;
+
+    printf("Option sets for %d identical sliders:\n\n",kOptionControls);
+
+    PrintRate("kw per call (build + FillKeyValues)",kOptionControls,TimeAvgUs([&]
+    {
+        for (int i=0;i<kOptionControls;i++) { auto stKeys = (kw::Range(0,100) | kw::Default(50) | kw::fgColor("Yellow") | kw::ShowValue()).FillKeyValues(); uSink = uSink + sizeof(stKeys); }
+    }));
+
+    auto & cCompiled = CompiledSliderKeys();
+    PrintRate("kw compiled (FillKeyValues on the copy)",kOptionControls,TimeAvgUs([&]
+    {
+        for (int i=0;i<kOptionControls;i++) { auto stKeys = cCompiled.GetKeys().FillKeyValues(); uSink = uSink + sizeof(stKeys); }
+    }));
+
+    PrintRate("kw compiled (GetKeyValues)",kOptionControls,TimeAvgUs([&]
+    {
+        for (int i=0;i<kOptionControls;i++) uSink = uSink + (size_t) &cCompiled.GetKeyValues();
+    }));
+
+    printf("\n");
+
+    PrintRate("opt per call (build)",kOptionControls,TimeAvgUs([&]
+    {
+        for (int i=0;i<kOptionControls;i++) uSink = uSink + (size_t) *SliderOpt();
+    }));
+
+    auto & cCache = COptCache::GetDefault();
+    PrintRate("opt per call (build + Intern)",kOptionControls,TimeAvgUs([&]
+    {
+        for (int i=0;i<kOptionControls;i++) uSink = uSink + cCache.Intern(SliderOpt()).GetHash();
+    }));
+
+    auto & cInterned = cCache.Intern(SliderOpt());
+    PrintRate("opt interned (Intern(string))",kOptionControls,TimeAvgUs([&]
+    {
+        for (int i=0;i<kOptionControls;i++) uSink = uSink + cCache.Intern(cInterned.GetString()).GetHash();
+    }));
+
+    PrintRate("opt interned (reused)",kOptionControls,TimeAvgUs([&]
+    {
+        for (int i=0;i<kOptionControls;i++) uSink = uSink + (size_t) (const cwfOpt *) &cInterned.GetOpt();
+    }));
+
+    printf("\nInterned option sets: %d (%llu hits, %llu misses)\n",cCache.GetCount(),cCache.GetHits(),cCache.GetMisses());
+}
+
+void ControlsBenchmark()
+{
+    struct Test_t { const char * sName; bool bSliders; bool bCompiled; };
+    static const Test_t stTests[] =
+    {
+        { "NewSlider, kw per call",     true,   false },
+        { "NewSlider, CCompiledKeys",   true,   true },
+        { "NewButton, kw per call",     false,  false },
+        { "NewButton, CCompiledKeys",   false,  true },
+    };
+
+    printf("Creating %d controls per test on a hidden window:\n\n",kCreateControls);
+
+    for (auto & stTest : stTests)
+    {
+        // A new window for each test, so every test starts with the same number of controls
+
+        auto & cWin = Sagebox::NewWindow(0,0,1600,1000,"Control Creation Benchmark",kw::Hidden());
+        CSageTimer cTimer;
+
+        for (int i=0;i<kCreateControls;i++)
+        {
+            int iX = (i % 8)*200;
+            int iY = (i/8 % 25)*40;
+
+            if (stTest.bSliders)
+            {
+                if (stTest.bCompiled) cWin.NewSlider(iX,iY,180,"Level",CompiledSliderKeys());
+                else cWin.NewSlider(iX,iY,180,"Level",kw::Range(0,100) | kw::Default(50) | kw::fgColor("Yellow") | kw::ShowValue());
+            }
+            else
+            {
+                if (stTest.bCompiled) cWin.NewButton(iX,iY,"Button",CompiledButtonKeys());
+                else cWin.NewButton(iX,iY,"Button",kw::fgColor("White") | kw::bgColor("Blue") | kw::Font("Arial,14"));
+            }
+        }
+
+        PrintRate(stTest.sName,kCreateControls,cTimer.ElapsedUsf());
+        cWin.Delete();
+    }
+}
@@ -0,0 +1,195 @@
+// ------------------------------------
+// Script Tokenizer/Parser Front End Benchmark
+// ------------------------------------
+//
+// Throughput of the CToken front end's two per-token costs over a synthetic script (Pascal-style declarations, loops and
+// expressions, about 4MB):
+//
+//      keyword/operator lookup     linear search of stTokenAlphaLookup/stTokenOperatorLookup (as CToken does), vs. the
+//                                  compile-time perfect hashes in CTokenLookup.h
+//
+//      node allocation             one stNODE and stNODEDATA per token, allocated with calloc() and freed one at a time
+//                                  (as CTree::CreateNode() does), vs. a CNodeArena freed all at once with Reset()
+//
+// The scanner is the same for all tests (identifiers, numbers, operators), so the differences are the lookups and
+// allocations.  Results are in MB of source per second (higher is better).
+
+#include "Benchmarks.h"
+#include "CTokenLookup.h"
+#include <string>
+#include <cctype>
+
+using namespace Sage;
+
+namespace
+{
+    constexpr int kSourceLines = 100000;
+
+    std::string MakeSource()
+    {
+        static const char * sLines[] =
+        {
+            "var iCount%d, iTotal%d : integer;\n",
+            "procedure Update%d(x : integer; y : long);\n",
+            "begin\n",
+            "    for i := 0 to %d do begin iTotal := iTotal + (i*3) - iCount mod 7; end;\n",
+            "    if iTotal <= %d then iCount := iCount div 2 else iCount := iCount + 1;\n",
+            "    repeat x := x - 1; until x <> %d;\n",
+            "    if (a >= b) andif (c != %d) orif not d then return x & y;\n",
+            "end;\n",
+        };
+
+        std::string sSource;
+        char sLine[200];
+        for (int i=0;i<kSourceLines;i++)
+        {
+            snprintf(sLine,sizeof(sLine),sLines[i % (sizeof(sLines)/sizeof(sLines[0]))],i,i);
+            sSource += sLine;
+        }
+        return sSource;
+    }
+
+    // Linear lookups, as in CToken: the token is upper-cased, then compared with each entry
+
+    TokenType LinearAlpha(const char * sToken,int iLength)
+    {
+        char sUpper[MAX_TOKEN_STRING_SIZE];
+        if (iLength >= MAX_TOKEN_STRING_SIZE) return tNULL;
+        for (int i=0;i<iLength;i++) sUpper[i] = (char) toupper((unsigned char) sToken[i]);
+        sUpper[iLength] = 0;
+
+        for (auto pEntry = stTokenAlphaLookup;pEntry->sToken;pEntry++)
+        {
+            if (!strcmp(pEntry->sToken + 1,sUpper)) return pEntry->eToken;
+        }
+        return tNULL;
+    }
+
+    TokenType LinearOperator(const char * sSource,int & iLength)
+    {
+        for (iLength = 2;iLength > 0;iLength--)
+        {
+            for (auto & stEntry : stTokenOperatorLookup)
+            {
+                if ((int) strlen(stEntry.sToken) == iLength && !strncmp(stEntry.sToken,sSource,iLength)) return stEntry.eToken;
+            }
+        }
+        iLength = 0;
+        return tNULL;
+    }
+
+    // Scans the source, calling fnToken(eToken) for each token.  Returns a checksum of the tokens.
+
+    template<bool bHashed,typename F>
+    unsigned int Scan(const std::string & sSource,F && fnToken)
+    {
+        unsigned int uSum = 0;
+        const char * s = sSource.c_str();
+
+        while (*s)
+        {
+            unsigned char c = (unsigned char) *s;
+            if (c <= ' ') { s++; continue; }
+
+            TokenType eToken;
+            int iLength = 0;
+
+            if (isalpha(c) || c == '_')
+            {
+                while (isalnum((unsigned char) s[iLength]) || s[iLength] == '_') iLength++;
+                eToken = bHashed ? CTokenLookup::FindAlpha(s,iLength) : LinearAlpha(s,iLength);
+                if (eToken == tNULL) eToken = tVar;
+            }
+            else if (isdigit(c))
+            {
+                while (isdigit((unsigned char) s[iLength])) iLength++;
+                eToken = tNum;
+            }
+            else
+            {
+                eToken = bHashed ? CTokenLookup::FindOperator(s,iLength) : LinearOperator(s,iLength);
+                if (!iLength) { eToken = tBad; iLength = 1; }
+            }
+
+            uSum = uSum*31 + (unsigned int) eToken;
+            fnToken(eToken,s - sSource.c_str());
+            s += iLength;
+        }
+        return uSum;
+    }
+
+    // Times fnTest (which returns the checksum from Scan()), and prints the rate
+
+    template<typename F>
+    void RunTest(const char * sTest,const std::string & sSource,F && fnTest)
+    {
+        unsigned int uSum = 0;
+        double fUs = TimeAvgUs([&] { uSum = fnTest(); });
+        printf("    %-44s %10.1f MB/s    (checksum %08X)\n",sTest,sSource.size()/fUs,uSum);
+    }
+}
+
+void ParseBenchmark()
+{
+    auto sSource = MakeSource();
+
+    printf("Synthetic source: %.1f MB, %d lines\n\n",sSource.size()/(1024.0*1024.0),kSourceLines);
+
+    RunTest("tokenize, linear lookup",sSource,[&] { return Scan<false>(sSource,[](TokenType,size_t) { }); });
+    RunTest("tokenize, perfect hash (CTokenLookup)",sSource,[&] { return Scan<true>(sSource,[](TokenType,size_t) { }); });
+
+    printf("\n");
+
+    // Nodes from the heap: linked together, then freed one at a time
+
+    RunTest("tokenize + nodes, calloc()/free()",sSource,[&]
+    {
+        stNODE * stLast = nullptr;
+        auto uSum = Scan<true>(sSource,[&](TokenType eToken,size_t uPos)
+        {
+            auto stNode = CTree::AllocNode();
+            auto stData = CTree::AllocNodeData();
+            if (!stNode || !stData) return;
+            stData->eToken          = eToken;
+            stData->iLinePosition   = (int) uPos;
+            stNode->stNodeData      = stData;
+            stNode->stPreviousNode  = stLast;
+            stLast = stNode;
+        });
+        while (stLast)
+        {
+            auto stPrevious = stLast->stPreviousNode;
+            CTree::FreeNodeData(stLast->stNodeData);
+            CTree::FreeNode(stLast);
+            stLast = stPrevious;
+        }
+        return uSum;
+    });
+
+    // Nodes from a CNodeArena: the same allocations, then freed with Reset()
+
+    CNodeArena cArena;
+    RunTest("tokenize + nodes, CNodeArena",sSource,[&]
+    {
+        unsigned int uSum;
+        {
+            CNodeArenaScope cScope(cArena);
+            stNODE * stLast = nullptr;
+            uSum = Scan<true>(sSource,[&](TokenType eToken,size_t uPos)
+            {
+                auto stNode = CTree::AllocNode();
+                auto stData = CTree::AllocNodeData();
+                if (!stNode || !stData) return;
+                stData->eToken          = eToken;
+                stData->iLinePosition   = (int) uPos;
+                stNode->stNodeData      = stData;
+                stNode->stPreviousNode  = stLast;
+                stLast = stNode;
+            });
+        }
+        cArena.Reset();
+        return uSum;
+    });
+
+    printf("\nArena blocks: %.1f MB\n",cArena.GetBlockBytes()/(1024.0*1024.0));
+}
@@ -0,0 +1,91 @@
+// ------------------------------------
+// 3D Point Cloud Projection Benchmark
+// ------------------------------------
+//
+// Projects a random point cloud (with normals) to 2D with CView3D, for:
+//
+//      point   -- Translate2DPoint() called for each point (the previous scatter-plot path)
+//      batch   -- Translate2DBatch() on a CPointCloud3D, with each Simd backend on 1 thread, then SimdBatch on all threads
+//      light   -- LightBatch() (normals to Lambert shading), SimdBatch on all threads
+//
+// Results are in millions of points per second (higher is better).  The batch points are checked against Translate2DPoint()
+// (the batch functions work in float rather than double precision, so they are compared with a relative tolerance).
+
+#include "Benchmarks.h"
+#include "CView3D.h"
+#include "InstructionSet.h"
+#include <random>
+#include <vector>
+#include <algorithm>
+
+using namespace Sage;
+
+namespace
+{
+    CPointCloud3D MakeCloud(int iPoints)
+    {
+        std::mt19937 cRand(1234);
+        std::uniform_real_distribution<float> fDist(-500.0f,500.0f);
+
+        CPointCloud3D cCloud;
+        cCloud.Reserve(iPoints);
+        for (int i=0;i<iPoints;i++)
+        {
+            float fX = fDist(cRand), fY = fDist(cRand), fZ = fDist(cRand);
+            cCloud.Add(fX,fY,fZ,fX,fY,fZ);
+        }
+        return cCloud;
+    }
+}
+
+void Project3DBenchmark()
+{
+    CView3D cView(500);
+    cView.SetViewerAngles(0.4,0.3,0.1);
+
+    printf("%-10s %12s %12s %12s %12s %12s %12s   (M points/s)\n","Points","point","scalar","sse","avx2","avx512","batch-mt");
+
+    for (int iPoints : { 10000, 100000, 1000000, 4000000 })
+    {
+        CPointCloud3D cCloud = MakeCloud(iPoints);
+        CPointCloud3D cOut;
+        std::vector<Point3D_t> vPoints(iPoints);
+        cView.Translate2DBatch(cCloud,cOut);
+
+        auto fnRate = [&](double fUs) { return fUs > 0 ? iPoints/fUs : 0.0; };
+
+        double fPoint = fnRate(TimeAvgUs([&]
+        {
+            for (int i=0;i<iPoints;i++)
+            {
+                auto p = cCloud.Get(i);
+                vPoints[i] = cView.Translate2DPoint({ p.fX,p.fY,p.fZ });
+            }
+        }));
+
+        double fScalar  = fnRate(TimeAvgUs([&] { cView.Translate2DBatch<SimdScalar>(cCloud,cOut,1); }));
+        double fSse     = fnRate(TimeAvgUs([&] { cView.Translate2DBatch<Simd128>(cCloud,cOut,1); }));
+        double fAvx2    = CCpuID::AVX2() ? fnRate(TimeAvgUs([&] { cView.Translate2DBatch<Simd256>(cCloud,cOut,1); })) : 0;
+        double fAvx512  = CCpuID::AVX512F() ? fnRate(TimeAvgUs([&] { cView.Translate2DBatch<Simd512>(cCloud,cOut,1); })) : 0;
+        double fBatch   = fnRate(TimeAvgUs([&] { cView.Translate2DBatch(cCloud,cOut); }));
+
+        printf("%-10d %12.1f %12.1f %12.1f %12.1f %12.1f %12.1f\n",iPoints,fPoint,fScalar,fSse,fAvx2,fAvx512,fBatch);
+
+        // Check the batch points against Translate2DPoint()
+
+        double fMaxDiff = 0;
+        for (int i=0;i<iPoints;i++)
+        {
+            auto p = cOut.Get(i);
+            fMaxDiff = (std::max)(fMaxDiff,fabs(p.fX - vPoints[i].fX)/(1.0 + fabs(vPoints[i].fX)));
+            fMaxDiff = (std::max)(fMaxDiff,fabs(p.fY - vPoints[i].fY)/(1.0 + fabs(vPoints[i].fY)));
+        }
+        if (fMaxDiff > 1e-3) printf("** Error: batch and Translate2DPoint() differ by %g (relative)\n",fMaxDiff);
+
+        if (iPoints == 4000000)
+        {
+            std::vector<float> vLight(iPoints);
+            printf("\nlight (LightBatch, %d points): %.1f M points/s\n",iPoints,fnRate(TimeAvgUs([&] { cView.LightBatch(cCloud,vLight.data()); })));
+        }
+    }
+}
@@ -0,0 +1,62 @@
+// ------------------------------------
+// Resize Benchmark
+// ------------------------------------
+//
+// Throughput (in destination megapixels per second) of the multi-threaded CSageResize Lanczos and Bilinear resize,
+// for 4K camera-frame sizes, with 1 thread up to all threads in the default thread pool.
+//
+// The "First(ms)" column is the first call for a size, which includes computing the filter weights.  All other columns are
+// steady-state calls, where the weights come from the cache and the destination bitmap is reused.
+
+#include "Benchmarks.h"
+#include "CSageResize.h"
+
+using namespace Sage;
+
+void ResizeBenchmark()
+{
+    struct Test_t { SIZE szSource; SIZE szDest; };
+    static constexpr Test_t stTests[] = { { { 3840,2160 }, { 1920,1080 } },
+                                          { { 3840,2160 }, { 1280,720  } },
+                                          { { 1920,1080 }, { 3840,2160 } } };
+
+    auto & cResize  = CSageResize::GetDefault();
+    int iMaxThreads = CThreadPool::GetDefault().GetThreads();
+
+    std::vector<int> vThreads;
+    for (int i=1;i<iMaxThreads;i *= 2) vThreads.push_back(i);
+    vThreads.push_back(iMaxThreads);
+
+    printf("Threads in pool: %d\n\n",iMaxThreads);
+    printf("%-22s %-9s %10s","Resize","Filter","First(ms)");
+    for (int iThreads : vThreads) printf(" %7d thr",iThreads);
+    printf("   (MPix/s)\n");
+
+    for (auto & stTest : stTests)
+    {
+        CBitmap cSource((int) stTest.szSource.cx,(int) stTest.szSource.cy);
+        for (int i=0;i<cSource.stBitmap.iTotalSize;i++) cSource.stBitmap.stMem[i] = (unsigned char) ((i*7) ^ (i >> 11));
+
+        for (auto eFilter : { CSageResize::Filter::Lanczos, CSageResize::Filter::Bilinear })
+        {
+            CBitmap cDest;
+            int iWidth = (int) stTest.szDest.cx, iHeight = (int) stTest.szDest.cy;
+
+            cResize.ClearCache();
+            CSageTimer cTimer;
+            cResize.Resize(cSource,iWidth,iHeight,cDest,eFilter);
+            double fFirstMs = cTimer.ElapsedUsf()/1000.0;
+
+            char sName[64];
+            snprintf(sName,sizeof(sName),"%dx%d -> %dx%d",(int) stTest.szSource.cx,(int) stTest.szSource.cy,iWidth,iHeight);
+            printf("%-22s %-9s %10.1f",sName,eFilter == CSageResize::Filter::Lanczos ? "Lanczos" : "Bilinear",fFirstMs);
+
+            for (int iThreads : vThreads)
+            {
+                double fUs = TimeAvgUs([&]{ cResize.Resize(cSource,iWidth,iHeight,cDest,eFilter,iThreads); });
+                printf(" %11.1f",(double) iWidth*iHeight/fUs);
+            }
+            printf("\n");
+        }
+    }
+}
@@ -0,0 +1,101 @@
+// ------------------------------------
+// Simd Backend Benchmark
+// ------------------------------------
+//
+// Runs the same templated kernels on each SimdClass.h backend the CPU supports (SimdScalar, Simd128, Simd256, Simd512):
+//
+//      gain    -- unsigned char -> float, multiply, float -> unsigned char (saturated), i.e. a brightness pass over a bitmap
+//      sincos  -- SinPoly() and CosPoly() throughput, with the maximum error against std::sin()/std::cos() in double precision
+//
+// The gain output of each backend is checked against SimdScalar, since all backends must produce the same bytes.
+//
+// Note: with GCC/Clang, this file must be compiled with the instruction sets enabled (i.e. -march=native); MSVC compiles
+//       all backends as-is.  Backends are only run when CCpuID reports support for them.
+
+#include "Benchmarks.h"
+#include "SimdClass.h"
+#include "InstructionSet.h"
+#include <cmath>
+#include <vector>
+
+using namespace Sage;
+
+static void GainScalar(const unsigned char * sIn,unsigned char * sOut,int iCount,float fGain)
+{
+    for (int i=0;i<iCount;i++) SimdScalar::StoreU8Int(sOut+i,SimdScalar::CvttInt(SimdScalar::Mul((float) sIn[i],fGain)));
+}
+
+template<class Simd>
+static void GainKernel(const unsigned char * sIn,unsigned char * sOut,int iCount,float fGain)
+{
+    auto vGain = Simd::Vecf(fGain);
+    int i = 0;
+    for (;i <= iCount-Simd::kSimdBytes32;i += Simd::kSimdBytes32)
+        Simd::StoreU8Int(sOut+i,Simd::CvttInt(Simd::Mul(Simd::CvtFloat(Simd::LoadU8Int(sIn+i)),vGain)));
+
+    GainScalar(sIn+i,sOut+i,iCount-i,fGain);      // Remainder
+}
+
+template<class Simd>
+static void SinCosKernel(const float * fIn,float * fSin,float * fCos,int iCount)
+{
+    for (int i=0;i<iCount;i += Simd::kSimdBytes32)
+    {
+        auto vIn = Simd::LoadU(fIn+i);
+        Simd::StoreU(fSin+i,Simd::SinPoly(vIn));
+        Simd::StoreU(fCos+i,Simd::CosPoly(vIn));
+    }
+}
+
+template<class Simd>
+static void RunBackend(const char * sName,const std::vector<unsigned char> & vBytes,const std::vector<unsigned char> & vCheck,
+                       const std::vector<float> & vAngles,double & fScalarGain,double & fScalarSinCos)
+{
+    std::vector<unsigned char> vOut(vBytes.size());
+    std::vector<float> vSin(vAngles.size()),vCos(vAngles.size());
+
+    int iBytes  = (int) vBytes.size();
+    int iAngles = (int) vAngles.size();
+
+    GainKernel<Simd>(vBytes.data(),vOut.data(),iBytes,1.7f);
+    if (vOut != vCheck) printf("** Error: %s gain output does not match SimdScalar\n",sName);
+
+    SinCosKernel<Simd>(vAngles.data(),vSin.data(),vCos.data(),iAngles);
+    double fMaxErr = 0;
+    for (int i=0;i<iAngles;i++)
+    {
+        fMaxErr = std::fmax(fMaxErr,std::fabs(vSin[i] - std::sin((double) vAngles[i])));
+        fMaxErr = std::fmax(fMaxErr,std::fabs(vCos[i] - std::cos((double) vAngles[i])));
+    }
+
+    double fGain    = TimeAvgUs([&]{ GainKernel<Simd>(vBytes.data(),vOut.data(),iBytes,1.7f); });
+    double fSinCos  = TimeAvgUs([&]{ SinCosKernel<Simd>(vAngles.data(),vSin.data(),vCos.data(),iAngles); });
+
+    if (!fScalarGain) { fScalarGain = fGain; fScalarSinCos = fSinCos; }
+
+    printf("%-10s %10.1f %8.2fx %12.1f %8.2fx %12.2g\n",sName,fGain,fScalarGain/fGain,fSinCos,fScalarSinCos/fSinCos,fMaxErr);
+}
+
+void SimdBenchmark()
+{
+    static constexpr int kBytes     = 1920*1080*3;
+    static constexpr int kAngles    = 1 << 20;
+
+    std::vector<unsigned char> vBytes(kBytes),vCheck(kBytes);
+    std::vector<float> vAngles(kAngles);
+
+    for (int i=0;i<kBytes;i++) vBytes[i] = (unsigned char) (i*7 + (i >> 9));
+    for (int i=0;i<kAngles;i++) vAngles[i] = -1000.0f + 2000.0f*(float) i/(float) kAngles;
+
+    GainScalar(vBytes.data(),vCheck.data(),kBytes,1.7f);
+
+    printf("gain: %d bytes (1920x1080 24-bit), sincos: %d floats in [-1000,1000]\n\n",kBytes,kAngles);
+    printf("%-10s %10s %9s %12s %9s %12s\n","Backend","Gain(us)","Speedup","SinCos(us)","Speedup","Max Error");
+
+    double fScalarGain = 0, fScalarSinCos = 0;
+
+    RunBackend<SimdScalar>("Scalar",vBytes,vCheck,vAngles,fScalarGain,fScalarSinCos);
+    if (CCpuID::SSE4())     RunBackend<Simd128>("Simd128",vBytes,vCheck,vAngles,fScalarGain,fScalarSinCos);
+    if (CCpuID::AVX2())     RunBackend<Simd256>("Simd256",vBytes,vCheck,vAngles,fScalarGain,fScalarSinCos);
+    if (CCpuID::AVX512F() && CCpuID::AVX512BW()) RunBackend<Simd512>("Simd512",vBytes,vCheck,vAngles,fScalarGain,fScalarSinCos);
+}
@@ -0,0 +1,62 @@
+// --------------------------------------
+// Sagebox Performance Benchmarks (Console)
+// --------------------------------------
+//
+// Console-mode micro-benchmarks for Sagebox internals.  No windows are opened, so these can be run on a build 
+// machine or from a script -- except for benchmarks marked as named-only (i.e. "controls"), which are only run when named.
+//
+// Usage:   "Performance Benchmarks"           -- runs all benchmarks
+//          "Performance Benchmarks" <name>    -- runs only the named benchmark (i.e. "Performance Benchmarks" blend)
+//
+// Build with the "Debug Optimized" configuration (or a Release configuration) -- timings from unoptimized builds are meaningless. 
+
+#include "Benchmarks.h"
+#include <cstring>
+
+struct Benchmark_t
+{
+    const char * sName;
+    const char * sDescription;
+    void (*fnBenchmark)();
+    bool bNamedOnly;            // Opens windows -- only run when named on the command line
+};
+
+static const Benchmark_t stBenchmarks[] =
+{
+    { "blend",  "ApplyMaskGraphic/ApplyMaskColor kernels vs. scalar (CBlendKernels)",   BlendBenchmark },
+    { "simd",   "SimdScalar/Simd128/Simd256/Simd512 backends on the same templated kernels (SimdClass.h)",   SimdBenchmark },
+    { "hittest", "MouseRegion display-list walk vs. CRegionIndex hit testing, by region count",   HitTestBenchmark },
+    { "resize",  "Multi-threaded Lanczos/Bilinear resize (CSageResize) in MPix/s, 1 to N threads",   ResizeBenchmark },
+    { "blur",    "Box-approximation Gaussian blur (CSageBlur) time vs. radius, 1 to N threads",   BlurBenchmark },
+    { "lock",    "CAdaptiveLock spin-then-park vs. CLockProcess spin-only vs. std::mutex, 1 to 64 threads",   LockBenchmark },
+    { "avi",     "Per-frame caller time: synchronous vs. CAviAsyncWriter AVI recording (CRawAviWriter)",   AviWriteBenchmark },
+    { "draw",    "Headless COffscreenWindow drawing throughput (1920x1080), primitives and report frames per second",   OffscreenBenchmark },
+    { "project3d", "CView3D per-point Translate2DPoint() vs. CPointCloud3D batch projection, by backend and thread count",   Project3DBenchmark },
+    { "options",  "kw::/opt:: option sets built per control vs. CCompiledKeys and COptCache interning",   OptionsBenchmark },
+    { "controls", "NewSlider()/NewButton() creation rate, keywords per control vs. CCompiledKeys (opens a hidden window)",   ControlsBenchmark, true },
+    { "alloc",    "Per-frame temporary buffers from the heap vs. CPoolAllocator vs. CScratchArena (CMemAllocator.h), 1 to N threads",   AllocBenchmark },
+    { "parse",    "CToken front end: linear vs. perfect-hash keyword/operator lookup, heap vs. CNodeArena nodes, in MB/s",   ParseBenchmark },
+    { "expr",     "Script expressions: tree walk vs. bytecode register VM (CExprVM.h) on a Mandelbrot inner loop",   ExprBenchmark },
+};
+
+int main(int argc,char * argv[])
+{
+    const char * sOnly = argc > 1 ? argv[1] : nullptr;
+    bool bFound = false;
+
+    for (auto & stBenchmark : stBenchmarks)
+    {
+        if (sOnly ? _stricmp(sOnly,stBenchmark.sName) != 0 : stBenchmark.bNamedOnly) continue;
+        bFound = true;
+        printf("\n---- %s -- %s ----\n\n",stBenchmark.sName,stBenchmark.sDescription);
+        stBenchmark.fnBenchmark();
+    }
+
+    if (!bFound)
+    {
+        printf("Unknown benchmark \"%s\".  Available benchmarks:\n\n",sOnly);
+        for (auto & stBenchmark : stBenchmarks) printf("    %-12s %s\n",stBenchmark.sName,stBenchmark.sDescription);
+        return -1;
+    }
+    return 0;
+}
@@ -135,6 +135,10 @@
 #include "CVisualSort.h"
 #include "sort-texture.pgr2.h"
 #include "AboutSorting.pgr2.h"
+#include <vector>
+#include <random>
+#include <chrono>
+#include <algorithm>
 
 using namespace Sage::kw;      // Sagebox keyword options
 
@@ -251,10 +255,11 @@ bool CVisualSort::RunSort(const SortType & stSort)
     m_cText->Write(stSort.sTitle);
     printf("Current Sort: %s\n",stSort.sTitle);
     InitDataArray();
+    m_stStats.Reset();
     clock_t ctStart = clock();
     (this->*stSort.fSortFunc)();        // Call the actual sort function.
 
-    printf("time = %d ms\n",(int) (clock()-ctStart));
+    printf("time = %d ms, %llu compares, %llu swaps/moves\n",(int) (clock()-ctStart),(unsigned long long) m_stStats.iCompares,(unsigned long long) m_stStats.iSwaps);
     DrawGraph();                        // One more update to make sure we got them all, since we skipped some.
     return !m_cWin->WindowClosing();    // If the window is closing, then return false.
 }
@@ -274,7 +279,9 @@ void CVisualSort::Go()
                             "Quick Sort",       &CVisualSort::QuickSort,
                             "Selection Sort",   &CVisualSort::SelectionSort,
                             "Heap Sort",        &CVisualSort::HeapSort,
-                            "Shell Sort",       &CVisualSort::ShellSort };
+                            "Shell Sort",       &CVisualSort::ShellSort,
+                            "Parallel Merge Sort",  &CVisualSort::ParallelMergeSort,
+                            "Radix Sort (LSD)", &CVisualSort::RadixSort };
 
     static constexpr int kNumSorts = sizeof(stSort)/sizeof(stSort[0]);
 
@@ -450,3 +457,68 @@ bool CVisualSort::main(bool bConsoleApp)
     return !bError;     // Return true if there is no error. 
 }
 
+
+// Benchmark() -- Sort iSize random integers with each sort function and print the times, without a window or Update() function.
+//
+// This is run with "Visual Sort Algorithms -benchmark [size]" (see main.cpp); the default size is kBenchmarkSize (10 million).
+// Each result is checked against std::sort(), which is also timed for reference.
+//
+// Selection Sort is skipped for more than 100,000 elements since it is O(n^2) -- at 10 million elements it would take hours.
+//
+bool CVisualSort::Benchmark(int iSize)
+{
+    if (iSize < 2) return false;
+
+    std::vector<int> vSource(iSize), vExpected, vData;
+    std::mt19937 cRand(12345);
+    for (auto & iValue : vSource) iValue = (int) cRand();      // Full int range, including negative numbers
+
+    struct Benchmark_t
+    {
+        const char * sName;
+        std::function<void(int * pData,int iSize)> fnSort;
+        bool bQuadratic;
+    };
+
+    CMergeSort<>            cMergeSort;
+    CQuickSort<>            cQuickSort;
+    CHeapSort<>             cHeapSort;
+    CShellSort<>            cShellSort;
+    CSelectionSort<>        cSelectionSort;
+    CParallelMergeSort<>    cParallelMergeSort;
+    CRadixSort<>            cRadixSort;
+
+    Benchmark_t stBenchmarks[] =
+    {
+        { "std::sort (reference)",  [&](int * p,int n) { std::sort(p,p + n); },                     false },
+        { "Merge Sort",             [&](int * p,int n) { cMergeSort.MergeSort(p,0,n - 1); },        false },
+        { "Quick Sort",             [&](int * p,int n) { cQuickSort.QuickSort(p,0,n - 1); },        false },
+        { "Heap Sort",              [&](int * p,int n) { cHeapSort.HeapSort(p,n); },                false },
+        { "Shell Sort",             [&](int * p,int n) { cShellSort.ShellSort(p,n); },              false },
+        { "Selection Sort",         [&](int * p,int n) { cSelectionSort.SelectionSort(p,n); },      true  },
+        { "Parallel Merge Sort",    [&](int * p,int n) { cParallelMergeSort.MergeSort(p,n); },      false },
+        { "Radix Sort (LSD)",       [&](int * p,int n) { cRadixSort.RadixSort(p,n); },              false },
+    };
+
+    vExpected = vSource;
+    std::sort(vExpected.begin(),vExpected.end());
+
+    printf("Sorting %d random integers (%d threads for the parallel sorts)\n\n",iSize,Sage::CThreadPool::GetDefault().GetThreads());
+    printf("%-24s %12s\n","Sort","Time (ms)");
+
+    bool bAllOk = true;
+    for (auto & stBenchmark : stBenchmarks)
+    {
+        if (stBenchmark.bQuadratic && iSize > 100000) { printf("%-24s %12s\n",stBenchmark.sName,"(skipped)"); continue; }
+
+        vData = vSource;
+        auto tStart = std::chrono::steady_clock::now();
+        stBenchmark.fnSort(vData.data(),iSize);
+        double fMs = std::chrono::duration<double,std::milli>(std::chrono::steady_clock::now() - tStart).count();
+
+        bool bOk = vData == vExpected;
+        bAllOk &= bOk;
+        printf("%-24s %12.1f%s\n",stBenchmark.sName,fMs,bOk ? "" : "   ** not sorted correctly **");
+    }
+    return bAllOk;
+}
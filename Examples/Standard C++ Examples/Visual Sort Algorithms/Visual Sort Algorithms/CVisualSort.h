@@ -46,11 +46,15 @@ class CVisualSort
                                                         // DrawGraph().
     // Sort function objects
 
-    CMergeSort            m_MergeSort; 
-    CQuickSort            m_QuickSort; 
-    CSelectionSort        m_SelectionSort;
-    CHeapSort             m_HeapSort;
-    CShellSort            m_ShellSort;
+    CMergeSort<>          m_MergeSort; 
+    CQuickSort<>          m_QuickSort; 
+    CSelectionSort<>      m_SelectionSort;
+    CHeapSort<>           m_HeapSort;
+    CShellSort<>          m_ShellSort;
+    CParallelMergeSort<>  m_ParallelMergeSort;
+    CRadixSort<>          m_RadixSort;
+
+    SortStats             m_stStats{};                  // Comparisons and swaps for the current sort (filled in by the sort functions)
 
     int                    m_iCounter;                  // Counter for the threshold (i.e. how many Update() calls before we print a graph)
     int                    m_iThreshold = 5;            // How many Update()/DrawGraph() calls before we draw a graph and update the window.
@@ -82,6 +86,8 @@ class CVisualSort
     void SelectionSort()    { m_SelectionSort.SelectionSort(m_ipArray,kSortSize); }
     void HeapSort()         { m_HeapSort.HeapSort(m_ipArray,kSortSize); }
     void ShellSort()        { m_ShellSort.ShellSort(m_ipArray,kSortSize); }
+    void ParallelMergeSort() { m_ParallelMergeSort.MergeSort(m_ipArray,kSortSize); }
+    void RadixSort()        { m_RadixSort.RadixSort(m_ipArray,kSortSize); }
 
 private:
     void InitDataArray();                       // Initialize the array with random data
@@ -91,15 +97,21 @@ private:
     bool InitWindow();                          // Initialize thw Window, Controls, etc.
     bool InitMem();                             // Allocate the initial memory.
 public:
+    static constexpr int kBenchmarkSize = 10000000;         // Default number of elements for Benchmark()
+
     bool main(bool bConsoleApp);                            // same as C++ main(), just here in our class.
 
+    static bool Benchmark(int iSize = kBenchmarkSize);      // Time each sort on iSize random elements, with no window (see main.cpp)
+
     // Instantiate and allocate all Sorting classes with the Update Pointer and passed object pointer (i.e. this)
     //
-    CVisualSort()    : m_MergeSort(     CMergeSort(     {this,SortUpdate})),
-                      m_QuickSort(      CQuickSort(     {this,SortUpdate})),
-                      m_HeapSort(       CHeapSort(      {this,SortUpdate})),
-                      m_ShellSort(      CShellSort(     {this,SortUpdate})),
-                      m_SelectionSort(  CSelectionSort( {this,SortUpdate}))
+    CVisualSort()    : m_MergeSort(     CMergeSort<>(     {this,SortUpdate,&m_stStats})),
+                      m_QuickSort(      CQuickSort<>(     {this,SortUpdate,&m_stStats})),
+                      m_HeapSort(       CHeapSort<>(      {this,SortUpdate,&m_stStats})),
+                      m_ShellSort(      CShellSort<>(     {this,SortUpdate,&m_stStats})),
+                      m_SelectionSort(  CSelectionSort<>( {this,SortUpdate,&m_stStats})),
+                      m_ParallelMergeSort(  UpdateFunc{this,SortUpdate,&m_stStats}),
+                      m_RadixSort(      UpdateFunc{this,SortUpdate,&m_stStats})
     {
     }
 };
@@ -3,16 +3,35 @@
 #if !defined(_SortAlgorithms_h_)
 #define _SortAlgorithms_h_
 
-// note: CMemClass is included here due to the Mem<> template uses.  These are used a simple way to effectively allocate managed 
-// memory that will be deleted automatically when the class is deleted.  Mem also has other management functions (such as ResizeMax())
-// which is used in the Merge function.
+// note: The sort classes are templates on the element type and comparator (the defaults are int and std::less<>, which is what
+// the original int-only versions did), so they are all in this header.  SortAlgorithms.cpp compiles the int versions
+// used by CVisualSort once.
 //
-// Only the Merge sort uses it, and if Mem is replaced with standard C/C++ memory allocation, then CMemClas.H can be removed and this
-// set of functions is completely transportable without any other sources other than this .H file and the .cpp file.
+// CThreadPool.h is only used by the parallel sorts (CParallelMergeSort and CRadixSort).  Other than that, this set of functions
+// is completely transportable without any other sources.
 
-#include "CMemClass.h"        
+#include "CThreadPool.h"
+#include <vector>
+#include <functional>
+#include <algorithm>
+#include <type_traits>
+#include <cstdint>
+#include <cstring>
 
-// UpdateFunc() 
+// SortStats -- Counters for the sort functions (see UpdateFunc)
+//
+// iCompares is the number of element comparisons, and iSwaps the number of swaps or element moves (for the merge and radix sorts,
+// which move elements rather than swap them).
+//
+struct SortStats
+{
+    uint64_t iCompares;
+    uint64_t iSwaps;
+
+    void Reset() { iCompares = 0; iSwaps = 0; }
+};
+
+// UpdateFunc()
 //
 // This structure allows an external call to be made to an update routine without the
 // sort algorithm neededing any details.
@@ -21,11 +40,18 @@
 // no real consequence to efficiency to the algorithm -- that is, all of the sort algorithms can be
 // used as general sort algorithms, as there is no time penalty when not providing an Update function.
 //
+// pStats is optional.  When it's given, the sort functions add their comparisons and swaps to it, so the cost of each
+// sort can be shown along with its time (see CVisualSort::RunSort()).
+//
 struct UpdateFunc
 {
     void * pData;
     void (*fUpdate)(void * pObj,int a,int b);
+    SortStats * pStats = nullptr;
+
     __forceinline void func(int a,int b) { if (fUpdate) fUpdate(pData,a,b); };
+    __forceinline void Compared() { if (pStats) pStats->iCompares++; }
+    __forceinline void Swapped(uint64_t iCount = 1) { if (pStats) pStats->iSwaps += iCount; }
 };
 
 // --------------------------------
@@ -33,112 +59,553 @@ struct UpdateFunc
 // --------------------------------
 //
 // All of these functions were copied from CodeProject and are as-is (including original comments)
-// In the code. 
-// 
+// In the code.
+//
 // The classes used for two purposes:
 //
 //    1. Keep a clean interface
-//    2. Allow the functions to be used with their original, copied source but with an 
-//       option Update() function that allows the CVisualSort function (or anything else) to 
+//    2. Allow the functions to be used with their original, copied source but with an
+//       option Update() function that allows the CVisualSort function (or anything else) to
 //       display the results realtime.
 //
-//     Without the Update() function, these routines can be used as normal sort functions. 
+//     Without the Update() function, these routines can be used as normal sort functions.
 //
 // --------------------------------------
 // Copying Code and Using it with SageBox
 // --------------------------------------
 //
-// As mentioned, the code for all sorting algorithms are in the exact same form and copied directly from 
-// Code Project.  This is to show how code can be used with Sagebox as-is, with very little needed to 
-// get the code working in a GUI format. 
+// As mentioned, the code for all sorting algorithms are in the exact same form and copied directly from
+// Code Project.  This is to show how code can be used with Sagebox as-is, with very little needed to
+// get the code working in a GUI format.
 //
 // In this case, little insertions for the Update() function in the right points for an update
 // display function is all that was needed, without touching any of the original code.
 //
-// There are two places where the code differs from the original:
+// The places where the code differs from the original:
 //
-//    1. In MergeSort(), a memory object is used for temporary arrays.  This is because MSVC doesn't support
-//       variable-sized arrays on the stack, but also -- and possibly more importantly -- putting these arrays on the 
+//    1. In MergeSort(), one scratch array the size of the input is used for the temporary arrays.  This is because MSVC
+//       doesn't support variable-sized arrays on the stack, but also -- and possibly more importantly -- putting these arrays on the
 //       stack in merge() can possily cause a crash if they exceed the size of the stack.
 //
-//     In this case, the memory objects are re-allocated only if the size needed is bigger.
-//       This does not happen with CVisualSort, as they are pre-allocated to a size that is larger than
-//     the size needed.  Therefore, the memory arrays are only allocated once.
+//       The scratch array is sized when MergeSort() is called, so it is only allocated again for a larger input.
+//
+//    2. Swap() -- there are many sort functions that call swap(), which is now an __forceinline function local to each class
+//       (it used to be a #define, before the classes became templates in a header).
 //
-//    2. Swap() -- there are many sort functions that call swap(), which should be a separate function
-//       local to each class.  However, since MSVC doesn't support inline lambdas, this was changed to a #define
-//       for the sake of efficiency.  Read the notes above the swap() #define.
+//    3. Comparisons go through the comparator (i.e. arr[a] < arr[b] is Less(arr[a],arr[b])), so any type and ordering can
+//       be sorted, and the comparisons can be counted.
+//
+// CParallelMergeSort and CRadixSort are not from the original sources -- they are multi-threaded sorts for large arrays
+// (i.e. millions of elements).  Their Update() calls are made between passes, from the calling thread.
 //
 
 // ----------------
 // Merge Sort Class
 // ----------------
 //
+template<typename T = int,typename Compare = std::less<T>>
 class CMergeSort
 {
     UpdateFunc Update = {};
-    void merge(int arr[], int l, int m, int r); 
-     Sage::Mem<int> Lm;    // Memory for merge() function. Changed due to variable-sized stack array in original version.
-    Sage::Mem<int> Rm;    // Memory for merge() function
+    Compare cmp;
+    std::vector<T> m_vScratch;          // Memory for merge() function. Changed due to variable-sized stack array in original version.
+
+    __forceinline bool Less(const T & a,const T & b) { Update.Compared(); return cmp(a,b); }
+
+    void merge(T arr[], int l, int m, int r)
+    {
+        int i, j, k;
+        int n1 = m - l + 1;
+        int n2 = r - m;
+
+        /* create temp arrays */
+
+        // The original used variable-sized stack arrays (int L[n1], R[n2]).  L and R are in the scratch array sized by MergeSort(),
+        // which is never smaller than n1 + n2.
+
+        T * L = m_vScratch.data();
+        T * R = L + n1;
+
+        // --- Original function follows (except for insertio of Update.func() ---
+        /* Copy data to temp arrays L[] and R[] */
+        for (i = 0; i < n1; i++)
+            L[i] = arr[l + i];
+        for (j = 0; j < n2; j++)
+            R[j] = arr[m + 1 + j];
+
+        /* Merge the temp arrays back into arr[l..r]*/
+        i = 0; // Initial index of first subarray
+        j = 0; // Initial index of second subarray
+        k = l; // Initial index of merged subarray
+        while (i < n1 && j < n2) {
+            if (!Less(R[j],L[i])) {         // L[i] <= R[j]
+                arr[k] = L[i];
+                i++;
+            }
+            else {
+                arr[k] = R[j];
+                j++;
+            }
+            k++;
+          Update.func(l,r);
+      }
+
+        /* Copy the remaining elements of L[], if there are any */
+        while (i < n1) {
+            arr[k] = L[i];
+            i++;
+            k++;
+          Update.func(l,r);
+        }
+
+        /* Copy the remaining elements of R[], if there are any */
+        while (j < n2) {
+            arr[k] = R[j];
+            j++;
+            k++;
+          Update.func(l,r);
+       }
+        Update.Swapped(n1 + n2);
+    }
+
+    /* l is for left index and r is right index of the
+       sub-array of arr to be sorted */
+    void mergeSort(T arr[], int l, int r)
+    {
+        if (l < r) {
+            // Same as (l+r)/2, but avoids overflow for
+            // large l and h
+            int m = l + (r - l) / 2;
+
+            // Sort first and second halves
+            mergeSort(arr, l, m);
+            mergeSort(arr, m + 1, r);
+
+            merge(arr, l, m, r);
+        }
+    }
 
 public:
-    CMergeSort(UpdateFunc stUpdate) : Update(stUpdate) { Lm = 2000; Rm = 2000; };
-    CMergeSort() { Lm = 2000; Rm = 2000; };        // Provide a version that does not require an Update function
-    void MergeSort(int arr[], int l, int r);
+    CMergeSort(UpdateFunc stUpdate,Compare cCompare = Compare()) : Update(stUpdate), cmp(cCompare) {};
+    CMergeSort(Compare cCompare = Compare()) : cmp(cCompare) {};      // Provide a version that does not require an Update function
+
+    void MergeSort(T arr[], int l, int r)
+    {
+        if (r - l + 1 > (int) m_vScratch.size()) m_vScratch.resize(r - l + 1);
+        mergeSort(arr,l,r);
+    }
 };
 
 // ----------------
 // Quick Sort Class
 // ----------------
 //
+template<typename T = int,typename Compare = std::less<T>>
 class CQuickSort
 {
     UpdateFunc Update = {};
-    int partition (int arr[], int low, int high);
+    Compare cmp;
+
+    __forceinline bool Less(const T & a,const T & b) { Update.Compared(); return cmp(a,b); }
+    __forceinline void swap(T arr[],int x,int y) { std::swap(arr[x],arr[y]); Update.Swapped(); Update.func(x,y); }
+
+    /* This function takes last element as pivot, places
+    the pivot element at its correct position in sorted
+    array, and places all smaller (smaller than pivot)
+    to left of pivot and all greater elements to right
+    of pivot */
+    int partition (T arr[], int low, int high)
+    {
+        T pivot = arr[high]; // pivot
+        int i = (low - 1); // Index of smaller element
+
+        for (int j = low; j <= high - 1; j++)
+        {
+            // If current element is smaller than the pivot
+            if (Less(arr[j],pivot))
+            {
+                i++; // increment index of smaller element
+                swap(arr,i,j);
+          }
+        }
+        swap(arr,i + 1, high);
+         return (i + 1);
+    }
+
 public:
-    CQuickSort(UpdateFunc stUpdate) : Update(stUpdate) {};
-    CQuickSort() { };    // Provide a version that does not require an Update function
-    void QuickSort(int arr[], int l, int r);
+    CQuickSort(UpdateFunc stUpdate,Compare cCompare = Compare()) : Update(stUpdate), cmp(cCompare) {};
+    CQuickSort(Compare cCompare = Compare()) : cmp(cCompare) { };    // Provide a version that does not require an Update function
+
+    /* The main function that implements QuickSort
+    arr[] --> Array to be sorted,
+    low --> Starting index,
+    high --> Ending index */
+    void QuickSort(T arr[], int low, int high)
+    {
+        if (low < high)
+        {
+            /* pi is partitioning index, arr[p] is now
+            at right place */
+            int pi = partition(arr, low, high);
+
+            // Separately sort elements before
+            // partition and after partition
+            QuickSort(arr, low, pi - 1);
+            QuickSort(arr, pi + 1, high);
+        }
+    }
 };
 
 // ---------------
 // Heap Sort Class
 // ---------------
 //
+template<typename T = int,typename Compare = std::less<T>>
 class CHeapSort
 {
     UpdateFunc Update = {};
-    void heapify(int arr[], int n, int i);
+    Compare cmp;
+
+    __forceinline bool Less(const T & a,const T & b) { Update.Compared(); return cmp(a,b); }
+    __forceinline void swap(T arr[],int x,int y) { std::swap(arr[x],arr[y]); Update.Swapped(); Update.func(x,y); }
+
+    void heapify(T arr[], int n, int i)
+    {
+        int largest = i; // Initialize largest as root
+        int l = 2*i + 1; // left = 2*i + 1
+        int r = 2*i + 2; // right = 2*i + 2
+
+        // If left child is larger than root
+        if (l < n && Less(arr[largest],arr[l]))
+            largest = l;
+
+        // If right child is larger than largest so far
+        if (r < n && Less(arr[largest],arr[r]))
+            largest = r;
+
+        // If largest is not root
+        if (largest != i)
+        {
+            swap(arr,i, largest);
+
+            // Recursively heapify the affected sub-tree
+            heapify(arr, n, largest);
+        }
+    }
+
 public:
-    CHeapSort(UpdateFunc stUpdate) : Update(stUpdate) {};
-    CHeapSort() { };    // Provide a version that does not require an Update function
-    void HeapSort(int arr[], int n);
+    CHeapSort(UpdateFunc stUpdate,Compare cCompare = Compare()) : Update(stUpdate), cmp(cCompare) {};
+    CHeapSort(Compare cCompare = Compare()) : cmp(cCompare) { };    // Provide a version that does not require an Update function
+
+    // main function to do heap sort
+    //
+    void HeapSort(T arr[], int n)
+    {
+        // Build heap (rearrange array)
+        for (int i = n / 2 - 1; i >= 0; i--)
+            heapify(arr, n, i);
+
+        // One by one extract an element from heap
+        for (int i=n-1; i>0; i--)
+        {
+            // Move current root to end
+            swap(arr,0, i);
+
+            // call max heapify on the reduced heap
+            heapify(arr, i, 0);
+        }
+    }
 };
 
 // ----------------
 // Shell Sort Class
 // ----------------
 //
+template<typename T = int,typename Compare = std::less<T>>
 class CShellSort
 {
     UpdateFunc Update = {};
+    Compare cmp;
+
+    __forceinline bool Less(const T & a,const T & b) { Update.Compared(); return cmp(a,b); }
+
 public:
-    CShellSort(UpdateFunc stUpdate) : Update(stUpdate) {};
-    CShellSort() { };    // Provide a version that does not require an Update function
-    int ShellSort(int arr[], int n);
+    CShellSort(UpdateFunc stUpdate,Compare cCompare = Compare()) : Update(stUpdate), cmp(cCompare) {};
+    CShellSort(Compare cCompare = Compare()) : cmp(cCompare) { };    // Provide a version that does not require an Update function
+
+    int ShellSort(T arr[], int n)
+    {
+        // Start with a big gap, then reduce the gap
+
+        for (int gap = n/2; gap > 0; gap /= 2)
+        {
+            // Do a gapped insertion sort for this gap size.
+            // The first gap elements a[0..gap-1] are already in gapped order
+            // keep adding one more element until the entire array is
+            // gap sorted
+            for (int i = gap; i < n; i += 1)
+            {
+                // add a[i] to the elements that have been gap sorted
+                // save a[i] in temp and make a hole at position i
+                T temp = arr[i];
+
+                // shift earlier gap-sorted elements up until the correct
+                // location for a[i] is found
+                int j;
+                for (j = i; j >= gap && Less(temp,arr[j - gap]); j -= gap)
+                {
+                    arr[j] = arr[j - gap];
+                    Update.Swapped();
+                }
+
+                //  put temp (the original a[i]) in its correct location
+                arr[j] = temp;
+                Update.func(i,j);
+            }
+        }
+        return 0;
+    }
 };
 
 // --------------------
 // Selection Sort Class
 // --------------------
 //
+template<typename T = int,typename Compare = std::less<T>>
 class CSelectionSort
 {
     UpdateFunc Update = {};
+    Compare cmp;
+
+    __forceinline bool Less(const T & a,const T & b) { Update.Compared(); return cmp(a,b); }
+    __forceinline void swap(T arr[],int x,int y) { std::swap(arr[x],arr[y]); Update.Swapped(); Update.func(x,y); }
+
+public:
+    CSelectionSort(UpdateFunc stUpdate,Compare cCompare = Compare()) : Update(stUpdate), cmp(cCompare) {};
+    CSelectionSort(Compare cCompare = Compare()) : cmp(cCompare) { };    // Provide a version that does not require an Update function
+
+    void SelectionSort(T arr[], int n)
+    {
+        int i, j, min_idx;
+
+        // One by one move boundary of unsorted subarray
+        for (i = 0; i < n-1; i++)
+        {
+            // Find the minimum element in unsorted array
+            min_idx = i;
+            for (j = i+1; j < n; j++)
+              if (Less(arr[j],arr[min_idx]))
+              {
+                  min_idx = j;
+                  Update.func(min_idx,i);
+              }
+
+            // Swap the found minimum element with the first element
+            swap(arr,min_idx, i);
+        }
+    }
+};
+
+// -------------------------
+// Parallel Merge Sort Class
+// -------------------------
+//
+// The array is split into one block per task, each block is sorted with CMergeSort, and the sorted blocks are merged in pairs
+// until one run is left.  Each merge of two runs is split into equal parts of the output (found with a binary search of
+// both runs), so every pass uses all threads, including the last one.
+//
+// The sort is stable and uses one scratch array the size of the input.
+//
+template<typename T = int,typename Compare = std::less<T>>
+class CParallelMergeSort
+{
+    UpdateFunc Update = {};
+    Compare cmp;
+    std::vector<T> m_vScratch;
+    Sage::CThreadPool & m_cPool;
+
+    // Number of elements taken from A (of nA) for the first k elements of the merged output, taking from A first for equal elements
+
+    int CoRank(const T * A,int nA,const T * B,int nB,int k)
+    {
+        int lo = k > nB ? k - nB : 0;
+        int hi = k < nA ? k : nA;
+        while (lo < hi)
+        {
+            int a = lo + (hi - lo)/2;           // Candidate count from A; B contributes k - a
+            if (cmp(B[k - a - 1],A[a])) hi = a; // B's last is before A's next -- too many from A
+            else lo = a + 1;
+        }
+        return lo;
+    }
+
+    // Merges A and B into out, counting comparisons in iCompares
+
+    void MergeRange(const T * A,int nA,const T * B,int nB,T * out,uint64_t & iCompares)
+    {
+        int i = 0, j = 0;
+        while (i < nA && j < nB)
+        {
+            iCompares++;
+            *out++ = cmp(B[j],A[i]) ? B[j++] : A[i++];
+        }
+        while (i < nA) *out++ = A[i++];
+        while (j < nB) *out++ = B[j++];
+    }
+
+public:
+    CParallelMergeSort(UpdateFunc stUpdate,Compare cCompare = Compare(),Sage::CThreadPool & cPool = Sage::CThreadPool::GetDefault()) : Update(stUpdate), cmp(cCompare), m_cPool(cPool) {};
+    CParallelMergeSort(Compare cCompare = Compare(),Sage::CThreadPool & cPool = Sage::CThreadPool::GetDefault()) : cmp(cCompare), m_cPool(cPool) {};
+
+    /// <summary>
+    /// Sorts arr[0] to arr[n-1] using up to iMaxThreads threads (0 = all threads in the pool).
+    /// </summary>
+    void MergeSort(T arr[],int n,int iMaxThreads = 0)
+    {
+        if (n < 2) return;
+
+        int iThreads = iMaxThreads > 0 ? (std::min)(iMaxThreads,m_cPool.GetThreads()) : m_cPool.GetThreads();
+        int iBlocks = 1;
+        while (iBlocks < iThreads*2 && n/(iBlocks*2) >= 1024) iBlocks *= 2;     // Power of 2, so the runs merge in pairs evenly
+
+        if ((int) m_vScratch.size() < n) m_vScratch.resize(n);
+
+        std::vector<SortStats> vStats(iBlocks,SortStats{});
+        auto fnBlock = [&](int iBlock) { return (int) ((int64_t) n*iBlock/iBlocks); };
+
+        // Sort each block.  Each block's CMergeSort uses its own scratch array (only the part it needs).
+
+        m_cPool.ParallelFor(iBlocks,[&](int iTask,int)
+        {
+            CMergeSort<T,Compare> cSort(UpdateFunc{ nullptr,nullptr,&vStats[iTask] },cmp);
+            cSort.MergeSort(arr,fnBlock(iTask),fnBlock(iTask + 1) - 1);
+        },iThreads);
+        Update.func(0,n - 1);
+
+        // Merge pairs of runs, back and forth between arr and the scratch array
+
+        T * src = arr;
+        T * dst = m_vScratch.data();
+        for (int iWidth=1;iWidth<iBlocks;iWidth *= 2)
+        {
+            int iMerges = iBlocks/(iWidth*2);
+            int iParts  = (std::max)(1,(iThreads*2)/iMerges);
+            std::vector<uint64_t> vCompares((size_t) iMerges*iParts,0);
+
+            m_cPool.ParallelFor(iMerges*iParts,[&](int iTask,int)
+            {
+                int iMerge = iTask/iParts, iPart = iTask % iParts;
+                int l = fnBlock(iMerge*iWidth*2), m = fnBlock(iMerge*iWidth*2 + iWidth), r = fnBlock((iMerge + 1)*iWidth*2);
+                int nA = m - l, nB = r - m, nOut = nA + nB;
+
+                int k1 = (int) ((int64_t) nOut*iPart/iParts), k2 = (int) ((int64_t) nOut*(iPart + 1)/iParts);
+                int a1 = CoRank(src + l,nA,src + m,nB,k1), a2 = CoRank(src + l,nA,src + m,nB,k2);
+                MergeRange(src + l + a1,a2 - a1,src + m + (k1 - a1),(k2 - a2) - (k1 - a1),dst + l + k1,vCompares[iTask]);
+            },iThreads);
+
+            for (auto iCompares : vCompares) if (Update.pStats) Update.pStats->iCompares += iCompares;
+            Update.Swapped(n);
+            std::swap(src,dst);
+            Update.func(0,n - 1);
+        }
+
+        if (src != arr) { std::copy(src,src + n,arr); Update.Swapped(n); }
+        for (auto & stStats : vStats) if (Update.pStats) Update.pStats->iCompares += stStats.iCompares, Update.pStats->iSwaps += stStats.iSwaps;
+    }
+};
+
+// ---------------------------
+// Parallel LSD Radix Sort Class
+// ---------------------------
+//
+// Least-significant-digit radix sort on 8-bit digits for integer types (signed or unsigned), with no comparisons.  Each pass
+// counts digits per thread block, then each block scatters its elements to its own part of the output, so the sort is
+// stable and every pass runs on all threads.  Passes where every element has the same digit are skipped.
+//
+template<typename T = int>
+class CRadixSort
+{
+    static_assert(std::is_integral<T>::value,"CRadixSort only sorts integer types");
+    using Key = typename std::make_unsigned<T>::type;
+
+    static constexpr int kPasses = (int) sizeof(T);
+    static constexpr Key kSignBit = std::is_signed<T>::value ? (Key) ((Key) 1 << (sizeof(T)*8 - 1)) : 0;    // Flipped so negative numbers sort first
+
+    UpdateFunc Update = {};
+    std::vector<T> m_vScratch;
+    Sage::CThreadPool & m_cPool;
+
+    static __forceinline int Digit(T v,int iPass) { return (int) ((((Key) v) ^ kSignBit) >> (iPass*8)) & 255; }
+
 public:
-    CSelectionSort(UpdateFunc stUpdate) : Update(stUpdate) {};
-    CSelectionSort() { };    // Provide a version that does not require an Update function
-    void SelectionSort(int arr[], int n);
+    CRadixSort(UpdateFunc stUpdate,Sage::CThreadPool & cPool = Sage::CThreadPool::GetDefault()) : Update(stUpdate), m_cPool(cPool) {};
+    CRadixSort(Sage::CThreadPool & cPool = Sage::CThreadPool::GetDefault()) : m_cPool(cPool) {};
+
+    /// <summary>
+    /// Sorts arr[0] to arr[n-1] in ascending order using up to iMaxThreads threads (0 = all threads in the pool).
+    /// </summary>
+    void RadixSort(T arr[],int n,int iMaxThreads = 0)
+    {
+        if (n < 2) return;
+
+        int iThreads = iMaxThreads > 0 ? (std::min)(iMaxThreads,m_cPool.GetThreads()) : m_cPool.GetThreads();
+        int iBlocks = (std::max)(1,(std::min)(iThreads,n/4096));
+        auto fnBlock = [&](int iBlock) { return (int) ((int64_t) n*iBlock/iBlocks); };
+
+        if ((int) m_vScratch.size() < n) m_vScratch.resize(n);
+        std::vector<int64_t> vCounts((size_t) iBlocks*256);
+
+        T * src = arr;
+        T * dst = m_vScratch.data();
+        for (int iPass=0;iPass<kPasses;iPass++)
+        {
+            std::fill(vCounts.begin(),vCounts.end(),0);
+            m_cPool.ParallelFor(iBlocks,[&](int iBlock,int)
+            {
+                int64_t * pCounts = vCounts.data() + (size_t) iBlock*256;
+                for (int i=fnBlock(iBlock);i<fnBlock(iBlock + 1);i++) pCounts[Digit(src[i],iPass)]++;
+            },iThreads);
+
+            // Skip the pass if all elements have the same digit
+
+            int iUsed = 0;
+            for (int d=0;d<256 && iUsed < 2;d++) for (int b=0;b<iBlocks;b++) if (vCounts[(size_t) b*256 + d]) { iUsed++; break; }
+            if (iUsed < 2) continue;
+
+            // Output offsets: by digit, then by block, so each block writes its own part of each digit's range (keeping it stable)
+
+            int64_t iOffset = 0;
+            for (int d=0;d<256;d++) for (int b=0;b<iBlocks;b++)
+            {
+                int64_t & iCount = vCounts[(size_t) b*256 + d];
+                int64_t iNext = iOffset + iCount;
+                iCount = iOffset;
+                iOffset = iNext;
+            }
+
+            m_cPool.ParallelFor(iBlocks,[&](int iBlock,int)
+            {
+                int64_t * pOffsets = vCounts.data() + (size_t) iBlock*256;
+                for (int i=fnBlock(iBlock);i<fnBlock(iBlock + 1);i++) dst[pOffsets[Digit(src[i],iPass)]++] = src[i];
+            },iThreads);
+
+            Update.Swapped(n);
+            std::swap(src,dst);
+            Update.func(0,n - 1);
+        }
+
+        if (src != arr) { memcpy(arr,src,(size_t) n*sizeof(T)); Update.Swapped(n); }
+    }
 };
 
-#endif // _SortAlgorithms_h_
\ No newline at end of file
+// The int versions used by CVisualSort are compiled once, in SortAlgorithms.cpp
+
+extern template class CMergeSort<int>;
+extern template class CQuickSort<int>;
+extern template class CHeapSort<int>;
+extern template class CShellSort<int>;
+extern template class CSelectionSort<int>;
+extern template class CParallelMergeSort<int>;
+extern template class CRadixSort<int>;
+
+#endif // _SortAlgorithms_h_
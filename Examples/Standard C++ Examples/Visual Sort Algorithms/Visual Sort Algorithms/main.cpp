@@ -16,6 +16,11 @@
 
 int main(int argc,char * argv[])
 {
+    // "-benchmark [size]" times each sort on a large array (10 million elements by default) without
+    // the window or the graph updates, and prints the results to the console.
+
+    if (argc > 1 && !_stricmp(argv[1],"-benchmark"))
+        return CVisualSort::Benchmark(argc > 2 ? atoi(argv[2]) : CVisualSort::kBenchmarkSize) ? 0 : 1;
 
     // Check if we're a console app.  We a couple things differently in the 
     // main program if we're Console or Windows
@@ -0,0 +1,285 @@
+// This file copyright(c) 2021 Rob Nelson, All Rights Reserved.    E-mail rob@projectsagebox.com for more information.
+//
+
+#pragma once
+#if !defined(_CAdaptiveLock_H_)
+#define _CAdaptiveLock_H_
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+#else
+#include <immintrin.h>
+#endif
+#include <functional>
+#include <atomic>
+#include <mutex>
+#include <condition_variable>
+#include <memory>
+#include <cstdint>
+#include <cstdio>
+
+#if !defined(_MSC_VER) && !defined(__forceinline)
+#define __forceinline inline __attribute__((always_inline))
+#endif
+
+namespace Sage
+{
+
+// CAdaptiveLock -- Small adaptive lock with the same interface as CLockProcess
+//
+// CLockProcess spins on a compare-exchange with no pause, backoff or yield, so a contended lock keeps whole cores busy.
+// CAdaptiveLock can be used in its place where a lock may be contended (CLockProcess itself is unchanged, since its layout
+// and functions are shared with the library).
+//
+// The lock is taken with one atomic compare-exchange when it is free.  When it is held, Lock() spins for a short time with
+// _mm_pause() and exponential backoff (most Sagebox locks are held for a few instructions, so this usually gets the lock without
+// a context switch), and then parks the thread until the holder unlocks, so a contended lock no longer burns whole cores.
+//
+// The lock word has three states: 0 = free, 1 = locked, 2 = locked with (possible) parked waiters.  Unlock() only wakes
+// anyone when the state was 2, so uncontended Lock()/Unlock() pairs never touch the parking lot.
+//
+// Parked threads wait on one of kParkBuckets process-wide mutex/condition pairs chosen by the lock's address, so each
+// CAdaptiveLock stays small enough to embed in any structure.
+//
+// Contention Stats:
+//
+//      EnableStats() turns on counters for this lock instance: acquisitions, contended acquisitions (the first try failed),
+//      parks, and cycles spent spinning.  The counters are updated while the lock is held, so they cost no extra atomics.
+//      GetStats() returns a copy and PrintStats() dumps them.
+//
+class CAdaptiveLock
+{
+public:
+    struct LockStats_t
+    {
+        uint64_t iAcquisitions;         // Total Lock()/FastLock() calls
+        uint64_t iContended;            // Calls where the lock was already held
+        uint64_t iParks;                // Times a thread had to sleep waiting for the lock
+        uint64_t iSpinCycles;           // Time stamp counter cycles spent spinning and waiting (contended calls only)
+    };
+
+    static constexpr int kSpinLimit     = 16;      // Spin rounds before parking
+    static constexpr int kMaxBackoff    = 64;      // Maximum _mm_pause() calls per spin round
+    static constexpr int kParkBuckets   = 64;
+
+private:
+    std::atomic<long> m_lState{0};
+    std::unique_ptr<LockStats_t> m_pStats;
+
+    struct ParkBucket_t
+    {
+        std::mutex mLock;
+        std::condition_variable cvWake;
+    };
+
+    static ParkBucket_t & GetBucket(const void * pLock)
+    {
+        static ParkBucket_t stBuckets[kParkBuckets];
+        auto uAddress = (uintptr_t) pLock;
+        return stBuckets[((uAddress >> 4) ^ (uAddress >> 10)) & (kParkBuckets-1)];
+    }
+
+    static __forceinline void Pause()
+    {
+#if defined(_M_X64) || defined(_M_IX86) || defined(__x86_64__) || defined(__i386__)
+        _mm_pause();
+#endif
+    }
+
+    static __forceinline uint64_t ReadCycles()
+    {
+#if defined(_M_X64) || defined(_M_IX86) || defined(__x86_64__) || defined(__i386__)
+        return (uint64_t) __rdtsc();
+#else
+        return 0;
+#endif
+    }
+
+    // Contended path: spin with backoff, then park.  Kept out of line so FastLock() stays a single compare-exchange.
+
+#if defined(_MSC_VER)
+    __declspec(noinline)
+#else
+    __attribute__((noinline))
+#endif
+    void LockContended()
+    {
+        uint64_t uStart = m_pStats ? ReadCycles() : 0;
+        bool bParked = false;
+
+        // Spin while the lock is held, trying again only when it looks free (so waiting threads only read the lock's cache line)
+
+        bool bAcquired = false;
+        int iBackoff = 1;
+        for (int i=0;i<kSpinLimit && !bAcquired;i++)
+        {
+            for (int j=0;j<iBackoff;j++) Pause();
+            if (iBackoff < kMaxBackoff) iBackoff *= 2;
+
+            long lExpected = 0;
+            bAcquired = m_lState.load(std::memory_order_relaxed) == 0 && m_lState.compare_exchange_strong(lExpected,1,std::memory_order_acquire);
+        }
+
+        // Park.  Setting the state to 2 tells Unlock() to wake the bucket; if the exchange returns 0, the lock was free and it's
+        // now ours (left at 2, which only costs one extra wake at Unlock()).
+        //
+        // The exchange is done with the bucket mutex held, and Unlock() takes the bucket mutex before notifying, so a wake can't
+        // be lost between the exchange and the wait.
+
+        if (!bAcquired)
+        {
+            auto & stBucket = GetBucket(this);
+            std::unique_lock<std::mutex> lock(stBucket.mLock);
+            while (m_lState.exchange(2,std::memory_order_acquire) != 0)
+            {
+                bParked = true;
+                stBucket.cvWake.wait(lock);
+            }
+        }
+
+        if (m_pStats)
+        {
+            m_pStats->iAcquisitions++;
+            m_pStats->iContended++;
+            m_pStats->iParks += bParked;
+            m_pStats->iSpinCycles += ReadCycles() - uStart;
+        }
+    }
+
+#if defined(_MSC_VER)
+    __declspec(noinline)
+#else
+    __attribute__((noinline))
+#endif
+    void Wake()
+    {
+        auto & stBucket = GetBucket(this);
+        { std::lock_guard<std::mutex> lock(stBucket.mLock); }
+
+        // Buckets are shared by locks, so wake everyone in the bucket -- waiters for other locks see their lock is still
+        // held and go back to sleep.
+
+        stBucket.cvWake.notify_all();
+    }
+
+public:
+    CAdaptiveLock() = default;
+
+    // Copying a lock creates a new, unlocked lock (the state of a lock can't be meaningfully copied)
+
+    CAdaptiveLock(const CAdaptiveLock &) { }
+    CAdaptiveLock & operator = (const CAdaptiveLock &) { return *this; }
+
+    __forceinline void Unlock()
+    {
+        if (m_lState.exchange(0,std::memory_order_release) == 2) Wake();
+    }
+
+    bool Lock()
+    {
+        return FastLock();
+    }
+
+    // Proper Use: if (FastLock()) { Locked Code } -- this is to ensure the
+    // optimizer executes the code completely before the Unlock().  Since this may not generate a call, the
+    // optimized may move some or all of the befor the Unlock() after the Unlock().  The if() above prevents this.
+    //
+    // Example:
+    //
+    // if (FastLock()) i = ++iLineCount;    // to get a line of data while it is locked.
+    // Unlock();
+    //
+    // The uncontended case is one compare-exchange with no call, so in tight cache situations, it can be useful.
+    //
+    __forceinline bool FastLock()
+    {
+        long lExpected = 0;
+        if (m_lState.compare_exchange_strong(lExpected,1,std::memory_order_acquire))
+        {
+            if (m_pStats) m_pStats->iAcquisitions++;
+        }
+        else LockContended();
+        return true;
+    }
+
+    /// <summary>
+    /// Tries to get the lock without waiting.  Returns true if the lock was taken (call Unlock() when done).
+    /// </summary>
+    __forceinline bool TryLock()
+    {
+        long lExpected = 0;
+        if (!m_lState.compare_exchange_strong(lExpected,1,std::memory_order_acquire)) return false;
+        if (m_pStats) m_pStats->iAcquisitions++;
+        return true;
+    }
+
+   // Note: MSVC does not yet have an inline lambda, so this will generate a call when optimized
+   //
+    __forceinline int Lock(std::function<int()> const & Execute)
+    {
+        int iValue = 0;
+        if (FastLock()) iValue = Execute();
+        Unlock();
+        return iValue;
+    }
+
+    // void() version of Lock(std::function<int()>...);
+    //
+    __forceinline void Lockv(std::function<void()> const & Execute)
+    {
+        if (FastLock()) Execute();
+        Unlock();
+    }
+
+    /// <summary>
+    /// Turns contention counters on or off for this lock (off by default).  Turning them on resets the counters.
+    /// <para></para>
+    /// --> This must be called when no other thread is using the lock.
+    /// </summary>
+    void EnableStats(bool bEnable = true)
+    {
+        if (!bEnable) m_pStats.reset();
+        else m_pStats.reset(new LockStats_t{});
+    }
+
+    bool isStatsEnabled() const { return m_pStats != nullptr; }
+
+    /// <summary>
+    /// Returns a copy of the contention counters (all 0 if EnableStats() has not been called).
+    /// </summary>
+    LockStats_t GetStats()
+    {
+        LockStats_t stStats{};
+        if (!m_pStats) return stStats;
+
+        FastLock();
+        stStats = *m_pStats;
+        stStats.iAcquisitions--;        // Don't count the GetStats() lock itself
+        Unlock();
+        return stStats;
+    }
+
+    void ResetStats()
+    {
+        if (!m_pStats) return;
+        FastLock();
+        *m_pStats = {};
+        Unlock();
+    }
+
+    /// <summary>
+    /// Prints the contention counters for this lock, i.e. PrintStats("DataStore").
+    /// </summary>
+    void PrintStats(const char * sName = nullptr,FILE * fOut = stdout)
+    {
+        auto stStats = GetStats();
+        double fContended = stStats.iAcquisitions ? 100.0*(double) stStats.iContended/(double) stStats.iAcquisitions : 0.0;
+        fprintf(fOut,"%s: %llu acquisitions, %llu contended (%.2f%%), %llu parks, %llu spin cycles (%.0f per contended)\n",
+                sName ? sName : "CAdaptiveLock",(unsigned long long) stStats.iAcquisitions,(unsigned long long) stStats.iContended,fContended,
+                (unsigned long long) stStats.iParks,(unsigned long long) stStats.iSpinCycles,
+                stStats.iContended ? (double) stStats.iSpinCycles/(double) stStats.iContended : 0.0);
+    }
+};
+
+} // namespace Sage
+#endif // _CAdaptiveLock_H_
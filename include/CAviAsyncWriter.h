@@ -0,0 +1,261 @@
+// This file copyright(c) 2021 Rob Nelson, All Rights Reserved.    E-mail rob@projectsagebox.com for more information.
+//
+
+#pragma once
+#if !defined(_CAviAsyncWriter_H_)
+#define _CAviAsyncWriter_H_
+
+#include "Sage.h"
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <functional>
+#include <vector>
+#include <cstring>
+#include <cstdint>
+
+namespace Sage
+{
+
+// CAviAsyncWriter -- Writes video frames on a background thread, so recording doesn't stall the caller (i.e. a render loop)
+//
+// Submit() copies the frame into one of iQueueDepth frame buffers allocated by Start(), and returns.  A writer thread
+// takes frames in order and passes them to the frame-writer function given to Start(), which does the actual (slow) writing:
+//
+//      CRawAviWriter cAvi;
+//      cAvi.Create("capture.avi",iWidth,iHeight,60);
+//      cAsync.Start(iWidth,iHeight,[&](const RawBitmap_t & stFrame) { return cAvi.WriteFrame(stFrame); });
+//      ...
+//      cAsync.Submit(cWin.GetWindowBitmap());       // Each frame, in the render loop
+//      ...
+//      cAsync.Stop();                                // Writes queued frames and ends the thread
+//      cAvi.Close();
+//
+// CAviFile::StartAsyncWrite() does the same for a CAviFile created with CreateAviFile().
+//
+// Back-pressure:
+//
+//      When all buffers are full (the writer can't keep up), Submit() either waits for a buffer (BackPressure::Block, no frames
+//      are lost) or drops the oldest queued frame to make room for the new one (BackPressure::DropOldest, the caller never
+//      waits, for live capture).
+//
+// GetStats() returns frames submitted, queued, dropped, written and failed, so dropped frames can be reported.
+//
+class CAviAsyncWriter
+{
+public:
+    enum class BackPressure
+    {
+        Block,              // Submit() waits for a free buffer
+        DropOldest,         // Submit() drops the oldest queued frame
+    };
+
+    struct Options_t
+    {
+        int iQueueDepth             = 4;                        // Frame buffers (minimum 2)
+        BackPressure eBackPressure  = BackPressure::Block;
+    };
+
+    struct Stats_t
+    {
+        uint64_t iSubmitted;        // Frames given to Submit()
+        uint64_t iWritten;          // Frames written successfully
+        uint64_t iDropped;          // Frames dropped by BackPressure::DropOldest
+        uint64_t iErrors;           // Frames the frame-writer function returned false for
+        int iQueued;                // Frames waiting to be written now
+        int iMaxQueued;             // Most frames ever waiting at once
+    };
+
+    using FrameWriter = std::function<bool(const RawBitmap_t & stFrame)>;
+
+private:
+    std::thread m_cThread;
+    std::mutex m_mLock;
+    std::condition_variable m_cvFrame;          // Signals the writer: frame queued or stopping
+    std::condition_variable m_cvSpace;          // Signals Submit()/Flush(): buffer freed
+
+    FrameWriter m_fnWrite;
+    Options_t m_stOptions;
+    Stats_t m_stStats{};
+
+    std::vector<std::vector<unsigned char>> m_vBuffers;
+    std::vector<int> m_vFree;                   // Free buffer indexes
+    std::vector<int> m_vQueue;                  // Ring of queued buffer indexes, oldest at m_iQueueHead
+    int m_iQueueHead    = 0;
+    int m_iQueueCount   = 0;
+    int m_iWriting      = 0;                    // 1 while the writer thread is writing a frame
+
+    int m_iWidth        = 0;
+    int m_iHeight       = 0;
+    int m_iWidthBytes   = 0;
+    bool m_bStop        = false;
+    bool m_bRunning     = false;
+
+    RawBitmap_t GetFrame(int iBuffer)
+    {
+        RawBitmap_t stFrame{};
+        stFrame.iWidth      = m_iWidth;
+        stFrame.iHeight     = m_iHeight;
+        stFrame.iWidthBytes = m_iWidthBytes;
+        stFrame.iOverHang   = m_iWidthBytes - m_iWidth*3;
+        stFrame.iTotalSize  = m_iWidthBytes*m_iHeight;
+        stFrame.stMem       = m_vBuffers[iBuffer].data();
+        return stFrame;
+    }
+
+    void Writer()
+    {
+        std::unique_lock<std::mutex> lock(m_mLock);
+        for (;;)
+        {
+            m_cvFrame.wait(lock,[&] { return m_bStop || m_iQueueCount; });
+            if (!m_iQueueCount) return;         // Stopping, and everything is written
+
+            int iBuffer = m_vQueue[m_iQueueHead];
+            m_iQueueHead = (m_iQueueHead + 1) % (int) m_vQueue.size();
+            m_iQueueCount--;
+            m_iWriting = 1;
+            lock.unlock();
+
+            bool bResult = m_fnWrite(GetFrame(iBuffer));
+
+            lock.lock();
+            if (bResult) m_stStats.iWritten++;
+            else m_stStats.iErrors++;
+            m_iWriting = 0;
+            m_vFree.push_back(iBuffer);
+            m_cvSpace.notify_all();
+        }
+    }
+
+public:
+    CAviAsyncWriter() = default;
+    ~CAviAsyncWriter() { Stop(); }
+
+    CAviAsyncWriter(const CAviAsyncWriter &) = delete;
+    CAviAsyncWriter & operator = (const CAviAsyncWriter &) = delete;
+
+    /// <summary>
+    /// Allocates the frame buffers and starts the writer thread.  fnWrite is called on the writer thread for each frame, in order.
+    /// </summary>
+    /// <param name="iWidth"> - Frame width (frames given to Submit() must be this size)</param>
+    /// <param name="iHeight"> - Frame height</param>
+    /// <param name="fnWrite"> - Frame-writer function, returning false if the frame could not be written</param>
+    /// <param name="stOptions"> - Queue depth and back-pressure policy (defaults are used when not given)</param>
+    /// <returns>false if already running or the sizes are invalid</returns>
+    bool Start(int iWidth,int iHeight,FrameWriter fnWrite,const Options_t & stOptions)
+    {
+        if (m_bRunning || iWidth <= 0 || iHeight <= 0 || !fnWrite) return false;
+
+        m_stOptions     = stOptions;
+        if (m_stOptions.iQueueDepth < 2) m_stOptions.iQueueDepth = 2;
+
+        m_fnWrite       = std::move(fnWrite);
+        m_iWidth        = iWidth;
+        m_iHeight       = iHeight;
+        m_iWidthBytes   = (iWidth*3 + 3) & ~3;
+
+        m_vBuffers.assign(m_stOptions.iQueueDepth,std::vector<unsigned char>((size_t) m_iWidthBytes*iHeight));
+        m_vQueue.assign(m_stOptions.iQueueDepth,0);
+        m_vFree.clear();
+        for (int i=m_stOptions.iQueueDepth-1;i>=0;i--) m_vFree.push_back(i);
+
+        m_iQueueHead    = 0;
+        m_iQueueCount   = 0;
+        m_iWriting      = 0;
+        m_stStats       = {};
+        m_bStop         = false;
+        m_bRunning      = true;
+
+        m_cThread = std::thread([this] { Writer(); });
+        return true;
+    }
+
+    bool Start(int iWidth,int iHeight,FrameWriter fnWrite) { return Start(iWidth,iHeight,std::move(fnWrite),Options_t()); }
+
+    /// <summary>
+    /// Copies stFrame into a frame buffer and queues it for the writer thread.  With BackPressure::Block this waits if all buffers
+    /// are in use; with BackPressure::DropOldest the oldest queued frame is dropped instead.
+    /// </summary>
+    /// <returns>false if the writer is not running or stFrame is not the size given to Start()</returns>
+    bool Submit(const RawBitmap_t & stFrame)
+    {
+        if (!stFrame.stMem || stFrame.iWidth != m_iWidth || stFrame.iHeight != m_iHeight) return false;
+
+        int iBuffer;
+        {
+            std::unique_lock<std::mutex> lock(m_mLock);
+            if (!m_bRunning || m_bStop) return false;
+            m_stStats.iSubmitted++;
+
+            if (m_vFree.empty() && m_stOptions.eBackPressure == BackPressure::DropOldest && m_iQueueCount)
+            {
+                m_vFree.push_back(m_vQueue[m_iQueueHead]);
+                m_iQueueHead = (m_iQueueHead + 1) % (int) m_vQueue.size();
+                m_iQueueCount--;
+                m_stStats.iDropped++;
+            }
+
+            // With DropOldest, this only waits when every buffer is being filled by another Submit() call
+
+            m_cvSpace.wait(lock,[&] { return !m_vFree.empty(); });
+            iBuffer = m_vFree.back();
+            m_vFree.pop_back();
+        }
+
+        // Copy outside of the lock -- the buffer belongs to this call until it's queued
+
+        auto stDest = GetFrame(iBuffer);
+        for (int y=0;y<m_iHeight;y++) memcpy(stDest.stMem + (size_t) y*m_iWidthBytes,stFrame.stMem + (size_t) y*stFrame.iWidthBytes,m_iWidth*3);
+
+        std::lock_guard<std::mutex> lock(m_mLock);
+        m_vQueue[(m_iQueueHead + m_iQueueCount) % (int) m_vQueue.size()] = iBuffer;
+        m_iQueueCount++;
+        if (m_iQueueCount > m_stStats.iMaxQueued) m_stStats.iMaxQueued = m_iQueueCount;
+        m_cvFrame.notify_one();
+        return true;
+    }
+
+    /// <summary>
+    /// Waits until every queued frame has been written.
+    /// </summary>
+    void Flush()
+    {
+        std::unique_lock<std::mutex> lock(m_mLock);
+        m_cvSpace.wait(lock,[&] { return !m_bRunning || (!m_iQueueCount && !m_iWriting && (int) m_vFree.size() == m_stOptions.iQueueDepth); });
+    }
+
+    /// <summary>
+    /// Writes all queued frames and stops the writer thread.  Returns true if every frame was written successfully.
+    /// </summary>
+    bool Stop()
+    {
+        if (!m_bRunning) return true;
+        Flush();
+        {
+            std::lock_guard<std::mutex> lock(m_mLock);
+            m_bStop = true;
+        }
+        m_cvFrame.notify_one();
+        m_cThread.join();
+
+        std::lock_guard<std::mutex> lock(m_mLock);
+        m_bRunning = false;
+        m_vBuffers.clear();
+        m_vBuffers.shrink_to_fit();
+        return !m_stStats.iErrors;
+    }
+
+    bool isRunning() const { return m_bRunning; }
+
+    Stats_t GetStats()
+    {
+        std::lock_guard<std::mutex> lock(m_mLock);
+        auto stStats = m_stStats;
+        stStats.iQueued = m_iQueueCount;
+        return stStats;
+    }
+};
+
+} // namespace Sage
+#endif // _CAviAsyncWriter_H_
@@ -11,6 +11,7 @@
 
 #include "CSageBox.h"
 #include <vfw.h>
+#include "CAviAsyncWriter.h"
 
 namespace Sage
 {
@@ -179,6 +180,19 @@ public:
     //
     Status  WriteFrame(CBitmap & cBitmap);
 
+    // StartAsyncWrite() -- Write frames on a background thread, so WriteFrame() doesn't stall the caller (i.e. recording
+    //                      a window at 60fps).  Call after CreateAviFile().  Frames given to cWriter.Submit() are copied
+    //                      into a ring of frame buffers and written with WriteFrame() on cWriter's thread.
+    //
+    // stOptions sets the number of frame buffers and whether Submit() waits or drops the oldest frame when they are full.
+    // Call cWriter.Stop() before CloseFile().  See CAviAsyncWriter.h
+    //
+    bool StartAsyncWrite(CAviAsyncWriter & cWriter,const CAviAsyncWriter::Options_t & stOptions = CAviAsyncWriter::Options_t())
+    {
+        SIZE szSize = GetFrameSize();
+        return cWriter.Start((int) szSize.cx,(int) szSize.cy,[this](const RawBitmap_t & stFrame) { return WriteFrame(stFrame.stMem,true) == Status::Ok; },stOptions);
+    }
+
     // ReadFrame() -- Read a frame of the avi into a bitmap buffer
     //
     // iFrameID         -- Which frame to read
@@ -0,0 +1,504 @@
+// This file copyright(c) 2021 Rob Nelson, All Rights Reserved.    E-mail rob@projectsagebox.com for more information.
+//
+
+// CBlendKernels -- Runtime-dispatched SIMD kernels for RawBitmap_t mask/blend operations.
+//
+// The ApplyMaskGraphic(), ApplyMaskGraphic8(), ApplyMaskGraphicR() and ApplyMaskColor() family all reduce to the same
+// per-byte operation on 24-bit interleaved (BGR) data:
+//
+//      Dest = (Source*Mask + Background*(255-Mask))/255     (rounded to nearest)
+//
+// CBlendKernels implements this one operation as a set of kernels (Scalar, SSE2, AVX2, AVX-512BW) and picks the best one
+// the CPU supports the first time it is used, via the Sage::CCpuID probes in InstructionSet.h.  The RawBitmap_t-level
+// functions below clip the rectangles, walk the rows and hand each row (in chunks) to the selected kernel.
+//
+// All kernels produce bit-identical results, so the selected kernel can be overridden (i.e. SetKernel()) for testing and
+// benchmarking without changing output.
+//
+// Mask Types
+//
+//      ApplyMaskGraphic()  -- Mask is a 24-bit RawBitmap_t with a separate mask value for each channel
+//      ApplyMaskGraphic8() -- Mask is a 24-bit RawBitmap_t where only the first byte (Blue) of each pixel is used as
+//                             the mask for all three channels (i.e. a grayscale mask)
+//      ApplyMaskColor()    -- A solid color is blended into the destination through a 24-bit mask
+//
+//      "R" versions (ApplyMaskGraphicR(), ApplyMaskColorR()) read the source and mask rows in reverse (bottom-up) order,
+//      for use with reversed bitmaps (see RawBitmap_t::ReverseBitmap())
+//
+//      Versions without a mask bitmap use the source's own mask (RawBitmap_t::sMask, see CBitmap::GetMaskMem()): one byte per
+//      pixel, iWidth bytes per row, used for all three channels.
+//
+// CBitmap's ApplyMaskGraphic(), ApplyMaskGraphicR(), ApplyMaskColor() and ApplyMaskColorR() (CRawBitmap.h) call these functions,
+// so existing code gets the selected kernel without changes.  The RawBitmap_t members and free functions in Sage.h are
+// compiled into the library and still use the library's own code.
+//
+
+#pragma once
+
+#if !defined(_CBlendKernels_H_)
+#define _CBlendKernels_H_
+
+#include "Sage.h"
+#include "InstructionSet.h"
+#include <cstddef>
+#include <initializer_list>
+#include <emmintrin.h>
+#include <immintrin.h>
+
+// Per-function instruction set targets.  MSVC allows any intrinsic in any function, where GCC and Clang
+// need the target declared on the function that uses it.
+
+#if !defined(_MSC_VER) && !defined(__forceinline)
+#define __forceinline inline __attribute__((always_inline))
+#endif
+
+#if defined(_MSC_VER)
+#define __sagetarget_avx2
+#define __sagetarget_avx512
+#else
+#define __sagetarget_avx2       __attribute__((target("avx2")))
+#define __sagetarget_avx512     __attribute__((target("avx512f,avx512bw")))
+#endif
+
+namespace Sage
+{
+
+class CBlendKernels
+{
+public:
+    enum class KernelType
+    {
+        Scalar,
+        SSE2,
+        AVX2,
+        AVX512,
+        Auto,       // Used with SetKernel() to return to the CPU-selected kernel
+    };
+
+    // Blend iNumBytes bytes: sDest[i] = (sSource[i]*sMask[i] + sBackground[i]*(255-sMask[i]))/255
+    //
+    // sDest may be the same memory as sSource or sBackground.
+    //
+    using BlendFunc = void (*)(const unsigned char * sSource,const unsigned char * sBackground,const unsigned char * sMask,unsigned char * sDest,size_t iNumBytes);
+
+    struct Kernel_t
+    {
+        KernelType      eType;
+        const char    * sName;
+        BlendFunc       fnBlend;
+    };
+
+    static constexpr int kChunkPixels = 1024;       // Pixels processed per kernel call when a mask or color row must be expanded
+
+private:
+
+    // Exact round-to-nearest of (x/255) for 0 <= x <= 65025, in integer-only form: (x + 128 + ((x + 128) >> 8)) >> 8
+
+    static __forceinline unsigned char Div255(unsigned int x) { x += 128; return (unsigned char) ((x + (x >> 8)) >> 8); }
+
+    static __forceinline __m128i Blend16_SSE2(__m128i s,__m128i b,__m128i m,__m128i v255,__m128i v128)
+    {
+        __m128i t = _mm_add_epi16(_mm_mullo_epi16(s,m),_mm_mullo_epi16(b,_mm_sub_epi16(v255,m)));
+        t = _mm_add_epi16(t,v128);
+        return _mm_srli_epi16(_mm_add_epi16(t,_mm_srli_epi16(t,8)),8);
+    }
+
+    __sagetarget_avx2 static __forceinline __m256i Blend16_AVX2(__m256i s,__m256i b,__m256i m,__m256i v255,__m256i v128)
+    {
+        __m256i t = _mm256_add_epi16(_mm256_mullo_epi16(s,m),_mm256_mullo_epi16(b,_mm256_sub_epi16(v255,m)));
+        t = _mm256_add_epi16(t,v128);
+        return _mm256_srli_epi16(_mm256_add_epi16(t,_mm256_srli_epi16(t,8)),8);
+    }
+
+    __sagetarget_avx512 static __forceinline __m512i Blend16_AVX512(__m512i s,__m512i b,__m512i m,__m512i v255,__m512i v128)
+    {
+        __m512i t = _mm512_add_epi16(_mm512_mullo_epi16(s,m),_mm512_mullo_epi16(b,_mm512_sub_epi16(v255,m)));
+        t = _mm512_add_epi16(t,v128);
+        return _mm512_srli_epi16(_mm512_add_epi16(t,_mm512_srli_epi16(t,8)),8);
+    }
+
+public:
+
+    static void BlendScalar(const unsigned char * sSource,const unsigned char * sBackground,const unsigned char * sMask,unsigned char * sDest,size_t iNumBytes)
+    {
+        for (size_t i=0;i<iNumBytes;i++)
+        {
+            unsigned int m = sMask[i];
+            sDest[i] = Div255(sSource[i]*m + sBackground[i]*(255-m));
+        }
+    }
+
+    static void BlendSSE2(const unsigned char * sSource,const unsigned char * sBackground,const unsigned char * sMask,unsigned char * sDest,size_t iNumBytes)
+    {
+        const __m128i vZero = _mm_setzero_si128();
+        const __m128i v255  = _mm_set1_epi16(255);
+        const __m128i v128  = _mm_set1_epi16(128);
+
+        size_t i = 0;
+        for (;i+16<=iNumBytes;i+=16)
+        {
+            __m128i s = _mm_loadu_si128((const __m128i *) (sSource+i));
+            __m128i b = _mm_loadu_si128((const __m128i *) (sBackground+i));
+            __m128i m = _mm_loadu_si128((const __m128i *) (sMask+i));
+
+            __m128i lo = Blend16_SSE2(_mm_unpacklo_epi8(s,vZero),_mm_unpacklo_epi8(b,vZero),_mm_unpacklo_epi8(m,vZero),v255,v128);
+            __m128i hi = Blend16_SSE2(_mm_unpackhi_epi8(s,vZero),_mm_unpackhi_epi8(b,vZero),_mm_unpackhi_epi8(m,vZero),v255,v128);
+            _mm_storeu_si128((__m128i *) (sDest+i),_mm_packus_epi16(lo,hi));
+        }
+        if (i < iNumBytes) BlendScalar(sSource+i,sBackground+i,sMask+i,sDest+i,iNumBytes-i);
+    }
+
+    // Note: unpack and pack work within each 128-bit lane for AVX2 and AVX-512, so the byte order
+    //       comes back out the same way it went in and no permute is needed.
+
+    __sagetarget_avx2 static void BlendAVX2(const unsigned char * sSource,const unsigned char * sBackground,const unsigned char * sMask,unsigned char * sDest,size_t iNumBytes)
+    {
+        const __m256i vZero = _mm256_setzero_si256();
+        const __m256i v255  = _mm256_set1_epi16(255);
+        const __m256i v128  = _mm256_set1_epi16(128);
+
+        size_t i = 0;
+        for (;i+32<=iNumBytes;i+=32)
+        {
+            __m256i s = _mm256_loadu_si256((const __m256i *) (sSource+i));
+            __m256i b = _mm256_loadu_si256((const __m256i *) (sBackground+i));
+            __m256i m = _mm256_loadu_si256((const __m256i *) (sMask+i));
+
+            __m256i lo = Blend16_AVX2(_mm256_unpacklo_epi8(s,vZero),_mm256_unpacklo_epi8(b,vZero),_mm256_unpacklo_epi8(m,vZero),v255,v128);
+            __m256i hi = Blend16_AVX2(_mm256_unpackhi_epi8(s,vZero),_mm256_unpackhi_epi8(b,vZero),_mm256_unpackhi_epi8(m,vZero),v255,v128);
+            _mm256_storeu_si256((__m256i *) (sDest+i),_mm256_packus_epi16(lo,hi));
+        }
+        if (i < iNumBytes) BlendSSE2(sSource+i,sBackground+i,sMask+i,sDest+i,iNumBytes-i);
+    }
+
+    __sagetarget_avx512 static void BlendAVX512(const unsigned char * sSource,const unsigned char * sBackground,const unsigned char * sMask,unsigned char * sDest,size_t iNumBytes)
+    {
+        const __m512i vZero = _mm512_setzero_si512();
+        const __m512i v255  = _mm512_set1_epi16(255);
+        const __m512i v128  = _mm512_set1_epi16(128);
+
+        size_t i = 0;
+        for (;i+64<=iNumBytes;i+=64)
+        {
+            __m512i s = _mm512_loadu_si512((const void *) (sSource+i));
+            __m512i b = _mm512_loadu_si512((const void *) (sBackground+i));
+            __m512i m = _mm512_loadu_si512((const void *) (sMask+i));
+
+            __m512i lo = Blend16_AVX512(_mm512_unpacklo_epi8(s,vZero),_mm512_unpacklo_epi8(b,vZero),_mm512_unpacklo_epi8(m,vZero),v255,v128);
+            __m512i hi = Blend16_AVX512(_mm512_unpackhi_epi8(s,vZero),_mm512_unpackhi_epi8(b,vZero),_mm512_unpackhi_epi8(m,vZero),v255,v128);
+            _mm512_storeu_si512((void *) (sDest+i),_mm512_packus_epi16(lo,hi));
+        }
+
+        // Remainder with a masked load/store rather than dropping to the narrower kernels
+
+        if (i < iNumBytes)
+        {
+            __mmask64 kMask = _cvtu64_mask64(~0ULL >> (64 - (iNumBytes-i)));
+            __m512i s = _mm512_maskz_loadu_epi8(kMask,sSource+i);
+            __m512i b = _mm512_maskz_loadu_epi8(kMask,sBackground+i);
+            __m512i m = _mm512_maskz_loadu_epi8(kMask,sMask+i);
+
+            __m512i lo = Blend16_AVX512(_mm512_unpacklo_epi8(s,vZero),_mm512_unpacklo_epi8(b,vZero),_mm512_unpacklo_epi8(m,vZero),v255,v128);
+            __m512i hi = Blend16_AVX512(_mm512_unpackhi_epi8(s,vZero),_mm512_unpackhi_epi8(b,vZero),_mm512_unpackhi_epi8(m,vZero),v255,v128);
+            _mm512_mask_storeu_epi8(sDest+i,kMask,_mm512_packus_epi16(lo,hi));
+        }
+    }
+
+    /// <summary>
+    /// Returns the kernel for the given type, or nullptr if the CPU does not support it.
+    /// <para></para>
+    /// --> KernelType::Auto returns the kernel selected for this CPU (same as GetKernel() with no parameters)
+    /// </summary>
+    static const Kernel_t * GetKernel(KernelType eType)
+    {
+        static const Kernel_t stKernels[] =
+        {
+            { KernelType::Scalar,  "Scalar",  BlendScalar },
+            { KernelType::SSE2,    "SSE2",    BlendSSE2   },
+            { KernelType::AVX2,    "AVX2",    BlendAVX2   },
+            { KernelType::AVX512,  "AVX-512", BlendAVX512 },
+        };
+
+        switch (eType)
+        {
+            case KernelType::Scalar:    return &stKernels[0];
+            case KernelType::SSE2:      return CCpuID::SSE2()     ? &stKernels[1] : nullptr;
+            case KernelType::AVX2:      return CCpuID::AVX2()     ? &stKernels[2] : nullptr;
+            case KernelType::AVX512:    return CCpuID::AVX512BW() ? &stKernels[3] : nullptr;
+            default:
+                break;
+        }
+
+        // Auto -- pick the widest supported kernel.  This is only evaluated once.
+
+        static const Kernel_t * stBest = []()
+        {
+            for (auto eTry : { KernelType::AVX512, KernelType::AVX2, KernelType::SSE2 })
+                if (auto stKernel = GetKernel(eTry)) return stKernel;
+            return &stKernels[0];
+        }();
+
+        return stBest;
+    }
+
+private:
+    static inline const Kernel_t * m_stOverride = nullptr;
+public:
+
+    /// <summary>
+    /// Returns the kernel currently used by the CBlendKernels bitmap functions.
+    /// </summary>
+    static __forceinline const Kernel_t & GetKernel() { return m_stOverride ? *m_stOverride : *GetKernel(KernelType::Auto); }
+
+    /// <summary>
+    /// Forces a specific kernel to be used (i.e. for testing or benchmarking).  Use KernelType::Auto to return to the CPU-selected kernel.
+    /// <para></para>
+    /// --> This is a process-wide setting and is not meant to be changed while other threads are blending.
+    /// </summary>
+    /// <returns>false if the CPU does not support the requested kernel (the current kernel is not changed)</returns>
+    static bool SetKernel(KernelType eType)
+    {
+        if (eType == KernelType::Auto) { m_stOverride = nullptr; return true; }
+        auto stKernel = GetKernel(eType);
+        if (stKernel) m_stOverride = stKernel;
+        return stKernel != nullptr;
+    }
+
+private:
+
+    // Clip a source/dest rectangle pair to both bitmaps.  Returns false if nothing is left to draw.
+
+    static bool ClipRect(const RawBitmap_t & stSource,POINT & pSourceStart,const RawBitmap_t & stDest,POINT & pDestStart,SIZE & szSize)
+    {
+        if (!stSource.stMem || !stDest.stMem) return false;
+        if (szSize.cx <= 0 || szSize.cy <= 0) szSize = { stSource.iWidth - pSourceStart.x, stSource.iHeight - pSourceStart.y };
+
+        if (pSourceStart.x < 0) { szSize.cx += pSourceStart.x; pDestStart.x -= pSourceStart.x; pSourceStart.x = 0; }
+        if (pSourceStart.y < 0) { szSize.cy += pSourceStart.y; pDestStart.y -= pSourceStart.y; pSourceStart.y = 0; }
+        if (pDestStart.x < 0)   { szSize.cx += pDestStart.x; pSourceStart.x -= pDestStart.x; pDestStart.x = 0; }
+        if (pDestStart.y < 0)   { szSize.cy += pDestStart.y; pSourceStart.y -= pDestStart.y; pDestStart.y = 0; }
+
+        if (pSourceStart.x + szSize.cx > stSource.iWidth)   szSize.cx = stSource.iWidth - pSourceStart.x;
+        if (pSourceStart.y + szSize.cy > stSource.iHeight)  szSize.cy = stSource.iHeight - pSourceStart.y;
+        if (pDestStart.x + szSize.cx > stDest.iWidth)       szSize.cx = stDest.iWidth - pDestStart.x;
+        if (pDestStart.y + szSize.cy > stDest.iHeight)      szSize.cy = stDest.iHeight - pDestStart.y;
+
+        return szSize.cx > 0 && szSize.cy > 0;
+    }
+
+    static __forceinline bool SameSize(const RawBitmap_t & st1,const RawBitmap_t & st2)
+    {
+        return st1.stMem && st2.stMem && st1.iWidth == st2.iWidth && st1.iHeight == st2.iHeight;
+    }
+
+    // Expand the first byte of each 24-bit mask pixel to all three channels
+
+    static __forceinline void ExpandMask8(const unsigned char * sMask,unsigned char * sOut,int iPixels)
+    {
+        for (int i=0;i<iPixels;i++,sMask += 3,sOut += 3) sOut[0] = sOut[1] = sOut[2] = *sMask;
+    }
+
+    // Expand each byte of a bitmap's own (8-bit) mask to all three channels
+
+    static __forceinline void ExpandAlpha(const unsigned char * sMask,unsigned char * sOut,int iPixels)
+    {
+        for (int i=0;i<iPixels;i++,sOut += 3) sOut[0] = sOut[1] = sOut[2] = sMask[i];
+    }
+
+    // Blends one row of iPixels pixels through an 8-bit mask, in chunks
+
+    static void BlendRowAlpha(BlendFunc fnBlend,const unsigned char * sSource,const unsigned char * sBackground,const unsigned char * sMask,unsigned char * sDest,int iPixels)
+    {
+        alignas(64) unsigned char sMaskRow[kChunkPixels*3];
+        for (int x=0;x<iPixels;x += kChunkPixels)
+        {
+            int iChunk = iPixels - x < kChunkPixels ? iPixels - x : kChunkPixels;
+            ExpandAlpha(sMask + x,sMaskRow,iChunk);
+            fnBlend(sSource + x*3,sBackground + x*3,sMaskRow,sDest + x*3,(size_t) iChunk*3);
+        }
+    }
+
+public:
+
+    /// <summary>
+    /// Blends stSource over stBackground through a 24-bit (per-channel) mask, writing to stDest.  All bitmaps must be the same size.
+    /// <para></para>
+    /// --> stDest may be the same bitmap as stSource or stBackground.
+    /// </summary>
+    static bool ApplyMaskGraphic(RawBitmap_t & stSource,RawBitmap_t & stBackground,RawBitmap_t & stDest,RawBitmap_t & stMask)
+    {
+        if (!SameSize(stSource,stBackground) || !SameSize(stSource,stDest) || !SameSize(stSource,stMask)) return false;
+
+        auto fnBlend    = GetKernel().fnBlend;
+        size_t iBytes   = (size_t) stSource.iWidth*3;
+
+        for (int i=0;i<stSource.iHeight;i++)
+            fnBlend(stSource.stMem + (size_t) i*stSource.iWidthBytes,stBackground.stMem + (size_t) i*stBackground.iWidthBytes,
+                    stMask.stMem + (size_t) i*stMask.iWidthBytes,stDest.stMem + (size_t) i*stDest.iWidthBytes,iBytes);
+        return true;
+    }
+
+    /// <summary>
+    /// Blends stSource over stBackground through a grayscale mask, writing to stDest.  All bitmaps must be the same size.
+    /// <para></para>
+    /// --> Only the first byte of each mask pixel is used, as the mask value for all three channels.
+    /// </summary>
+    static bool ApplyMaskGraphic8(RawBitmap_t & stSource,RawBitmap_t & stBackground,RawBitmap_t & stDest,RawBitmap_t & stMask)
+    {
+        if (!SameSize(stSource,stBackground) || !SameSize(stSource,stDest) || !SameSize(stSource,stMask)) return false;
+
+        auto fnBlend = GetKernel().fnBlend;
+        alignas(64) unsigned char sMaskRow[kChunkPixels*3];
+
+        for (int i=0;i<stSource.iHeight;i++)
+        {
+            size_t iSourceRow   = (size_t) i*stSource.iWidthBytes;
+            size_t iBgRow       = (size_t) i*stBackground.iWidthBytes;
+            size_t iDestRow     = (size_t) i*stDest.iWidthBytes;
+            size_t iMaskRow     = (size_t) i*stMask.iWidthBytes;
+
+            for (int x=0;x<stSource.iWidth;x += kChunkPixels)
+            {
+                int iPixels = stSource.iWidth - x < kChunkPixels ? stSource.iWidth - x : kChunkPixels;
+                ExpandMask8(stMask.stMem + iMaskRow + x*3,sMaskRow,iPixels);
+                fnBlend(stSource.stMem + iSourceRow + x*3,stBackground.stMem + iBgRow + x*3,sMaskRow,stDest.stMem + iDestRow + x*3,(size_t) iPixels*3);
+            }
+        }
+        return true;
+    }
+
+    /// <summary>
+    /// Blends a rectangle of stSource into stDest (in-place) through a 24-bit mask that has the same size and position as stSource.
+    /// <para></para>
+    /// --> szSize of {0,0} uses the remaining size of stSource from pSourceStart.  The rectangle is clipped to both bitmaps.
+    /// <para></para>
+    /// --> When bReversed is true, source and mask rows are read bottom-up (this is ApplyMaskGraphicR())
+    /// </summary>
+    static bool ApplyMaskGraphic(RawBitmap_t & stSource,RawBitmap_t & stMask,POINT pSourceStart,RawBitmap_t & stDest,POINT pDestStart,SIZE szSize = { 0,0 },bool bReversed = false)
+    {
+        if (!SameSize(stSource,stMask)) return false;
+        if (!ClipRect(stSource,pSourceStart,stDest,pDestStart,szSize)) return true;      // Nothing to draw is not an error
+
+        auto fnBlend    = GetKernel().fnBlend;
+        size_t iBytes   = (size_t) szSize.cx*3;
+
+        for (int i=0;i<szSize.cy;i++)
+        {
+            int iSourceY = bReversed ? stSource.iHeight-1 - (pSourceStart.y + i) : pSourceStart.y + i;
+            size_t iSourceOffset = (size_t) iSourceY*stSource.iWidthBytes + pSourceStart.x*3;
+            size_t iMaskOffset   = (size_t) iSourceY*stMask.iWidthBytes + pSourceStart.x*3;
+            unsigned char * sDest = stDest.stMem + (size_t) (pDestStart.y + i)*stDest.iWidthBytes + pDestStart.x*3;
+
+            fnBlend(stSource.stMem + iSourceOffset,sDest,stMask.stMem + iMaskOffset,sDest,iBytes);
+        }
+        return true;
+    }
+
+    /// <summary>
+    /// Same as ApplyMaskGraphic() with a position and size, but reads the source and mask bottom-up (i.e. for reversed bitmaps)
+    /// </summary>
+    static __forceinline bool ApplyMaskGraphicR(RawBitmap_t & stSource,RawBitmap_t & stMask,POINT pSourceStart,RawBitmap_t & stDest,POINT pDestStart,SIZE szSize = { 0,0 })
+    {
+        return ApplyMaskGraphic(stSource,stMask,pSourceStart,stDest,pDestStart,szSize,true);
+    }
+
+    /// <summary>
+    /// Blends stSource over stBackground through stSource's own mask (sMask), writing to stDest.  All bitmaps must be the same size.
+    /// <para></para>
+    /// --> Returns false if stSource has no mask.  stDest may be the same bitmap as stSource or stBackground.
+    /// </summary>
+    static bool ApplyMaskGraphic(RawBitmap_t & stSource,RawBitmap_t & stBackground,RawBitmap_t & stDest)
+    {
+        if (!stSource.sMask || !SameSize(stSource,stBackground) || !SameSize(stSource,stDest)) return false;
+
+        auto fnBlend = GetKernel().fnBlend;
+
+        for (int i=0;i<stSource.iHeight;i++)
+            BlendRowAlpha(fnBlend,stSource.stMem + (size_t) i*stSource.iWidthBytes,stBackground.stMem + (size_t) i*stBackground.iWidthBytes,
+                          stSource.sMask + (size_t) i*stSource.iWidth,stDest.stMem + (size_t) i*stDest.iWidthBytes,stSource.iWidth);
+        return true;
+    }
+
+    /// <summary>
+    /// Blends a rectangle of stSource into stDest (in-place) through stSource's own mask (sMask).
+    /// <para></para>
+    /// --> szSize of {0,0} uses the remaining size of stSource from pSourceStart.  The rectangle is clipped to both bitmaps.
+    /// <para></para>
+    /// --> When bReversed is true, source and mask rows are read bottom-up (this is ApplyMaskGraphicR())
+    /// </summary>
+    static bool ApplyMaskGraphic(RawBitmap_t & stSource,POINT pSourceStart,RawBitmap_t & stDest,POINT pDestStart,SIZE szSize = { 0,0 },bool bReversed = false)
+    {
+        if (!stSource.sMask) return false;
+        if (!ClipRect(stSource,pSourceStart,stDest,pDestStart,szSize)) return true;      // Nothing to draw is not an error
+
+        auto fnBlend = GetKernel().fnBlend;
+
+        for (int i=0;i<szSize.cy;i++)
+        {
+            int iSourceY = bReversed ? stSource.iHeight-1 - (pSourceStart.y + i) : pSourceStart.y + i;
+            unsigned char * sDest = stDest.stMem + (size_t) (pDestStart.y + i)*stDest.iWidthBytes + pDestStart.x*3;
+
+            BlendRowAlpha(fnBlend,stSource.stMem + (size_t) iSourceY*stSource.iWidthBytes + pSourceStart.x*3,sDest,
+                          stSource.sMask + (size_t) iSourceY*stSource.iWidth + pSourceStart.x,sDest,szSize.cx);
+        }
+        return true;
+    }
+
+    /// <summary>
+    /// Same as ApplyMaskGraphic() with stSource's own mask, but reads the source and mask bottom-up (i.e. for reversed bitmaps)
+    /// </summary>
+    static __forceinline bool ApplyMaskGraphicR(RawBitmap_t & stSource,POINT pSourceStart,RawBitmap_t & stDest,POINT pDestStart,SIZE szSize = { 0,0 })
+    {
+        return ApplyMaskGraphic(stSource,pSourceStart,stDest,pDestStart,szSize,true);
+    }
+
+    /// <summary>
+    /// Blends a solid color into stDest (in-place) through a 24-bit (per-channel) mask.
+    /// <para></para>
+    /// --> szSize of {0,0} uses the remaining size of stMask from pMaskStart.  The rectangle is clipped to both bitmaps.
+    /// <para></para>
+    /// --> When bReversed is true, mask rows are read bottom-up (this is ApplyMaskColorR())
+    /// </summary>
+    static bool ApplyMaskColor(RGBColor_t rgbColor,RawBitmap_t & stMask,POINT pMaskStart,RawBitmap_t & stDest,POINT pDestStart,SIZE szSize = { 0,0 },bool bReversed = false)
+    {
+        if (!ClipRect(stMask,pMaskStart,stDest,pDestStart,szSize)) return stMask.stMem && stDest.stMem;
+
+        auto fnBlend = GetKernel().fnBlend;
+
+        // Build one chunk's worth of the color in BGR order, then blend against it as a source row.
+
+        alignas(64) unsigned char sColorRow[kChunkPixels*3];
+        for (int i=0;i<kChunkPixels;i++)
+        {
+            sColorRow[i*3+0] = (unsigned char) rgbColor.iBlue;
+            sColorRow[i*3+1] = (unsigned char) rgbColor.iGreen;
+            sColorRow[i*3+2] = (unsigned char) rgbColor.iRed;
+        }
+
+        for (int i=0;i<szSize.cy;i++)
+        {
+            int iMaskY = bReversed ? stMask.iHeight-1 - (pMaskStart.y + i) : pMaskStart.y + i;
+            const unsigned char * sMask = stMask.stMem + (size_t) iMaskY*stMask.iWidthBytes + pMaskStart.x*3;
+            unsigned char * sDest       = stDest.stMem + (size_t) (pDestStart.y + i)*stDest.iWidthBytes + pDestStart.x*3;
+
+            for (int x=0;x<szSize.cx;x += kChunkPixels)
+            {
+                int iPixels = szSize.cx - x < kChunkPixels ? szSize.cx - x : kChunkPixels;
+                fnBlend(sColorRow,sDest + x*3,sMask + x*3,sDest + x*3,(size_t) iPixels*3);
+            }
+        }
+        return true;
+    }
+
+    /// <summary>
+    /// Same as ApplyMaskColor(), but reads the mask bottom-up (i.e. for reversed bitmaps)
+    /// </summary>
+    static __forceinline bool ApplyMaskColorR(RGBColor_t rgbColor,RawBitmap_t & stMask,POINT pMaskStart,RawBitmap_t & stDest,POINT pDestStart,SIZE szSize = { 0,0 })
+    {
+        return ApplyMaskColor(rgbColor,stMask,pMaskStart,stDest,pDestStart,szSize,true);
+    }
+};
+
+} // namespace Sage
+
+#endif // _CBlendKernels_H_
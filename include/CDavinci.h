@@ -161,6 +161,22 @@ public:
 	int RegisterWidget(int & iRegistryID);
 	static CBitmap ReadPgrBitmap(const char * sImageTitle,const char * sPgrPath,bool * bSuccess = nullptr);
 	static CBitmap ReadPgrBitmap(const char * sImageTitle,const unsigned char * sPGRMemory,bool * bSuccess = nullptr);
+
+	// GetPgrBitmap() -- Same as ReadPgrBitmap(), but shared through the process-wide CImageCache, so an image already read from
+	// the same PGR isn't decoded again.  Returns nullptr (and *bSuccess = false) if the image can't be read.
+
+	static CImageCache::Bitmap_t GetPgrBitmap(const char * sImageTitle,const char * sPgrPath,bool * bSuccess = nullptr)
+	{
+		auto cBitmap = CImageCache::Get().GetOrDecode(CImageCache::PgrID(sPgrPath),sImageTitle,[&] { return ReadPgrBitmap(sImageTitle,sPgrPath); });
+		if (bSuccess) *bSuccess = cBitmap != nullptr;
+		return cBitmap;
+	}
+	static CImageCache::Bitmap_t GetPgrBitmap(const char * sImageTitle,const unsigned char * sPGRMemory,bool * bSuccess = nullptr)
+	{
+		auto cBitmap = CImageCache::Get().GetOrDecode(CImageCache::PgrID(sPGRMemory),sImageTitle,[&] { return ReadPgrBitmap(sImageTitle,sPGRMemory); });
+		if (bSuccess) *bSuccess = cBitmap != nullptr;
+		return cBitmap;
+	}
 	HWND GetConsoleWindow() { return m_hConsoleWindow; }
     HINSTANCE GetInstance();
 };
@@ -0,0 +1,182 @@
+// This file copyright(c) 2021 Rob Nelson, All Rights Reserved.    E-mail rob@projectsagebox.com for more information.
+//
+
+#pragma once
+#if !defined(_CDirtyRegion_H_)
+#define _CDirtyRegion_H_
+
+#include <Windows.h>
+
+namespace Sage
+{
+
+// CDirtyRegion -- List of changed (dirty) rectangles of a window canvas, merged as they are added
+//
+// CWindow can keep one of these (see CWindow::EnableDirtyRegions(), MarkDirty() and UpdateDirty()) so an update only copies the
+// parts of the canvas that changed, i.e. a few small gauges repainted on a 4K canvas.  Areas are added with MarkDirty(); drawing
+// functions don't add them.
+//
+// Rectangles are merged when added:
+//
+//      1. A new rectangle is merged with any rectangle where the merged rectangle wastes less than kMergeSlack of its area (or
+//         less than kMinSlackArea pixels) -- overlapping and neighboring rectangles, and rectangles drawn over and over.
+//      2. Merging repeats with the merged rectangle, so chains of touching rectangles collapse to one.
+//      3. When there are more than kMaxRects rectangles, the pair that wastes the least area when merged is merged.
+//
+// When the dirty area reaches kFullFraction of the canvas, GetRects() reports the whole canvas as one rectangle, since one
+// large copy is faster than many that cover most of it.
+//
+class CDirtyRegion
+{
+public:
+    static constexpr int kMaxRects          = 16;
+    static constexpr double kMergeSlack     = 0.25;         // Fraction of a merged rectangle that may be clean
+    static constexpr int kMinSlackArea      = 32*32;        // Always merge when the clean part is smaller than this
+    static constexpr double kFullFraction   = 0.5;          // Update everything when this much of the canvas is dirty
+
+private:
+    RECT m_rRects[kMaxRects+1];
+    int m_iCount                = 0;
+    int m_iWidth                = 0;                        // Canvas size (0 = not clipped)
+    int m_iHeight               = 0;
+    bool m_bEnabled             = false;
+    bool m_bAll                 = false;                    // Whole canvas is dirty
+    unsigned long long m_ullLastPresentMs = 0;
+
+    static long long GetArea(const RECT & r) { return (long long) (r.right - r.left)*(r.bottom - r.top); }
+
+    static RECT GetUnion(const RECT & a,const RECT & b)
+    {
+        return { a.left < b.left ? a.left : b.left, a.top < b.top ? a.top : b.top,
+                 a.right > b.right ? a.right : b.right, a.bottom > b.bottom ? a.bottom : b.bottom };
+    }
+
+    // Clean area added by merging a and b (the overlap of a and b is only counted once)
+
+    static long long GetWaste(const RECT & a,const RECT & b)
+    {
+        RECT rUnion = GetUnion(a,b);
+        long long iOverlap = 0;
+        LONG iW = (a.right < b.right ? a.right : b.right) - (a.left > b.left ? a.left : b.left);
+        LONG iH = (a.bottom < b.bottom ? a.bottom : b.bottom) - (a.top > b.top ? a.top : b.top);
+        if (iW > 0 && iH > 0) iOverlap = (long long) iW*iH;
+        return GetArea(rUnion) - (GetArea(a) + GetArea(b) - iOverlap);
+    }
+
+    static bool ShouldMerge(const RECT & a,const RECT & b)
+    {
+        long long iWaste = GetWaste(a,b);
+        return iWaste <= kMinSlackArea || (double) iWaste <= kMergeSlack*(double) GetArea(GetUnion(a,b));
+    }
+
+    void RemoveAt(int iIndex) { m_rRects[iIndex] = m_rRects[--m_iCount]; }
+
+    void MergeBestPair()
+    {
+        int iBestA = 0, iBestB = 1;
+        long long iBestWaste = -1;
+        for (int i=0;i<m_iCount;i++) for (int j=i+1;j<m_iCount;j++)
+        {
+            long long iWaste = GetWaste(m_rRects[i],m_rRects[j]);
+            if (iBestWaste < 0 || iWaste < iBestWaste) iBestWaste = iWaste, iBestA = i, iBestB = j;
+        }
+        m_rRects[iBestA] = GetUnion(m_rRects[iBestA],m_rRects[iBestB]);
+        RemoveAt(iBestB);
+    }
+
+    void CheckFull()
+    {
+        if (!m_iWidth || !m_iHeight) return;
+        long long iTotal = 0;
+        for (int i=0;i<m_iCount;i++) iTotal += GetArea(m_rRects[i]);
+        if ((double) iTotal >= kFullFraction*(double) m_iWidth*(double) m_iHeight) SetAll();
+    }
+
+public:
+    void Enable(bool bEnable = true) { m_bEnabled = bEnable; Clear(); }
+    bool isEnabled() const { return m_bEnabled; }
+
+    /// <summary>
+    /// Sets the canvas size.  Added rectangles are clipped to it, and it's used for the whole-canvas check.
+    /// </summary>
+    void SetBounds(int iWidth,int iHeight)
+    {
+        if (iWidth == m_iWidth && iHeight == m_iHeight) return;
+        m_iWidth    = iWidth;
+        m_iHeight   = iHeight;
+        SetAll();                   // Size changed -- everything has to be updated
+    }
+
+    /// <summary>
+    /// Marks the whole canvas as dirty (i.e. after Cls())
+    /// </summary>
+    void SetAll() { m_bAll = true; m_iCount = 0; }
+
+    /// <summary>
+    /// Adds a dirty rectangle (iX,iY) to (iX+iWidth,iY+iHeight).  Does nothing when not enabled.
+    /// </summary>
+    void Add(int iX,int iY,int iWidth,int iHeight)
+    {
+        if (!m_bEnabled || m_bAll || iWidth <= 0 || iHeight <= 0) return;
+
+        RECT rNew = { iX, iY, iX + iWidth, iY + iHeight };
+        if (m_iWidth && m_iHeight)
+        {
+            if (rNew.left < 0) rNew.left = 0;
+            if (rNew.top < 0) rNew.top = 0;
+            if (rNew.right > m_iWidth) rNew.right = m_iWidth;
+            if (rNew.bottom > m_iHeight) rNew.bottom = m_iHeight;
+            if (rNew.right <= rNew.left || rNew.bottom <= rNew.top) return;
+        }
+
+        for (int i=0;i<m_iCount;)
+        {
+            if (ShouldMerge(m_rRects[i],rNew))
+            {
+                rNew = GetUnion(m_rRects[i],rNew);
+                RemoveAt(i);
+                i = 0;                  // The larger rectangle may now merge with one already checked
+            }
+            else i++;
+        }
+
+        m_rRects[m_iCount++] = rNew;
+        if (m_iCount > kMaxRects) MergeBestPair();
+        CheckFull();
+    }
+
+    void Add(const RECT & rRect) { Add(rRect.left,rRect.top,rRect.right - rRect.left,rRect.bottom - rRect.top); }
+
+    /// <summary>
+    /// Returns the number of rectangles to update and fills rRects (kMaxRects entries) with them.  When the whole canvas is dirty,
+    /// this is one rectangle of the canvas size.
+    /// </summary>
+    int GetRects(RECT * rRects) const
+    {
+        if (m_bAll)
+        {
+            if (!m_iWidth || !m_iHeight) return 0;
+            rRects[0] = { 0, 0, m_iWidth, m_iHeight };
+            return 1;
+        }
+        for (int i=0;i<m_iCount;i++) rRects[i] = m_rRects[i];
+        return m_iCount;
+    }
+
+    bool isAll() const { return m_bAll; }
+    bool isEmpty() const { return !m_bAll && !m_iCount; }
+    void Clear() { m_iCount = 0; m_bAll = false; }
+
+    /// <summary>
+    /// Returns true if an update throttled to iUpdateMS is due at time ullNowMs (always true for iUpdateMS = 0), and records the time.
+    /// </summary>
+    bool ReadyToPresent(unsigned long long ullNowMs,int iUpdateMS)
+    {
+        if (iUpdateMS > 0 && ullNowMs - m_ullLastPresentMs < (unsigned long long) iUpdateMS) return false;
+        m_ullLastPresentMs = ullNowMs;
+        return true;
+    }
+};
+
+} // namespace Sage
+#endif // _CDirtyRegion_H_
@@ -0,0 +1,272 @@
+// This file copyright(c) 2021 Rob Nelson, All Rights Reserved.    E-mail rob@projectsagebox.com for more information.
+//
+
+#pragma once
+#if !defined(_CDisplayList_H_)
+#define _CDisplayList_H_
+
+#include "CRawBitmap.h"
+#include <vector>
+#include <memory>
+#include <functional>
+#include <algorithm>
+#include <cstring>
+#include <cmath>
+
+namespace Sage
+{
+
+// CDisplayList -- Retained list of drawing entries (i.e. TurtleShell strokes), stored in chunks with bounding boxes
+//
+// Entries are added in drawing order with their bounding box, and stored in fixed-size chunks, so there is no limit on the
+// number of entries and adding never copies earlier ones.  Each chunk keeps the bounding box of its entries, so a replay of
+// a visible (or dirty) area skips whole chunks outside of it, then skips entries outside of it in the chunks that remain:
+//
+//      cList.Add(stEntry,{ fLeft,fTop,fRight,fBottom });
+//      ...
+//      cList.Replay(rDirty,[&](const Entry & stEntry) { Draw(stEntry); });     // Only entries touching rDirty, in order
+//
+// Tile cache (optional):
+//
+//      With EnableTileCache(), chunks are rasterized into cached tiles (iTileSize x iTileSize bitmaps covering the canvas) once
+//      they are full (or Seal() is called).  Each tile starts with the background (fnInit) and has each completed chunk drawn
+//      onto it in order by fnRender, so a tile is always the final image of its area for every completed chunk.  A replay
+//      then copies the visible tiles and only draws the entries of the chunk still being filled, so the replay time no longer
+//      grows with the number of entries.
+//
+//      fnRender is given the tile, its position on the canvas, and the entries of the chunk that touch the tile.
+//
+template<typename Entry>
+class CDisplayList
+{
+public:
+    static constexpr int kChunkSize         = 4096;     // Entries per chunk
+    static constexpr int kDefaultTileSize   = 256;
+
+    struct Bounds_t
+    {
+        float fLeft, fTop, fRight, fBottom;
+
+        bool Intersects(const Bounds_t & b) const { return fLeft < b.fRight && b.fLeft < fRight && fTop < b.fBottom && b.fTop < fBottom; }
+        void Add(const Bounds_t & b)
+        {
+            fLeft   = (std::min)(fLeft,b.fLeft);
+            fTop    = (std::min)(fTop,b.fTop);
+            fRight  = (std::max)(fRight,b.fRight);
+            fBottom = (std::max)(fBottom,b.fBottom);
+        }
+
+        static Bounds_t FromRect(int iX,int iY,int iWidth,int iHeight) { return { (float) iX,(float) iY,(float) (iX + iWidth),(float) (iY + iHeight) }; }
+    };
+
+    using TileInit      = std::function<void(CBitmap & cTile,int iTileX,int iTileY)>;
+    using TileRender    = std::function<void(CBitmap & cTile,int iTileX,int iTileY,const std::vector<const Entry *> & vEntries)>;
+
+private:
+    struct Item_t
+    {
+        Entry stEntry;
+        Bounds_t stBounds;
+    };
+
+    struct Chunk_t
+    {
+        std::vector<Item_t> vItems;
+        Bounds_t stBounds{};
+        bool bTiled = false;                        // Rasterized into the tile cache
+    };
+
+    struct Tile_t
+    {
+        std::unique_ptr<CBitmap> cBitmap;           // nullptr until a chunk touches the tile
+    };
+
+    std::vector<std::unique_ptr<Chunk_t>> m_vChunks;
+    size_t m_iSize = 0;
+
+    // Tile cache
+
+    bool m_bTileCache   = false;
+    int m_iTileSize     = kDefaultTileSize;
+    int m_iTilesX       = 0;
+    int m_iTilesY       = 0;
+    std::vector<Tile_t> m_vTiles;
+    TileInit m_fnTileInit;
+    TileRender m_fnTileRender;
+    std::vector<const Entry *> m_vTileEntries;      // Reused by RenderChunk()
+
+    Bounds_t GetTileBounds(int iTX,int iTY) const { return Bounds_t::FromRect(iTX*m_iTileSize,iTY*m_iTileSize,m_iTileSize,m_iTileSize); }
+
+    // Draws a completed chunk onto every tile it touches
+
+    void RenderChunk(Chunk_t & stChunk)
+    {
+        if (!m_bTileCache || stChunk.bTiled || stChunk.vItems.empty()) return;
+        stChunk.bTiled = true;
+
+        int iTX1 = (std::max)(0,(int) (stChunk.stBounds.fLeft/m_iTileSize));
+        int iTY1 = (std::max)(0,(int) (stChunk.stBounds.fTop/m_iTileSize));
+        int iTX2 = (std::min)(m_iTilesX - 1,(int) (stChunk.stBounds.fRight/m_iTileSize));
+        int iTY2 = (std::min)(m_iTilesY - 1,(int) (stChunk.stBounds.fBottom/m_iTileSize));
+
+        for (int ty=iTY1;ty<=iTY2;ty++) for (int tx=iTX1;tx<=iTX2;tx++)
+        {
+            Bounds_t stTile = GetTileBounds(tx,ty);
+            m_vTileEntries.clear();
+            for (auto & stItem : stChunk.vItems) if (stItem.stBounds.Intersects(stTile)) m_vTileEntries.push_back(&stItem.stEntry);
+            if (m_vTileEntries.empty()) continue;
+
+            auto & stTileData = m_vTiles[ty*m_iTilesX + tx];
+            if (!stTileData.cBitmap)
+            {
+                stTileData.cBitmap = std::make_unique<CBitmap>(m_iTileSize,m_iTileSize);
+                if (m_fnTileInit) m_fnTileInit(*stTileData.cBitmap,tx*m_iTileSize,ty*m_iTileSize);
+                else memset(stTileData.cBitmap->stBitmap.stMem,0,stTileData.cBitmap->stBitmap.iTotalSize);
+            }
+            m_fnTileRender(*stTileData.cBitmap,tx*m_iTileSize,ty*m_iTileSize,m_vTileEntries);
+        }
+    }
+
+public:
+    CDisplayList() = default;
+
+    /// <summary>
+    /// Adds an entry with its bounding box (in canvas coordinates, including the pen width).  When this fills a chunk and the tile
+    /// cache is enabled, the chunk is rasterized into the tiles it touches.
+    /// </summary>
+    void Add(const Entry & stEntry,const Bounds_t & stBounds)
+    {
+        if (m_vChunks.empty() || (int) m_vChunks.back()->vItems.size() >= kChunkSize || m_vChunks.back()->bTiled)
+        {
+            m_vChunks.push_back(std::make_unique<Chunk_t>());
+            m_vChunks.back()->vItems.reserve(kChunkSize);
+            m_vChunks.back()->stBounds = stBounds;
+        }
+
+        auto & stChunk = *m_vChunks.back();
+        stChunk.vItems.push_back({ stEntry,stBounds });
+        stChunk.stBounds.Add(stBounds);
+        m_iSize++;
+
+        if ((int) stChunk.vItems.size() == kChunkSize) RenderChunk(stChunk);
+    }
+
+    /// <summary>
+    /// Completes the chunk being filled, so it's rasterized into the tile cache now (i.e. when a drawing is finished).
+    /// </summary>
+    void Seal() { if (!m_vChunks.empty()) RenderChunk(*m_vChunks.back()); }
+
+    size_t size() const { return m_iSize; }
+    bool empty() const { return !m_iSize; }
+    int GetChunkCount() const { return (int) m_vChunks.size(); }
+
+    void Clear()
+    {
+        m_vChunks.clear();
+        m_iSize = 0;
+        for (auto & stTile : m_vTiles) stTile.cBitmap.reset();
+    }
+
+    /// <summary>
+    /// Calls fnDraw(const Entry &amp;) for every entry whose bounding box touches rVisible, in the order they were added.  Returns
+    /// the number of entries drawn.
+    /// </summary>
+    template<typename F>
+    size_t Replay(const Bounds_t & rVisible,F && fnDraw) const
+    {
+        size_t iDrawn = 0;
+        for (auto & cChunk : m_vChunks)
+        {
+            if (!cChunk->stBounds.Intersects(rVisible)) continue;
+            for (auto & stItem : cChunk->vItems)
+                if (stItem.stBounds.Intersects(rVisible)) fnDraw(stItem.stEntry), iDrawn++;
+        }
+        return iDrawn;
+    }
+
+    /// <summary>
+    /// Calls fnDraw(const Entry &amp;) for every entry, in order.
+    /// </summary>
+    template<typename F>
+    void ForEach(F && fnDraw) const
+    {
+        for (auto & cChunk : m_vChunks) for (auto & stItem : cChunk->vItems) fnDraw(stItem.stEntry);
+    }
+
+    /// <summary>
+    /// Enables the tile cache for an iWidth x iHeight canvas (see the notes at the top of this file).  Chunks that are already
+    /// complete are rasterized now.
+    /// </summary>
+    /// <param name="fnRender"> - Draws entries onto a tile (entries are in canvas coordinates; the tile's upper-left is at iTileX,iTileY)</param>
+    /// <param name="fnInit"> - [optional] Fills a new tile with the background (black when not given)</param>
+    bool EnableTileCache(int iWidth,int iHeight,TileRender fnRender,TileInit fnInit = nullptr,int iTileSize = kDefaultTileSize)
+    {
+        if (iWidth <= 0 || iHeight <= 0 || iTileSize < 16 || !fnRender) return false;
+
+        m_bTileCache    = true;
+        m_iTileSize     = iTileSize;
+        m_iTilesX       = (iWidth + iTileSize - 1)/iTileSize;
+        m_iTilesY       = (iHeight + iTileSize - 1)/iTileSize;
+        m_fnTileRender  = std::move(fnRender);
+        m_fnTileInit    = std::move(fnInit);
+        m_vTiles.clear();
+        m_vTiles.resize((size_t) m_iTilesX*m_iTilesY);
+
+        for (auto & cChunk : m_vChunks)
+        {
+            cChunk->bTiled = false;
+            if ((int) cChunk->vItems.size() == kChunkSize) RenderChunk(*cChunk);
+        }
+        return true;
+    }
+
+    void DisableTileCache()
+    {
+        m_bTileCache = false;
+        m_vTiles.clear();
+        for (auto & cChunk : m_vChunks) cChunk->bTiled = false;
+    }
+
+    bool isTileCacheEnabled() const { return m_bTileCache; }
+
+    /// <summary>
+    /// Replays rVisible using the tile cache: calls fnDrawTile(CBitmap &amp; cTile,int iDestX,int iDestY,int iSrcX,int iSrcY,int iWidth,int iHeight)
+    /// with the part of each cached tile inside rVisible (iSrcX,iSrcY in the tile, copied to iDestX,iDestY on the canvas), then
+    /// fnDraw(const Entry &amp;) for the entries of chunks not yet in the cache.  Areas without a tile have nothing from the completed
+    /// chunks, so they're left as the background.  Without the tile cache, this is the same as Replay().
+    /// </summary>
+    template<typename FT,typename F>
+    size_t ReplayTiled(const Bounds_t & rVisible,FT && fnDrawTile,F && fnDraw) const
+    {
+        if (!m_bTileCache) return Replay(rVisible,fnDraw);
+
+        size_t iDrawn = 0;
+        for (int ty=0;ty<m_iTilesY;ty++) for (int tx=0;tx<m_iTilesX;tx++)
+        {
+            auto & stTile = m_vTiles[ty*m_iTilesX + tx];
+            if (!stTile.cBitmap) continue;
+
+            // The tile clipped to rVisible (the bounds are compared as floats first, so the casts stay within the tile)
+
+            int iTileX = tx*m_iTileSize, iTileY = ty*m_iTileSize;
+            int iX1 = iTileX + (int) std::ceil((std::min)((std::max)(rVisible.fLeft - iTileX,0.0f),(float) m_iTileSize));
+            int iY1 = iTileY + (int) std::ceil((std::min)((std::max)(rVisible.fTop - iTileY,0.0f),(float) m_iTileSize));
+            int iX2 = iTileX + (int) std::floor((std::min)((std::max)(rVisible.fRight - iTileX,0.0f),(float) m_iTileSize));
+            int iY2 = iTileY + (int) std::floor((std::min)((std::max)(rVisible.fBottom - iTileY,0.0f),(float) m_iTileSize));
+            if (iX1 >= iX2 || iY1 >= iY2) continue;
+
+            fnDrawTile(*stTile.cBitmap,iX1,iY1,iX1 - iTileX,iY1 - iTileY,iX2 - iX1,iY2 - iY1);
+            iDrawn++;
+        }
+        for (auto & cChunk : m_vChunks)
+        {
+            if (cChunk->bTiled || !cChunk->stBounds.Intersects(rVisible)) continue;
+            for (auto & stItem : cChunk->vItems)
+                if (stItem.stBounds.Intersects(rVisible)) fnDraw(stItem.stEntry), iDrawn++;
+        }
+        return iDrawn;
+    }
+};
+
+} // namespace Sage
+#endif // _CDisplayList_H_
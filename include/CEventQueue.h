@@ -0,0 +1,179 @@
+// This file copyright(c) 2021 Rob Nelson, All Rights Reserved.    E-mail rob@projectsagebox.com for more information.
+//
+
+#pragma once
+#if !defined(_CEventQueue_H_)
+#define _CEventQueue_H_
+
+#include "Sage.h"
+#include <atomic>
+#include <memory>
+#include <vector>
+#include <chrono>
+
+namespace Sage
+{
+
+// InputEvent_t -- One timestamped input event, as stored in CEventQueue
+//
+//      eEvent      -- SageEvent::MouseMoved, MouseLButtonClicked, MouseLButtonUnclicked, MouseWheel, KeyPress, etc.
+//      iX,iY       -- Mouse position in the window for mouse events (the window size for WindowResize)
+//      iValue      -- Wheel delta for MouseWheel, character for KeyPress, 0 otherwise
+//      ullTimeUs   -- Time the event was received, in microseconds (std::chrono::steady_clock; see CEventQueue::GetTimeUs())
+//
+struct InputEvent_t
+{
+    SageEvent eEvent;
+    int iX;
+    int iY;
+    int iValue;
+    unsigned long long ullTimeUs;
+};
+
+// CEventQueue -- Lock-free multiple-producer/single-consumer ring buffer of InputEvent_t
+//
+// Each CWindow can keep one of these (see CWindow::EnableEventQueue()) so every mouse move, click and key is kept in order with
+// its time, rather than read from counters and pending flags that only show the state at the time they are polled -- with
+// counters, the positions between two polls (and a click and unclick in the same poll) are lost.
+//
+//      Producers (any thread)      Push() -- i.e. the window's message thread, or a tablet/sensor thread with PostEvent()
+//      Consumer (one thread)       Pop(), Drain() -- i.e. the GetEvent() loop
+//
+// This is the bounded queue by Dmitry Vyukov: each cell has a sequence number telling producers and the consumer whether it is
+// free or filled, so producers only contend on one atomic increment and the consumer never blocks a producer.
+//
+// Notes:
+//
+//      1. The capacity is a power of 2 (kDefaultCapacity unless given).  When the queue is full, Push() drops the event and
+//         returns false, and GetDropped() counts it -- a consumer that keeps up never loses an event.
+//      2. Only one thread may call Pop() and Drain() at a time.
+//
+class CEventQueue
+{
+public:
+    static constexpr int kDefaultCapacity = 4096;
+
+private:
+    struct Cell_t
+    {
+        std::atomic<unsigned int> uSequence;
+        InputEvent_t stEvent;
+    };
+
+    std::unique_ptr<Cell_t[]> m_pCells;
+    unsigned int m_uMask = 0;
+
+    alignas(64) std::atomic<unsigned int> m_uTail{0};      // Next cell for producers
+    alignas(64) unsigned int m_uHead = 0;                  // Next cell for the consumer
+    std::atomic<unsigned int> m_uDropped{0};
+
+public:
+    CEventQueue(int iCapacity = kDefaultCapacity)
+    {
+        unsigned int uCapacity = 2;
+        while (uCapacity < (unsigned int) iCapacity && uCapacity < (1u << 24)) uCapacity <<= 1;
+
+        m_pCells = std::make_unique<Cell_t[]>(uCapacity);
+        for (unsigned int i=0;i<uCapacity;i++) m_pCells[i].uSequence.store(i,std::memory_order_relaxed);
+        m_uMask = uCapacity - 1;
+    }
+
+    CEventQueue(const CEventQueue &) = delete;
+    CEventQueue & operator = (const CEventQueue &) = delete;
+
+    static unsigned long long GetTimeUs()
+    {
+        return (unsigned long long) std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+    }
+
+    /// <summary>
+    /// Adds an event.  Can be called from any thread.  Returns false (and counts the event in GetDropped()) if the queue is full.
+    /// </summary>
+    bool Push(const InputEvent_t & stEvent)
+    {
+        Cell_t * pCell;
+        unsigned int uPos = m_uTail.load(std::memory_order_relaxed);
+        for (;;)
+        {
+            pCell = &m_pCells[uPos & m_uMask];
+            int iDiff = (int) (pCell->uSequence.load(std::memory_order_acquire) - uPos);
+
+            if (!iDiff)
+            {
+                if (m_uTail.compare_exchange_weak(uPos,uPos + 1,std::memory_order_relaxed)) break;
+            }
+            else if (iDiff < 0)
+            {
+                m_uDropped.fetch_add(1,std::memory_order_relaxed);
+                return false;
+            }
+            else uPos = m_uTail.load(std::memory_order_relaxed);
+        }
+
+        pCell->stEvent = stEvent;
+        pCell->uSequence.store(uPos + 1,std::memory_order_release);
+        return true;
+    }
+
+    /// <summary>
+    /// Adds an event with the current time.  Can be called from any thread.
+    /// </summary>
+    bool Push(SageEvent eEvent,int iX = 0,int iY = 0,int iValue = 0) { return Push({ eEvent,iX,iY,iValue,GetTimeUs() }); }
+
+    /// <summary>
+    /// Removes the oldest event into stEvent.  Returns false if the queue is empty.  Consumer thread only.
+    /// </summary>
+    bool Pop(InputEvent_t & stEvent)
+    {
+        Cell_t & stCell = m_pCells[m_uHead & m_uMask];
+        if ((int) (stCell.uSequence.load(std::memory_order_acquire) - (m_uHead + 1)) < 0) return false;
+
+        stEvent = stCell.stEvent;
+        stCell.uSequence.store(m_uHead + m_uMask + 1,std::memory_order_release);
+        m_uHead++;
+        return true;
+    }
+
+    /// <summary>
+    /// Removes up to iMaxEvents events (oldest first) into pEvents, and returns the number removed.  Consumer thread only.
+    /// </summary>
+    int Drain(InputEvent_t * pEvents,int iMaxEvents)
+    {
+        int iCount = 0;
+        while (iCount < iMaxEvents && Pop(pEvents[iCount])) iCount++;
+        return iCount;
+    }
+
+    /// <summary>
+    /// Appends all waiting events to vEvents, and returns the number added.  Consumer thread only.
+    /// </summary>
+    int Drain(std::vector<InputEvent_t> & vEvents)
+    {
+        int iCount = 0;
+        for (InputEvent_t stEvent;Pop(stEvent);iCount++) vEvents.push_back(stEvent);
+        return iCount;
+    }
+
+    /// <summary>
+    /// Returns true if no events are waiting (this can change right after the call if other threads are adding events).
+    /// </summary>
+    bool isEmpty() const
+    {
+        return (int) (m_pCells[m_uHead & m_uMask].uSequence.load(std::memory_order_acquire) - (m_uHead + 1)) < 0;
+    }
+
+    /// <summary>
+    /// Removes all waiting events.  Consumer thread only.
+    /// </summary>
+    void Clear() { for (InputEvent_t stEvent;Pop(stEvent);); }
+
+    int GetCapacity() const { return (int) m_uMask + 1; }
+
+    /// <summary>
+    /// Returns the number of events dropped because the queue was full.
+    /// </summary>
+    unsigned int GetDropped() const { return m_uDropped.load(std::memory_order_relaxed); }
+};
+
+} // namespace Sage
+#endif // _CEventQueue_H_
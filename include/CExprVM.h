@@ -0,0 +1,766 @@
+// This file copyright(c) 2021 Rob Nelson, All Rights Reserved.    E-mail rob@projectsagebox.com for more information.
+//
+
+#pragma once
+#if !defined(_CExprVM_H_)
+#define _CExprVM_H_
+
+#include "CToken.h"
+#include <cmath>
+#include <cstring>
+#include <vector>
+#include <unordered_map>
+
+namespace Sage
+{
+
+// ---------------------------------------
+// Expression bytecode and register VM
+// ---------------------------------------
+//
+// The stNODE trees CToken and CTree build for a script are evaluated by walking them: one pointer chase, a switch on the node
+// type and a recursive call for every node, every time the expression runs.  For scripts that run per pixel or per frame,
+// CExprCompiler lowers the trees once to a CExprProgram -- compact 3-address bytecode -- which CExprVM runs:
+//
+//      CExprCompiler cCompiler;
+//      cCompiler.AddStatement(stInit);                         // Statements are stNODE trees (or CTree objects)
+//      cCompiler.While(stCondition);                           // Control flow around them: While()/EndWhile(),
+//          cCompiler.AddStatement(stBody);                     // If()/Else()/EndIf()
+//      cCompiler.EndWhile();
+//
+//      CExprProgram cProgram;
+//      if (cCompiler.Compile(cProgram))
+//      {
+//          CExprVM cVM(cProgram);
+//          cVM.Bind(stVar,&fValue);                            // Where each variable's value is kept (see BindAll())
+//          cVM.Run();
+//      }
+//
+// Compiling:
+//
+//      Registers       Variables, constants and temporaries are all registers (up to 65536), so each instruction is one
+//                      operation on registers -- variables are copied in and out once per Run(), and constants are loaded
+//                      into their registers when the CExprVM is created.  Each variable (stVARSTRUCT) gets its own
+//                      register the first time it is used (CExprProgram::vVars); iAddress isn't used, since it is an
+//                      offset in the global or the local data space, and a global and a local can have the same one.
+//      Folding         Sub-expressions of constants are evaluated at compile time, i.e. 2*3.14159*r is one multiply.
+//      Dead branches   A constant left side of && or || drops the right side, and an If() or While() with a constant
+//                      condition drops the code that can't run (and the test itself).
+//
+// Notes:
+//
+//      1. Values are doubles.  Integer node types (nAdd, nSub, nMul, nDiv, nMod, nAnd, nOr, nxor and nneg) truncate their
+//         operands to 32-bit ints and wrap their result to 32 bits, as C int arithmetic does, and division or modulo by 0
+//         is 0.  The float node types (nFadd, etc.) and += are done in doubles.  CExprTree::Apply() has the rules for both
+//         the tree and the bytecode (and is what the compiler folds constants with), so they give the same results.
+//      2. The node types supported are numbers, variables, arithmetic, bitwise, comparison and logical operators, negation
+//         and assignment (including +=).  Compile() returns false (see GetError()) for anything else -- i.e. function
+//         calls or pointers -- and the tree can still be evaluated as before.
+//      3. With GCC and Clang, the VM dispatches with computed gotos (one indirect jump per instruction, at the end of each
+//         instruction's code); otherwise it uses a switch.
+//
+
+// CExprTree -- Direct evaluation of an stNODE tree (the tree-walking form), with the same rules as the bytecode
+
+class CExprTree
+{
+public:
+    static bool isSupported(eNODETYPE eNodeType)
+    {
+        switch (eNodeType)
+        {
+            case nNum: case nFloat: case nVar:
+            case nAdd: case nSub: case nMul: case nDiv: case nFadd: case nFsub: case nFmul: case nFdiv:
+            case nAnd: case nOr: case nxor: case nMod: case nlogAnd: case nlogOr:
+            case nneg: case nFneg: case nNot:
+            case nEqualto: case nNotEqualto: case nGreaterThan: case nFGreaterThan: case nLessThan:
+            case nAssign: case nPlusEqual:
+                return true;
+            default:
+                return false;
+        }
+    }
+
+    static bool isUnary(eNODETYPE eNodeType) { return eNodeType == nneg || eNodeType == nFneg || eNodeType == nNot; }
+
+    // The operand of a unary node, which the parser may have put on either side
+
+    static stNODE * UnaryChild(stNODE * stNode) { return stNode->tLeft ? stNode->tLeft : stNode->tRight; }
+
+    static double NumberValue(const stNODEDATA & stData)
+    {
+        auto & stNumber = stData.suTokenData.stNumber.stNumber;
+        if (stData.eNodeType == nFloat) return (double) stNumber.fFloat;
+        return stNumber.eRawNumType & __numtypUNSIGNED ? (double) (unsigned int) stNumber.LSW : (double) (int) stNumber.LSW;
+    }
+
+    // Integer operands are truncated toward 0 and wrapped to 32 bits (values past +/-2^62 are clamped first, and NaN is 0),
+    // so conversion can't overflow
+
+    static int ToInt(double fValue)
+    {
+        constexpr double kLimit = 4611686018427387904.0;
+        long long llValue = fValue >= kLimit ? (long long) kLimit : fValue <= -kLimit ? -(long long) kLimit : fValue == fValue ? (long long) fValue : 0;
+        return (int) (unsigned int) (unsigned long long) llValue;
+    }
+
+    // Wraps an integer result to 32 bits
+
+    static double Wrap(long long llValue) { return (double) (int) (unsigned int) (unsigned long long) llValue; }
+
+    /// <summary>
+    /// Applies a binary or unary (fRight ignored) operator.  This is the arithmetic for both the tree and the bytecode.
+    /// </summary>
+    static double Apply(eNODETYPE eNodeType,double fLeft,double fRight)
+    {
+        switch (eNodeType)
+        {
+            case nFadd:                 return fLeft + fRight;
+            case nFsub:                 return fLeft - fRight;
+            case nFmul:                 return fLeft*fRight;
+            case nFdiv:                 return fLeft/fRight;
+            case nAdd:                  return Wrap((long long) ToInt(fLeft) + ToInt(fRight));
+            case nSub:                  return Wrap((long long) ToInt(fLeft) - ToInt(fRight));
+            case nMul:                  return Wrap((long long) ToInt(fLeft)*ToInt(fRight));
+            case nDiv:                  return ToInt(fRight) ? Wrap((long long) ToInt(fLeft)/ToInt(fRight)) : 0.0;
+            case nMod:                  return ToInt(fRight) ? Wrap((long long) ToInt(fLeft) % ToInt(fRight)) : 0.0;
+            case nAnd:                  return (double) (ToInt(fLeft) & ToInt(fRight));
+            case nOr:                   return (double) (ToInt(fLeft) | ToInt(fRight));
+            case nxor:                  return (double) (ToInt(fLeft) ^ ToInt(fRight));
+            case nEqualto:              return fLeft == fRight ? 1.0 : 0.0;
+            case nNotEqualto:           return fLeft != fRight ? 1.0 : 0.0;
+            case nGreaterThan:
+            case nFGreaterThan:         return fLeft > fRight ? 1.0 : 0.0;
+            case nLessThan:             return fLeft < fRight ? 1.0 : 0.0;
+            case nneg:                  return Wrap(-(long long) ToInt(fLeft));
+            case nFneg:                 return -fLeft;
+            case nNot:                  return fLeft == 0.0 ? 1.0 : 0.0;
+            default:                    return 0.0;
+        }
+    }
+
+    /// <summary>
+    /// Evaluates the tree.  fnVar(const stVARSTRUCT * stVar) returns a double & for the value of each variable (assignments
+    /// change it).  Unsupported nodes evaluate to 0.
+    /// </summary>
+    template<typename F>
+    static double Evaluate(stNODE * stNode,F && fnVar)
+    {
+        if (!stNode || !stNode->stNodeData) return 0.0;
+        auto & stData = *stNode->stNodeData;
+
+        switch (stData.eNodeType)
+        {
+            case nNum:
+            case nFloat:
+                return NumberValue(stData);
+
+            case nVar:
+                return fnVar((const stVARSTRUCT *) stData.suTokenData.stVar);
+
+            case nAssign:
+            case nPlusEqual:
+            {
+                if (!stNode->tLeft || !stNode->tLeft->stNodeData || stNode->tLeft->stNodeData->eNodeType != nVar) return 0.0;
+                double & fVar = fnVar((const stVARSTRUCT *) stNode->tLeft->stNodeData->suTokenData.stVar);
+                double fValue = Evaluate(stNode->tRight,fnVar);
+                return fVar = stData.eNodeType == nAssign ? fValue : fVar + fValue;
+            }
+
+            case nlogAnd:   return Evaluate(stNode->tLeft,fnVar) != 0.0 && Evaluate(stNode->tRight,fnVar) != 0.0 ? 1.0 : 0.0;
+            case nlogOr:    return Evaluate(stNode->tLeft,fnVar) != 0.0 || Evaluate(stNode->tRight,fnVar) != 0.0 ? 1.0 : 0.0;
+
+            default:
+                if (!isSupported(stData.eNodeType)) return 0.0;
+                if (isUnary(stData.eNodeType)) return Apply(stData.eNodeType,Evaluate(UnaryChild(stNode),fnVar),0.0);
+                double fLeft = Evaluate(stNode->tLeft,fnVar);
+                return Apply(stData.eNodeType,fLeft,Evaluate(stNode->tRight,fnVar));
+        }
+    }
+};
+
+// ExprInstr_t -- One bytecode instruction: uOp, then the destination and source registers (or a jump target in uB,uC)
+
+struct ExprInstr_t
+{
+    unsigned char uOp;
+    unsigned short uA;
+    unsigned short uB;
+    unsigned short uC;
+
+    int GetTarget() const { return (int) (uB | (unsigned int) uC << 16); }
+};
+
+namespace ExprOp
+{
+    enum : unsigned char
+    {
+        Halt,           // Stop; the result is register A
+        Mov,            // A = B
+        Add, Sub, Mul,  // A = B op C
+        Div,            // A = B/C
+        IAdd, ISub,     // A = B op C, as 32-bit integers
+        IMul,
+        IDiv, Mod,      // A = B op C, as 32-bit integers (0 when C is 0)
+        And, Or, Xor,   // A = B op C, bitwise on integers
+        Eq, Ne, Lt, Gt, // A = B op C ? 1 : 0
+        Neg,            // A = -B
+        INeg,           // A = -B, as a 32-bit integer
+        Not,            // A = B == 0 ? 1 : 0
+        Bool,           // A = B != 0 ? 1 : 0
+        Jmp,            // Jump to target
+        Jz, Jnz,        // Jump to target if A is zero / not zero
+        Count
+    };
+}
+
+// CExprProgram -- Compiled bytecode, from CExprCompiler::Compile()
+//
+// Registers are laid out as the variables (register n is vVars[n]), then the constants, then the temporaries.
+//
+class CExprProgram
+{
+public:
+    static constexpr int kMaxRegisters = 65536;
+
+    std::vector<ExprInstr_t> vCode;
+    std::vector<double> vConstants;
+    std::vector<const stVARSTRUCT *> vVars;                     // The variable in each of the first registers
+    std::unordered_map<const stVARSTRUCT *,int> mVarRegs;       // And the register of each variable
+    int iRegisters  = 0;
+
+    // FindVar() -- the register for a variable, or -1 if the program doesn't use it
+
+    int FindVar(const stVARSTRUCT * stVar) const
+    {
+        auto it = mVarRegs.find(stVar);
+        return it != mVarRegs.end() ? it->second : -1;
+    }
+
+    bool isEmpty() const { return vCode.empty(); }
+};
+
+// CExprCompiler -- Lowers stNODE trees to a CExprProgram
+//
+class CExprCompiler
+{
+    // While compiling, registers are virtual -- kind and index -- and are laid out in Compile()
+
+    enum : int { kVar = 1 << 24, kConst = 2 << 24, kTemp = 3 << 24, kKindMask = 0xff << 24, kIndexMask = 0xffffff };
+
+    struct Instr_t
+    {
+        unsigned char uOp;
+        int iA, iB, iC;             // Virtual registers, or a jump target in iB
+    };
+
+    // One operand: a constant (not yet given a register) or a register
+
+    struct Operand_t
+    {
+        bool bConst;
+        double fValue;
+        int iReg;
+    };
+
+    struct Block_t
+    {
+        bool bWhile;
+        bool bConst;                // The condition was a constant (nothing was emitted for it)
+        bool bDead;                 // This part of the block is not compiled
+        bool bInDead;               // The whole block is inside dead code
+        int iStart;                 // While: the loop start
+        int iJump;                  // Jump to patch at the end (or -1)
+    };
+
+    std::vector<Instr_t> m_vCode;
+    std::vector<double> m_vConstants;
+    std::vector<Block_t> m_vBlocks;
+    std::vector<const stVARSTRUCT *> m_vVars;                   // Variables, in the order they were given registers
+    std::unordered_map<const stVARSTRUCT *,int> m_mVarRegs;
+
+    int m_iTemp         = 0;        // Next free temporary
+    int m_iMaxTemp      = 0;
+    int m_iDead         = 0;        // > 0 while compiling code that can't run
+    int m_iResult       = -1;       // Register holding the last top-level statement's value
+    int m_iFolded       = 0;
+    int m_iDeadBranches = 0;
+    const char * m_sError = nullptr;
+
+    bool Fail(const char * sError) { if (!m_sError) m_sError = sError; return false; }
+
+    int Emit(unsigned char uOp,int iA,int iB = 0,int iC = 0)
+    {
+        if (m_iDead) return -1;
+        m_vCode.push_back({ uOp,iA,iB,iC });
+        return (int) m_vCode.size() - 1;
+    }
+
+    void Patch(int iJump) { if (iJump >= 0) m_vCode[iJump].iB = (int) m_vCode.size(); }
+
+    int NewTemp()
+    {
+        int iTemp = m_iTemp++;
+        if (m_iTemp > m_iMaxTemp) m_iMaxTemp = m_iTemp;
+        return kTemp | iTemp;
+    }
+
+    int ConstReg(double fValue)
+    {
+        for (size_t i=0;i<m_vConstants.size();i++) if (!memcmp(&m_vConstants[i],&fValue,sizeof(double))) return kConst | (int) i;
+        m_vConstants.push_back(fValue);
+        return kConst | (int) (m_vConstants.size() - 1);
+    }
+
+    int Reg(const Operand_t & stOperand) { return stOperand.bConst ? ConstReg(stOperand.fValue) : stOperand.iReg; }
+
+    static unsigned char OpCode(eNODETYPE eNodeType)
+    {
+        switch (eNodeType)
+        {
+            case nFadd:                     return ExprOp::Add;
+            case nFsub:                     return ExprOp::Sub;
+            case nFmul:                     return ExprOp::Mul;
+            case nAdd:                      return ExprOp::IAdd;
+            case nSub:                      return ExprOp::ISub;
+            case nMul:                      return ExprOp::IMul;
+            case nFdiv:                     return ExprOp::Div;
+            case nDiv:                      return ExprOp::IDiv;
+            case nMod:                      return ExprOp::Mod;
+            case nAnd:                      return ExprOp::And;
+            case nOr:                       return ExprOp::Or;
+            case nxor:                      return ExprOp::Xor;
+            case nEqualto:                  return ExprOp::Eq;
+            case nNotEqualto:               return ExprOp::Ne;
+            case nLessThan:                 return ExprOp::Lt;
+            case nGreaterThan:
+            case nFGreaterThan:             return ExprOp::Gt;
+            case nFneg:                     return ExprOp::Neg;
+            case nneg:                      return ExprOp::INeg;
+            case nNot:                      return ExprOp::Not;
+            default:                        return ExprOp::Halt;
+        }
+    }
+
+    // True if the tree assigns to a variable (so a variable read before it must be copied first)
+
+    static bool isAssigning(stNODE * stNode)
+    {
+        if (!stNode || !stNode->stNodeData) return false;
+        auto eNodeType = stNode->stNodeData->eNodeType;
+        return eNodeType == nAssign || eNodeType == nPlusEqual || isAssigning(stNode->tLeft) || isAssigning(stNode->tRight);
+    }
+
+    // The register for a variable, given the next one the first time the variable is used
+
+    int VarReg(stNODE * stNode)
+    {
+        const stVARSTRUCT * stVar = stNode && stNode->stNodeData && stNode->stNodeData->eNodeType == nVar ? stNode->stNodeData->suTokenData.stVar : nullptr;
+        if (!stVar) return Fail("Assignment to something other than a variable"), -1;
+
+        auto it = m_mVarRegs.find(stVar);
+        if (it != m_mVarRegs.end()) return kVar | it->second;
+        if ((int) m_vVars.size() >= CExprProgram::kMaxRegisters) return Fail("Too many registers"), -1;
+
+        int iVar = (int) m_vVars.size();
+        m_vVars.push_back(stVar);
+        m_mVarRegs.emplace(stVar,iVar);
+        return kVar | iVar;
+    }
+
+    // Compiles an expression.  When iTarget is a register and the value takes one instruction, it is written there directly;
+    // otherwise the caller moves it.
+
+    bool Expr(stNODE * stNode,Operand_t & stResult,int iTarget = -1)
+    {
+        if (!stNode || !stNode->stNodeData) return Fail("Missing node in expression tree");
+        auto eNodeType = stNode->stNodeData->eNodeType;
+        if (!CExprTree::isSupported(eNodeType)) return Fail("Node type not supported by the bytecode compiler");
+
+        stResult = { false,0.0,-1 };
+        int iSave = m_iTemp;
+
+        switch (eNodeType)
+        {
+            case nNum:
+            case nFloat:
+                stResult = { true,CExprTree::NumberValue(*stNode->stNodeData),-1 };
+                return true;
+
+            case nVar:
+                stResult.iReg = VarReg(stNode);
+                return stResult.iReg >= 0;
+
+            case nAssign:
+            case nPlusEqual:
+            {
+                int iVar = VarReg(stNode->tLeft);
+                Operand_t stValue;
+                if (iVar < 0 || !Expr(stNode->tRight,stValue,eNodeType == nAssign ? iVar : -1)) return false;
+                m_iTemp = iSave;
+
+                if (eNodeType == nPlusEqual) Emit(ExprOp::Add,iVar,iVar,Reg(stValue));
+                else if (stValue.bConst || stValue.iReg != iVar) Emit(ExprOp::Mov,iVar,Reg(stValue));
+                stResult.iReg = iVar;
+                return true;
+            }
+
+            case nlogAnd:
+            case nlogOr:
+            {
+                bool bAnd = eNodeType == nlogAnd;
+                Operand_t stLeft,stRight;
+                if (!Expr(stNode->tLeft,stLeft)) return false;
+
+                // A constant left side decides whether the right side runs at all
+
+                if (stLeft.bConst)
+                {
+                    if ((stLeft.fValue != 0.0) != bAnd)
+                    {
+                        m_iDeadBranches++;
+                        stResult = { true,bAnd ? 0.0 : 1.0,-1 };
+                        return true;
+                    }
+                    if (!Expr(stNode->tRight,stRight)) return false;
+                    m_iTemp = iSave;
+                    if (stRight.bConst) stResult = { true,stRight.fValue != 0.0 ? 1.0 : 0.0,-1 };
+                    else Emit(ExprOp::Bool,stResult.iReg = iTarget >= 0 ? iTarget : NewTemp(),stRight.iReg);
+                    return true;
+                }
+
+                // Computed in a new temporary (not iTarget, which the right side may read)
+
+                m_iTemp = iSave;
+                int iTemp = NewTemp();
+                Emit(ExprOp::Bool,iTemp,stLeft.iReg);
+                int iJump = Emit(bAnd ? ExprOp::Jz : ExprOp::Jnz,iTemp,-1);
+                if (!Expr(stNode->tRight,stRight)) return false;
+                Emit(ExprOp::Bool,iTemp,Reg(stRight));
+                Patch(iJump);
+                m_iTemp = iSave;
+                stResult.iReg = NewTemp();          // Same register as iTemp
+                return true;
+            }
+
+            default:
+            {
+                Operand_t stLeft,stRight = { true,0.0,-1 };
+                bool bUnary = CExprTree::isUnary(eNodeType);
+                if (!Expr(bUnary ? CExprTree::UnaryChild(stNode) : stNode->tLeft,stLeft)) return false;
+
+                // The left side is evaluated first, so a variable the right side assigns to is copied before it does
+
+                if (!bUnary && !stLeft.bConst && (stLeft.iReg & kKindMask) == kVar && isAssigning(stNode->tRight))
+                {
+                    int iTemp = NewTemp();
+                    Emit(ExprOp::Mov,iTemp,stLeft.iReg);
+                    stLeft.iReg = iTemp;
+                }
+                if (!bUnary && !Expr(stNode->tRight,stRight)) return false;
+                m_iTemp = iSave;
+
+                if (stLeft.bConst && stRight.bConst)
+                {
+                    m_iFolded++;
+                    stResult = { true,CExprTree::Apply(eNodeType,stLeft.fValue,stRight.fValue),-1 };
+                    return true;
+                }
+
+                int iLeft = Reg(stLeft);
+                int iRight = bUnary ? 0 : Reg(stRight);
+                stResult.iReg = iTarget >= 0 ? iTarget : NewTemp();
+                Emit(OpCode(eNodeType),stResult.iReg,iLeft,iRight);
+                return true;
+            }
+        }
+    }
+
+    // Compiles a condition.  Returns false on an error; bConst/fValue are set if the condition is a constant.
+
+    bool Condition(stNODE * stCondition,Operand_t & stCond)
+    {
+        int iSave = m_iTemp;
+        if (!Expr(stCondition,stCond)) return false;
+        m_iTemp = iSave;
+        return true;
+    }
+
+    int Layout(int iReg,int iConstBase,int iTempBase) const
+    {
+        switch (iReg & kKindMask)
+        {
+            case kVar:      return iReg & kIndexMask;
+            case kConst:    return iConstBase + (iReg & kIndexMask);
+            case kTemp:     return iTempBase + (iReg & kIndexMask);
+            default:        return 0;
+        }
+    }
+
+public:
+    /// <summary>
+    /// Adds a statement (an expression tree, i.e. an assignment).  Returns false if the tree can't be compiled.
+    /// </summary>
+    bool AddStatement(stNODE * stStatement)
+    {
+        Operand_t stResult;
+        int iSave = m_iTemp;
+        if (!Expr(stStatement,stResult)) return false;
+        if (!m_iDead && m_vBlocks.empty()) m_iResult = stResult.bConst ? ConstReg(stResult.fValue) : stResult.iReg;
+        m_iTemp = iSave;
+
+        // The result of the last statement is returned by Run(), so it is kept out of the temporaries used after it
+
+        if (m_iResult >= 0 && (m_iResult & kKindMask) == kTemp) m_iTemp = (m_iResult & kIndexMask) + 1;
+        if (m_iTemp > m_iMaxTemp) m_iMaxTemp = m_iTemp;
+        return true;
+    }
+
+    bool AddStatement(CTree * cTree) { return cTree ? AddStatement(cTree->stMaster) : Fail("Missing tree"); }
+
+    /// <summary>
+    /// Starts a block run when stCondition is not zero, ended with EndIf() (optionally with an Else() part).
+    /// </summary>
+    bool If(stNODE * stCondition)
+    {
+        Block_t stBlock{ false,false,false,m_iDead > 0,0,-1 };
+        Operand_t stCond{ true,0.0,-1 };
+        if (!stBlock.bInDead && !Condition(stCondition,stCond)) return false;
+
+        if (stBlock.bInDead) m_iDead++;
+        else if (stCond.bConst)
+        {
+            stBlock.bConst = true;
+            stBlock.bDead = stCond.fValue == 0.0;
+            if (stBlock.bDead) m_iDead++, m_iDeadBranches++;
+        }
+        else stBlock.iJump = Emit(ExprOp::Jz,stCond.iReg,-1);
+
+        m_vBlocks.push_back(stBlock);
+        return true;
+    }
+
+    bool Else()
+    {
+        if (m_vBlocks.empty() || m_vBlocks.back().bWhile) return Fail("Else() without If()");
+        auto & stBlock = m_vBlocks.back();
+        if (stBlock.bInDead) return true;
+
+        if (stBlock.bConst)
+        {
+            if (stBlock.bDead) m_iDead--;
+            else m_iDead++, m_iDeadBranches++;
+            stBlock.bDead = !stBlock.bDead;
+            return true;
+        }
+
+        int iJump = Emit(ExprOp::Jmp,0,-1);
+        Patch(stBlock.iJump);
+        stBlock.iJump = iJump;
+        return true;
+    }
+
+    bool EndIf()
+    {
+        if (m_vBlocks.empty() || m_vBlocks.back().bWhile) return Fail("EndIf() without If()");
+        auto stBlock = m_vBlocks.back();
+        m_vBlocks.pop_back();
+
+        if (stBlock.bInDead || stBlock.bDead) m_iDead--;
+        else Patch(stBlock.iJump);
+        return true;
+    }
+
+    /// <summary>
+    /// Starts a loop run while stCondition is not zero (tested before each pass), ended with EndWhile().
+    /// </summary>
+    bool While(stNODE * stCondition)
+    {
+        Block_t stBlock{ true,false,false,m_iDead > 0,(int) m_vCode.size(),-1 };
+        Operand_t stCond{ true,0.0,-1 };
+        if (!stBlock.bInDead && !Condition(stCondition,stCond)) return false;
+
+        if (stBlock.bInDead) m_iDead++;
+        else if (stCond.bConst)
+        {
+            stBlock.bConst = true;
+            stBlock.bDead = stCond.fValue == 0.0;
+            if (stBlock.bDead) m_iDead++, m_iDeadBranches++;
+        }
+        else stBlock.iJump = Emit(ExprOp::Jz,stCond.iReg,-1);
+
+        m_vBlocks.push_back(stBlock);
+        return true;
+    }
+
+    bool EndWhile()
+    {
+        if (m_vBlocks.empty() || !m_vBlocks.back().bWhile) return Fail("EndWhile() without While()");
+        auto stBlock = m_vBlocks.back();
+        m_vBlocks.pop_back();
+
+        if (stBlock.bInDead || stBlock.bDead) m_iDead--;
+        else
+        {
+            Emit(ExprOp::Jmp,0,stBlock.iStart);
+            Patch(stBlock.iJump);
+        }
+        return true;
+    }
+
+    /// <summary>
+    /// Lays out the registers and writes the bytecode to cProgram.  Returns false (with GetError() set) if anything added
+    /// couldn't be compiled, a block wasn't ended, or more than 65536 registers are needed.
+    /// </summary>
+    bool Compile(CExprProgram & cProgram)
+    {
+        if (!m_vBlocks.empty()) Fail("If() or While() without EndIf() or EndWhile()");
+        if (m_sError) return false;
+
+        int iConstBase = (int) m_vVars.size();
+        int iTempBase = iConstBase + (int) m_vConstants.size();
+        if (iTempBase + m_iMaxTemp > CExprProgram::kMaxRegisters) return Fail("Too many registers");
+
+        cProgram.vCode.clear();
+        for (auto & stInstr : m_vCode)
+        {
+            bool bJump = stInstr.uOp == ExprOp::Jmp || stInstr.uOp == ExprOp::Jz || stInstr.uOp == ExprOp::Jnz;
+            int iB = bJump ? stInstr.iB : Layout(stInstr.iB,iConstBase,iTempBase);
+            cProgram.vCode.push_back({ stInstr.uOp,(unsigned short) Layout(stInstr.iA,iConstBase,iTempBase),
+                                       (unsigned short) (bJump ? iB & 0xffff : iB),(unsigned short) (bJump ? iB >> 16 : Layout(stInstr.iC,iConstBase,iTempBase)) });
+        }
+        cProgram.vCode.push_back({ ExprOp::Halt,(unsigned short) (m_iResult >= 0 ? Layout(m_iResult,iConstBase,iTempBase) : 0),0,0 });
+
+        cProgram.vConstants = m_vConstants;
+        cProgram.vVars      = m_vVars;
+        cProgram.mVarRegs   = m_mVarRegs;
+        cProgram.iRegisters = iTempBase + m_iMaxTemp;
+        return true;
+    }
+
+    const char * GetError() const { return m_sError; }
+
+    // Sub-expressions folded to constants, and branches (or && / || right sides) dropped as dead code
+
+    int GetFolded() const { return m_iFolded; }
+    int GetDeadBranches() const { return m_iDeadBranches; }
+};
+
+// CExprVM -- Runs a CExprProgram
+//
+// The VM has its own registers (with the program's constants loaded), so one CExprVM is needed per thread running the
+// program.  The program must exist as long as the VM.
+//
+// Each variable the program uses is bound to the double its value is kept in, with Bind() or BindAll().  Run() reads the
+// bound variables into their registers and writes them back when it's done; a variable that isn't bound keeps its value in
+// the VM from one Run() to the next (starting at 0).
+//
+class CExprVM
+{
+    const CExprProgram & m_cProgram;
+    std::vector<double> m_vRegs;
+    std::vector<double *> m_vBindings;                  // The value for each variable register (or nullptr)
+
+public:
+    CExprVM(const CExprProgram & cProgram) : m_cProgram(cProgram), m_vRegs(cProgram.iRegisters > 0 ? cProgram.iRegisters : 1),
+                                             m_vBindings(cProgram.vVars.size())
+    {
+        int iConstants = (int) cProgram.vConstants.size();
+        if (iConstants) memcpy(m_vRegs.data() + cProgram.vVars.size(),cProgram.vConstants.data(),iConstants*sizeof(double));
+    }
+
+    CExprVM(const CExprVM &) = delete;
+    CExprVM & operator = (const CExprVM &) = delete;
+
+    /// <summary>
+    /// Keeps stVar's value in *pValue (nullptr unbinds it).  Returns false if the program doesn't use stVar.
+    /// </summary>
+    bool Bind(const stVARSTRUCT * stVar,double * pValue)
+    {
+        int iReg = m_cProgram.FindVar(stVar);
+        if (iReg < 0) return false;
+        m_vBindings[iReg] = pValue;
+        return true;
+    }
+
+    /// <summary>
+    /// Binds every variable the program uses to fnBind(const stVARSTRUCT * stVar), which returns a double * (or nullptr).
+    /// </summary>
+    template<typename F>
+    void BindAll(F && fnBind)
+    {
+        for (size_t i=0;i<m_vBindings.size();i++) m_vBindings[i] = fnBind(m_cProgram.vVars[i]);
+    }
+
+    /// <summary>
+    /// Runs the program, reading the bound variables before and writing them back after.  Returns the value of the last
+    /// top-level statement.
+    /// </summary>
+    double Run()
+    {
+        double * r = m_vRegs.data();
+        int iVars = (int) m_vBindings.size();
+        for (int i=0;i<iVars;i++) if (m_vBindings[i]) r[i] = *m_vBindings[i];
+
+        const ExprInstr_t * pCode = m_cProgram.vCode.data();
+        const ExprInstr_t * pc = pCode;
+
+#if defined(__GNUC__) || defined(__clang__)
+        static void * const kDispatch[ExprOp::Count] =
+        {
+            &&opHalt,&&opMov,&&opAdd,&&opSub,&&opMul,&&opDiv,&&opIAdd,&&opISub,&&opIMul,&&opIDiv,&&opMod,&&opAnd,&&opOr,&&opXor,
+            &&opEq,&&opNe,&&opLt,&&opGt,&&opNeg,&&opINeg,&&opNot,&&opBool,&&opJmp,&&opJz,&&opJnz,
+        };
+        #define _ExprOp(_x)         op##_x:
+        #define _ExprDispatch()     goto *kDispatch[pc->uOp]
+        _ExprDispatch();
+#else
+        #define _ExprOp(_x)         case ExprOp::_x:
+        #define _ExprDispatch()     continue
+        for (;;) switch (pc->uOp)
+        {
+#endif
+        #define _ExprNext()         { ++pc; _ExprDispatch(); }
+
+            _ExprOp(Mov)    r[pc->uA] = r[pc->uB];                                              _ExprNext();
+            _ExprOp(Add)    r[pc->uA] = r[pc->uB] + r[pc->uC];                                  _ExprNext();
+            _ExprOp(Sub)    r[pc->uA] = r[pc->uB] - r[pc->uC];                                  _ExprNext();
+            _ExprOp(Mul)    r[pc->uA] = r[pc->uB]*r[pc->uC];                                    _ExprNext();
+            _ExprOp(Div)    r[pc->uA] = r[pc->uB]/r[pc->uC];                                    _ExprNext();
+            _ExprOp(IAdd)   r[pc->uA] = CExprTree::Apply(nAdd,r[pc->uB],r[pc->uC]);             _ExprNext();
+            _ExprOp(ISub)   r[pc->uA] = CExprTree::Apply(nSub,r[pc->uB],r[pc->uC]);             _ExprNext();
+            _ExprOp(IMul)   r[pc->uA] = CExprTree::Apply(nMul,r[pc->uB],r[pc->uC]);             _ExprNext();
+            _ExprOp(IDiv)   r[pc->uA] = CExprTree::Apply(nDiv,r[pc->uB],r[pc->uC]);             _ExprNext();
+            _ExprOp(Mod)    r[pc->uA] = CExprTree::Apply(nMod,r[pc->uB],r[pc->uC]);             _ExprNext();
+            _ExprOp(And)    r[pc->uA] = CExprTree::Apply(nAnd,r[pc->uB],r[pc->uC]);             _ExprNext();
+            _ExprOp(Or)     r[pc->uA] = CExprTree::Apply(nOr,r[pc->uB],r[pc->uC]);              _ExprNext();
+            _ExprOp(Xor)    r[pc->uA] = CExprTree::Apply(nxor,r[pc->uB],r[pc->uC]);             _ExprNext();
+            _ExprOp(Eq)     r[pc->uA] = r[pc->uB] == r[pc->uC] ? 1.0 : 0.0;                     _ExprNext();
+            _ExprOp(Ne)     r[pc->uA] = r[pc->uB] != r[pc->uC] ? 1.0 : 0.0;                     _ExprNext();
+            _ExprOp(Lt)     r[pc->uA] = r[pc->uB] < r[pc->uC] ? 1.0 : 0.0;                      _ExprNext();
+            _ExprOp(Gt)     r[pc->uA] = r[pc->uB] > r[pc->uC] ? 1.0 : 0.0;                      _ExprNext();
+            _ExprOp(Neg)    r[pc->uA] = -r[pc->uB];                                             _ExprNext();
+            _ExprOp(INeg)   r[pc->uA] = CExprTree::Apply(nneg,r[pc->uB],0.0);                   _ExprNext();
+            _ExprOp(Not)    r[pc->uA] = r[pc->uB] == 0.0 ? 1.0 : 0.0;                           _ExprNext();
+            _ExprOp(Bool)   r[pc->uA] = r[pc->uB] != 0.0 ? 1.0 : 0.0;                           _ExprNext();
+            _ExprOp(Jmp)    pc = pCode + pc->GetTarget();                                       _ExprDispatch();
+            _ExprOp(Jz)     if (r[pc->uA] == 0.0) { pc = pCode + pc->GetTarget(); _ExprDispatch(); }    _ExprNext();
+            _ExprOp(Jnz)    if (r[pc->uA] != 0.0) { pc = pCode + pc->GetTarget(); _ExprDispatch(); }    _ExprNext();
+            _ExprOp(Halt)   goto Done;
+
+#if !(defined(__GNUC__) || defined(__clang__))
+            default:        goto Done;
+        }
+#endif
+        #undef _ExprOp
+        #undef _ExprDispatch
+        #undef _ExprNext
+
+    Done:
+        for (int i=0;i<iVars;i++) if (m_vBindings[i]) *m_vBindings[i] = r[i];
+        return r[pc->uA];
+    }
+};
+
+} // namespace Sage
+#endif // _CExprVM_H_
@@ -0,0 +1,263 @@
+// This file copyright(c) 2021 Rob Nelson, All Rights Reserved.    E-mail rob@projectsagebox.com for more information.
+//
+
+#pragma once
+#if !defined(_CImageCache_H_)
+#define _CImageCache_H_
+
+#include <windows.h>
+#include "CRawBitmap.h"
+#include <cstdio>
+#include <cctype>
+#include <string>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+
+namespace Sage
+{
+
+// CImageCache -- Process-wide cache of bitmaps decoded from PGR files and memory (LRU, with a byte budget)
+//
+// Bitmaps in a PGR are stored compressed (JPEG or TPC), and are decoded each time they are read: CDavinci::ReadPgrBitmap()
+// and CSagePGR::ReadBitmap() decode again when a skinned dialog is reopened.  CImageCache keeps the decoded bitmaps, keyed by
+// the PGR and the entry name (CDavinci::GetPgrBitmap() and CSagePGR::GetBitmap() use it this way):
+//
+//      auto cBitmap = CImageCache::Get().GetOrDecode(CImageCache::PgrID(sPgrPath),"Bitmaps:Image1",[&]
+//      {
+//          return CDavinci::ReadPgrBitmap("Bitmaps:Image1",sPgrPath);      // Only called on a miss
+//      });
+//
+// Bitmaps are returned as std::shared_ptr<const CBitmap>, so a bitmap evicted from the cache (or removed with Clear()) stays
+// valid for anyone still using it, and is deleted when the last user releases it.
+//
+// Notes:
+//
+//      1. The budget (64MB by default, see SetBudget()) counts the bitmaps held by the cache.  When it is exceeded, the least-
+//         recently used bitmaps are evicted.  A bitmap larger than the budget is returned but not cached.
+//      2. PgrID(sPath) identifies a PGR file by its full path, size and write time, so a changed file doesn't return stale
+//         bitmaps.  PgrID(sMemory) identifies PGR memory by its address, which is meant for PGR data compiled into the program;
+//         for PGR memory that is freed, call RemovePgr() first, as the address may be reused.  CSagePGR::GetBitmap() keys
+//         memory PGRs by their size and CRCs as well (see CSagePGR::GetCacheID()), so it doesn't need RemovePgr().
+//      3. Bitmaps that fail to decode (invalid bitmaps) are not cached, so a missing entry is looked up again each time.
+//      4. CImageCache is thread-safe.  Decoding is done outside the lock, so two threads missing on the same entry at once may
+//         both decode it (the first one inserted is kept).
+//
+class CImageCache
+{
+public:
+    using Bitmap_t = std::shared_ptr<const CBitmap>;
+
+    static constexpr size_t kDefaultBudget = 64*1024*1024;
+
+    struct Stats_t
+    {
+        long long llHits;
+        long long llMisses;
+        long long llEvictions;
+        size_t uBytes;              // Bytes of bitmaps in the cache
+        size_t uBudget;
+        int iCount;                 // Bitmaps in the cache
+    };
+
+private:
+    struct Entry_t
+    {
+        std::string sKey;
+        Bitmap_t cBitmap;
+        size_t uBytes;
+    };
+
+    mutable std::mutex m_mutex;
+    std::list<Entry_t> m_lEntries;                                          // Most-recently used first
+    std::unordered_map<std::string,std::list<Entry_t>::iterator> m_mEntries;
+
+    size_t m_uBudget        = kDefaultBudget;
+    size_t m_uBytes         = 0;
+    long long m_llHits      = 0;
+    long long m_llMisses    = 0;
+    long long m_llEvictions = 0;
+
+    static std::string MakeKey(const std::string & sPgrID,const char * sEntry) { return sPgrID + '\x1f' + (sEntry ? sEntry : ""); }
+
+    static size_t BitmapBytes(const CBitmap & cBitmap) { return (size_t) cBitmap.stBitmap.iWidthBytes*(size_t) cBitmap.stBitmap.iHeight; }
+
+    // Evicts least-recently used bitmaps until the cache fits the budget (m_mutex must be held)
+
+    void Trim()
+    {
+        while (m_uBytes > m_uBudget && !m_lEntries.empty())
+        {
+            auto & stEntry = m_lEntries.back();
+            m_uBytes -= stEntry.uBytes;
+            m_mEntries.erase(stEntry.sKey);
+            m_lEntries.pop_back();
+            m_llEvictions++;
+        }
+    }
+
+    Bitmap_t FindKey(const std::string & sKey)
+    {
+        auto it = m_mEntries.find(sKey);
+        if (it == m_mEntries.end()) return nullptr;
+        m_lEntries.splice(m_lEntries.begin(),m_lEntries,it->second);
+        return it->second->cBitmap;
+    }
+
+public:
+    CImageCache() = default;
+    CImageCache(const CImageCache &) = delete;
+    CImageCache & operator = (const CImageCache &) = delete;
+
+    /// <summary>
+    /// Returns the process-wide cache shared by CSagePGR::GetBitmap() and CDavinci::GetPgrBitmap().
+    /// </summary>
+    static CImageCache & Get()
+    {
+        static CImageCache cCache;
+        return cCache;
+    }
+
+    /// <summary>
+    /// Returns the ID of a PGR file for cache keys: the full path (case-insensitive), size and last write time.
+    /// </summary>
+    static std::string PgrID(const char * sPath)
+    {
+        if (!sPath) return std::string();
+
+        char sFullPath[MAX_PATH];
+        DWORD dwLength = GetFullPathNameA(sPath,MAX_PATH,sFullPath,nullptr);
+        std::string sID(dwLength && dwLength < MAX_PATH ? sFullPath : sPath);
+        for (auto & c : sID) c = (char) tolower((unsigned char) c);
+
+        WIN32_FILE_ATTRIBUTE_DATA stData{};
+        if (GetFileAttributesExA(sPath,GetFileExInfoStandard,&stData))
+        {
+            char sStamp[64];
+            snprintf(sStamp,sizeof(sStamp),"|%lx%08lx|%lx%08lx",stData.nFileSizeHigh,stData.nFileSizeLow,
+                                                             stData.ftLastWriteTime.dwHighDateTime,stData.ftLastWriteTime.dwLowDateTime);
+            sID += sStamp;
+        }
+        return "file:" + sID;
+    }
+
+    /// <summary>
+    /// Returns the ID of PGR memory for cache keys (its address -- see the notes above).
+    /// </summary>
+    static std::string PgrID(const unsigned char * sPgrMemory)
+    {
+        char sID[32];
+        snprintf(sID,sizeof(sID),"mem:%p",(const void *) sPgrMemory);
+        return sID;
+    }
+
+    /// <summary>
+    /// Returns the cached bitmap for sEntry in the PGR, or nullptr if it isn't cached.  Counts a hit or a miss.
+    /// </summary>
+    Bitmap_t Find(const std::string & sPgrID,const char * sEntry)
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        auto cBitmap = FindKey(MakeKey(sPgrID,sEntry));
+        cBitmap ? m_llHits++ : m_llMisses++;
+        return cBitmap;
+    }
+
+    /// <summary>
+    /// Adds a decoded bitmap to the cache and returns it.  If a bitmap is already cached for the entry, that one is kept and
+    /// returned instead.  Invalid bitmaps and bitmaps larger than the budget are returned without being cached; nullptr is
+    /// returned for an invalid bitmap.
+    /// </summary>
+    Bitmap_t Insert(const std::string & sPgrID,const char * sEntry,CBitmap && cBitmap)
+    {
+        if (!cBitmap.isValid()) return nullptr;
+
+        size_t uBytes = BitmapBytes(cBitmap);
+        auto sKey = MakeKey(sPgrID,sEntry);
+
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (auto cCached = FindKey(sKey)) return cCached;
+
+        Bitmap_t cShared = std::make_shared<const CBitmap>(std::move(cBitmap));
+        if (uBytes > m_uBudget) return cShared;
+
+        m_lEntries.push_front({ std::move(sKey),cShared,uBytes });
+        m_mEntries[m_lEntries.front().sKey] = m_lEntries.begin();
+        m_uBytes += uBytes;
+        Trim();
+        return cShared;
+    }
+
+    /// <summary>
+    /// Returns the cached bitmap for sEntry in the PGR, or calls fnDecode() -- which returns a CBitmap -- to decode it and caches
+    /// the result.  Returns nullptr if the bitmap isn't cached and fnDecode() returns an invalid bitmap.
+    /// </summary>
+    template<typename F>
+    Bitmap_t GetOrDecode(const std::string & sPgrID,const char * sEntry,F && fnDecode)
+    {
+        auto sKey = MakeKey(sPgrID,sEntry);
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            if (auto cBitmap = FindKey(sKey)) { m_llHits++; return cBitmap; }
+            m_llMisses++;
+        }
+
+        // Another thread may have decoded the same entry while this one was -- Insert() keeps the first one
+
+        CBitmap cDecoded = fnDecode();
+        return Insert(sPgrID,sEntry,std::move(cDecoded));
+    }
+
+    /// <summary>
+    /// Removes the bitmaps cached for one PGR (i.e. before PGR memory is freed).  Returns the number removed.
+    /// </summary>
+    int RemovePgr(const std::string & sPgrID)
+    {
+        auto sPrefix = sPgrID + '\x1f';
+        int iRemoved = 0;
+
+        std::lock_guard<std::mutex> lock(m_mutex);
+        for (auto it = m_lEntries.begin();it != m_lEntries.end();)
+        {
+            if (it->sKey.compare(0,sPrefix.size(),sPrefix)) { ++it; continue; }
+            m_uBytes -= it->uBytes;
+            m_mEntries.erase(it->sKey);
+            it = m_lEntries.erase(it);
+            iRemoved++;
+        }
+        return iRemoved;
+    }
+
+    void Clear()
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_lEntries.clear();
+        m_mEntries.clear();
+        m_uBytes = 0;
+    }
+
+    /// <summary>
+    /// Sets the most memory the cached bitmaps can use, evicting bitmaps if the cache is now over it.
+    /// </summary>
+    void SetBudget(size_t uBytes)
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_uBudget = uBytes;
+        Trim();
+    }
+
+    Stats_t GetStats() const
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        return { m_llHits,m_llMisses,m_llEvictions,m_uBytes,m_uBudget,(int) m_lEntries.size() };
+    }
+
+    void ResetStats()
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_llHits = m_llMisses = m_llEvictions = 0;
+    }
+};
+
+} // namespace Sage
+#endif // _CImageCache_H_
@@ -14,12 +14,26 @@
 //#pragma once
 
 #include "Sage.h"
+#include "CThreadPool.h"
+#include <atomic>
+#include <cstdio>
+#include <mutex>
+#include <vector>
 
 #if !defined(_CJPEG_H_)
 #define _CJPEG_H_
 namespace Sage
 {
 
+// CJpeg -- JPEG decoding into RawBitmap_t
+//
+// ReadJpegBatch() reads a list of JPEG files (or decodes a list of memory buffers), i.e. for loading a folder of thumbnails
+// at startup.  The files are read across a CThreadPool, one CJpeg object per image.
+//
+// Note: the decoder keeps its state in the library (see SetBusy()), so it is not thread-safe, and decoding should only be
+// done on one thread at a time.  ReadJpegBatch() decodes one image at a time (under a lock shared by all batches), so only
+// the file reads overlap.  CJpeg calls made outside of ReadJpegBatch() while a batch is running are not covered by its lock.
+//
 class CJpeg
 {
 public:
@@ -37,10 +51,123 @@ private:
 	[[nodiscard]] RawBitmap_t ReadJpegMem(const unsigned char * sData,int iDataLength,bool * bSuccess = nullptr);
 	void SetBusy(bool bBusy);	// Stop-gap until multi-threading is more properly buit in
 	void SleepBusy();
+
+    // Serializes the decodes in ReadJpegBatch() (see notes above)
+
+    static std::mutex & GetDecodeLock()
+    {
+        static std::mutex mLock;
+        return mLock;
+    }
+
+    // Reads a whole file for ReadJpegBatch(), returning the same status ReadJpegFile() would for a missing or empty file
+
+    static Status ReadFileData(const char * sPath,std::vector<unsigned char> & vData)
+    {
+        if (!sPath || !*sPath) return Status::EmptyFilePath;
+
+        FILE * fFile = nullptr;
+#if defined(_MSC_VER)
+        if (fopen_s(&fFile,sPath,"rb")) fFile = nullptr;
+#else
+        fFile = fopen(sPath,"rb");
+#endif
+        if (!fFile) return Status::FileNotFound;
+
+        bool bRead = !fseek(fFile,0,SEEK_END);
+        long lLength = bRead ? ftell(fFile) : -1;
+        if (lLength > 0 && lLength < 0x7fffffff && !fseek(fFile,0,SEEK_SET))
+        {
+            vData.resize((size_t) lLength);
+            bRead = fread(vData.data(),1,vData.size(),fFile) == vData.size();
+        }
+        fclose(fFile);
+
+        if (lLength == 0) return Status::FileLengthZero;
+        return bRead && !vData.empty() ? Status::Ok : Status::Error;
+    }
+
+    // Runs fnLoad(iIndex,iLength,eStatus) -- which returns the image's data (or sets eStatus) -- across the pool, then decodes each
+    // image under GetDecodeLock().  Returns the number of images decoded.
+
+    template<typename F>
+    static int ReadBatch(int iCount,RawBitmap_t * stBitmaps,Status * eStatus,int iMaxThreads,CThreadPool & cPool,F && fnLoad)
+    {
+        if (iCount <= 0 || !stBitmaps) return 0;
+        std::atomic<int> iDecoded{0};
+
+        cPool.ParallelFor(iCount,[&](int iTask,int)
+        {
+            Status eLoad = Status::Ok;
+            int iLength = 0;
+            const unsigned char * sData = fnLoad(iTask,iLength,eLoad);
+
+            stBitmaps[iTask] = {};
+            if (eLoad == Status::Ok)
+            {
+                CJpeg cJpeg;
+                bool bSuccess = false;
+                {
+                    std::lock_guard<std::mutex> lock(GetDecodeLock());
+                    stBitmaps[iTask] = cJpeg.ReadJpeg(sData,iLength,&bSuccess);
+                }
+                eLoad = cJpeg.GetStatus();
+                if (bSuccess) iDecoded++;
+            }
+            if (eStatus) eStatus[iTask] = eLoad;
+        },iMaxThreads);
+
+        return iDecoded;
+    }
+
 public:
 	[[nodiscard]] RawBitmap_t  ReadJpegFile(const char * sPath,bool * bSuccess = nullptr);
 	[[nodiscard]] RawBitmap_t  ReadJpeg(const unsigned char * sData,int iDataLength,bool * bSuccess = nullptr);
 	Status GetStatus() { return m_eStatus; }		// Status of last opersation/request
+
+    /// <summary>
+    /// Reads iCount JPEG files across the thread pool (the files are read concurrently, and decoded one at a time).  stBitmaps[i]
+    /// receives the image for sPaths[i] (an empty bitmap if it could not be read), and eStatus[i] (if eStatus is not nullptr) its status.
+    /// <para></para>
+    /// --> The caller owns the returned bitmaps and must delete them (i.e. with DeleteBitmap() or by moving them into CBitmap objects).
+    /// </summary>
+    /// <param name="sPaths"> - Array of iCount file paths</param>
+    /// <param name="iCount"> - Number of files</param>
+    /// <param name="stBitmaps"> - Array of iCount bitmaps to receive the images</param>
+    /// <param name="eStatus"> - [optional] Array of iCount status values</param>
+    /// <param name="iMaxThreads"> - [optional] Maximum threads to use.  0 = all threads in the pool</param>
+    /// <returns>Number of images successfully read</returns>
+    static int ReadJpegBatch(const char * const * sPaths,int iCount,RawBitmap_t * stBitmaps,Status * eStatus = nullptr,int iMaxThreads = 0,
+                             CThreadPool & cPool = CThreadPool::GetDefault())
+    {
+        if (!sPaths || iCount <= 0) return 0;
+        std::vector<std::vector<unsigned char>> vFiles(iCount);
+        return ReadBatch(iCount,stBitmaps,eStatus,iMaxThreads,cPool,[&](int iIndex,int & iLength,Status & eLoad)
+        {
+            auto & vData = vFiles[iIndex];
+            eLoad = ReadFileData(sPaths[iIndex],vData);
+            iLength = (int) vData.size();
+            return vData.data();
+        });
+    }
+
+    /// <summary>
+    /// Decodes iCount JPEG images already in memory, one at a time (see the notes above).  stBitmaps[i] receives the image for
+    /// sData[i] (iDataLength[i] bytes), and eStatus[i] (if eStatus is not nullptr) its status.
+    /// <para></para>
+    /// --> The caller owns the returned bitmaps and must delete them (i.e. with DeleteBitmap() or by moving them into CBitmap objects).
+    /// </summary>
+    /// <returns>Number of images successfully decoded</returns>
+    static int ReadJpegBatch(const unsigned char * const * sData,const int * iDataLength,int iCount,RawBitmap_t * stBitmaps,Status * eStatus = nullptr,
+                             int iMaxThreads = 0,CThreadPool & cPool = CThreadPool::GetDefault())
+    {
+        if (!sData || !iDataLength) return 0;
+        return ReadBatch(iCount,stBitmaps,eStatus,iMaxThreads,cPool,[&](int iIndex,int & iLength,Status &)
+        {
+            iLength = iDataLength[iIndex];
+            return sData[iIndex];
+        });
+    }
 };
 }; // namespace Sage
 #endif // _CJPEG_H_
@@ -0,0 +1,322 @@
+// This file copyright(c) 2021 Rob Nelson, All Rights Reserved.    E-mail rob@projectsagebox.com for more information.
+//
+
+#pragma once
+#if !defined(_CMappedPGR_H_)
+#define _CMappedPGR_H_
+
+#include "CPgr.h"
+#include <string>
+#include <vector>
+#include <memory>
+#include <unordered_map>
+#include <cstring>
+#include <algorithm>
+
+namespace Sage
+{
+
+// CMappedPGR -- Memory-mapped CReadPGR for large PGR containers (i.e. skins opened at startup)
+//
+// CReadPGR reads through its virtual fopen()/fread()/fseek() functions.  CMappedPGR maps the container file once and serves
+// those calls from the mapped view, so reads are memory copies from the page cache with no file-system calls, and only the
+// pages actually used are ever read from disk.
+//
+// FindKey() and GetFileLocation() are indexed.  BuildIndex() (called on the first lookup, or directly, i.e. right after
+// opening a skin) walks the PGR's key table and file directory once and hashes every name, so a lookup is one hash probe with
+// no copying, decryption or linear search.  Key text is stored in a reusable arena.
+//
+// Notes:
+//
+//      1. Only calls made on the CMappedPGR itself are indexed.  FindKey() and GetFileLocation() are not virtual in CReadPGR,
+//         so code that reaches the PGR through a CReadPGR pointer or reference (including the library's own readers)
+//         still uses CReadPGR's search.
+//      2. The directory is read as stored.  BuildIndex() checks entries against CReadPGR's own lookup.  When the values can't
+//         be read directly (i.e. they are encrypted), only the key names are indexed, and each value is read through CReadPGR
+//         (which decrypts it) on its first lookup.  When the names can't be read either, or for sub-keys, entries are indexed on
+//         their first lookup.
+//      3. Missing keys and files are indexed too, so repeated lookups of optional keys are also O(1).
+//      4. Pointers returned by FindKey() stay valid until ClearIndex() or the CMappedPGR is deleted.
+//      5. Like CReadPGR, a CMappedPGR should be used by one thread at a time.
+//
+class CMappedPGR : public CReadPGR
+{
+public:
+    static constexpr size_t kArenaBlockSize = 64*1024;
+
+private:
+    HANDLE m_hFile              = INVALID_HANDLE_VALUE;
+    HANDLE m_hMapping           = nullptr;
+    const unsigned char * m_sView = nullptr;
+    size_t m_iViewSize          = 0;
+    size_t m_iPos               = 0;
+    bool m_bOpen                = false;
+
+    struct FileEntry_t
+    {
+        int iLocation;
+        int iFileSize;
+    };
+
+    std::unordered_map<std::string,const char *> m_mKeys;  // PendingKey() until the value is read (encrypted PGRs)
+    std::unordered_map<std::string,FileEntry_t> m_mFiles;
+    std::string m_sLookup;                                  // Reused so lookups of indexed entries don't allocate
+    bool m_bIndexed             = false;                    // BuildIndex() has run (since the last ClearIndex())
+
+    // Marks a key whose name is indexed but whose value hasn't been read yet
+
+    static const char * PendingKey() { static const char cPending = 0; return &cPending; }
+
+    // Arena for key text.  Blocks are kept when the index is cleared and reused.
+
+    std::vector<std::unique_ptr<char[]>> m_vArena;
+    std::vector<size_t> m_vArenaSize;
+    size_t m_iArenaBlock        = 0;
+    size_t m_iArenaUsed         = 0;
+
+    char * ArenaCopy(const char * sText)
+    {
+        size_t iLength = strlen(sText) + 1;
+        size_t iBlockSize = iLength > kArenaBlockSize ? iLength : kArenaBlockSize;
+
+        while (m_iArenaBlock < m_vArena.size() && m_iArenaUsed + iLength > m_vArenaSize[m_iArenaBlock]) m_iArenaBlock++, m_iArenaUsed = 0;
+        if (m_iArenaBlock == m_vArena.size())
+        {
+            m_vArena.emplace_back(new char[iBlockSize]);
+            m_vArenaSize.push_back(iBlockSize);
+            m_iArenaUsed = 0;
+        }
+
+        char * sDest = m_vArena[m_iArenaBlock].get() + m_iArenaUsed;
+        memcpy(sDest,sText,iLength);
+        m_iArenaUsed += iLength;
+        return sDest;
+    }
+
+    const std::string & LookupName(const char * sKey,const char * sSubKey)
+    {
+        m_sLookup.assign(sKey ? sKey : "");
+        if (sSubKey) m_sLookup.append(1,'\x1f').append(sSubKey);
+        return m_sLookup;
+    }
+
+    // Returns the string at iOffset in the string table, or nullptr if it is outside the table or not terminated within it
+
+    const char * TableString(unsigned int iOffset) const
+    {
+        if (!m_sStringTable || iOffset >= m_stPGRHeader.ulStringTableLength) return nullptr;
+        auto sString = m_sStringTable + iOffset;
+        return memchr(sString,0,m_stPGRHeader.ulStringTableLength - iOffset) ? sString : nullptr;
+    }
+
+    // Checks a key table entry against CReadPGR::FindKey().  Returns 0 if the name can't be read, 1 if the name is found
+    // but the stored value differs (encrypted), and 2 if both match.
+
+    int CheckKey(const stPGRKeyTable_t & stKey)
+    {
+        auto sName = TableString(stKey.ulKeynamePointer);
+        if (!sName || !*sName) return 0;
+        auto sValue = CReadPGR::FindKey(sName);
+        if (!sValue) return 0;
+        auto sStored = TableString(stKey.ulKeyValuePointer);
+        return sStored && !strcmp(sStored,sValue) ? 2 : 1;
+    }
+
+    bool CheckFile(const stPGRFileDirectory_t & stFile)
+    {
+        auto sName = TableString(stFile.ulFileNamePointer);
+        if (!sName || !*sName) return false;
+        int iFileSize = 0;
+        int iLocation = CReadPGR::GetFileLocation((char *) sName,&iFileSize);
+        return iLocation == (int) stFile.ulFilePointer && iFileSize == (int) stFile.ulFileSize;
+    }
+
+    bool MapFile(const char * sFile)
+    {
+        if (m_sView) return true;
+        if (!sFile || !*sFile) return false;
+
+        m_hFile = CreateFileA(sFile,GENERIC_READ,FILE_SHARE_READ,nullptr,OPEN_EXISTING,FILE_ATTRIBUTE_NORMAL | FILE_FLAG_RANDOM_ACCESS,nullptr);
+        if (m_hFile == INVALID_HANDLE_VALUE) return false;
+
+        LARGE_INTEGER liSize;
+        if (!GetFileSizeEx(m_hFile,&liSize) || !liSize.QuadPart) { UnmapFile(); return false; }
+
+        m_hMapping = CreateFileMappingA(m_hFile,nullptr,PAGE_READONLY,0,0,nullptr);
+        if (m_hMapping) m_sView = (const unsigned char *) MapViewOfFile(m_hMapping,FILE_MAP_READ,0,0,0);
+        if (!m_sView) { UnmapFile(); return false; }
+
+        m_iViewSize = (size_t) liSize.QuadPart;
+        return true;
+    }
+
+    void UnmapFile()
+    {
+        if (m_sView) UnmapViewOfFile(m_sView);
+        if (m_hMapping) CloseHandle(m_hMapping);
+        if (m_hFile != INVALID_HANDLE_VALUE) CloseHandle(m_hFile);
+        m_sView     = nullptr;
+        m_hMapping  = nullptr;
+        m_hFile     = INVALID_HANDLE_VALUE;
+        m_iViewSize = 0;
+        m_iPos      = 0;
+    }
+
+public:
+    CMappedPGR(const char * sFile) : CReadPGR((char *) sFile) { }
+
+    ~CMappedPGR()
+    {
+        // CReadPGR's destructor would call its own fclose() on m_fFile, which is not a real FILE here (same as CMemPGR)
+
+        m_fFile = nullptr;
+        UnmapFile();
+    }
+
+    CMappedPGR(const CMappedPGR &) = delete;
+    CMappedPGR & operator = (const CMappedPGR &) = delete;
+
+    // CReadPGR file interface, served from the mapped view.  The file is mapped on the first fopen() and stays mapped until
+    // the CMappedPGR is deleted, so CReadPGR opening and closing the file for each read costs nothing.
+
+    FILE * fopen(const char * sFile,const char * sControl) override
+    {
+        if (!MapFile(sFile)) return nullptr;
+        m_iPos  = 0;
+        m_bOpen = true;
+        return (FILE *) this;
+    }
+
+    int fclose(FILE * fFile) override
+    {
+        m_bOpen = false;
+        return 0;
+    }
+
+    size_t fread(void * pDest,size_t iWidth,size_t iLength,FILE * fFile) override
+    {
+        if (!m_bOpen || !pDest || !iWidth || m_iPos >= m_iViewSize) return 0;
+        size_t iItems = (m_iViewSize - m_iPos)/iWidth;
+        if (iItems > iLength) iItems = iLength;
+        memcpy(pDest,m_sView + m_iPos,iItems*iWidth);
+        m_iPos += iItems*iWidth;
+        return iItems;
+    }
+
+    int fseek(FILE * fFile,long iLocation,int iStart) override
+    {
+        long long iBase = iStart == SEEK_CUR ? (long long) m_iPos : iStart == SEEK_END ? (long long) m_iViewSize : 0;
+        long long iPos = iBase + iLocation;
+        if (!m_bOpen || iPos < 0) return -1;
+        m_iPos = (size_t) iPos;
+        return 0;
+    }
+
+    long filelength(int iFile) override { return (long) m_iViewSize; }
+
+    /// <summary>
+    /// Returns the mapped container (nullptr if the file could not be opened), for reading stored files directly by location
+    /// with no copy -- i.e. GetMappedData() + GetFileLocation().  Data in the PGR is stored as written (encrypted data must be decrypted).
+    /// </summary>
+    const unsigned char * GetMappedData(size_t * iSize = nullptr) const { if (iSize) *iSize = m_iViewSize; return m_sView; }
+
+    /// <summary>
+    /// Indexes every key and file in the PGR directory.  This is called on the first FindKey() or GetFileLocation(), and can be
+    /// called earlier (i.e. when a skin is opened) to do the work up front.  Returns false if the PGR could not be read.
+    /// <para></para>
+    /// --> Keys are read as stored when the first and last entries match CReadPGR::FindKey().  When only the names match (the
+    /// values are encrypted), just the names are indexed here, and each value is read through CReadPGR::FindKey() the first
+    /// time it is looked up.  Files are read as stored when the first and last entries match CReadPGR::GetFileLocation().
+    /// Anything not indexed here is indexed on its first lookup.
+    /// </summary>
+    bool BuildIndex()
+    {
+        if (m_bIndexed) return true;
+        if ((!m_stPGRKeyTable || !m_stPGRFileDirectory) && ReadFile() != ePGR_OK) return false;
+        m_bIndexed = true;
+
+        int iKeys   = m_stPGRKeyTable ? (int) m_stPGRHeader.ulNumKeys : 0;
+        int iFiles  = m_stPGRFileDirectory ? (int) m_stPGRHeader.ulNumFiles : 0;
+
+        if (iKeys)
+        {
+            int iCheck = CheckKey(m_stPGRKeyTable[0]);
+            if (iCheck && iKeys > 1) iCheck = (std::min)(iCheck,CheckKey(m_stPGRKeyTable[iKeys-1]));
+
+            for (int i=0;iCheck && i<iKeys;i++)
+            {
+                auto sName = TableString(m_stPGRKeyTable[i].ulKeynamePointer);
+                if (!sName || m_mKeys.count(sName)) continue;
+
+                if (iCheck == 1) { m_mKeys.emplace(sName,PendingKey()); continue; }
+
+                auto sValue = TableString(m_stPGRKeyTable[i].ulKeyValuePointer);
+                m_mKeys.emplace(sName,sValue ? ArenaCopy(sValue) : nullptr);
+            }
+        }
+
+        if (iFiles && CheckFile(m_stPGRFileDirectory[0]) && CheckFile(m_stPGRFileDirectory[iFiles-1]))
+            for (int i=0;i<iFiles;i++)
+            {
+                auto & stFile = m_stPGRFileDirectory[i];
+                if (auto sName = TableString(stFile.ulFileNamePointer))
+                    m_mFiles.emplace(sName,FileEntry_t{ (int) stFile.ulFilePointer,(int) stFile.ulFileSize });
+            }
+        return true;
+    }
+
+    /// <summary>
+    /// Indexed version of CReadPGR::FindKey().  Returns nullptr if the key does not exist.  See BuildIndex().
+    /// </summary>
+    char * FindKey(const char * sKey,const char * sSubKey = NULL)
+    {
+        BuildIndex();
+        auto & sName = LookupName(sKey,sSubKey);
+        auto it = m_mKeys.find(sName);
+        if (it != m_mKeys.end() && it->second != PendingKey()) return (char *) it->second;
+
+        const char * sValue = CReadPGR::FindKey(sKey,sSubKey);
+        if (sValue) sValue = ArenaCopy(sValue);
+        if (it != m_mKeys.end()) it->second = sValue;
+        else m_mKeys.emplace(sName,sValue);
+        return (char *) sValue;
+    }
+
+    /// <summary>
+    /// Indexed version of CReadPGR::GetFileLocation().  Returns the location of sFile in the container (or the same value
+    /// CReadPGR::GetFileLocation() returns when it is not found), and its size in iFileSize.  See BuildIndex().
+    /// </summary>
+    int GetFileLocation(char * sFile,int * iFileSize = NULL)
+    {
+        BuildIndex();
+        auto & sName = LookupName(sFile,nullptr);
+        auto it = m_mFiles.find(sName);
+        if (it == m_mFiles.end())
+        {
+            FileEntry_t stEntry{};
+            stEntry.iLocation = CReadPGR::GetFileLocation(sFile,&stEntry.iFileSize);
+            it = m_mFiles.emplace(sName,stEntry).first;
+        }
+        if (iFileSize) *iFileSize = it->second.iFileSize;
+        return it->second.iLocation;
+    }
+
+    /// <summary>
+    /// Clears the key and file index (it is built again on the next lookup).  Arena memory is kept and reused.  Pointers returned by
+    /// FindKey() are no longer valid.
+    /// </summary>
+    void ClearIndex()
+    {
+        m_bIndexed = false;
+        m_mKeys.clear();
+        m_mFiles.clear();
+        m_iArenaBlock   = 0;
+        m_iArenaUsed    = 0;
+    }
+
+    size_t GetIndexedKeys() const { return m_mKeys.size(); }
+    size_t GetIndexedFiles() const { return m_mFiles.size(); }
+};
+
+} // namespace Sage
+#endif // _CMappedPGR_H_
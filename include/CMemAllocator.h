@@ -0,0 +1,754 @@
+// This file copyright(c) 2021 Rob Nelson, All Rights Reserved.    E-mail rob@projectsagebox.com for more information.
+//
+
+#pragma once
+#if !defined(_CMemAllocator_H_)
+#define _CMemAllocator_H_
+
+#include <windows.h>
+#include <malloc.h>
+#include <cstring>
+#include <atomic>
+#include <mutex>
+#include <vector>
+#include <new>
+#include <memory>
+#include <algorithm>
+#include <type_traits>
+
+namespace Sage
+{
+
+// ----------------------
+// MemT allocators
+// ----------------------
+//
+// MemT<> (below) is a Mem<>/MemA<>-style array that gets its memory from a CMemAllocator, rather than calling malloc() and free()
+// directly.  The allocator is given to the constructor (or is CMemAllocator::GetDefault()), and is kept with the memory, so memory
+// is always returned to the allocator it came from.
+//
+// Only MemT uses these allocators.  Mem<> and MemA<> (see CMemClass.h) are passed to and from the library, so they keep their
+// layout and use malloc()/_aligned_malloc() as before, and RawBitmap_t and CBitmap memory is still allocated by the library.
+// SetDefault() doesn't change any of these -- to use an allocator for image data, keep the pixels in a MemT.
+//
+//      CHeapAllocator          malloc()/_aligned_malloc() -- the default, the same memory Mem and MemA use
+//      CPoolAllocator          Size-class pools: freed blocks are kept and reused for the next allocation of the same size
+//                              class, i.e. image buffers of the same (or similar) dimensions created every frame
+//      CScratchArena           Per-thread bump allocator for per-frame scratch memory -- allocation is a pointer increment,
+//                              and everything is released at once with Reset() or a CScratchScope
+//      CHugePageAllocator      VirtualAlloc() with large pages (when the process has the "Lock pages in memory" privilege),
+//                              for very large buffers
+//
+// For example, per-frame temporary buffers that were going to the heap (and its lock) can be taken from the scratch arena:
+//
+//      CScratchScope cScope;                                                   // Everything below is released at the '}'
+//      MemT<float> fTemp(iWidth*iHeight,CScratchArena::GetThread());
+//
+// Each allocator counts its allocations, frees and bytes in use (see GetCounters()).
+//
+// Notes:
+//
+//      1. Sizes are size_t (64-bit), so MemT allocations are not limited to 2GB (Mem and MemA still are).
+//      2. Free() and Reallocate() must be given the same size and alignment that the memory was allocated with (MemT always
+//         does this).  Alignments of 16 or less give memory compatible with malloc()/free().
+//
+
+struct MemCounters_t
+{
+    unsigned long long ullAllocs;           // Number of allocations (including reallocations)
+    unsigned long long ullFrees;            // Number of frees (including reallocations)
+    unsigned long long ullBytesInUse;       // Bytes allocated and not yet freed
+    unsigned long long ullPeakBytes;        // Highest ullBytesInUse
+};
+
+class CMemAllocator
+{
+    std::atomic<unsigned long long> m_ullAllocs{0};
+    std::atomic<unsigned long long> m_ullFrees{0};
+    std::atomic<unsigned long long> m_ullBytesInUse{0};
+    std::atomic<unsigned long long> m_ullPeakBytes{0};
+
+    static std::atomic<CMemAllocator *> & DefaultAllocator();
+
+protected:
+    void CountAlloc(size_t uBytes)
+    {
+        m_ullAllocs.fetch_add(1,std::memory_order_relaxed);
+        auto ullInUse = m_ullBytesInUse.fetch_add(uBytes,std::memory_order_relaxed) + uBytes;
+        auto ullPeak = m_ullPeakBytes.load(std::memory_order_relaxed);
+        while (ullInUse > ullPeak && !m_ullPeakBytes.compare_exchange_weak(ullPeak,ullInUse,std::memory_order_relaxed));
+    }
+
+    void CountFree(size_t uBytes)
+    {
+        m_ullFrees.fetch_add(1,std::memory_order_relaxed);
+        m_ullBytesInUse.fetch_sub(uBytes,std::memory_order_relaxed);
+    }
+
+public:
+    CMemAllocator() = default;
+    CMemAllocator(const CMemAllocator &) = delete;
+    CMemAllocator & operator = (const CMemAllocator &) = delete;
+    virtual ~CMemAllocator() = default;
+
+    /// <summary>
+    /// Allocates uBytes aligned to uAlign bytes (a power of 2).  Returns nullptr if the memory can't be allocated.
+    /// </summary>
+    virtual void * Allocate(size_t uBytes,size_t uAlign) = 0;
+
+    /// <summary>
+    /// Frees memory from Allocate() or Reallocate(), with the size and alignment it was allocated with.
+    /// </summary>
+    virtual void Free(void * pMem,size_t uBytes,size_t uAlign) = 0;
+
+    /// <summary>
+    /// Resizes memory, keeping its contents (up to the smaller size).  pMem may be nullptr.  Returns nullptr (leaving pMem
+    /// unchanged) if the memory can't be allocated.
+    /// </summary>
+    virtual void * Reallocate(void * pMem,size_t uOldBytes,size_t uNewBytes,size_t uAlign)
+    {
+        void * pNew = Allocate(uNewBytes,uAlign);
+        if (!pNew) return nullptr;
+        if (pMem)
+        {
+            memcpy(pNew,pMem,(std::min)(uOldBytes,uNewBytes));
+            Free(pMem,uOldBytes,uAlign);
+        }
+        return pNew;
+    }
+
+    virtual const char * GetName() const = 0;
+
+    /// <summary>
+    /// Counts uBytes allocated outside of the allocator (i.e. with malloc()) that will be returned with Free() -- see MemT::SetData().
+    /// </summary>
+    void Adopt(size_t uBytes) { CountAlloc(uBytes); }
+
+    MemCounters_t GetCounters() const
+    {
+        return { m_ullAllocs.load(std::memory_order_relaxed),m_ullFrees.load(std::memory_order_relaxed),
+                 m_ullBytesInUse.load(std::memory_order_relaxed),m_ullPeakBytes.load(std::memory_order_relaxed) };
+    }
+
+    // GetHeap() -- the process-wide CHeapAllocator
+
+    static CMemAllocator & GetHeap();
+
+    // GetDefault() -- the allocator used by MemT objects that aren't given one (GetHeap() unless changed with SetDefault())
+
+    static CMemAllocator & GetDefault() { return *DefaultAllocator().load(std::memory_order_acquire); }
+
+    /// <summary>
+    /// Sets the allocator used by MemT objects that aren't given one.  Objects that already have memory keep using the
+    /// allocator they have.  The allocator must exist for the rest of the program.  nullptr restores GetHeap().
+    /// </summary>
+    static void SetDefault(CMemAllocator * pAllocator) { DefaultAllocator().store(pAllocator ? pAllocator : &GetHeap(),std::memory_order_release); }
+};
+
+// CHeapAllocator -- malloc()/realloc()/free(), or _aligned_malloc() and friends for alignments over 16 bytes
+
+class CHeapAllocator final : public CMemAllocator
+{
+public:
+    void * Allocate(size_t uBytes,size_t uAlign) override
+    {
+        void * pMem = uAlign <= 16 ? malloc(uBytes) : _aligned_malloc(uBytes,uAlign);
+        if (pMem) CountAlloc(uBytes);
+        return pMem;
+    }
+
+    void Free(void * pMem,size_t uBytes,size_t uAlign) override
+    {
+        if (!pMem) return;
+        if (uAlign <= 16) free(pMem);
+        else _aligned_free(pMem);
+        CountFree(uBytes);
+    }
+
+    void * Reallocate(void * pMem,size_t uOldBytes,size_t uNewBytes,size_t uAlign) override
+    {
+        void * pNew = uAlign <= 16 ? realloc(pMem,uNewBytes) : _aligned_realloc(pMem,uNewBytes,uAlign);
+        if (!pNew) return nullptr;
+        if (pMem) CountFree(uOldBytes);
+        CountAlloc(uNewBytes);
+        return pNew;
+    }
+
+    const char * GetName() const override { return "Heap"; }
+};
+
+inline CMemAllocator & CMemAllocator::GetHeap()
+{
+    static CHeapAllocator cHeap;
+    return cHeap;
+}
+
+inline std::atomic<CMemAllocator *> & CMemAllocator::DefaultAllocator()
+{
+    static std::atomic<CMemAllocator *> pDefault{&GetHeap()};
+    return pDefault;
+}
+
+// CPoolAllocator -- Size-class pools on top of the heap
+//
+// Sizes from kMinBlock to the maximum pooled size are rounded up to one of 4 size classes per power of 2 (so at most 25% is
+// wasted), and freed blocks are kept on a free list for their class rather than returned to the heap.  The next allocation in
+// the same class takes a block from the list, so creating and deleting MemT buffers of the same size every frame stops going
+// to the heap after the first frame.
+//
+// Notes:
+//
+//      1. Each size class has its own lock, so threads allocating different sizes don't wait on each other.
+//      2. Up to GetMaxCached() bytes are kept on the free lists (freed blocks past that go back to the heap).  Trim() returns
+//         all kept blocks to the heap.
+//      3. Blocks are aligned to kBlockAlign bytes.  Smaller sizes, larger sizes and larger alignments go to the heap directly.
+//
+class CPoolAllocator final : public CMemAllocator
+{
+public:
+    static constexpr int kMinShift          = 12;                       // Smallest pooled block: 4K
+    static constexpr size_t kMinBlock       = (size_t) 1 << kMinShift;
+    static constexpr int kMaxShift          = 30;                       // Largest pooled block: 1GB
+    static constexpr size_t kBlockAlign     = 128;
+    static constexpr int kNumClasses        = 1 + (kMaxShift - kMinShift)*4;
+
+private:
+    struct alignas(64) Class_t
+    {
+        std::mutex mLock;
+        std::vector<void *> vFree;
+    };
+
+    Class_t m_stClasses[kNumClasses];
+    size_t m_uMaxPooled;
+    std::atomic<size_t> m_uMaxCached;
+    std::atomic<size_t> m_uCached{0};
+    std::atomic<unsigned long long> m_ullHits{0};
+    std::atomic<unsigned long long> m_ullMisses{0};
+
+    // Returns the size class for uBytes (-1 if it isn't pooled), and sets uClassBytes to the size of its blocks
+
+    int GetClass(size_t uBytes,size_t & uClassBytes) const
+    {
+        if (uBytes < kMinBlock || uBytes > m_uMaxPooled) return -1;
+        if (uBytes == kMinBlock) { uClassBytes = kMinBlock; return 0; }
+
+        int iShift = kMinShift;
+        size_t uValue = uBytes - 1;
+        while ((uValue >> iShift) > 1) iShift++;                   // 2^iShift <= uBytes-1 < 2^(iShift+1)
+
+        size_t uStep = (size_t) 1 << (iShift - 2);
+        int iQuarter = (int) (uValue >> (iShift - 2));             // 4-7
+        uClassBytes = (iQuarter + 1)*uStep;
+        return 1 + (iShift - kMinShift)*4 + (iQuarter - 4);
+    }
+
+public:
+    /// <summary>
+    /// Creates a pool allocator keeping up to uMaxCached bytes of freed blocks, for sizes up to uMaxPooled bytes.
+    /// </summary>
+    CPoolAllocator(size_t uMaxCached = (size_t) 512 << 20,size_t uMaxPooled = (size_t) 256 << 20)
+        : m_uMaxPooled((std::min)(uMaxPooled,(size_t) 1 << kMaxShift)), m_uMaxCached(uMaxCached) { }
+
+    ~CPoolAllocator() { Trim(); }
+
+    void * Allocate(size_t uBytes,size_t uAlign) override
+    {
+        size_t uClassBytes;
+        int iClass = uAlign <= kBlockAlign ? GetClass(uBytes,uClassBytes) : -1;
+        if (iClass < 0)
+        {
+            void * pMem = _aligned_malloc(uBytes,(std::max)(uAlign,(size_t) 16));
+            if (pMem) CountAlloc(uBytes);
+            return pMem;
+        }
+
+        void * pMem = nullptr;
+        {
+            auto & stClass = m_stClasses[iClass];
+            std::lock_guard<std::mutex> lock(stClass.mLock);
+            if (!stClass.vFree.empty())
+            {
+                pMem = stClass.vFree.back();
+                stClass.vFree.pop_back();
+            }
+        }
+
+        if (pMem)
+        {
+            m_uCached.fetch_sub(uClassBytes,std::memory_order_relaxed);
+            m_ullHits.fetch_add(1,std::memory_order_relaxed);
+        }
+        else
+        {
+            if (!(pMem = _aligned_malloc(uClassBytes,kBlockAlign))) return nullptr;
+            m_ullMisses.fetch_add(1,std::memory_order_relaxed);
+        }
+        CountAlloc(uBytes);
+        return pMem;
+    }
+
+    void Free(void * pMem,size_t uBytes,size_t uAlign) override
+    {
+        if (!pMem) return;
+        CountFree(uBytes);
+
+        size_t uClassBytes;
+        int iClass = uAlign <= kBlockAlign ? GetClass(uBytes,uClassBytes) : -1;
+        if (iClass >= 0 && m_uCached.fetch_add(uClassBytes,std::memory_order_relaxed) + uClassBytes <= m_uMaxCached.load(std::memory_order_relaxed))
+        {
+            auto & stClass = m_stClasses[iClass];
+            std::lock_guard<std::mutex> lock(stClass.mLock);
+            stClass.vFree.push_back(pMem);
+            return;
+        }
+
+        if (iClass >= 0) m_uCached.fetch_sub(uClassBytes,std::memory_order_relaxed);
+        _aligned_free(pMem);
+    }
+
+    void * Reallocate(void * pMem,size_t uOldBytes,size_t uNewBytes,size_t uAlign) override
+    {
+        // Same size class -- the block already has room
+
+        size_t uOldClass, uNewClass;
+        if (pMem && uAlign <= kBlockAlign)
+        {
+            int iOld = GetClass(uOldBytes,uOldClass);
+            if (iOld >= 0 && iOld == GetClass(uNewBytes,uNewClass))
+            {
+                CountFree(uOldBytes);
+                CountAlloc(uNewBytes);
+                return pMem;
+            }
+        }
+        return CMemAllocator::Reallocate(pMem,uOldBytes,uNewBytes,uAlign);
+    }
+
+    /// <summary>
+    /// Returns all blocks kept on the free lists to the heap.
+    /// </summary>
+    void Trim()
+    {
+        for (auto & stClass : m_stClasses)
+        {
+            std::lock_guard<std::mutex> lock(stClass.mLock);
+            for (auto pMem : stClass.vFree) _aligned_free(pMem);
+            stClass.vFree.clear();
+        }
+        m_uCached.store(0,std::memory_order_relaxed);
+    }
+
+    void SetMaxCached(size_t uMaxCached) { m_uMaxCached.store(uMaxCached,std::memory_order_relaxed); }
+    size_t GetMaxCached() const { return m_uMaxCached.load(std::memory_order_relaxed); }
+    size_t GetCached() const { return m_uCached.load(std::memory_order_relaxed); }
+
+    // Allocations served from a free list (hits) and from the heap (misses)
+
+    unsigned long long GetHits() const { return m_ullHits.load(std::memory_order_relaxed); }
+    unsigned long long GetMisses() const { return m_ullMisses.load(std::memory_order_relaxed); }
+
+    const char * GetName() const override { return "Pool"; }
+
+    // GetBitmapPool() -- a process-wide pool for image-sized MemT buffers (RawBitmap_t and CBitmap memory doesn't come from here)
+
+    static CPoolAllocator & GetBitmapPool()
+    {
+        static CPoolAllocator cPool;
+        return cPool;
+    }
+};
+
+// CScratchArena -- Per-thread bump allocator for per-frame scratch memory
+//
+// Memory is taken from large blocks by moving a pointer, and is only given back all at once: with Reset() (i.e. at the end of
+// a frame) or when a CScratchScope ends.  The blocks are kept, so after the first frame a frame's scratch memory doesn't
+// allocate at all.
+//
+//      void DrawFrame()
+//      {
+//          CScratchScope cScope;
+//          MemT<float,CScratchArena,128> fBlur(iWidth*iHeight,CScratchArena::GetThread());
+//          ...
+//      }                                                                   // All scratch memory from DrawFrame() released
+//
+// Notes:
+//
+//      1. GetThread() returns the calling thread's arena -- only use an arena on the thread it belongs to.
+//      2. Free() only gives memory back if it's the last allocation (so a MemT that grows and shrinks reuses the same space);
+//         otherwise memory is held until Reset() or the end of the CScratchScope.
+//      3. Memory must not be used after the Reset() or CScratchScope that releases it.
+//
+class CScratchArena final : public CMemAllocator
+{
+public:
+    static constexpr size_t kBlockBytes = (size_t) 4 << 20;
+    static constexpr size_t kBlockAlign = 128;
+
+    struct Mark_t
+    {
+        size_t iBlock;
+        size_t uUsed;
+    };
+
+private:
+    struct AlignedDelete_t { void operator()(unsigned char * pMem) const { ::operator delete[](pMem,std::align_val_t(kBlockAlign)); } };
+
+    struct Block_t
+    {
+        std::unique_ptr<unsigned char[],AlignedDelete_t> pMem;
+        size_t uSize;
+        size_t uUsed;
+    };
+
+    std::vector<Block_t> m_vBlocks;
+    size_t m_iBlock         = 0;            // Block being allocated from
+    void * m_pLast          = nullptr;      // Last allocation, and the block position before it
+    size_t m_uLastStart     = 0;
+
+    static size_t AlignUp(size_t uValue,size_t uAlign) { return (uValue + uAlign - 1) & ~(uAlign - 1); }
+
+    bool isThread() const { return this == &GetThread(); }
+
+public:
+    CScratchArena() = default;
+
+    static CScratchArena & GetThread()
+    {
+        static thread_local CScratchArena cArena;
+        return cArena;
+    }
+
+    void * Allocate(size_t uBytes,size_t uAlign) override
+    {
+        uAlign = (std::max)(uAlign,(size_t) 16);
+        if (uAlign > kBlockAlign) return nullptr;
+
+        for (;;)
+        {
+            if (m_iBlock < m_vBlocks.size())
+            {
+                auto & stBlock = m_vBlocks[m_iBlock];
+                size_t uStart = AlignUp(stBlock.uUsed,uAlign);
+                if (uStart + uBytes <= stBlock.uSize)
+                {
+                    m_uLastStart    = stBlock.uUsed;
+                    stBlock.uUsed   = uStart + uBytes;
+                    m_pLast         = stBlock.pMem.get() + uStart;
+                    CountAlloc(uBytes);
+                    return m_pLast;
+                }
+
+                // Full -- move on to the next block
+
+                if (stBlock.uUsed) { m_iBlock++; continue; }
+            }
+
+            // No block, or an unused one that's too small -- add one here, keeping any unused blocks after it for later frames
+
+            size_t uSize = (std::max)(kBlockBytes,AlignUp(uBytes,kBlockAlign));
+            Block_t stBlock{ std::unique_ptr<unsigned char[],AlignedDelete_t>((unsigned char *) ::operator new[](uSize,std::align_val_t(kBlockAlign),std::nothrow)),uSize,0 };
+            if (!stBlock.pMem) return nullptr;
+            m_vBlocks.insert(m_vBlocks.begin() + m_iBlock,std::move(stBlock));
+        }
+    }
+
+    void Free(void * pMem,size_t uBytes,size_t) override
+    {
+        if (!pMem) return;
+        CountFree(uBytes);
+        if (pMem == m_pLast && isThread())
+        {
+            m_vBlocks[m_iBlock].uUsed = m_uLastStart;
+            m_pLast = nullptr;
+        }
+    }
+
+    void * Reallocate(void * pMem,size_t uOldBytes,size_t uNewBytes,size_t uAlign) override
+    {
+        // The last allocation can grow (or shrink) in place when its block has room
+
+        if (pMem && pMem == m_pLast && isThread())
+        {
+            auto & stBlock = m_vBlocks[m_iBlock];
+            size_t uStart = (unsigned char *) pMem - stBlock.pMem.get();
+            if (uStart + uNewBytes <= stBlock.uSize)
+            {
+                stBlock.uUsed = uStart + uNewBytes;
+                CountFree(uOldBytes);
+                CountAlloc(uNewBytes);
+                return pMem;
+            }
+        }
+        return CMemAllocator::Reallocate(pMem,uOldBytes,uNewBytes,uAlign);
+    }
+
+    Mark_t GetMark() const { return { m_iBlock,m_vBlocks.empty() ? 0 : m_vBlocks[m_iBlock].uUsed }; }
+
+    /// <summary>
+    /// Releases everything allocated since stMark was taken with GetMark().
+    /// </summary>
+    void Release(const Mark_t & stMark)
+    {
+        if (m_vBlocks.empty()) return;
+        for (size_t i=stMark.iBlock + 1;i<=m_iBlock && i<m_vBlocks.size();i++) m_vBlocks[i].uUsed = 0;
+        m_iBlock = stMark.iBlock;
+        m_vBlocks[m_iBlock].uUsed = stMark.uUsed;
+        m_pLast = nullptr;
+    }
+
+    /// <summary>
+    /// Releases all scratch memory (the blocks are kept for reuse).
+    /// </summary>
+    void Reset() { Release({ 0,0 }); }
+
+    /// <summary>
+    /// Releases all scratch memory and frees the blocks.
+    /// </summary>
+    void FreeBlocks()
+    {
+        m_vBlocks.clear();
+        m_iBlock = 0;
+        m_pLast = nullptr;
+    }
+
+    size_t GetBlockBytes() const
+    {
+        size_t uTotal = 0;
+        for (auto & stBlock : m_vBlocks) uTotal += stBlock.uSize;
+        return uTotal;
+    }
+
+    const char * GetName() const override { return "Scratch"; }
+};
+
+// CScratchScope -- Releases the thread's scratch arena memory allocated during the scope
+
+class CScratchScope
+{
+    CScratchArena & m_cArena;
+    CScratchArena::Mark_t m_stMark;
+
+public:
+    CScratchScope() : m_cArena(CScratchArena::GetThread()), m_stMark(m_cArena.GetMark()) { }
+    ~CScratchScope() { m_cArena.Release(m_stMark); }
+
+    CScratchScope(const CScratchScope &) = delete;
+    CScratchScope & operator = (const CScratchScope &) = delete;
+
+    CScratchArena & GetArena() { return m_cArena; }
+};
+
+// CHugePageAllocator -- VirtualAlloc() (with large pages when possible) for very large allocations
+//
+// Allocations of at least GetMinBytes() are made directly with VirtualAlloc(), rounded up to the page size, so they are
+// outside of the heap (very large buffers don't fragment it) and are returned to the system when freed.  With large pages
+// (usually 2MB), a large buffer needs far fewer TLB entries, which speeds up passes over the whole buffer.
+//
+// Large pages need the "Lock pages in memory" user right (SeLockMemoryPrivilege), which the allocator enables for the process
+// when it's created.  Without it, normal pages are used -- isLargePages() tells which.  Smaller allocations go to the heap.
+//
+class CHugePageAllocator final : public CMemAllocator
+{
+    size_t m_uPageSize      = 4096;
+    size_t m_uMinBytes;
+    bool m_bLargePages      = false;
+
+    static bool EnableLockMemoryPrivilege()
+    {
+        HANDLE hToken;
+        if (!OpenProcessToken(GetCurrentProcess(),TOKEN_ADJUST_PRIVILEGES | TOKEN_QUERY,&hToken)) return false;
+
+        TOKEN_PRIVILEGES stPrivileges{};
+        stPrivileges.PrivilegeCount = 1;
+        stPrivileges.Privileges[0].Attributes = SE_PRIVILEGE_ENABLED;
+
+        bool bEnabled = LookupPrivilegeValueA(nullptr,"SeLockMemoryPrivilege",&stPrivileges.Privileges[0].Luid) &&
+                        AdjustTokenPrivileges(hToken,FALSE,&stPrivileges,0,nullptr,nullptr) && GetLastError() == ERROR_SUCCESS;
+        CloseHandle(hToken);
+        return bEnabled;
+    }
+
+    size_t GetAllocSize(size_t uBytes) const { return (uBytes + m_uPageSize - 1) & ~(m_uPageSize - 1); }
+
+public:
+    /// <summary>
+    /// Creates the allocator.  Allocations smaller than uMinBytes go to the heap.
+    /// </summary>
+    CHugePageAllocator(size_t uMinBytes = (size_t) 2 << 20) : m_uMinBytes(uMinBytes)
+    {
+        size_t uLargePage = GetLargePageMinimum();
+        if (uLargePage && EnableLockMemoryPrivilege())
+        {
+            m_uPageSize = uLargePage;
+            m_bLargePages = true;
+        }
+    }
+
+    void * Allocate(size_t uBytes,size_t uAlign) override
+    {
+        if (uBytes < m_uMinBytes) return GetHeap().Allocate(uBytes,uAlign);
+
+        size_t uSize = GetAllocSize(uBytes);
+        void * pMem = m_bLargePages ? VirtualAlloc(nullptr,uSize,MEM_RESERVE | MEM_COMMIT | MEM_LARGE_PAGES,PAGE_READWRITE) : nullptr;
+
+        // Large pages can run out (they must be physically contiguous), so fall back to normal pages
+
+        if (!pMem) pMem = VirtualAlloc(nullptr,(uBytes + 4095) & ~(size_t) 4095,MEM_RESERVE | MEM_COMMIT,PAGE_READWRITE);
+        if (pMem) CountAlloc(uBytes);
+        return pMem;
+    }
+
+    void Free(void * pMem,size_t uBytes,size_t uAlign) override
+    {
+        if (!pMem) return;
+        if (uBytes < m_uMinBytes) return GetHeap().Free(pMem,uBytes,uAlign);
+        VirtualFree(pMem,0,MEM_RELEASE);
+        CountFree(uBytes);
+    }
+
+    void * Reallocate(void * pMem,size_t uOldBytes,size_t uNewBytes,size_t uAlign) override
+    {
+        if (uOldBytes < m_uMinBytes && uNewBytes < m_uMinBytes) return GetHeap().Reallocate(pMem,uOldBytes,uNewBytes,uAlign);
+        return CMemAllocator::Reallocate(pMem,uOldBytes,uNewBytes,uAlign);
+    }
+
+    bool isLargePages() const { return m_bLargePages; }
+    size_t GetPageSize() const { return m_uPageSize; }
+    size_t GetMinBytes() const { return m_uMinBytes; }
+
+    const char * GetName() const override { return "HugePage"; }
+};
+
+// MemT -- Array of _t with memory from an allocator (Alloc is CMemAllocator or a class derived from it)
+//
+// MemT has the Mem<>/MemA<> functions (SetMemSize(), ResizeMax(), Fill(), Clear(), operator [], etc.), with a 64-bit size, and
+// memory aligned to iAlign bytes (16 is malloc()-compatible; 128 is the same as MemA):
+//
+//      MemT<float> fTemp(iWidth*iHeight);                                      // CMemAllocator::GetDefault()
+//      MemT<unsigned char,CPoolAllocator,128> sFrame(iFrameBytes,CPoolAllocator::GetBitmapPool());
+//
+// When Alloc is one of the allocator classes (which are final) rather than CMemAllocator, the compiler can call its functions
+// directly rather than through the vtable.
+//
+// Notes:
+//
+//      1. MemT is only for data types, as with Mem and MemA.
+//      2. MemT can be moved but not copied (use copyFrom()).  It can't be passed to library functions that take a Mem<>; use
+//         GetMem() and GetNumItems() to pass the memory itself.
+//
+template <class _t,class Alloc = CMemAllocator,size_t iAlign = 16>
+class MemT
+{
+    Alloc * m_pAllocator;
+
+    static Alloc & GetDefaultAllocator()
+    {
+        static_assert(std::is_same<Alloc,CMemAllocator>::value,"MemT: give the allocator to the constructor when Alloc is not CMemAllocator");
+        return CMemAllocator::GetDefault();
+    }
+
+    _t * AllocMem(long long iNumElements) { return (_t *) m_pAllocator->Allocate((size_t) iNumElements*sizeof(_t),iAlign); }
+    void FreeMem() { if (pMem) m_pAllocator->Free(pMem,(size_t) iSize*sizeof(_t),iAlign); pMem = nullptr; iSize = 0; }
+
+public:
+    long long iSize = 0;
+    _t * pMem = nullptr;
+
+    MemT() : m_pAllocator(&GetDefaultAllocator()) { }
+    explicit MemT(Alloc & cAllocator) : m_pAllocator(&cAllocator) { }
+    explicit MemT(long long iNumElements) : m_pAllocator(&GetDefaultAllocator()) { SetMemSize(iNumElements); }
+    MemT(long long iNumElements,Alloc & cAllocator) : m_pAllocator(&cAllocator) { SetMemSize(iNumElements); }
+    ~MemT() { FreeMem(); }
+
+    MemT(const MemT &) = delete;
+    MemT & operator = (const MemT &) = delete;
+
+    MemT(MemT && p2) noexcept : m_pAllocator(p2.m_pAllocator), iSize(p2.iSize), pMem(p2.pMem)
+    {
+        p2.iSize = 0;
+        p2.pMem = nullptr;
+    }
+    MemT & operator = (MemT && p2) noexcept
+    {
+        if (this != &p2)
+        {
+            FreeMem();
+            m_pAllocator = p2.m_pAllocator;
+            iSize = p2.iSize;
+            pMem = p2.pMem;
+
+            p2.iSize = 0;
+            p2.pMem = nullptr;
+        }
+        return *this;
+    }
+
+    Alloc & GetAllocator() { return *m_pAllocator; }
+    _t * GetMem() { return pMem; }
+
+    // SetData() -- Takes ownership of pInMem (iNumElements elements), which must have been allocated by this object's allocator with
+    // the same size and alignment.
+    //
+    bool SetData(_t * pInMem,long long iNumElements)
+    {
+        if (!pInMem || iNumElements <= 0) return false;
+        FreeMem();
+        pMem = pInMem;
+        iSize = iNumElements;
+        return true;
+    }
+    void DeleteData() { FreeMem(); }
+
+    long long GetNumItems() const { return pMem ? iSize : 0; }
+    long long GetMemSize() const { return pMem ? iSize*(long long) sizeof(_t) : 0; }
+
+    // SetMemSize() -- Sets the number of elements, reallocating (without keeping the contents) if the size changes.  Returns
+    // nullptr if the memory couldn't be allocated.
+    //
+    _t * SetMemSize(long long iNumElements)
+    {
+        if (iNumElements <= 0) return pMem;
+        if (iSize == iNumElements) return pMem;
+        FreeMem();
+        pMem = AllocMem(iNumElements);
+        iSize = pMem ? iNumElements : 0;
+        return pMem;
+    }
+    _t * SetMemSizeMax(long long iNumElements) { return iNumElements > iSize ? SetMemSize(iNumElements) : pMem; }
+
+    // ResizeMax() -- Grows the memory to iNumElements, keeping the contents.  As with Mem::ResizeMax(), if the reallocation
+    // fails the memory is freed and nullptr is returned.
+    //
+    _t * ResizeMax(long long iNumElements)
+    {
+        if (iNumElements <= iSize) return pMem;
+        auto pNewMem = (_t *) m_pAllocator->Reallocate(pMem,pMem ? (size_t) iSize*sizeof(_t) : 0,(size_t) iNumElements*sizeof(_t),iAlign);
+        if (!pNewMem) { FreeMem(); return nullptr; }
+        pMem = pNewMem;
+        iSize = iNumElements;
+        return pMem;
+    }
+
+    void Clear(unsigned char ucValue = 0) { if (pMem) memset(pMem,ucValue,(size_t) iSize*sizeof(_t)); }
+    void Fill(_t t) { for (long long i=0;i<GetNumItems();i++) pMem[i] = t; }
+
+    bool copyFrom(const MemT & p2)
+    {
+        if (this == &p2) return true;
+        FreeMem();
+        if (!p2.pMem) return true;
+        if (!(pMem = AllocMem(p2.iSize))) return false;
+        memcpy(pMem,p2.pMem,(size_t) p2.iSize*sizeof(_t));
+        iSize = p2.iSize;
+        return true;
+    }
+
+    bool isEmpty() const { return pMem == nullptr; }
+    operator _t * () const { return pMem; }
+    _t & operator [](long long i) { return pMem[i]; }
+    const _t & operator [](long long i) const { return pMem[i]; }
+};
+
+} // namespace Sage
+#endif // _CMemAllocator_H_
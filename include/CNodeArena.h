@@ -0,0 +1,245 @@
+// This file copyright(c) 2021 Rob Nelson, All Rights Reserved.    E-mail rob@projectsagebox.com for more information.
+//
+
+#pragma once
+#if !defined(_CNodeArena_H_)
+#define _CNodeArena_H_
+
+#include <cstddef>
+#include <cstring>
+#include <memory>
+#include <vector>
+#include <new>
+#include <type_traits>
+#include <algorithm>
+#include <map>
+#include <mutex>
+#include <atomic>
+
+namespace Sage
+{
+
+// CNodeArena -- Per-compilation bump allocator for parse trees (stNODE, stNODEDATA, etc.)
+//
+// Each node is carved out of a 64K block with a pointer increment, rather than with its own malloc(), and nothing is freed
+// individually: Reset() frees the whole tree at once (in constant time -- the blocks are kept for the next compilation), and
+// the blocks themselves are freed when the arena is deleted.
+//
+// CTree::AllocNode() and AllocNodeData() (see CToken.h) take their memory from the thread's current arena, set with a
+// CNodeArenaScope for the length of a compilation:
+//
+//      CNodeArena cArena;
+//      {
+//          CNodeArenaScope cScope(cArena);         // Nodes created on this thread come from cArena
+//          ... compile ...
+//      }
+//      cArena.Reset();                             // The whole tree is gone
+//
+// Notes:
+//
+//      1. Only trivially-destructible types can be allocated (nothing is destructed), and memory is returned zeroed.
+//      2. An arena is used by one thread at a time.
+//      3. Owns(p) tells whether p came from any arena (on any thread, in or out of a CNodeArenaScope), so code freeing a node
+//         doesn't need to know which scope it was allocated in -- see CTree::FreeNode().  The thread's current arena is checked
+//         first, without a lock; the table of all arenas' blocks is only searched (under its lock) when other arenas have blocks.
+//
+class CNodeArena
+{
+public:
+    static constexpr size_t kBlockBytes = 64*1024;
+
+private:
+    struct Block_t
+    {
+        std::unique_ptr<unsigned char[]> pMem;
+        size_t uSize;
+    };
+
+    std::vector<Block_t> m_vBlocks;
+    size_t m_iBlock         = 0;            // Block being allocated from (when m_pPos is set)
+    unsigned char * m_pPos  = nullptr;
+    unsigned char * m_pEnd  = nullptr;
+
+    long long m_llAllocations   = 0;
+    size_t m_uUsedBlocks        = 0;        // Bytes in the blocks before m_iBlock
+
+    // Blocks of all arenas, by address, for Owns()
+
+    struct BlockMap_t
+    {
+        std::mutex mLock;
+        std::map<const unsigned char *,size_t> mBlocks;
+        std::atomic<size_t> uBlocks{0};                 // mBlocks.size(), for checks without the lock
+    };
+
+    static CNodeArena * & Current()
+    {
+        static thread_local CNodeArena * pArena = nullptr;
+        return pArena;
+    }
+
+    static BlockMap_t & GetBlockMap()
+    {
+        static BlockMap_t stMap;
+        return stMap;
+    }
+
+    void RemoveBlocks()
+    {
+        auto & stMap = GetBlockMap();
+        std::lock_guard<std::mutex> lock(stMap.mLock);
+        for (auto & stBlock : m_vBlocks) stMap.mBlocks.erase(stBlock.pMem.get());
+        stMap.uBlocks.store(stMap.mBlocks.size(),std::memory_order_release);
+    }
+
+    bool InBlocks(const unsigned char * pByte) const
+    {
+        for (auto & stBlock : m_vBlocks) if (pByte >= stBlock.pMem.get() && pByte < stBlock.pMem.get() + stBlock.uSize) return true;
+        return false;
+    }
+
+    void * AllocateSlow(size_t uBytes,size_t uAlign)
+    {
+        // Move on to the next block large enough -- a smaller one is skipped for this compilation -- or add one
+
+        size_t uNeeded = uBytes + uAlign;
+        size_t iBlock = m_pPos ? m_iBlock + 1 : 0;
+
+        if (m_pPos) m_uUsedBlocks += m_vBlocks[m_iBlock].uSize;
+        while (iBlock < m_vBlocks.size() && m_vBlocks[iBlock].uSize < uNeeded) m_uUsedBlocks += m_vBlocks[iBlock++].uSize;
+
+        if (iBlock == m_vBlocks.size())
+        {
+            size_t uSize = (std::max)(kBlockBytes,uNeeded);
+            auto pMem = std::unique_ptr<unsigned char[]>(new (std::nothrow) unsigned char[uSize]);
+            if (!pMem) return nullptr;
+            {
+                auto & stMap = GetBlockMap();
+                std::lock_guard<std::mutex> lock(stMap.mLock);
+                stMap.mBlocks[pMem.get()] = uSize;
+                stMap.uBlocks.store(stMap.mBlocks.size(),std::memory_order_release);
+            }
+            m_vBlocks.push_back({ std::move(pMem),uSize });
+        }
+
+        m_iBlock    = iBlock;
+        m_pPos      = m_vBlocks[iBlock].pMem.get();
+        m_pEnd      = m_pPos + m_vBlocks[iBlock].uSize;
+        return Allocate(uBytes,uAlign);
+    }
+
+public:
+    CNodeArena() = default;
+    CNodeArena(const CNodeArena &) = delete;
+    CNodeArena & operator = (const CNodeArena &) = delete;
+
+    ~CNodeArena()
+    {
+        if (Current() == this) Current() = nullptr;
+        RemoveBlocks();
+    }
+
+    /// <summary>
+    /// Returns uBytes of zeroed memory aligned to uAlign (a power of 2), or nullptr if memory can't be allocated.
+    /// </summary>
+    void * Allocate(size_t uBytes,size_t uAlign = alignof(std::max_align_t))
+    {
+        auto uPos = ((size_t) m_pPos + uAlign - 1) & ~(uAlign - 1);
+        if (!m_pPos || uPos + uBytes > (size_t) m_pEnd) return AllocateSlow(uBytes,uAlign);
+
+        m_pPos = (unsigned char *) (uPos + uBytes);
+        m_llAllocations++;
+        return memset((void *) uPos,0,uBytes);
+    }
+
+    /// <summary>
+    /// Returns a zeroed T, or nullptr if memory can't be allocated.  T must be trivially destructible, since it is never destructed.
+    /// </summary>
+    template<typename T>
+    T * New()
+    {
+        static_assert(std::is_trivially_destructible<T>::value,"CNodeArena::New() -- T must be trivially destructible");
+        return (T *) Allocate(sizeof(T),alignof(T));
+    }
+
+    /// <summary>
+    /// Frees everything allocated from the arena, keeping the blocks for reuse.  This doesn't depend on the number of nodes.
+    /// </summary>
+    void Reset()
+    {
+        m_iBlock        = 0;
+        m_pPos          = nullptr;
+        m_pEnd          = nullptr;
+        m_uUsedBlocks   = 0;
+        m_llAllocations = 0;
+    }
+
+    /// <summary>
+    /// Frees everything allocated from the arena, and the blocks themselves.
+    /// </summary>
+    void FreeBlocks()
+    {
+        Reset();
+        RemoveBlocks();
+        m_vBlocks.clear();
+        m_vBlocks.shrink_to_fit();
+    }
+
+    // Allocations and bytes used since the last Reset() (bytes include alignment, and the unused ends of earlier blocks)
+
+    long long GetAllocations() const { return m_llAllocations; }
+    size_t GetBytesUsed() const { return m_pPos ? m_uUsedBlocks + (size_t) (m_pPos - m_vBlocks[m_iBlock].pMem.get()) : 0; }
+
+    size_t GetBlockBytes() const
+    {
+        size_t uBytes = 0;
+        for (auto & stBlock : m_vBlocks) uBytes += stBlock.uSize;
+        return uBytes;
+    }
+
+    // GetCurrent() -- the arena set for this thread with CNodeArenaScope, or nullptr when there isn't one
+
+    static CNodeArena * GetCurrent() { return Current(); }
+
+    /// <summary>
+    /// Returns true if p is in a block of any CNodeArena (whether or not it is current, or the memory has been Reset()), and
+    /// false if it isn't -- i.e. it came from the heap.
+    /// </summary>
+    static bool Owns(const void * p)
+    {
+        if (!p) return false;
+        auto pByte = (const unsigned char *) p;
+
+        // The current arena's blocks are in the table, so when they are all of the table there's nothing else to search
+
+        auto & stMap = GetBlockMap();
+        auto pCurrent = Current();
+        if (pCurrent && pCurrent->InBlocks(pByte)) return true;
+        if (stMap.uBlocks.load(std::memory_order_acquire) == (pCurrent ? pCurrent->m_vBlocks.size() : 0)) return false;
+
+        std::lock_guard<std::mutex> lock(stMap.mLock);
+        auto it = stMap.mBlocks.upper_bound(pByte);
+        if (it == stMap.mBlocks.begin()) return false;
+        --it;
+        return pByte < it->first + it->second;
+    }
+
+    friend class CNodeArenaScope;
+};
+
+// CNodeArenaScope -- Makes cArena the thread's current CNodeArena until the end of the scope (then restores the previous one)
+//
+class CNodeArenaScope
+{
+    CNodeArena * m_pPrevious;
+
+public:
+    CNodeArenaScope(CNodeArena & cArena) : m_pPrevious(CNodeArena::Current()) { CNodeArena::Current() = &cArena; }
+    ~CNodeArenaScope() { CNodeArena::Current() = m_pPrevious; }
+
+    CNodeArenaScope(const CNodeArenaScope &) = delete;
+    CNodeArenaScope & operator = (const CNodeArenaScope &) = delete;
+};
+
+} // namespace Sage
+#endif // _CNodeArena_H_
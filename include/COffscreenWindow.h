@@ -0,0 +1,643 @@
+// This file copyright(c) 2021 Rob Nelson, All Rights Reserved.    E-mail rob@projectsagebox.com for more information.
+//
+
+#pragma once
+#if !defined(_COffscreenWindow_H_)
+#define _COffscreenWindow_H_
+
+#include <vector>
+#include <algorithm>
+#include <utility>
+#include <cmath>
+#include <cstdio>
+#include <cstdint>
+#include <cstring>
+
+#if !defined(_MSC_VER) && !defined(__forceinline)
+#define __forceinline inline __attribute__((always_inline))
+#endif
+
+namespace Sage
+{
+
+// COffscreenWindow -- Headless CWindow-style drawing onto an in-memory 24-bit bitmap
+//
+// COffscreenWindow has the CWindow drawing functions (Cls(), FillRectangle(), DrawLine(), DrawLines(), FillPolygonFast(),
+// DrawPolygon(), FillCircle(), DrawCircle(), DrawBezier(), Write(), DisplayBitmap(), ...) with the same names and parameter
+// order, drawn in software onto a bitmap in memory.  There is no window, message thread, display, GDI or GDI+, so it can be
+// used on servers (it only uses standard C++ and builds on any platform), for rendering report images in batch jobs, and as a
+// deterministic drawing target for benchmarks and golden-image tests:
+//
+//      COffscreenWindow cWin(1920,1080);
+//      cWin.Cls({ 0,0,64 },{ 0,0,0 });                          // Vertical gradient, as CWindow::Cls(color1,color2)
+//      cWin.FillPolygonFast(pPoints,iVertices,{ 255,0,0 });
+//      cWin.Write(20,20,"Report",{ 255,255,255 },2);
+//      cWin.WriteBMP("report.bmp");
+//      uint64_t uHash = cWin.GetHash();                        // Compare with a known-good hash for regression tests
+//
+// Notes:
+//
+//      1. The bitmap has the RawBitmap_t layout -- BGR in memory, top row first, rows padded to 4 bytes -- and can be the canvas
+//         itself (created by COffscreenWindow) or an existing RawBitmap_t/CBitmap (see Attach()).
+//      2. Output is exactly repeatable on every platform: integer coordinates, pixel-center sampling and no anti-aliasing.
+//      3. Text uses a built-in 8x8 font (scaled by whole numbers), so it never depends on installed fonts.
+//      4. Point types are any type with x and y members (POINT, CPoint, CfPointf, etc.); colors may be given as { r,g,b } or any
+//         type with iRed, iGreen and iBlue members (RGBColor_t, CRgbColor).
+//
+class COffscreenWindow
+{
+public:
+    struct Color_t
+    {
+        unsigned char b, g, r;                                  // Memory order of a canvas pixel
+
+        Color_t(int iRed = 0,int iGreen = 0,int iBlue = 0) : b((unsigned char) iBlue), g((unsigned char) iGreen), r((unsigned char) iRed) { }
+
+        template<typename T,typename = decltype(std::declval<T>().iRed)>
+        Color_t(const T & rgbColor) : b((unsigned char) rgbColor.iBlue), g((unsigned char) rgbColor.iGreen), r((unsigned char) rgbColor.iRed) { }
+    };
+
+    static constexpr int kFontSize = 8;
+
+    // Coordinates are limited to +/- kMaxCoord, so that differences between them can't overflow an int
+
+    static constexpr int kMaxCoord = 1 << 28;
+
+private:
+    std::vector<unsigned char> m_vCanvas;           // Owned canvas (empty when attached to an external bitmap)
+    unsigned char * m_sMem  = nullptr;
+    int m_iWidth            = 0;
+    int m_iHeight           = 0;
+    int m_iWidthBytes       = 0;
+
+    std::vector<double> m_vCrossings;               // Reused by FillPolygonFast()
+    std::vector<std::pair<double,double>> m_vFlat;  // Reused by DrawBezier()
+
+    // 8x8 font for ASCII 32-126 (public-domain font8x8_basic; bit 0 is the leftmost pixel)
+
+    static const unsigned char * GetGlyph(char c)
+    {
+        static constexpr unsigned char sFont[95][8] = {
+            { 0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00 }, { 0x18,0x3C,0x3C,0x18,0x18,0x00,0x18,0x00 }, { 0x36,0x36,0x00,0x00,0x00,0x00,0x00,0x00 },
+            { 0x36,0x36,0x7F,0x36,0x7F,0x36,0x36,0x00 }, { 0x0C,0x3E,0x03,0x1E,0x30,0x1F,0x0C,0x00 }, { 0x00,0x63,0x33,0x18,0x0C,0x66,0x63,0x00 },
+            { 0x1C,0x36,0x1C,0x6E,0x3B,0x33,0x6E,0x00 }, { 0x06,0x06,0x03,0x00,0x00,0x00,0x00,0x00 }, { 0x18,0x0C,0x06,0x06,0x06,0x0C,0x18,0x00 },
+            { 0x06,0x0C,0x18,0x18,0x18,0x0C,0x06,0x00 }, { 0x00,0x66,0x3C,0xFF,0x3C,0x66,0x00,0x00 }, { 0x00,0x0C,0x0C,0x3F,0x0C,0x0C,0x00,0x00 },
+            { 0x00,0x00,0x00,0x00,0x00,0x0C,0x0C,0x06 }, { 0x00,0x00,0x00,0x3F,0x00,0x00,0x00,0x00 }, { 0x00,0x00,0x00,0x00,0x00,0x0C,0x0C,0x00 },
+            { 0x60,0x30,0x18,0x0C,0x06,0x03,0x01,0x00 }, { 0x3E,0x63,0x73,0x7B,0x6F,0x67,0x3E,0x00 }, { 0x0C,0x0E,0x0C,0x0C,0x0C,0x0C,0x3F,0x00 },
+            { 0x1E,0x33,0x30,0x1C,0x06,0x33,0x3F,0x00 }, { 0x1E,0x33,0x30,0x1C,0x30,0x33,0x1E,0x00 }, { 0x38,0x3C,0x36,0x33,0x7F,0x30,0x78,0x00 },
+            { 0x3F,0x03,0x1F,0x30,0x30,0x33,0x1E,0x00 }, { 0x1C,0x06,0x03,0x1F,0x33,0x33,0x1E,0x00 }, { 0x3F,0x33,0x30,0x18,0x0C,0x0C,0x0C,0x00 },
+            { 0x1E,0x33,0x33,0x1E,0x33,0x33,0x1E,0x00 }, { 0x1E,0x33,0x33,0x3E,0x30,0x18,0x0E,0x00 }, { 0x00,0x0C,0x0C,0x00,0x00,0x0C,0x0C,0x00 },
+            { 0x00,0x0C,0x0C,0x00,0x00,0x0C,0x0C,0x06 }, { 0x18,0x0C,0x06,0x03,0x06,0x0C,0x18,0x00 }, { 0x00,0x00,0x3F,0x00,0x00,0x3F,0x00,0x00 },
+            { 0x06,0x0C,0x18,0x30,0x18,0x0C,0x06,0x00 }, { 0x1E,0x33,0x30,0x18,0x0C,0x00,0x0C,0x00 }, { 0x3E,0x63,0x7B,0x7B,0x7B,0x03,0x1E,0x00 },
+            { 0x0C,0x1E,0x33,0x33,0x3F,0x33,0x33,0x00 }, { 0x3F,0x66,0x66,0x3E,0x66,0x66,0x3F,0x00 }, { 0x3C,0x66,0x03,0x03,0x03,0x66,0x3C,0x00 },
+            { 0x1F,0x36,0x66,0x66,0x66,0x36,0x1F,0x00 }, { 0x7F,0x46,0x16,0x1E,0x16,0x46,0x7F,0x00 }, { 0x7F,0x46,0x16,0x1E,0x16,0x06,0x0F,0x00 },
+            { 0x3C,0x66,0x03,0x03,0x73,0x66,0x7C,0x00 }, { 0x33,0x33,0x33,0x3F,0x33,0x33,0x33,0x00 }, { 0x1E,0x0C,0x0C,0x0C,0x0C,0x0C,0x1E,0x00 },
+            { 0x78,0x30,0x30,0x30,0x33,0x33,0x1E,0x00 }, { 0x67,0x66,0x36,0x1E,0x36,0x66,0x67,0x00 }, { 0x0F,0x06,0x06,0x06,0x46,0x66,0x7F,0x00 },
+            { 0x63,0x77,0x7F,0x7F,0x6B,0x63,0x63,0x00 }, { 0x63,0x67,0x6F,0x7B,0x73,0x63,0x63,0x00 }, { 0x1C,0x36,0x63,0x63,0x63,0x36,0x1C,0x00 },
+            { 0x3F,0x66,0x66,0x3E,0x06,0x06,0x0F,0x00 }, { 0x1E,0x33,0x33,0x33,0x3B,0x1E,0x38,0x00 }, { 0x3F,0x66,0x66,0x3E,0x36,0x66,0x67,0x00 },
+            { 0x1E,0x33,0x07,0x0E,0x38,0x33,0x1E,0x00 }, { 0x3F,0x2D,0x0C,0x0C,0x0C,0x0C,0x1E,0x00 }, { 0x33,0x33,0x33,0x33,0x33,0x33,0x3F,0x00 },
+            { 0x33,0x33,0x33,0x33,0x33,0x1E,0x0C,0x00 }, { 0x63,0x63,0x63,0x6B,0x7F,0x77,0x63,0x00 }, { 0x63,0x63,0x36,0x1C,0x1C,0x36,0x63,0x00 },
+            { 0x33,0x33,0x33,0x1E,0x0C,0x0C,0x1E,0x00 }, { 0x7F,0x63,0x31,0x18,0x4C,0x66,0x7F,0x00 }, { 0x1E,0x06,0x06,0x06,0x06,0x06,0x1E,0x00 },
+            { 0x03,0x06,0x0C,0x18,0x30,0x60,0x40,0x00 }, { 0x1E,0x18,0x18,0x18,0x18,0x18,0x1E,0x00 }, { 0x08,0x1C,0x36,0x63,0x00,0x00,0x00,0x00 },
+            { 0x00,0x00,0x00,0x00,0x00,0x00,0x00,0xFF }, { 0x0C,0x0C,0x18,0x00,0x00,0x00,0x00,0x00 }, { 0x00,0x00,0x1E,0x30,0x3E,0x33,0x6E,0x00 },
+            { 0x07,0x06,0x06,0x3E,0x66,0x66,0x3B,0x00 }, { 0x00,0x00,0x1E,0x33,0x03,0x33,0x1E,0x00 }, { 0x38,0x30,0x30,0x3E,0x33,0x33,0x6E,0x00 },
+            { 0x00,0x00,0x1E,0x33,0x3F,0x03,0x1E,0x00 }, { 0x1C,0x36,0x06,0x0F,0x06,0x06,0x0F,0x00 }, { 0x00,0x00,0x6E,0x33,0x33,0x3E,0x30,0x1F },
+            { 0x07,0x06,0x36,0x6E,0x66,0x66,0x67,0x00 }, { 0x0C,0x00,0x0E,0x0C,0x0C,0x0C,0x1E,0x00 }, { 0x30,0x00,0x30,0x30,0x30,0x33,0x33,0x1E },
+            { 0x07,0x06,0x66,0x36,0x1E,0x36,0x67,0x00 }, { 0x0E,0x0C,0x0C,0x0C,0x0C,0x0C,0x1E,0x00 }, { 0x00,0x00,0x33,0x7F,0x7F,0x6B,0x63,0x00 },
+            { 0x00,0x00,0x1F,0x33,0x33,0x33,0x33,0x00 }, { 0x00,0x00,0x1E,0x33,0x33,0x33,0x1E,0x00 }, { 0x00,0x00,0x3B,0x66,0x66,0x3E,0x06,0x0F },
+            { 0x00,0x00,0x6E,0x33,0x33,0x3E,0x30,0x78 }, { 0x00,0x00,0x3B,0x6E,0x66,0x06,0x0F,0x00 }, { 0x00,0x00,0x3E,0x03,0x1E,0x30,0x1F,0x00 },
+            { 0x08,0x0C,0x3E,0x0C,0x0C,0x2C,0x18,0x00 }, { 0x00,0x00,0x33,0x33,0x33,0x33,0x6E,0x00 }, { 0x00,0x00,0x33,0x33,0x33,0x1E,0x0C,0x00 },
+            { 0x00,0x00,0x63,0x6B,0x7F,0x7F,0x36,0x00 }, { 0x00,0x00,0x63,0x36,0x1C,0x36,0x63,0x00 }, { 0x00,0x00,0x33,0x33,0x33,0x3E,0x30,0x1F },
+            { 0x00,0x00,0x3F,0x19,0x0C,0x26,0x3F,0x00 }, { 0x38,0x0C,0x0C,0x07,0x0C,0x0C,0x38,0x00 }, { 0x18,0x18,0x18,0x00,0x18,0x18,0x18,0x00 },
+            { 0x07,0x0C,0x0C,0x38,0x0C,0x0C,0x07,0x00 }, { 0x6E,0x3B,0x00,0x00,0x00,0x00,0x00,0x00 },
+        };
+        return sFont[(c >= 32 && c <= 126) ? c - 32 : '?' - 32];
+    }
+
+    __forceinline unsigned char * GetRow(int iY) { return m_sMem + (size_t) iY*m_iWidthBytes; }
+
+    // Converts fValue to an int within iMin to iMax (NaN converts to iMin), since out-of-range casts are undefined
+
+    static __forceinline int ClampInt(double fValue,int iMin = -kMaxCoord,int iMax = kMaxCoord)
+    {
+        if (!(fValue > iMin)) return iMin;
+        return fValue < iMax ? (int) fValue : iMax;
+    }
+
+    // Fills pixels iX1 to iX2-1 on row iY (clipped)
+
+    __forceinline void FillSpan(int iY,int iX1,int iX2,Color_t rgbColor)
+    {
+        if (iY < 0 || iY >= m_iHeight) return;
+        if (iX1 < 0) iX1 = 0;
+        if (iX2 > m_iWidth) iX2 = m_iWidth;
+        if (iX1 >= iX2) return;
+
+        unsigned char * sOut = GetRow(iY) + iX1*3;
+        if (rgbColor.r == rgbColor.g && rgbColor.g == rgbColor.b) { memset(sOut,rgbColor.r,(size_t) (iX2 - iX1)*3); return; }
+        // Write a few pixels, then keep doubling with memcpy() (much faster than a pixel loop for long spans)
+
+        size_t iBytes = (size_t) (iX2 - iX1)*3, iDone = (std::min)(iBytes,(size_t) 24);
+        for (size_t i=0;i<iDone;i += 3) sOut[i] = rgbColor.b, sOut[i+1] = rgbColor.g, sOut[i+2] = rgbColor.r;
+        while (iDone < iBytes)
+        {
+            size_t iCopy = (std::min)(iDone,iBytes - iDone);
+            memcpy(sOut + iDone,sOut,iCopy);
+            iDone += iCopy;
+        }
+    }
+
+    // Fills iX1 to iX2-1 on rows iY1 to iY2-1 (clipped).  The extents are 64-bit so rectangles near the int limits don't overflow.
+
+    void FillRect(int64_t iX1,int64_t iY1,int64_t iX2,int64_t iY2,Color_t rgbColor)
+    {
+        iX1 = (std::max)(iX1,(int64_t) 0);
+        iY1 = (std::max)(iY1,(int64_t) 0);
+        iX2 = (std::min)(iX2,(int64_t) m_iWidth);
+        iY2 = (std::min)(iY2,(int64_t) m_iHeight);
+        if (iX1 >= iX2) return;
+        for (int64_t y=iY1;y<iY2;y++) FillSpan((int) y,(int) iX1,(int) iX2,rgbColor);
+    }
+
+    // Fills the span of pixels whose centers are within [fX1,fX2)
+
+    __forceinline void FillSpanf(int iY,double fX1,double fX2,Color_t rgbColor)
+    {
+        FillSpan(iY,ClampInt(std::ceil(fX1 - 0.5),-1,m_iWidth),ClampInt(std::ceil(fX2 - 0.5),-1,m_iWidth),rgbColor);
+    }
+
+    // Clips the line to the canvas (plus a pixel on each side) with Liang-Barsky, so off-canvas lines cost nothing.  Lines
+    // inside the canvas are not changed, so they are drawn exactly as before.  Returns false if the line is outside the canvas.
+
+    bool ClipLine(int & iX1,int & iY1,int & iX2,int & iY2)
+    {
+        auto fnInside = [&](int x,int y) { return x >= -1 && x <= m_iWidth && y >= -1 && y <= m_iHeight; };
+        if (fnInside(iX1,iY1) && fnInside(iX2,iY2)) return true;
+
+        double fDX = (double) iX2 - iX1, fDY = (double) iY2 - iY1;
+        double t0 = 0, t1 = 1;
+        auto fnEdge = [&](double p,double q)
+        {
+            if (p == 0) return q >= 0;
+            double r = q/p;
+            if (p < 0) { if (r > t1) return false; if (r > t0) t0 = r; }
+            else { if (r < t0) return false; if (r < t1) t1 = r; }
+            return true;
+        };
+
+        if (!fnEdge(-fDX,iX1 + 1.0) || !fnEdge(fDX,(double) m_iWidth - iX1) ||
+            !fnEdge(-fDY,iY1 + 1.0) || !fnEdge(fDY,(double) m_iHeight - iY1)) return false;
+
+        double fX = iX1, fY = iY1;
+        iX1 = (int) std::lround(fX + t0*fDX), iY1 = (int) std::lround(fY + t0*fDY);
+        iX2 = (int) std::lround(fX + t1*fDX), iY2 = (int) std::lround(fY + t1*fDY);
+        return true;
+    }
+
+    void DrawThinLine(int iX1,int iY1,int iX2,int iY2,Color_t rgbColor)
+    {
+        if (!ClipLine(iX1,iY1,iX2,iY2)) return;
+
+        int iDX = std::abs(iX2 - iX1), iDY = -std::abs(iY2 - iY1);
+        int iSX = iX1 < iX2 ? 1 : -1, iSY = iY1 < iY2 ? 1 : -1;
+        int iErr = iDX + iDY;
+
+        for (;;)
+        {
+            SetPixel(iX1,iY1,rgbColor);
+            if (iX1 == iX2 && iY1 == iY2) break;
+            int iErr2 = 2*iErr;
+            if (iErr2 >= iDY) iErr += iDY, iX1 += iSX;
+            if (iErr2 <= iDX) iErr += iDX, iY1 += iSY;
+        }
+    }
+
+    // Even-odd scanline fill of a polygon given as iCount (x,y) pairs returned by fnPoint(i)
+
+    template<typename F>
+    void FillPolygonPoints(int iCount,F && fnPoint,Color_t rgbColor)
+    {
+        if (iCount < 3 || !m_sMem) return;
+
+        double fMinY = fnPoint(0).second, fMaxY = fMinY;
+        for (int i=1;i<iCount;i++) { double fY = fnPoint(i).second; fMinY = (std::min)(fMinY,fY); fMaxY = (std::max)(fMaxY,fY); }
+
+        int iY1 = ClampInt(std::ceil(fMinY - 0.5),0,m_iHeight);
+        int iY2 = ClampInt(std::floor(fMaxY - 0.5),-1,m_iHeight - 1);
+
+        for (int y=iY1;y<=iY2;y++)
+        {
+            double fY = y + 0.5;
+            m_vCrossings.clear();
+            for (int i=0,j=iCount-1;i<iCount;j=i++)
+            {
+                auto a = fnPoint(i), b = fnPoint(j);
+                if ((a.second <= fY) == (b.second <= fY)) continue;
+                m_vCrossings.push_back(a.first + (fY - a.second)*(b.first - a.first)/(b.second - a.second));
+            }
+            std::sort(m_vCrossings.begin(),m_vCrossings.end());
+            for (size_t i=0;i+1<m_vCrossings.size();i += 2) FillSpanf(y,m_vCrossings[i],m_vCrossings[i+1],rgbColor);
+        }
+    }
+
+    // A line iPenSize wide, as a filled quad with round ends
+
+    void DrawThickLine(double fX1,double fY1,double fX2,double fY2,Color_t rgbColor,int iPenSize)
+    {
+        double fDX = fX2 - fX1, fDY = fY2 - fY1;
+        double fLength = std::sqrt(fDX*fDX + fDY*fDY);
+        double fRadius = iPenSize/2.0;
+
+        if (fLength > 0)
+        {
+            double fNX = -fDY/fLength*fRadius, fNY = fDX/fLength*fRadius;
+            std::pair<double,double> pQuad[4] = { { fX1 + fNX,fY1 + fNY }, { fX2 + fNX,fY2 + fNY }, { fX2 - fNX,fY2 - fNY }, { fX1 - fNX,fY1 - fNY } };
+            FillPolygonPoints(4,[&](int i) { return pQuad[i]; },rgbColor);
+        }
+        FillCirclef(fX1,fY1,fRadius,rgbColor);
+        FillCirclef(fX2,fY2,fRadius,rgbColor);
+    }
+
+    void FillCirclef(double fCX,double fCY,double fRadius,Color_t rgbColor)
+    {
+        int iY1 = ClampInt(std::ceil(fCY - fRadius - 0.5),0,m_iHeight);
+        int iY2 = ClampInt(std::floor(fCY + fRadius - 0.5),-1,m_iHeight - 1);
+        for (int y=iY1;y<=iY2;y++)
+        {
+            double fDY = y + 0.5 - fCY;
+            double fHalf = fRadius*fRadius - fDY*fDY;
+            if (fHalf < 0) continue;
+            fHalf = std::sqrt(fHalf);
+            FillSpanf(y,fCX - fHalf,fCX + fHalf,rgbColor);
+        }
+    }
+
+    void DrawLinePen(double fX1,double fY1,double fX2,double fY2,Color_t rgbColor,int iPenSize)
+    {
+        if (iPenSize <= 1) DrawThinLine(ClampInt(std::floor(fX1)),ClampInt(std::floor(fY1)),ClampInt(std::floor(fX2)),ClampInt(std::floor(fY2)),rgbColor);
+        else DrawThickLine(fX1,fY1,fX2,fY2,rgbColor,iPenSize);
+    }
+
+public:
+    COffscreenWindow() = default;
+    COffscreenWindow(int iWidth,int iHeight,Color_t rgbBackground = Color_t()) { Create(iWidth,iHeight,rgbBackground); }
+
+    // Copies get their own copy of an owned canvas; a copy of an attached COffscreenWindow draws onto the same memory
+
+    COffscreenWindow(const COffscreenWindow & cWin) { *this = cWin; }
+    COffscreenWindow(COffscreenWindow && cWin) noexcept { *this = std::move(cWin); }
+
+    COffscreenWindow & operator = (const COffscreenWindow & cWin)
+    {
+        if (this == &cWin) return *this;
+        m_vCanvas       = cWin.m_vCanvas;
+        m_sMem          = cWin.m_vCanvas.empty() ? cWin.m_sMem : m_vCanvas.data();
+        m_iWidth        = cWin.m_iWidth;
+        m_iHeight       = cWin.m_iHeight;
+        m_iWidthBytes   = cWin.m_iWidthBytes;
+        return *this;
+    }
+
+    COffscreenWindow & operator = (COffscreenWindow && cWin) noexcept
+    {
+        if (this == &cWin) return *this;
+        bool bOwned     = !cWin.m_vCanvas.empty();
+        m_vCanvas       = std::move(cWin.m_vCanvas);
+        m_sMem          = bOwned ? m_vCanvas.data() : cWin.m_sMem;
+        m_iWidth        = cWin.m_iWidth;
+        m_iHeight       = cWin.m_iHeight;
+        m_iWidthBytes   = cWin.m_iWidthBytes;
+
+        cWin.m_vCanvas.clear();
+        cWin.m_sMem     = nullptr;
+        cWin.m_iWidth   = cWin.m_iHeight = cWin.m_iWidthBytes = 0;
+        return *this;
+    }
+
+    /// <summary>
+    /// Creates (or re-creates) an iWidth x iHeight canvas owned by the COffscreenWindow, cleared to rgbBackground.
+    /// </summary>
+    bool Create(int iWidth,int iHeight,Color_t rgbBackground = Color_t())
+    {
+        if (iWidth <= 0 || iHeight <= 0) return false;
+        m_iWidth        = iWidth;
+        m_iHeight       = iHeight;
+        m_iWidthBytes   = (iWidth*3 + 3) & ~3;
+        m_vCanvas.assign((size_t) m_iWidthBytes*iHeight,0);
+        m_sMem          = m_vCanvas.data();
+        Cls(rgbBackground);
+        return true;
+    }
+
+    /// <summary>
+    /// Draws onto existing memory instead of an owned canvas (24-bit BGR, top row first, iWidthBytes per row).  The memory must
+    /// stay valid while it is drawn to.
+    /// </summary>
+    bool Attach(unsigned char * sMem,int iWidth,int iHeight,int iWidthBytes)
+    {
+        if (!sMem || iWidth <= 0 || iHeight <= 0 || iWidthBytes < iWidth*3) return false;
+        m_vCanvas.clear();
+        m_sMem          = sMem;
+        m_iWidth        = iWidth;
+        m_iHeight       = iHeight;
+        m_iWidthBytes   = iWidthBytes;
+        return true;
+    }
+
+    /// <summary>
+    /// Draws onto an existing bitmap -- any type with stMem, iWidth, iHeight and iWidthBytes members (i.e. RawBitmap_t).
+    /// </summary>
+    template<typename Bitmap>
+    bool Attach(Bitmap & stBitmap) { return Attach(stBitmap.stMem,stBitmap.iWidth,stBitmap.iHeight,stBitmap.iWidthBytes); }
+
+    bool isValid() const { return m_sMem != nullptr; }
+    int GetWidth() const { return m_iWidth; }
+    int GetHeight() const { return m_iHeight; }
+    int GetWidthBytes() const { return m_iWidthBytes; }
+    unsigned char * GetMemory() { return m_sMem; }
+
+    __forceinline void SetPixel(int iX,int iY,Color_t rgbColor)
+    {
+        if ((unsigned) iX >= (unsigned) m_iWidth || (unsigned) iY >= (unsigned) m_iHeight) return;
+        unsigned char * sOut = GetRow(iY) + iX*3;
+        sOut[0] = rgbColor.b, sOut[1] = rgbColor.g, sOut[2] = rgbColor.r;
+    }
+
+    Color_t GetPixel(int iX,int iY)
+    {
+        if ((unsigned) iX >= (unsigned) m_iWidth || (unsigned) iY >= (unsigned) m_iHeight) return Color_t();
+        unsigned char * sIn = GetRow(iY) + iX*3;
+        return Color_t(sIn[2],sIn[1],sIn[0]);
+    }
+
+    /// <summary>
+    /// Clears the canvas to rgbColor.
+    /// </summary>
+    void Cls(Color_t rgbColor = Color_t())
+    {
+        if (!m_sMem) return;
+        FillSpan(0,0,m_iWidth,rgbColor);
+        for (int y=1;y<m_iHeight;y++) memcpy(GetRow(y),GetRow(0),(size_t) m_iWidth*3);
+    }
+
+    /// <summary>
+    /// Clears the canvas with a vertical gradient from rgbTop (first row) to rgbBottom (last row), as CWindow::Cls(rgbColor1,rgbColor2).
+    /// </summary>
+    void Cls(Color_t rgbTop,Color_t rgbBottom)
+    {
+        for (int y=0;y<m_iHeight;y++)
+        {
+            int iDiv = m_iHeight > 1 ? m_iHeight - 1 : 1;
+            Color_t rgbRow(rgbTop.r + ((int) rgbBottom.r - rgbTop.r)*y/iDiv,rgbTop.g + ((int) rgbBottom.g - rgbTop.g)*y/iDiv,rgbTop.b + ((int) rgbBottom.b - rgbTop.b)*y/iDiv);
+            FillSpan(y,0,m_iWidth,rgbRow);
+        }
+    }
+
+    bool FillRectangle(int iX,int iY,int iWidth,int iHeight,Color_t rgbColor)
+    {
+        if (!m_sMem || iWidth <= 0 || iHeight <= 0) return false;
+        FillRect(iX,iY,(int64_t) iX + iWidth,(int64_t) iY + iHeight,rgbColor);
+        return true;
+    }
+
+    bool DrawRectangle(int iX,int iY,int iWidth,int iHeight,Color_t rgbColor,int iPenSize = 1)
+    {
+        if (!m_sMem || iWidth <= 0 || iHeight <= 0) return false;
+        if (iPenSize < 1) iPenSize = 1;
+        if ((int64_t) iPenSize*2 >= iWidth || (int64_t) iPenSize*2 >= iHeight) return FillRectangle(iX,iY,iWidth,iHeight,rgbColor);
+
+        int64_t iX1 = iX, iY1 = iY, iX2 = iX1 + iWidth, iY2 = iY1 + iHeight;
+        FillRect(iX1,iY1,iX2,iY1 + iPenSize,rgbColor);                             // Top
+        FillRect(iX1,iY2 - iPenSize,iX2,iY2,rgbColor);                             // Bottom
+        FillRect(iX1,iY1 + iPenSize,iX1 + iPenSize,iY2 - iPenSize,rgbColor);       // Left
+        FillRect(iX2 - iPenSize,iY1 + iPenSize,iX2,iY2 - iPenSize,rgbColor);       // Right
+        return true;
+    }
+
+    bool DrawLine(int iX1,int iY1,int iX2,int iY2,Color_t rgbColor,int iPenSize = 1)
+    {
+        if (!m_sMem) return false;
+        if (iPenSize <= 1) DrawThinLine(iX1,iY1,iX2,iY2,rgbColor);
+        else DrawThickLine(iX1 + 0.5,iY1 + 0.5,iX2 + 0.5,iY2 + 0.5,rgbColor,iPenSize);
+        return true;
+    }
+
+    /// <summary>
+    /// Draws connected lines through iNumPoints points (POINT, CPoint, CfPointf, etc.)
+    /// </summary>
+    template<typename Point>
+    bool DrawLines(const Point * pLinePoints,int iNumPoints,Color_t rgbColor,int iPenSize = 1)
+    {
+        if (!m_sMem || !pLinePoints || iNumPoints < 2) return false;
+        for (int i=1;i<iNumPoints;i++) DrawLine(ClampInt(pLinePoints[i-1].x),ClampInt(pLinePoints[i-1].y),ClampInt(pLinePoints[i].x),ClampInt(pLinePoints[i].y),rgbColor,iPenSize);
+        return true;
+    }
+
+    template<typename Point>
+    bool DrawLines(const std::vector<Point> & vLinePoints,Color_t rgbColor,int iPenSize = 1) { return DrawLines(vLinePoints.data(),(int) vLinePoints.size(),rgbColor,iPenSize); }
+
+    /// <summary>
+    /// Fills a polygon (even-odd rule, so self-intersecting polygons work), with an optional outline in rgbColorOut when iPenSize > 0.
+    /// </summary>
+    template<typename Point>
+    bool FillPolygonFast(const Point * pPoints,int iVertices,Color_t rgbColor,Color_t rgbColorOut = Color_t(),int iPenSize = 0)
+    {
+        if (!m_sMem || !pPoints || iVertices < 3) return false;
+
+        // Pixel (x,y) covers x to x+1, so vertices are at the pixel corners they name, as with GDI
+
+        FillPolygonPoints(iVertices,[&](int i) { return std::pair<double,double>((double) pPoints[i].x,(double) pPoints[i].y); },rgbColor);
+        if (iPenSize > 0) DrawPolygon(pPoints,iVertices,rgbColorOut,iPenSize);
+        return true;
+    }
+
+    template<typename Point>
+    bool DrawPolygon(const Point * pPoints,int iVertices,Color_t rgbColor,int iPenSize = 1)
+    {
+        if (!m_sMem || !pPoints || iVertices < 2) return false;
+        for (int i=0;i<iVertices;i++)
+        {
+            auto & p1 = pPoints[i];
+            auto & p2 = pPoints[(i + 1) % iVertices];
+            DrawLine(ClampInt(p1.x),ClampInt(p1.y),ClampInt(p2.x),ClampInt(p2.y),rgbColor,iPenSize);
+        }
+        return true;
+    }
+
+    bool FillCircle(int iX,int iY,int iRadius,Color_t rgbColor)
+    {
+        if (!m_sMem || iRadius <= 0) return false;
+        FillCirclef(iX + 0.5,iY + 0.5,iRadius,rgbColor);
+        return true;
+    }
+
+    /// <summary>
+    /// Draws a circle outline iPenSize wide, inside the radius.
+    /// </summary>
+    bool DrawCircle(int iX,int iY,int iRadius,Color_t rgbColor,int iPenSize = 1)
+    {
+        if (!m_sMem || iRadius <= 0) return false;
+        if (iPenSize < 1) iPenSize = 1;
+
+        double fCX = iX + 0.5, fCY = iY + 0.5;
+        double fOuter = iRadius, fInner = iRadius - iPenSize;
+
+        int iY1 = (int) (std::max)((int64_t) 0,(int64_t) iY - iRadius);
+        int iY2 = (int) (std::min)((int64_t) m_iHeight - 1,(int64_t) iY + iRadius);
+
+        for (int y=iY1;y<=iY2;y++)
+        {
+            double fDY = y + 0.5 - fCY;
+            double fOut = fOuter*fOuter - fDY*fDY;
+            if (fOut < 0) continue;
+            fOut = std::sqrt(fOut);
+
+            double fIn = fInner > 0 ? fInner*fInner - fDY*fDY : -1;
+            if (fIn <= 0) { FillSpanf(y,fCX - fOut,fCX + fOut,rgbColor); continue; }
+            fIn = std::sqrt(fIn);
+            FillSpanf(y,fCX - fOut,fCX - fIn,rgbColor);
+            FillSpanf(y,fCX + fIn,fCX + fOut,rgbColor);
+        }
+        return true;
+    }
+
+    /// <summary>
+    /// Draws a cubic Bezier curve from p0 to p3 with control points p1 and p2.
+    /// </summary>
+    template<typename Point>
+    bool DrawBezier(const Point & p0,const Point & p1,const Point & p2,const Point & p3,Color_t rgbColor,int iPenSize = 1)
+    {
+        if (!m_sMem) return false;
+
+        // Segments from the length of the control polygon, so the flattened curve is within about a pixel
+
+        auto fnDist = [](const Point & a,const Point & b) { double dx = (double) b.x - a.x, dy = (double) b.y - a.y; return std::sqrt(dx*dx + dy*dy); };
+        int iSegments = (std::max)(8,ClampInt((fnDist(p0,p1) + fnDist(p1,p2) + fnDist(p2,p3))/4,0,1024));
+
+        m_vFlat.clear();
+        for (int i=0;i<=iSegments;i++)
+        {
+            double t = (double) i/iSegments, u = 1 - t;
+            double a = u*u*u, b = 3*u*u*t, c = 3*u*t*t, d = t*t*t;
+            m_vFlat.emplace_back(a*p0.x + b*p1.x + c*p2.x + d*p3.x,a*p0.y + b*p1.y + c*p2.y + d*p3.y);
+        }
+
+        double fOffset = iPenSize <= 1 ? 0.0 : 0.5;
+        for (int i=1;i<=iSegments;i++) DrawLinePen(m_vFlat[i-1].first + fOffset,m_vFlat[i-1].second + fOffset,m_vFlat[i].first + fOffset,m_vFlat[i].second + fOffset,rgbColor,iPenSize);
+        return true;
+    }
+
+    /// <summary>
+    /// Writes text at (iX,iY) with the built-in 8x8 font, scaled by iScale.  '\n' starts a new line.  Returns the width of the
+    /// widest line written, in pixels.
+    /// </summary>
+    int Write(int iX,int iY,const char * sText,Color_t rgbColor = Color_t(255,255,255),int iScale = 1)
+    {
+        if (!m_sMem || !sText) return 0;
+        if (iScale < 1) iScale = 1;
+
+        int iCharSize = kFontSize*iScale;
+        int iCol = 0, iMaxCol = 0, iLine = 0;
+        for (const char * s = sText;*s;s++)
+        {
+            if (*s == '\n') { iLine++; iCol = 0; continue; }
+
+            int iCharX = iX + iCol*iCharSize, iCharY = iY + iLine*iCharSize;
+            iMaxCol = (std::max)(iMaxCol,++iCol);
+            if (iCharX >= m_iWidth || iCharY >= m_iHeight || iCharX + iCharSize <= 0 || iCharY + iCharSize <= 0) continue;
+
+            const unsigned char * sGlyph = GetGlyph(*s);
+            for (int gy=0;gy<kFontSize;gy++)
+            {
+                unsigned char uBits = sGlyph[gy];
+                for (int gx=0;gx<kFontSize;)
+                {
+                    if (!(uBits & (1 << gx))) { gx++; continue; }
+                    int iStart = gx;
+                    while (gx < kFontSize && (uBits & (1 << gx))) gx++;
+                    for (int sy=0;sy<iScale;sy++) FillSpan(iCharY + gy*iScale + sy,iCharX + iStart*iScale,iCharX + gx*iScale,rgbColor);
+                }
+            }
+        }
+        return iMaxCol*iCharSize;
+    }
+
+    /// <summary>
+    /// Copies a 24-bit bitmap (any type with stMem, iWidth, iHeight and iWidthBytes members, i.e. RawBitmap_t) to (iX,iY), clipped
+    /// to the canvas.
+    /// </summary>
+    template<typename Bitmap>
+    bool DisplayBitmap(int iX,int iY,const Bitmap & stBitmap)
+    {
+        return DisplayBitmap(iX,iY,stBitmap.iWidth,stBitmap.iHeight,stBitmap.stMem,stBitmap.iWidthBytes);
+    }
+
+    /// <summary>
+    /// Copies iWidth x iHeight 24-bit BGR pixels from sMemory to (iX,iY), clipped to the canvas.  Rows are iWidthBytes apart
+    /// (0 = rows padded to 4 bytes, as with CWindow::DisplayBitmap()).
+    /// </summary>
+    bool DisplayBitmap(int iX,int iY,int iWidth,int iHeight,const unsigned char * sMemory,int iWidthBytes = 0)
+    {
+        if (!m_sMem || !sMemory || iWidth <= 0 || iHeight <= 0) return false;
+        if (!iWidthBytes) iWidthBytes = (iWidth*3 + 3) & ~3;
+
+        int iSX = iX < 0 ? -iX : 0, iSY = iY < 0 ? -iY : 0;
+        int iCopyW = (std::min)(iWidth,m_iWidth - iX) - iSX;
+        int iCopyH = (std::min)(iHeight,m_iHeight - iY) - iSY;
+        if (iCopyW <= 0 || iCopyH <= 0) return true;
+
+        for (int y=0;y<iCopyH;y++)
+            memcpy(GetRow(iY + iSY + y) + (iX + iSX)*3,sMemory + (size_t) (iSY + y)*iWidthBytes + iSX*3,(size_t) iCopyW*3);
+        return true;
+    }
+
+    /// <summary>
+    /// Returns a 64-bit FNV-1a hash of the pixels (row padding is not included), for golden-image comparisons.
+    /// </summary>
+    uint64_t GetHash() const
+    {
+        uint64_t uHash = 0xcbf29ce484222325ull;
+        for (int y=0;y<m_iHeight;y++)
+        {
+            const unsigned char * sRow = m_sMem + (size_t) y*m_iWidthBytes;
+            for (int x=0;x<m_iWidth*3;x++) uHash = (uHash ^ sRow[x])*0x100000001b3ull;
+        }
+        return uHash;
+    }
+
+    /// <summary>
+    /// Writes the canvas as a 24-bit .BMP file.
+    /// </summary>
+    bool WriteBMP(const char * sPath) const
+    {
+        if (!m_sMem || !sPath) return false;
+        FILE * fOut = fopen(sPath,"wb");
+        if (!fOut) return false;
+
+        int iRowBytes = (m_iWidth*3 + 3) & ~3;
+        uint32_t uImageSize = (uint32_t) iRowBytes*m_iHeight;
+        unsigned char sHeader[54] = { 'B','M' };
+        auto fnPut32 = [&](int iOffset,uint32_t uValue) { for (int i=0;i<4;i++) sHeader[iOffset+i] = (unsigned char) (uValue >> (i*8)); };
+        fnPut32(2,54 + uImageSize);
+        fnPut32(10,54);
+        fnPut32(14,40);
+        fnPut32(18,(uint32_t) m_iWidth);
+        fnPut32(22,(uint32_t) m_iHeight);
+        sHeader[26] = 1;
+        sHeader[28] = 24;
+        fnPut32(34,uImageSize);
+
+        bool bResult = fwrite(sHeader,1,54,fOut) == 54;
+        std::vector<unsigned char> vRow(iRowBytes,0);
+        for (int y=m_iHeight-1;y>=0 && bResult;y--)
+        {
+            memcpy(vRow.data(),m_sMem + (size_t) y*m_iWidthBytes,(size_t) m_iWidth*3);        // Canvas rows are already BMP (BGR) order
+            bResult = fwrite(vRow.data(),1,iRowBytes,fOut) == (size_t) iRowBytes;
+        }
+        bResult &= !fclose(fOut);
+        return bResult;
+    }
+};
+
+} // namespace Sage
+#endif // _COffscreenWindow_H_
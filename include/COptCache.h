@@ -0,0 +1,221 @@
+// This file copyright(c) 2021 Rob Nelson, All Rights Reserved.    E-mail rob@projectsagebox.com for more information.
+//
+
+#pragma once
+#if !defined(_COptCache_H_)
+#define _COptCache_H_
+
+#include "Sage.h"
+#include "SageOpt.h"
+#include "keywords\opt2_ckwargs.h"
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <memory>
+#include <mutex>
+#include <atomic>
+
+namespace Sage
+{
+
+// ----------------------------------
+// Interned and compiled option sets
+// ----------------------------------
+//
+// Control and window creation functions take their options as a cwfOpt (opt::) string or a kwOpt (kw::) keyword chain.  Both
+// are rebuilt on every call -- cwfOpt objects are taken from the recycled Temp() array and their strings concatenated, and
+// each kw:: function constructs a ckw node -- and then parsed again by the function receiving them.  When the same option
+// set is used for thousands of controls, this is all repeated work.
+//
+// The classes below build an option set once, into an immutable form that can be passed to the same functions:
+//
+//      cwfOpt      COptCache::Intern() returns a CInternedOpt, shared by content: interning the same option string again
+//                  returns the same object, with its hash.  This is a string interner -- it saves building and copying the
+//                  string, but the function receiving the cwfOpt still parses it.
+//
+//      kwOpt       CCompiledKeys keeps a persistent copy of a keyword chain, along with its KeyValuesPtr (the parsed form
+//                  returned by FillKeyValues()), so it's built once where it's declared:
+//
+//                      static const CCompiledKeys<> cSliderKeys(kw::Range(0,100) | kw::Default(50) | kw::fgColor("Yellow"));
+//
+//                      for (int i=0;i<iSliders;i++) cWin.NewSlider(10,10 + i*40,200,"Level",cSliderKeys);
+//
+
+// CInternedOpt -- One immutable option set, from COptCache::Intern()
+//
+// The object has the option string, its hash and a cwfOpt copy of it, and lives as long as the COptCache that returned it, so
+// references to it can be kept and compared by address (two CInternedOpt references are the same options only if they are
+// the same object).  Nothing is parsed -- for keywords parsed once, see CCompiledKeys below.
+//
+class CInternedOpt
+{
+    std::string m_sOpt;
+    size_t m_uHash;
+    cwfOpt m_cOpt;
+
+public:
+    CInternedOpt(const cwfOpt & cOpt,std::string_view sOpt,size_t uHash) : m_sOpt(sOpt), m_uHash(uHash), m_cOpt(cOpt) { }
+
+    CInternedOpt(const CInternedOpt &) = delete;
+    CInternedOpt & operator = (const CInternedOpt &) = delete;
+
+    const cwfOpt & GetOpt() const { return m_cOpt; }
+    operator const cwfOpt & () const { return m_cOpt; }
+
+    const char * GetString() const { return m_sOpt.c_str(); }
+    const std::string & str() const { return m_sOpt; }
+    size_t GetHash() const { return m_uHash; }
+};
+
+// COptCache -- Interner for cwfOpt option strings (a content-keyed table of CInternedOpt objects)
+//
+// Intern() looks up the option string in a hash table, and only creates (and copies) the cwfOpt the first time that string is
+// seen.  The lookup doesn't allocate, so interning the options for each of 10,000 identical controls costs one hash and one
+// compare per control.
+//
+//      auto & cOpt = COptCache::GetDefault().Intern(opt::fgColor("Yellow") | opt::Font("Arial,20"));
+//
+// Notes:
+//
+//      1. Entries are never removed (there is no Clear()), so references returned by Intern() stay valid for the life of
+//         the cache -- this is meant for the fixed set of option strings a program uses, not for strings built from data.
+//      2. Intern() can be called from any thread.
+//
+class COptCache
+{
+    mutable std::mutex m_mLock;
+    std::unordered_map<std::string_view,std::unique_ptr<CInternedOpt>> m_mOpts;     // Keys point into the CInternedOpt string
+
+    std::atomic<unsigned long long> m_ullHits{0};
+    std::atomic<unsigned long long> m_ullMisses{0};
+
+public:
+    COptCache() = default;
+    COptCache(const COptCache &) = delete;
+    COptCache & operator = (const COptCache &) = delete;
+
+    // Returns the process-wide cache
+
+    static COptCache & GetDefault()
+    {
+        static COptCache cCache;
+        return cCache;
+    }
+
+    /// <summary>
+    /// Returns the interned copy of cOpt -- the same object for every call with the same option string.
+    /// </summary>
+    const CInternedOpt & Intern(const cwfOpt & cOpt)
+    {
+        std::string_view sOpt(*cOpt);
+        size_t uHash = std::hash<std::string_view>{}(sOpt);
+
+        std::lock_guard<std::mutex> lock(m_mLock);
+
+        auto it = m_mOpts.find(sOpt);
+        if (it != m_mOpts.end())
+        {
+            m_ullHits.fetch_add(1,std::memory_order_relaxed);
+            return *it->second;
+        }
+
+        m_ullMisses.fetch_add(1,std::memory_order_relaxed);
+        auto pOpt = std::make_unique<CInternedOpt>(cOpt,sOpt,uHash);
+        auto & cInterned = *pOpt;
+        m_mOpts.emplace(std::string_view(cInterned.str()),std::move(pOpt));
+        return cInterned;
+    }
+
+    /// <summary>
+    /// Returns the interned option set for a literal option string (i.e. the same as opt::Str(sOptions)).  Nothing is created
+    /// when the string has been interned before.
+    /// </summary>
+    const CInternedOpt & Intern(const char * sOptions)
+    {
+        if (!sOptions) sOptions = "";
+        {
+            std::lock_guard<std::mutex> lock(m_mLock);
+            auto it = m_mOpts.find(std::string_view(sOptions));
+            if (it != m_mOpts.end())
+            {
+                m_ullHits.fetch_add(1,std::memory_order_relaxed);
+                return *it->second;
+            }
+        }
+
+        cwfOpt cOpt;
+        if (*sOptions) cOpt.literal(sOptions);
+        return Intern(cOpt);
+    }
+
+    int GetCount() const
+    {
+        std::lock_guard<std::mutex> lock(m_mLock);
+        return (int) m_mOpts.size();
+    }
+
+    unsigned long long GetHits() const { return m_ullHits.load(std::memory_order_relaxed); }
+    unsigned long long GetMisses() const { return m_ullMisses.load(std::memory_order_relaxed); }
+};
+
+// CCompiledKeys -- A keyword chain (kwOpt) built once, with its parsed KeyValuesPtr
+//
+// The keyword chain passed in is copied node by node into a SageKeys<> buffer, so it no longer depends on the temporaries
+// returned by the kw:: functions, and FillKeyValues() is called once for it.  The object can then be passed to any function
+// taking a const kwOpt &, as many times as needed.
+//
+// Notes:
+//
+//      1. Keyword values are copied, but strings in them are kept as pointers (as with any kwOpt), so strings used for
+//         a CCompiledKeys must stay unchanged for its lifetime -- string literals are the usual case.
+//      2. Up to iMaxKeys keywords are kept; any more are ignored (see GetCount()).
+//      3. CCompiledKeys can't be copied or moved, since GetKeyValues() points into it.
+//
+template<int iMaxKeys = 32>
+class CCompiledKeys
+{
+    SageKeys<iMaxKeys> m_cKeys;
+    const kwType::ckw * m_pKeys = nullptr;
+    kwType::KeyValuesPtr m_stValues{};
+    int m_iCount = 0;
+
+public:
+    CCompiledKeys(const kwType::ckw & keys) { Compile(keys); }
+
+    CCompiledKeys(const CCompiledKeys &) = delete;
+    CCompiledKeys & operator = (const CCompiledKeys &) = delete;
+
+    /// <summary>
+    /// Replaces the keywords with a copy of the chain in keys.  This isn't thread-safe -- compile before sharing the object.
+    /// </summary>
+    void Compile(const kwType::ckw & keys)
+    {
+        m_cKeys.Clear();
+        m_iCount = 0;
+
+        for (auto pNode = &keys;pNode && m_iCount < iMaxKeys;pNode = pNode->pNext)
+        {
+            kwType::ckw stNode;
+            stNode.package.key  = pNode->package.key;
+            stNode.keyValues    = pNode->keyValues;
+            m_cKeys << stNode;
+            m_iCount++;
+        }
+
+        kwType::ckw & cRoot = m_cKeys;
+        m_pKeys     = &cRoot;
+        m_stValues  = cRoot.FillKeyValues();
+    }
+
+    operator const kwType::ckw & () const { return *m_pKeys; }
+    const kwType::ckw & GetKeys() const { return *m_pKeys; }
+
+    // The parsed keywords: a pointer to each keyword's value, or nullptr for keywords not in the set
+
+    const kwType::KeyValuesPtr & GetKeyValues() const { return m_stValues; }
+
+    int GetCount() const { return m_iCount; }
+};
+
+} // namespace Sage
+#endif // _COptCache_H_
@@ -20,6 +20,7 @@
 #include "Sage.h"
 #include "CString.h"
 #include "CRawBitmap32.h"
+#include "CImageCache.h"
 
 namespace Sage
 {
@@ -261,6 +262,38 @@ public:
 	CBitmap32 ReadBitmap32(const char * sTopKey,const char * sFile);
 	CBitmap ReadBitmap(const char * sFile);
 	CBitmap ReadBitmap(const char * sTopKey,const char * sFile);
+
+	// GetBitmap() -- Returns a bitmap shared through the process-wide CImageCache, decoding it with ReadBitmap() only when it
+	// isn't cached (i.e. when a skinned dialog is opened again).  Returns nullptr if the bitmap can't be read.  Bitmaps are
+	// cached by the PGR that is loaded (see GetCacheID()), not by the CSagePGR object, so deleting the CSagePGR or reading
+	// another PGR with it can't return stale bitmaps -- the old PGR's bitmaps are left to be evicted from the cache.
+
+	CImageCache::Bitmap_t GetBitmap(const char * sFile) { return GetBitmap(nullptr,sFile); }
+	CImageCache::Bitmap_t GetBitmap(const char * sTopKey,const char * sFile)
+	{
+		if (!m_cPGR) return nullptr;
+		std::string sEntry = sTopKey ? std::string(sTopKey) + ':' + (sFile ? sFile : "") : std::string(sFile ? sFile : "");
+		return CImageCache::Get().GetOrDecode(GetCacheID(),sEntry.c_str(),[&] { return sTopKey ? ReadBitmap(sTopKey,sFile) : ReadBitmap(sFile); });
+	}
+
+	// GetCacheID() -- CImageCache ID of the loaded PGR: CImageCache::PgrID() of its file (path, size and write time) or memory
+	// (address), with the memory size and the PGR's CRCs, so memory reused for a different PGR gets a different ID.  Call
+	// CImageCache::Get().RemovePgr(GetCacheID()) to free the bitmaps cached for the PGR right away.
+
+	std::string GetCacheID()
+	{
+		if (!m_cPGR) return std::string();
+		char sStamp[64];
+		snprintf(sStamp,sizeof(sStamp),"|%x|%x",m_cPGR->m_stPGRHeader.ulCRC,m_cPGR->m_stPGRHeader.ulHeaderCRC);
+
+		if (auto cMemPgr = dynamic_cast<CMemPGR *>(m_cPGR))
+		{
+			char sSize[16];
+			snprintf(sSize,sizeof(sSize),"|%x",cMemPgr->m_iFileSize);
+			return CImageCache::PgrID(cMemPgr->m_sPGRLocation) + sSize + sStamp;
+		}
+		return CImageCache::PgrID(m_cPGR->m_sFile) + sStamp;
+	}
 	bool FileExists(const char * sTopKey,const char * sFile);
 	bool FileExists(const char * sFile);
 	ePGR_t ReadInt(int * iValue,const char * sKey,const char * sSubKey = nullptr); 
@@ -0,0 +1,193 @@
+// This file copyright(c) 2021 Rob Nelson, All Rights Reserved.    E-mail rob@projectsagebox.com for more information.
+//
+
+#pragma once
+#if !defined(_CPointCloud3D_H_)
+#define _CPointCloud3D_H_
+
+#include "Point3D.h"
+#include <new>
+#include <memory>
+#include <cstring>
+#include <cstddef>
+
+namespace Sage
+{
+
+// CPointCloud3D -- Structure-of-arrays point cloud: separate, aligned X, Y and Z float arrays (and optional normals)
+//
+// This is the input (and output) of the CView3D batch functions (CView3D::TranslateViewBatch(), Translate2DBatch() and
+// LightBatch()), which work on kSimdPad points at a time with the SimdClass backends, rather than one Point3D_t at a time.
+//
+//      CPointCloud3D cCloud;
+//      cCloud.Reserve(iPoints);
+//      for (auto & p : vSamples) cCloud.Add(p.fX,p.fY,p.fZ);
+//
+//      cView.Translate2DBatch(cCloud,cProjected);      // cProjected X,Y = 2D point, Z = 2D multiplier (see CView3D::Translate2DPoint())
+//
+// Notes:
+//
+//      1. Each array starts on a kAlign-byte boundary, and is allocated in multiples of kSimdPad floats, so a kernel can always load
+//         and store whole vectors, including the last one.  Padding past size() is kept at 0.
+//      2. Normals are only allocated after EnableNormals() (or the first Add() with a normal).
+//
+class CPointCloud3D
+{
+public:
+    static constexpr int kAlign     = 64;           // Array alignment (one AVX-512 register / cache line)
+    static constexpr int kSimdPad   = 16;           // Arrays are allocated in multiples of this many floats
+
+private:
+    struct AlignedDelete_t { void operator()(float * fMem) const { ::operator delete[](fMem,std::align_val_t(kAlign)); } };
+    using Array_t = std::unique_ptr<float[],AlignedDelete_t>;
+
+    Array_t m_fX, m_fY, m_fZ;
+    Array_t m_fNX, m_fNY, m_fNZ;
+    int m_iSize         = 0;
+    int m_iCapacity     = 0;
+    bool m_bNormals     = false;
+
+    static int PadSize(int iSize) { return (iSize + kSimdPad - 1) & ~(kSimdPad - 1); }
+
+    static Array_t Allocate(int iCapacity)
+    {
+        Array_t fMem((float *) ::operator new[](iCapacity*sizeof(float),std::align_val_t(kAlign)));
+        memset(fMem.get(),0,iCapacity*sizeof(float));
+        return fMem;
+    }
+
+    void Grow(Array_t & fArray,int iCapacity)
+    {
+        Array_t fNew = Allocate(iCapacity);
+        if (fArray && m_iSize) memcpy(fNew.get(),fArray.get(),m_iSize*sizeof(float));
+        fArray = std::move(fNew);
+    }
+
+public:
+    CPointCloud3D() = default;
+    CPointCloud3D(int iSize,bool bNormals = false) { Resize(iSize); if (bNormals) EnableNormals(); }
+
+    CPointCloud3D(CPointCloud3D &&) = default;
+    CPointCloud3D & operator = (CPointCloud3D &&) = default;
+
+    CPointCloud3D(const CPointCloud3D & cCloud) { *this = cCloud; }
+    CPointCloud3D & operator = (const CPointCloud3D & cCloud)
+    {
+        if (this == &cCloud) return *this;
+        Clear();
+        Resize(cCloud.m_iSize);
+        if (cCloud.m_bNormals) EnableNormals();
+        if (!m_iSize) return *this;
+        size_t iBytes = m_iSize*sizeof(float);
+        memcpy(m_fX.get(),cCloud.m_fX.get(),iBytes);
+        memcpy(m_fY.get(),cCloud.m_fY.get(),iBytes);
+        memcpy(m_fZ.get(),cCloud.m_fZ.get(),iBytes);
+        if (m_bNormals)
+        {
+            memcpy(m_fNX.get(),cCloud.m_fNX.get(),iBytes);
+            memcpy(m_fNY.get(),cCloud.m_fNY.get(),iBytes);
+            memcpy(m_fNZ.get(),cCloud.m_fNZ.get(),iBytes);
+        }
+        return *this;
+    }
+
+    /// <summary>
+    /// Makes room for iCapacity points without changing the size.
+    /// </summary>
+    void Reserve(int iCapacity)
+    {
+        if (iCapacity <= m_iCapacity) return;
+        iCapacity = PadSize(iCapacity);
+        Grow(m_fX,iCapacity);
+        Grow(m_fY,iCapacity);
+        Grow(m_fZ,iCapacity);
+        if (m_bNormals) Grow(m_fNX,iCapacity), Grow(m_fNY,iCapacity), Grow(m_fNZ,iCapacity);
+        m_iCapacity = iCapacity;
+    }
+
+    /// <summary>
+    /// Sets the number of points.  New points are 0,0,0.
+    /// </summary>
+    void Resize(int iSize)
+    {
+        if (iSize < 0) iSize = 0;
+        Reserve(iSize);
+
+        // Clear anything past the new size, so padding stays 0 and grown points start at 0
+
+        if (iSize < m_iSize)
+        {
+            size_t iBytes = (m_iSize - iSize)*sizeof(float);
+            memset(m_fX.get() + iSize,0,iBytes);
+            memset(m_fY.get() + iSize,0,iBytes);
+            memset(m_fZ.get() + iSize,0,iBytes);
+            if (m_bNormals) memset(m_fNX.get() + iSize,0,iBytes), memset(m_fNY.get() + iSize,0,iBytes), memset(m_fNZ.get() + iSize,0,iBytes);
+        }
+        m_iSize = iSize;
+    }
+
+    /// <summary>
+    /// Allocates the normal arrays (all 0) if they aren't already allocated.
+    /// </summary>
+    void EnableNormals()
+    {
+        if (m_bNormals) return;
+        m_bNormals = true;
+        if (!m_iCapacity) return;
+        m_fNX = Allocate(m_iCapacity);
+        m_fNY = Allocate(m_iCapacity);
+        m_fNZ = Allocate(m_iCapacity);
+    }
+
+    void Clear() { Resize(0); }
+
+    __forceinline void Add(float fX,float fY,float fZ)
+    {
+        if (m_iSize == m_iCapacity) Reserve(m_iCapacity ? m_iCapacity*2 : 1024);
+        m_fX[m_iSize] = fX;
+        m_fY[m_iSize] = fY;
+        m_fZ[m_iSize] = fZ;
+        m_iSize++;
+    }
+
+    __forceinline void Add(float fX,float fY,float fZ,float fNX,float fNY,float fNZ)
+    {
+        EnableNormals();
+        Add(fX,fY,fZ);
+        m_fNX[m_iSize-1] = fNX;
+        m_fNY[m_iSize-1] = fNY;
+        m_fNZ[m_iSize-1] = fNZ;
+    }
+
+    __forceinline void Add(const Point3D_t & p) { Add((float) p.fX,(float) p.fY,(float) p.fZ); }
+    __forceinline void Add(const Point3Df_t & p) { Add(p.fX,p.fY,p.fZ); }
+
+    __forceinline void Set(int iIndex,float fX,float fY,float fZ) { m_fX[iIndex] = fX; m_fY[iIndex] = fY; m_fZ[iIndex] = fZ; }
+    __forceinline void SetNormal(int iIndex,float fNX,float fNY,float fNZ) { m_fNX[iIndex] = fNX; m_fNY[iIndex] = fNY; m_fNZ[iIndex] = fNZ; }
+
+    __forceinline Point3Df_t Get(int iIndex) const { return { m_fX[iIndex],m_fY[iIndex],m_fZ[iIndex] }; }
+    __forceinline Point3Df_t GetNormal(int iIndex) const { return { m_fNX[iIndex],m_fNY[iIndex],m_fNZ[iIndex] }; }
+
+    int size() const { return m_iSize; }
+    bool empty() const { return !m_iSize; }
+    int GetCapacity() const { return m_iCapacity; }
+    bool hasNormals() const { return m_bNormals; }
+
+    // Direct access to the arrays (nullptr until something is allocated).  Each array has GetCapacity() floats.
+
+    float * GetX() { return m_fX.get(); }
+    float * GetY() { return m_fY.get(); }
+    float * GetZ() { return m_fZ.get(); }
+    float * GetNX() { return m_fNX.get(); }
+    float * GetNY() { return m_fNY.get(); }
+    float * GetNZ() { return m_fNZ.get(); }
+    const float * GetX() const { return m_fX.get(); }
+    const float * GetY() const { return m_fY.get(); }
+    const float * GetZ() const { return m_fZ.get(); }
+    const float * GetNX() const { return m_fNX.get(); }
+    const float * GetNY() const { return m_fNY.get(); }
+    const float * GetNZ() const { return m_fNZ.get(); }
+};
+
+} // namespace Sage
+#endif // _CPointCloud3D_H_
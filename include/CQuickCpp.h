@@ -5179,6 +5179,11 @@ public:
     //
     static WaitEvent WaitforEvent(cwfEvent & cwEvent);
 
+    // WaitforEvent() -- Same as WaitforEvent() above, with an EventFilter (see EventOpt.h), i.e. WaitforEvent(EventMask::Button | EventMask::MouseMove).
+    // The filter is passed as its cwfEvent option string (see EventFilter::GetOptString()).
+    //
+    static WaitEvent WaitforEvent(EventFilter eFilter) { return WaitforEvent(eFilter.GetOptString()); }
+
     //-->  Original Prototype: bool EventLoop(WaitEvent * eStatus = nullptr);
 
     // EventLoop() -- Wait for a user event, such as a mouse move, mouse click, button press, slider press, or any control or widget event.
@@ -0,0 +1,217 @@
+// This file copyright(c) 2021 Rob Nelson, All Rights Reserved.    E-mail rob@projectsagebox.com for more information.
+//
+
+#pragma once
+#if !defined(_CRawAviWriter_H_)
+#define _CRawAviWriter_H_
+
+#include "Sage.h"
+#include <cstdio>
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+namespace Sage
+{
+
+// CRawAviWriter -- Writes uncompressed 24-bit AVI files directly, without the Windows VFW (avifil32.dll) functions
+//
+// The file is a standard AVI 1.0 RIFF file with one 'vids' stream of uncompressed DIB frames and an 'idx1' index, so it
+// plays in any AVI reader (and can be read with CAviFile::OpenAviFile()).  Since it only uses stdio, it also works where
+// VFW isn't available.
+//
+// Frames are RawBitmap_t bitmaps (BGR in memory, first row is the top of the image); they are written as bottom-up BGR DIB
+// rows, as AVI readers expect.  Use bSourceRGB = true in Create() if the frames are RGB in memory (i.e. after SwapRedBlueInline()),
+// so red and blue are swapped as they are written.
+//
+// Notes:
+//
+//      1. AVI 1.0 files are limited to 4GB -- WriteFrame() returns false once the next frame would go past this.
+//      2. The header is written at Create() and rewritten with the final frame count at Close() (or the destructor).
+//
+class CRawAviWriter
+{
+public:
+    static constexpr uint64_t kMaxFileSize = 0xFFFFFFFFull - 1024*1024;
+
+private:
+    static constexpr int kHeaderSize    = 224;      // RIFF + hdrl + 'movi' LIST header (see WriteHeader())
+    static constexpr int kBufferSize    = 1024*1024;
+
+    FILE * m_fFile      = nullptr;
+    int m_iWidth        = 0;
+    int m_iHeight       = 0;
+    int m_iFrameRate    = 30;
+    int m_iFrames       = 0;
+    int m_iFrameBytes   = 0;            // DIB frame size (rows padded to 4 bytes)
+    bool m_bSourceRGB   = false;
+    std::vector<unsigned char> m_vRow;
+
+    void Put32(unsigned char * & sOut,uint32_t uValue)
+    {
+        for (int i=0;i<4;i++) *sOut++ = (unsigned char) (uValue >> (i*8));
+    }
+    void Put16(unsigned char * & sOut,uint32_t uValue)
+    {
+        *sOut++ = (unsigned char) uValue;
+        *sOut++ = (unsigned char) (uValue >> 8);
+    }
+    void PutID(unsigned char * & sOut,const char * sID)
+    {
+        for (int i=0;i<4;i++) *sOut++ = (unsigned char) sID[i];
+    }
+
+    uint32_t GetMoviSize() const { return 4 + (uint32_t) m_iFrames*(8 + m_iFrameBytes); }
+
+    bool WriteHeader()
+    {
+        unsigned char sHeader[kHeaderSize];
+        unsigned char * s = sHeader;
+
+        uint32_t uIndexSize = 16*(uint32_t) m_iFrames;
+
+        PutID(s,"RIFF"); Put32(s,kHeaderSize - 8 + GetMoviSize() - 4 + 8 + uIndexSize); PutID(s,"AVI ");
+        PutID(s,"LIST"); Put32(s,192); PutID(s,"hdrl");
+
+        // avih -- main AVI header
+
+        PutID(s,"avih"); Put32(s,56);
+        Put32(s,1000000/m_iFrameRate);                      // dwMicroSecPerFrame
+        Put32(s,(uint32_t) m_iFrameBytes*(uint32_t) m_iFrameRate);  // dwMaxBytesPerSec
+        Put32(s,0);                                         // dwPaddingGranularity
+        Put32(s,0x10);                                      // dwFlags = AVIF_HASINDEX
+        Put32(s,m_iFrames);                                 // dwTotalFrames
+        Put32(s,0);                                         // dwInitialFrames
+        Put32(s,1);                                         // dwStreams
+        Put32(s,m_iFrameBytes);                             // dwSuggestedBufferSize
+        Put32(s,m_iWidth);
+        Put32(s,m_iHeight);
+        for (int i=0;i<4;i++) Put32(s,0);                   // dwReserved
+
+        // strl -- one video stream
+
+        PutID(s,"LIST"); Put32(s,116); PutID(s,"strl");
+        PutID(s,"strh"); Put32(s,56);
+        PutID(s,"vids"); PutID(s,"DIB ");
+        Put32(s,0);                                         // dwFlags
+        Put16(s,0); Put16(s,0);                             // wPriority, wLanguage
+        Put32(s,0);                                         // dwInitialFrames
+        Put32(s,1); Put32(s,m_iFrameRate);                  // dwScale, dwRate
+        Put32(s,0);                                         // dwStart
+        Put32(s,m_iFrames);                                 // dwLength
+        Put32(s,m_iFrameBytes);                             // dwSuggestedBufferSize
+        Put32(s,0xFFFFFFFF);                                // dwQuality
+        Put32(s,0);                                         // dwSampleSize (0 for video)
+        Put16(s,0); Put16(s,0); Put16(s,m_iWidth); Put16(s,m_iHeight);     // rcFrame
+
+        PutID(s,"strf"); Put32(s,40);                       // BITMAPINFOHEADER
+        Put32(s,40);
+        Put32(s,m_iWidth);
+        Put32(s,m_iHeight);                                 // Positive = bottom-up
+        Put16(s,1); Put16(s,24);
+        Put32(s,0);                                         // BI_RGB
+        Put32(s,m_iFrameBytes);
+        for (int i=0;i<4;i++) Put32(s,0);
+
+        PutID(s,"LIST"); Put32(s,GetMoviSize()); PutID(s,"movi");
+
+        return s - sHeader == kHeaderSize && fwrite(sHeader,1,kHeaderSize,m_fFile) == kHeaderSize;
+    }
+
+    bool WriteIndex()
+    {
+        unsigned char sEntry[16];
+        unsigned char * s = sEntry;
+        PutID(s,"idx1"); Put32(s,16*(uint32_t) m_iFrames);
+        if (fwrite(sEntry,1,8,m_fFile) != 8) return false;
+
+        for (int i=0;i<m_iFrames;i++)
+        {
+            s = sEntry;
+            PutID(s,"00db");
+            Put32(s,0x10);                                  // AVIIF_KEYFRAME
+            Put32(s,4 + (uint32_t) i*(8 + m_iFrameBytes));  // Offset from the 'movi' ID
+            Put32(s,m_iFrameBytes);
+            if (fwrite(sEntry,1,16,m_fFile) != 16) return false;
+        }
+        return true;
+    }
+
+public:
+    CRawAviWriter() = default;
+    ~CRawAviWriter() { Close(); }
+
+    CRawAviWriter(const CRawAviWriter &) = delete;
+    CRawAviWriter & operator = (const CRawAviWriter &) = delete;
+
+    /// <summary>
+    /// Creates sPath as an uncompressed AVI file for iWidth x iHeight frames.  Returns false if the file can't be created.
+    /// </summary>
+    /// <param name="bSourceRGB"> - [optional] When true, frames are RGB in memory, and red and blue are swapped as they are written</param>
+    bool Create(const char * sPath,int iWidth,int iHeight,int iFrameRate = 30,bool bSourceRGB = false)
+    {
+        Close();
+        if (!sPath || iWidth <= 0 || iHeight <= 0 || iWidth > 32767 || iHeight > 32767) return false;
+
+        m_fFile = fopen(sPath,"wb");
+        if (!m_fFile) return false;
+        setvbuf(m_fFile,nullptr,_IOFBF,kBufferSize);
+
+        m_iWidth        = iWidth;
+        m_iHeight       = iHeight;
+        m_iFrameRate    = iFrameRate > 0 ? iFrameRate : 30;
+        m_iFrames       = 0;
+        m_iFrameBytes   = ((iWidth*3 + 3) & ~3)*iHeight;
+        m_bSourceRGB    = bSourceRGB;
+        m_vRow.assign((iWidth*3 + 3) & ~3,0);
+
+        if (!WriteHeader()) { fclose(m_fFile); m_fFile = nullptr; return false; }
+        return true;
+    }
+
+    /// <summary>
+    /// Appends one frame.  stFrame must be the size given to Create().  Returns false on a size mismatch, a write error, or when the
+    /// file would go past the AVI 1.0 size limit.
+    /// </summary>
+    bool WriteFrame(const RawBitmap_t & stFrame)
+    {
+        if (!m_fFile || !stFrame.stMem || stFrame.iWidth != m_iWidth || stFrame.iHeight != m_iHeight) return false;
+        if ((uint64_t) kHeaderSize + GetMoviSize() + 8 + m_iFrameBytes + 16ull*(m_iFrames + 1) + 8 > kMaxFileSize) return false;
+
+        unsigned char sChunk[8];
+        unsigned char * s = sChunk;
+        PutID(s,"00db"); Put32(s,m_iFrameBytes);
+        if (fwrite(sChunk,1,8,m_fFile) != 8) return false;
+
+        // Bottom-up, BGR
+
+        for (int y=m_iHeight-1;y>=0;y--)
+        {
+            const unsigned char * sIn = stFrame.stMem + (size_t) y*stFrame.iWidthBytes;
+            unsigned char * sOut = m_vRow.data();
+            if (!m_bSourceRGB) memcpy(sOut,sIn,m_iWidth*3);
+            else for (int x=0;x<m_iWidth;x++,sIn += 3,sOut += 3) sOut[0] = sIn[2], sOut[1] = sIn[1], sOut[2] = sIn[0];
+            if (fwrite(m_vRow.data(),1,m_vRow.size(),m_fFile) != m_vRow.size()) return false;
+        }
+        m_iFrames++;
+        return true;
+    }
+
+    /// <summary>
+    /// Writes the index, updates the header with the frame count and closes the file.  Returns false if anything could not be written.
+    /// </summary>
+    bool Close()
+    {
+        if (!m_fFile) return true;
+        bool bResult = WriteIndex() && !fseek(m_fFile,0,SEEK_SET) && WriteHeader();
+        bResult &= !fclose(m_fFile);
+        m_fFile = nullptr;
+        return bResult;
+    }
+
+    bool isOpen() const { return m_fFile != nullptr; }
+    int GetFrameCount() const { return m_iFrames; }
+};
+
+} // namespace Sage
+#endif // _CRawAviWriter_H_
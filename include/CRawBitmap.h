@@ -16,6 +16,7 @@
 #if !defined(_CRawBitmap_H_)
 #define _CRawBitmap_H_
 #include "Sage.h"
+#include "CBlendKernels.h"
 
 #pragma warning(push)
 #pragma warning(disable : 26451)    // Mute Microsoft "warning" about overflow (which, imo, is far too broad)
@@ -538,29 +539,29 @@ public:
     //
 	CBitmap ReverseBitmap();
 
-	bool ApplyMaskGraphic(RawBitmap_t & stBackground,RawBitmap_t & stDest) { return stBitmap.ApplyMaskGraphic(stBackground,stDest); }
-	bool ApplyMaskGraphic(CBitmap & cBackground,CBitmap & cDest) { return stBitmap.ApplyMaskGraphic(*cBackground,*cDest); }
+	bool ApplyMaskGraphic(RawBitmap_t & stBackground,RawBitmap_t & stDest) { return CBlendKernels::ApplyMaskGraphic(stBitmap,stBackground,stDest); }
+	bool ApplyMaskGraphic(CBitmap & cBackground,CBitmap & cDest) { return CBlendKernels::ApplyMaskGraphic(stBitmap,*cBackground,*cDest); }
 		
-	bool ApplyMaskGraphic(POINT pSourceStart, RawBitmap_t & stDest, POINT pDestStart, SIZE & szSize) { return stBitmap.ApplyMaskGraphic(pSourceStart,stDest,pDestStart,szSize); }
-	bool ApplyMaskGraphic(POINT pSourceStart, CBitmap & cDest, POINT pDestStart, SIZE & szSize) { return stBitmap.ApplyMaskGraphic(pSourceStart,*cDest,pDestStart,szSize); }
-	bool ApplyMaskGraphic(CBitmap & cDest, const POINT pDestStart = { 0,0 }) { return stBitmap.ApplyMaskGraphic({ 0,0} ,*cDest,pDestStart,stBitmap.GetSize()); }
-
-	bool ApplyMaskGraphic(RawBitmap_t & stSource, RawBitmap_t & stBackground,RawBitmap_t & stDest) { return stBitmap.ApplyMaskGraphic(stSource,stBackground,stDest); }
-	bool ApplyMaskGraphic(CBitmap & cSource,CBitmap & cBackground,CBitmap & cDest) { return stBitmap.ApplyMaskGraphic(*cSource,*cBackground,*cDest); }
-
-
-	bool ApplyMaskGraphicR(const POINT pSourceStart, RawBitmap_t & stDest,const POINT pDestStart,const SIZE & szSize) { return stBitmap.ApplyMaskGraphicR(pSourceStart,stDest,pDestStart,szSize); }
-	bool ApplyMaskGraphicR(const POINT pSourceStart, CBitmap & cDest,const POINT pDestStart, const SIZE & szSize) { return stBitmap.ApplyMaskGraphicR(pSourceStart,*cDest,pDestStart,szSize); }
-	bool ApplyMaskGraphicR(CBitmap & cDest, const POINT pDestStart) { return stBitmap.ApplyMaskGraphicR({ 0,0} ,*cDest,pDestStart,stBitmap.GetSize()); }
-	bool ApplyMaskColor(RGBColor_t rgbColor	,RawBitmap_t stMask,POINT pMaskStart, POINT pDestStart, SIZE szSize) { return stBitmap.ApplyMaskColor(rgbColor,stMask,pMaskStart,pDestStart,szSize);	}
-	bool ApplyMaskColorR(RGBColor_t rgbColor,RawBitmap_t stMask,POINT pMaskStart,POINT pDestStart, SIZE szSize) { return stBitmap.ApplyMaskColorR(rgbColor,stMask,pMaskStart,pDestStart,szSize);	}
-	bool ApplyMaskColor(RGBColor_t rgbColor	,RawBitmap_t stMask,POINT pDestStart) { return stBitmap.ApplyMaskColor(rgbColor,stMask,pDestStart); }
-	bool ApplyMaskColorR(RGBColor_t rgbColor,RawBitmap_t stMask,POINT pDestStart) { return stBitmap.ApplyMaskColorR(rgbColor,stMask,pDestStart); }
-
-	bool ApplyMaskColor(RGBColor_t	 rgbColor,	CBitmap & cMask,POINT pMaskStart,	POINT pDestStart, SIZE szSize = { 0,0 }) { return stBitmap.ApplyMaskColor(rgbColor,*cMask,pMaskStart,pDestStart,szSize);	}
-	bool ApplyMaskColorR(RGBColor_t	 rgbColor,	CBitmap & cMask,POINT pMaskStart,	POINT pDestStart, SIZE szSize = { 0,0 }) { return stBitmap.ApplyMaskColorR(rgbColor,*cMask,pMaskStart,pDestStart,szSize);	}
-	bool ApplyMaskColor(RGBColor_t	 rgbColor,	CBitmap & cMask,POINT pDestStart = { 0,0 }) { return stBitmap.ApplyMaskColor(rgbColor,*cMask,pDestStart); }
-	bool ApplyMaskColorR(RGBColor_t  rgbColor,	CBitmap & cMask,POINT pDestStart = { 0,0 }) { return stBitmap.ApplyMaskColorR(rgbColor,*cMask,pDestStart); }
+	bool ApplyMaskGraphic(POINT pSourceStart, RawBitmap_t & stDest, POINT pDestStart, SIZE & szSize) { return CBlendKernels::ApplyMaskGraphic(stBitmap,pSourceStart,stDest,pDestStart,szSize); }
+	bool ApplyMaskGraphic(POINT pSourceStart, CBitmap & cDest, POINT pDestStart, SIZE & szSize) { return CBlendKernels::ApplyMaskGraphic(stBitmap,pSourceStart,*cDest,pDestStart,szSize); }
+	bool ApplyMaskGraphic(CBitmap & cDest, const POINT pDestStart = { 0,0 }) { return CBlendKernels::ApplyMaskGraphic(stBitmap,{ 0,0 },*cDest,pDestStart); }
+
+	bool ApplyMaskGraphic(RawBitmap_t & stSource, RawBitmap_t & stBackground,RawBitmap_t & stDest) { return CBlendKernels::ApplyMaskGraphic(stSource,stBackground,stDest,stBitmap); }
+	bool ApplyMaskGraphic(CBitmap & cSource,CBitmap & cBackground,CBitmap & cDest) { return CBlendKernels::ApplyMaskGraphic(*cSource,*cBackground,*cDest,stBitmap); }
+
+
+	bool ApplyMaskGraphicR(const POINT pSourceStart, RawBitmap_t & stDest,const POINT pDestStart,const SIZE & szSize) { return CBlendKernels::ApplyMaskGraphicR(stBitmap,pSourceStart,stDest,pDestStart,szSize); }
+	bool ApplyMaskGraphicR(const POINT pSourceStart, CBitmap & cDest,const POINT pDestStart, const SIZE & szSize) { return CBlendKernels::ApplyMaskGraphicR(stBitmap,pSourceStart,*cDest,pDestStart,szSize); }
+	bool ApplyMaskGraphicR(CBitmap & cDest, const POINT pDestStart) { return CBlendKernels::ApplyMaskGraphicR(stBitmap,{ 0,0 },*cDest,pDestStart); }
+	bool ApplyMaskColor(RGBColor_t rgbColor	,RawBitmap_t stMask,POINT pMaskStart, POINT pDestStart, SIZE szSize) { return CBlendKernels::ApplyMaskColor(rgbColor,stMask,pMaskStart,stBitmap,pDestStart,szSize);	}
+	bool ApplyMaskColorR(RGBColor_t rgbColor,RawBitmap_t stMask,POINT pMaskStart,POINT pDestStart, SIZE szSize) { return CBlendKernels::ApplyMaskColorR(rgbColor,stMask,pMaskStart,stBitmap,pDestStart,szSize);	}
+	bool ApplyMaskColor(RGBColor_t rgbColor	,RawBitmap_t stMask,POINT pDestStart) { return CBlendKernels::ApplyMaskColor(rgbColor,stMask,{ 0,0 },stBitmap,pDestStart); }
+	bool ApplyMaskColorR(RGBColor_t rgbColor,RawBitmap_t stMask,POINT pDestStart) { return CBlendKernels::ApplyMaskColorR(rgbColor,stMask,{ 0,0 },stBitmap,pDestStart); }
+
+	bool ApplyMaskColor(RGBColor_t	 rgbColor,	CBitmap & cMask,POINT pMaskStart,	POINT pDestStart, SIZE szSize = { 0,0 }) { return CBlendKernels::ApplyMaskColor(rgbColor,*cMask,pMaskStart,stBitmap,pDestStart,szSize);	}
+	bool ApplyMaskColorR(RGBColor_t	 rgbColor,	CBitmap & cMask,POINT pMaskStart,	POINT pDestStart, SIZE szSize = { 0,0 }) { return CBlendKernels::ApplyMaskColorR(rgbColor,*cMask,pMaskStart,stBitmap,pDestStart,szSize);	}
+	bool ApplyMaskColor(RGBColor_t	 rgbColor,	CBitmap & cMask,POINT pDestStart = { 0,0 }) { return CBlendKernels::ApplyMaskColor(rgbColor,*cMask,{ 0,0 },stBitmap,pDestStart); }
+	bool ApplyMaskColorR(RGBColor_t  rgbColor,	CBitmap & cMask,POINT pDestStart = { 0,0 }) { return CBlendKernels::ApplyMaskColorR(rgbColor,*cMask,{ 0,0 },stBitmap,pDestStart); }
 
 
 	bool CopyFrom(RawBitmap_t & stSource, POINT pDestStart = {0,0} , POINT pSourceStart = { 0,0 }, SIZE szSize = {0,0}) { return stBitmap.CopyFrom(stSource,pDestStart,pSourceStart,szSize); }		
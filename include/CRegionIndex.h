@@ -0,0 +1,249 @@
+// This file copyright(c) 2021 Rob Nelson, All Rights Reserved.    E-mail rob@projectsagebox.com for more information.
+//
+
+#pragma once
+#if !defined(_CRegionIndex_H_)
+#define _CRegionIndex_H_
+
+#include <vector>
+#include <unordered_map>
+#include <cstdint>
+
+namespace Sage
+{
+
+// CRegionIndex -- Spatial index for topmost-rectangle hit testing
+//
+// This is used by MouseRegion to find the highlighted/clicked point or region without walking the entire display list on every
+// mouse move.  It can be used for any set of overlapping rectangles with a display (z) order.
+//
+// Items are integer rectangles { x, y, width, height } identified by an index (0-based, i.e. the MouseRegion index).  The index
+// is a sparse uniform grid: each item is listed in every cell it overlaps, so a hit test only looks at the items in one cell.
+// Cells are hashed, so items may be anywhere (including negative or very large coordinates) without sizing the grid first.
+//
+// Display order is kept as a stamp per item -- the item with the highest stamp is the topmost.  Raise() brings an item to the top
+// in O(1), so the index never has to be rebuilt when the display order changes.
+//
+// Items that would cover more than kMaxItemCells cells (i.e. large background regions) are kept in a separate list that is checked
+// on every hit test, so that one large item doesn't fill hundreds of cells.
+//
+// Hit testing matches MouseRegion's test exactly: x >= iX && x < iX + iWidth (and the same for y), so items with a 0 width or
+// height are never hit.
+//
+// Notes:
+//
+//      1. Update() with the same rectangle is a fast no-op, so callers can call it whenever an item may have moved.
+//      2. The cell size should be around the size of the typical item (i.e. the default 64 works well for points from 4x4 up to 100x100)
+//      3. This class is not thread-safe -- it is meant to be owned and used by one window/MouseRegion.
+//
+class CRegionIndex
+{
+public:
+    static constexpr int kDefaultCellSize   = 64;
+    static constexpr int kMaxItemCells      = 64;
+
+    struct Stats_t
+    {
+        int iItems;             // Number of items in the index
+        int iLargeItems;        // Items too large for the grid (always checked)
+        int iCells;             // Number of non-empty grid cells
+        int iMaxCellItems;      // Most items listed in one cell
+    };
+
+private:
+    struct Item_t
+    {
+        int iX, iY, iWidth, iHeight;            // Hit rectangle
+        int iCellX0, iCellY0, iCellX1, iCellY1; // Cell range (inclusive), when not bLarge
+        uint64_t uOrder;                        // Display order stamp (higher is on top)
+        bool bActive;
+        bool bLarge;
+    };
+
+    int m_iCellSize     = kDefaultCellSize;
+    int m_iCellShift    = 6;                    // Cell size is a power of 2, so cells are found with a shift (and work with negative values)
+    uint64_t m_uOrder   = 0;
+
+    std::vector<Item_t> m_vItems;
+    std::vector<int> m_vLarge;
+    std::unordered_map<uint64_t,std::vector<int>> m_mCells;
+
+    static inline uint64_t CellKey(int iCellX,int iCellY) { return ((uint64_t) (uint32_t) iCellX << 32) | (uint32_t) iCellY; }
+
+    inline int CellCoord(int iValue) const { return iValue >> m_iCellShift; }       // Arithmetic shift, i.e. floor() for negative values
+
+    static inline bool Contains(const Item_t & stItem,int iX,int iY)
+    {
+        return iX >= stItem.iX && iX < stItem.iX + stItem.iWidth && iY >= stItem.iY && iY < stItem.iY + stItem.iHeight;
+    }
+
+    static void RemoveValue(std::vector<int> & vList,int iValue)
+    {
+        for (auto & iEntry : vList)
+            if (iEntry == iValue) { iEntry = vList.back(); vList.pop_back(); return; }
+    }
+
+    void Link(int iIndex)
+    {
+        auto & stItem = m_vItems[iIndex];
+
+        stItem.iCellX0 = CellCoord(stItem.iX);
+        stItem.iCellY0 = CellCoord(stItem.iY);
+        stItem.iCellX1 = CellCoord(stItem.iX + (stItem.iWidth > 0 ? stItem.iWidth-1 : 0));
+        stItem.iCellY1 = CellCoord(stItem.iY + (stItem.iHeight > 0 ? stItem.iHeight-1 : 0));
+
+        int64_t iCells = (int64_t) (stItem.iCellX1 - stItem.iCellX0 + 1)*(stItem.iCellY1 - stItem.iCellY0 + 1);
+        stItem.bLarge = iCells > kMaxItemCells;
+
+        if (stItem.bLarge) { m_vLarge.push_back(iIndex); return; }
+
+        for (int y=stItem.iCellY0;y<=stItem.iCellY1;y++)
+            for (int x=stItem.iCellX0;x<=stItem.iCellX1;x++)
+                m_mCells[CellKey(x,y)].push_back(iIndex);
+    }
+
+    void Unlink(int iIndex)
+    {
+        auto & stItem = m_vItems[iIndex];
+        if (stItem.bLarge) { RemoveValue(m_vLarge,iIndex); return; }
+
+        for (int y=stItem.iCellY0;y<=stItem.iCellY1;y++)
+            for (int x=stItem.iCellX0;x<=stItem.iCellX1;x++)
+            {
+                auto it = m_mCells.find(CellKey(x,y));
+                if (it == m_mCells.end()) continue;
+                RemoveValue(it->second,iIndex);
+                if (it->second.empty()) m_mCells.erase(it);
+            }
+    }
+
+public:
+    CRegionIndex(int iCellSize = kDefaultCellSize) { SetCellSize(iCellSize); }
+
+    /// <summary>
+    /// Sets the grid cell size in pixels (rounded up to a power of 2, minimum 4).  Existing items are re-indexed.
+    /// </summary>
+    void SetCellSize(int iCellSize)
+    {
+        int iShift = 2;
+        while ((1 << iShift) < iCellSize && iShift < 24) iShift++;
+        if (m_iCellShift == iShift && m_iCellSize == (1 << iShift)) return;
+
+        for (int i=0;i<(int) m_vItems.size();i++) if (m_vItems[i].bActive) Unlink(i);
+        m_iCellShift    = iShift;
+        m_iCellSize     = 1 << iShift;
+        for (int i=0;i<(int) m_vItems.size();i++) if (m_vItems[i].bActive) Link(i);
+    }
+
+    int GetCellSize() const { return m_iCellSize; }
+
+    /// <summary>
+    /// Removes all items.
+    /// </summary>
+    void Clear()
+    {
+        m_vItems.clear();
+        m_vLarge.clear();
+        m_mCells.clear();
+        m_uOrder = 0;
+    }
+
+    /// <summary>
+    /// Adds or moves an item, leaving its display order unchanged (new items are placed on top).
+    /// <para></para>
+    /// --> This is a fast no-op when the rectangle has not changed.
+    /// </summary>
+    /// <param name="iIndex"> - Item index (0-based).  The index grows as needed.</param>
+    /// <returns>false if iIndex is negative</returns>
+    bool Update(int iIndex,int iX,int iY,int iWidth,int iHeight)
+    {
+        if (iIndex < 0) return false;
+        if (iIndex >= (int) m_vItems.size()) m_vItems.resize(iIndex+1,Item_t{});
+
+        auto & stItem = m_vItems[iIndex];
+        if (stItem.bActive)
+        {
+            if (stItem.iX == iX && stItem.iY == iY && stItem.iWidth == iWidth && stItem.iHeight == iHeight) return true;
+
+            // Same cell range -- only the rectangle changes (the common case when dragging a point by a few pixels)
+
+            int iCellX0 = CellCoord(iX), iCellY0 = CellCoord(iY);
+            int iCellX1 = CellCoord(iX + (iWidth > 0 ? iWidth-1 : 0));
+            int iCellY1 = CellCoord(iY + (iHeight > 0 ? iHeight-1 : 0));
+
+            if (!stItem.bLarge && iCellX0 == stItem.iCellX0 && iCellY0 == stItem.iCellY0 && iCellX1 == stItem.iCellX1 && iCellY1 == stItem.iCellY1)
+            {
+                stItem.iX = iX; stItem.iY = iY; stItem.iWidth = iWidth; stItem.iHeight = iHeight;
+                return true;
+            }
+            Unlink(iIndex);
+        }
+        else
+        {
+            stItem.bActive  = true;
+            stItem.uOrder   = ++m_uOrder;
+        }
+
+        stItem.iX = iX; stItem.iY = iY; stItem.iWidth = iWidth; stItem.iHeight = iHeight;
+        Link(iIndex);
+        return true;
+    }
+
+    /// <summary>
+    /// Removes an item from the index.
+    /// </summary>
+    bool Remove(int iIndex)
+    {
+        if (iIndex < 0 || iIndex >= (int) m_vItems.size() || !m_vItems[iIndex].bActive) return false;
+        Unlink(iIndex);
+        m_vItems[iIndex].bActive = false;
+        return true;
+    }
+
+    /// <summary>
+    /// Brings an item to the top of the display order.
+    /// </summary>
+    bool Raise(int iIndex)
+    {
+        if (iIndex < 0 || iIndex >= (int) m_vItems.size() || !m_vItems[iIndex].bActive) return false;
+        m_vItems[iIndex].uOrder = ++m_uOrder;
+        return true;
+    }
+
+    /// <summary>
+    /// Returns the index of the topmost item containing (iX,iY), or -1 if there is no item at that point.
+    /// </summary>
+    int HitTest(int iX,int iY) const
+    {
+        int iFound      = -1;
+        uint64_t uTop   = 0;
+
+        auto it = m_mCells.find(CellKey(CellCoord(iX),CellCoord(iY)));
+        if (it != m_mCells.end())
+            for (int iIndex : it->second)
+            {
+                auto & stItem = m_vItems[iIndex];
+                if (stItem.uOrder > uTop && Contains(stItem,iX,iY)) { iFound = iIndex; uTop = stItem.uOrder; }
+            }
+
+        for (int iIndex : m_vLarge)
+        {
+            auto & stItem = m_vItems[iIndex];
+            if (stItem.uOrder > uTop && Contains(stItem,iX,iY)) { iFound = iIndex; uTop = stItem.uOrder; }
+        }
+        return iFound;
+    }
+
+    Stats_t GetStats() const
+    {
+        Stats_t stStats{};
+        for (auto & stItem : m_vItems) if (stItem.bActive) stStats.iItems++;
+        stStats.iLargeItems = (int) m_vLarge.size();
+        stStats.iCells      = (int) m_mCells.size();
+        for (auto & it : m_mCells) if ((int) it.second.size() > stStats.iMaxCellItems) stStats.iMaxCellItems = (int) it.second.size();
+        return stStats;
+    }
+};
+
+} // namespace Sage
+#endif // _CRegionIndex_H_
@@ -0,0 +1,294 @@
+// This file copyright(c) 2021 Rob Nelson, All Rights Reserved.    E-mail rob@projectsagebox.com for more information.
+//
+
+#pragma once
+#if !defined(_CSageBlur_H_)
+#define _CSageBlur_H_
+
+#include "Sage.h"
+#include "CRawBitmap.h"
+#include "CThreadPool.h"
+#include "SimdClass.h"
+#include <cmath>
+#include <vector>
+#include <mutex>
+
+namespace Sage
+{
+
+// CSageBlur -- Constant-time (any radius) Gaussian blur approximation for 24-bit bitmaps
+//
+// This is the engine behind CSageTools::GaussianBlurStd() with BlurMode::Box.  The Gaussian is approximated by N successive
+// box blurs (3 by default), with box widths chosen so the combined variance matches the Gaussian (see GetBoxSizes()).  Each
+// box blur is a running sum, so the cost per pixel is the same for a radius of 2 or 200 -- large-radius blurs (i.e. glass or
+// drop-shadow effects) can be done in real-time.
+//
+//      1. Horizontal passes are done a row at a time, on { B, G, R } lanes of the interleaved row, all N passes in a float row
+//         buffer before rounding back to the bitmap.
+//      2. Vertical passes are done on strips of kStripBytes columns, all N passes in a float strip buffer.
+//      3. Rows (horizontal) and strips (vertical) are split across the CThreadPool threads.
+//      4. Edges are clamped (i.e. the edge pixel is repeated), so edges don't darken.
+//
+// Notes:
+//
+//      1. The input and output bitmaps may be the same bitmap (in-place blur).
+//      2. Steady-state calls allocate nothing -- scratch buffers are kept by the CSageBlur object, and the output must already
+//         exist (or, for the CBitmap version, it's only created when its size changes).
+//      3. 3 passes is within a few percent of a true Gaussian; more passes are closer, at the cost of time.  Box widths are
+//         odd integers, so very small radii (under about 2) are only a rough match -- use BlurMode::Exact for those.
+//      4. Blur() calls on one CSageBlur object are serialized, since the scratch buffers belong to the object.
+//
+class CSageBlur
+{
+public:
+    enum class BlurMode
+    {
+        Exact,          // The original GaussianBlurStd() (cost grows with the radius)
+        Box,            // N-pass box approximation (cost does not depend on the radius)
+    };
+
+    static constexpr int kDefaultPasses = 3;
+    static constexpr int kMaxPasses     = 8;
+    static constexpr int kRowsPerTask   = 16;
+    static constexpr int kStripBytes    = 64;
+
+private:
+    std::mutex m_mBlur;
+    std::vector<std::vector<float>> m_vScratch;        // One per pool thread
+    CThreadPool & m_cPool;
+
+    struct Job_t
+    {
+        RawBitmap_t * pDest;
+        const RawBitmap_t * pSource;
+        int iRadius[kMaxPasses];
+        int iPasses;
+        int iMaxRadius;
+        std::vector<float> * pScratch;
+    };
+
+    // Rounds iCount floats (plus 0.5) to unsigned char with saturation, 16 at a time with SSE2
+
+    static void StoreRow(const float * fIn,unsigned char * sOut,int iCount)
+    {
+        auto vHalf = Simd128::Vecf(0.5f);
+        int x = 0;
+        for (;x<(iCount & ~15);x += 16)
+        {
+            auto v0 = Simd128::Packs_epi32(Simd128::CvttInt(Simd128::Add(Simd128::LoadU(fIn+x),vHalf)),  Simd128::CvttInt(Simd128::Add(Simd128::LoadU(fIn+x+4),vHalf)));
+            auto v1 = Simd128::Packs_epi32(Simd128::CvttInt(Simd128::Add(Simd128::LoadU(fIn+x+8),vHalf)),Simd128::CvttInt(Simd128::Add(Simd128::LoadU(fIn+x+12),vHalf)));
+            _mm_storeu_si128((__m128i *) (sOut+x),Simd128::Packus_epi16(v0,v1));
+        }
+        for (;x<iCount;x++)
+        {
+            float fValue = fIn[x] + 0.5f;
+            sOut[x] = fValue <= 0.0f ? 0 : fValue >= 255.0f ? 255 : (unsigned char) fValue;
+        }
+    }
+
+    // One horizontal box pass on a padded float row.  fIn points to the first pixel; iRadius pixels before and after it are
+    // filled here with the edge pixels.  Each pixel is one 4-lane vector { B, G, R, (next) }, so buffers have 1 float of slack.
+
+    static void BoxRow(float * fIn,float * fOut,int iWidth,int iRadius)
+    {
+        for (int i=1;i<=iRadius;i++)
+        {
+            for (int c=0;c<3;c++) fIn[-i*3+c] = fIn[c], fIn[(iWidth-1+i)*3+c] = fIn[(iWidth-1)*3+c];
+        }
+
+        const float * fLeft = fIn - iRadius*3;
+        auto vSum = Simd128::Vecf(0.0f);
+        for (int i=0;i<2*iRadius+1;i++) vSum = Simd128::Add(vSum,Simd128::LoadU(fLeft + i*3));
+
+        auto vScale = Simd128::Vecf(1.0f/(float) (2*iRadius+1));
+        const float * fRight = fLeft + (2*iRadius+1)*3;
+
+        for (int x=0;x<iWidth;x++)
+        {
+            Simd128::StoreU(fOut + x*3,Simd128::Mul(vSum,vScale));
+            vSum = Simd128::Add(vSum,Simd128::Sub(Simd128::LoadU(fRight + x*3),Simd128::LoadU(fLeft + x*3)));
+        }
+    }
+
+    // One vertical box pass on a padded strip of kStripBytes floats per row (same layout as BoxRow(), with rows instead of pixels)
+
+    static void BoxStrip(float * fIn,float * fOut,int iHeight,int iRadius)
+    {
+        constexpr int S = kStripBytes;
+        for (int i=1;i<=iRadius;i++)
+        {
+            memcpy(fIn - i*S,fIn,S*sizeof(float));
+            memcpy(fIn + (iHeight-1+i)*S,fIn + (iHeight-1)*S,S*sizeof(float));
+        }
+
+        const float * fTop = fIn - iRadius*S;
+        const float * fBottom = fTop + (2*iRadius+1)*S;
+        auto vScale = Simd128::Vecf(1.0f/(float) (2*iRadius+1));
+
+        for (int v=0;v<S;v += 4)
+        {
+            auto vSum = Simd128::Vecf(0.0f);
+            for (int i=0;i<2*iRadius+1;i++) vSum = Simd128::Add(vSum,Simd128::LoadU(fTop + i*S + v));
+
+            for (int y=0;y<iHeight;y++)
+            {
+                Simd128::StoreU(fOut + y*S + v,Simd128::Mul(vSum,vScale));
+                vSum = Simd128::Add(vSum,Simd128::Sub(Simd128::LoadU(fBottom + y*S + v),Simd128::LoadU(fTop + y*S + v)));
+            }
+        }
+    }
+
+    static void BlurRows(const Job_t & stJob,int iTask,float * fScratch)
+    {
+        const int iWidth    = stJob.pSource->iWidth;
+        const int iPad      = stJob.iMaxRadius*3;
+        const int iRowSize  = iWidth*3 + 2*iPad + 4;
+
+        float * fBuf[2] = { fScratch + iPad, fScratch + iRowSize + iPad };
+
+        int iLast = (iTask+1)*kRowsPerTask < stJob.pSource->iHeight ? (iTask+1)*kRowsPerTask : stJob.pSource->iHeight;
+        for (int y=iTask*kRowsPerTask;y<iLast;y++)
+        {
+            const unsigned char * sIn = stJob.pSource->stMem + (size_t) y*stJob.pSource->iWidthBytes;
+            for (int x=0;x<iWidth*3;x++) fBuf[0][x] = (float) sIn[x];
+
+            for (int i=0;i<stJob.iPasses;i++) BoxRow(fBuf[i & 1],fBuf[(i+1) & 1],iWidth,stJob.iRadius[i]);
+
+            StoreRow(fBuf[stJob.iPasses & 1],stJob.pDest->stMem + (size_t) y*stJob.pDest->iWidthBytes,iWidth*3);
+        }
+    }
+
+    static void BlurStrip(const Job_t & stJob,int iTask,float * fScratch)
+    {
+        constexpr int S = kStripBytes;
+        auto & stDest       = *stJob.pDest;
+        const int iHeight   = stDest.iHeight;
+        const int iPad      = stJob.iMaxRadius*S;
+        const size_t iSize  = (size_t) (iHeight + 2*stJob.iMaxRadius + 1)*S;      // +1: the last running-sum update reads one row past the pad
+
+        float * fBuf[2] = { fScratch + iPad, fScratch + iSize + iPad };
+
+        // The last strip may be narrower -- it's processed at full width, with the extra columns ignored
+
+        int iX      = iTask*S;
+        int iBytes  = stDest.iWidth*3 - iX < S ? stDest.iWidth*3 - iX : S;
+
+        for (int y=0;y<iHeight;y++)
+        {
+            const unsigned char * sIn = stDest.stMem + (size_t) y*stDest.iWidthBytes + iX;
+            float * fRow = fBuf[0] + (size_t) y*S;
+            for (int x=0;x<iBytes;x++) fRow[x] = (float) sIn[x];
+            for (int x=iBytes;x<S;x++) fRow[x] = 0;
+        }
+
+        for (int i=0;i<stJob.iPasses;i++) BoxStrip(fBuf[i & 1],fBuf[(i+1) & 1],iHeight,stJob.iRadius[i]);
+
+        const float * fOut = fBuf[stJob.iPasses & 1];
+        for (int y=0;y<iHeight;y++) StoreRow(fOut + (size_t) y*S,stDest.stMem + (size_t) y*stDest.iWidthBytes + iX,iBytes);
+    }
+
+public:
+    CSageBlur(CThreadPool & cPool = CThreadPool::GetDefault()) : m_cPool(cPool) { }
+
+    /// <summary>
+    /// Computes the box radii whose iPasses successive box blurs approximate a Gaussian with standard deviation fSigma.
+    /// <para></para>
+    /// This uses the "boxes for Gauss" method: all boxes are the same width (or the next odd width up), with the number of
+    /// each chosen so the total variance matches fSigma^2 as closely as possible.
+    /// </summary>
+    /// <param name="iRadius"> - Filled with iPasses box radii (box width is 2*radius+1)</param>
+    static void GetBoxSizes(double fSigma,int iPasses,int * iRadius)
+    {
+        double fIdeal = std::sqrt(12.0*fSigma*fSigma/iPasses + 1.0);
+        int iLower = (int) std::floor(fIdeal);
+        if (!(iLower & 1)) iLower--;
+        if (iLower < 1) iLower = 1;
+        int iUpper = iLower + 2;
+
+        double fM = (12.0*fSigma*fSigma - iPasses*iLower*iLower - 4.0*iPasses*iLower - 3.0*iPasses)/(-4.0*iLower - 4.0);
+        int iM = (int) std::lround(fM);
+
+        for (int i=0;i<iPasses;i++) iRadius[i] = ((i < iM ? iLower : iUpper) - 1)/2;
+    }
+
+    /// <summary>
+    /// Blurs stSource into stDest (which may be the same bitmap) with an iPasses box-blur approximation of a Gaussian.
+    /// </summary>
+    /// <param name="stSource"> - Source bitmap</param>
+    /// <param name="stDest"> - Destination bitmap.  Must be the same size as stSource (or the same bitmap).</param>
+    /// <param name="fRadius"> - Blur radius (the Gaussian's standard deviation).  Values under 0.5 copy the bitmap unchanged.</param>
+    /// <param name="iPasses"> - [optional] Number of box passes (1-8).  Default is 3.</param>
+    /// <param name="iMaxThreads"> - [optional] Maximum threads to use.  0 (default) = all threads in the pool.</param>
+    /// <returns>true if ok, false if the bitmaps are empty or not the same size.</returns>
+    bool Blur(const RawBitmap_t & stSource,RawBitmap_t & stDest,double fRadius,int iPasses = kDefaultPasses,int iMaxThreads = 0)
+    {
+        if (!stSource.stMem || !stDest.stMem || stSource.iWidth <= 0 || stSource.iHeight <= 0) return false;
+        if (stSource.iWidth != stDest.iWidth || stSource.iHeight != stDest.iHeight) return false;
+
+        if (iPasses < 1) iPasses = 1;
+        if (iPasses > kMaxPasses) iPasses = kMaxPasses;
+
+        Job_t stJob{ &stDest, &stSource };
+        stJob.iPasses = iPasses;
+        GetBoxSizes(fRadius < 0.5 ? 0.0 : fRadius,iPasses,stJob.iRadius);
+
+        stJob.iMaxRadius = 0;
+        for (int i=0;i<iPasses;i++) if (stJob.iRadius[i] > stJob.iMaxRadius) stJob.iMaxRadius = stJob.iRadius[i];
+
+        if (!stJob.iMaxRadius)
+        {
+            if (stSource.stMem != stDest.stMem)
+                for (int y=0;y<stDest.iHeight;y++) memcpy(stDest.stMem + (size_t) y*stDest.iWidthBytes,stSource.stMem + (size_t) y*stSource.iWidthBytes,stDest.iWidth*3);
+            return true;
+        }
+
+        std::lock_guard<std::mutex> lock(m_mBlur);
+
+        // Scratch is two padded float rows (horizontal), or two padded strips (vertical) -- whichever is larger
+
+        size_t iRowScratch      = 2*((size_t) stSource.iWidth*3 + 2*stJob.iMaxRadius*3 + 4);
+        size_t iStripScratch    = 2*((size_t) (stSource.iHeight + 2*stJob.iMaxRadius + 1)*kStripBytes);
+        size_t iScratch         = iRowScratch > iStripScratch ? iRowScratch : iStripScratch;
+
+        if ((int) m_vScratch.size() < m_cPool.GetThreads()) m_vScratch.resize(m_cPool.GetThreads());
+        for (auto & vScratch : m_vScratch) if (vScratch.size() < iScratch) vScratch.resize(iScratch);
+        stJob.pScratch = m_vScratch.data();
+
+        // Horizontal passes (source -> dest), then vertical passes (dest -> dest)
+
+        m_cPool.ParallelFor((stSource.iHeight + kRowsPerTask-1)/kRowsPerTask,[pJob = &stJob](int iTask,int iThread)
+            { BlurRows(*pJob,iTask,pJob->pScratch[iThread].data()); },iMaxThreads);
+
+        m_cPool.ParallelFor((stDest.iWidth*3 + kStripBytes-1)/kStripBytes,[pJob = &stJob](int iTask,int iThread)
+            { BlurStrip(*pJob,iTask,pJob->pScratch[iThread].data()); },iMaxThreads);
+
+        return true;
+    }
+
+    /// <summary>
+    /// Blurs cInput into cOutput.  cOutput is only (re)created when it is not already the size of cInput, so calling this every frame with
+    /// the same cOutput does not allocate memory.  cInput and cOutput may be the same bitmap.
+    /// </summary>
+    bool Blur(CBitmap & cInput,CBitmap & cOutput,double fRadius,int iPasses = kDefaultPasses,int iMaxThreads = 0)
+    {
+        if (!cInput.stBitmap.stMem) return false;
+        if (&cInput != &cOutput && (cOutput.stBitmap.iWidth != cInput.stBitmap.iWidth || cOutput.stBitmap.iHeight != cInput.stBitmap.iHeight || !cOutput.stBitmap.stMem))
+        {
+            cOutput.Delete();
+            if (!cOutput.CreateBitmap(cInput.stBitmap.iWidth,cInput.stBitmap.iHeight)) return false;
+        }
+        return Blur(cInput.stBitmap,cOutput.stBitmap,fRadius,iPasses,iMaxThreads);
+    }
+
+    /// <summary>
+    /// Returns the process-wide CSageBlur object used by CSageTools, using CThreadPool::GetDefault().
+    /// </summary>
+    static CSageBlur & GetDefault()
+    {
+        static CSageBlur cBlur;
+        return cBlur;
+    }
+};
+
+} // namespace Sage
+#endif // _CSageBlur_H_
@@ -0,0 +1,423 @@
+// This file copyright(c) 2021 Rob Nelson, All Rights Reserved.    E-mail rob@projectsagebox.com for more information.
+//
+
+#pragma once
+#if !defined(_CSageProfile_H_)
+#define _CSageProfile_H_
+
+#include <Windows.h>
+#include <atomic>
+#include <mutex>
+#include <vector>
+#include <string>
+#include <algorithm>
+#include <cstdio>
+#include <cstdint>
+#include <cstring>
+#include <cmath>
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+namespace Sage
+{
+
+// CSageProfile -- Named profiling scopes with per-scope histograms (min/max/mean/p50/p99)
+//
+// Put SageProfileScope("name") at the top of a block to time it, i.e. to find which draw calls or Update() cycles take the
+// frame time:
+//
+//      {
+//          SageProfileScope("Frame Draw");
+//          DrawEverything(cWin);
+//      }
+//      {
+//          SageProfileScope("Update");
+//          cWin.Update();
+//      }
+//      ...
+//      CSageProfile::WriteCSV("profile.csv");           // or WriteJSON(), GetReport(), PrintReport()
+//
+// Each scope keeps a count, min, max and total, plus a log-linear (HDR-style) histogram of times: 64 exact buckets, then 32
+// buckets per power of 2, so percentiles are within about 3% for any time from one timer tick to hours.
+//
+// Times are accumulated per thread (no locks or atomic read-modify-write in the scope itself), and merged when a report
+// is requested.  Data from threads that have exited is kept.
+//
+// Notes:
+//
+//      1. Scope names must be string literals (or otherwise live as long as the program) -- only the pointer is kept per
+//         call site, and names are registered once.
+//      2. Scopes can nest; each scope's time includes the scopes inside it.
+//      3. SetEnabled(false) turns timing off at run time.  Defining SAGE_PROFILE_DISABLE removes SageProfileScope() entirely.
+//      4. Reset() while other threads are timing may miss a few events from those threads.
+//
+class CSageProfile
+{
+public:
+    static constexpr int kMaxScopes     = 1024;
+    static constexpr int kSubBits       = 5;                        // 32 buckets per power of 2
+    static constexpr int kMaxShift      = 36;                       // Times up to 2^42 ticks are kept exactly (longer times go in the last bucket)
+    static constexpr int kBuckets       = (kMaxShift + 2) << kSubBits;
+
+    struct ScopeReport_t
+    {
+        std::string sName;
+        uint64_t iCount;
+        double fTotalMs;
+        double fMinUs;
+        double fMeanUs;
+        double fP50Us;
+        double fP99Us;
+        double fMaxUs;
+    };
+
+private:
+    // One thread's data for one scope.  Only the owning thread writes; reports read with relaxed loads.
+
+    struct ScopeData_t
+    {
+        std::atomic<uint64_t> iCount{0};
+        std::atomic<uint64_t> iTotal{0};
+        std::atomic<uint64_t> iMin{UINT64_MAX};
+        std::atomic<uint64_t> iMax{0};
+        std::atomic<uint64_t> iBuckets[kBuckets] = {};
+
+        static __forceinline void Add(std::atomic<uint64_t> & iValue,uint64_t iAdd) { iValue.store(iValue.load(std::memory_order_relaxed) + iAdd,std::memory_order_relaxed); }
+
+        __forceinline void Record(uint64_t iTicks)
+        {
+            Add(iCount,1);
+            Add(iTotal,iTicks);
+            if (iTicks < iMin.load(std::memory_order_relaxed)) iMin.store(iTicks,std::memory_order_relaxed);
+            if (iTicks > iMax.load(std::memory_order_relaxed)) iMax.store(iTicks,std::memory_order_relaxed);
+            Add(iBuckets[GetBucket(iTicks)],1);
+        }
+    };
+
+    // Merged (plain) totals for one scope
+
+    struct Totals_t
+    {
+        uint64_t iCount = 0;
+        uint64_t iTotal = 0;
+        uint64_t iMin   = UINT64_MAX;
+        uint64_t iMax   = 0;
+        std::vector<uint64_t> vBuckets;
+
+        void Merge(const ScopeData_t & stData)
+        {
+            uint64_t iDataCount = stData.iCount.load(std::memory_order_relaxed);
+            if (!iDataCount) return;
+            if (vBuckets.empty()) vBuckets.assign(kBuckets,0);
+
+            iCount += iDataCount;
+            iTotal += stData.iTotal.load(std::memory_order_relaxed);
+            iMin    = (std::min)(iMin,stData.iMin.load(std::memory_order_relaxed));
+            iMax    = (std::max)(iMax,stData.iMax.load(std::memory_order_relaxed));
+            for (int i=0;i<kBuckets;i++) vBuckets[i] += stData.iBuckets[i].load(std::memory_order_relaxed);
+        }
+    };
+
+    // Per-thread table of scopes.  Entries are allocated by the owning thread the first time it uses a scope.
+
+    struct ThreadData_t
+    {
+        std::atomic<ScopeData_t *> pScopes[kMaxScopes] = {};
+
+        ThreadData_t()
+        {
+            auto & stGlobal = GetGlobal();
+            std::lock_guard<std::mutex> lock(stGlobal.mLock);
+            stGlobal.vThreads.push_back(this);
+        }
+
+        // On thread exit, fold this thread's data into the retired totals so it still shows up in reports
+
+        ~ThreadData_t()
+        {
+            auto & stGlobal = GetGlobal();
+            std::lock_guard<std::mutex> lock(stGlobal.mLock);
+            stGlobal.vThreads.erase(std::remove(stGlobal.vThreads.begin(),stGlobal.vThreads.end(),this),stGlobal.vThreads.end());
+            for (int i=0;i<kMaxScopes;i++)
+            {
+                auto pData = pScopes[i].load();
+                if (!pData) continue;
+                stGlobal.vRetired[i].Merge(*pData);
+                delete pData;
+            }
+        }
+
+        __forceinline ScopeData_t & GetScope(int iScope)
+        {
+            auto pData = pScopes[iScope].load(std::memory_order_relaxed);
+            if (!pData)
+            {
+                pData = new ScopeData_t;
+                pScopes[iScope].store(pData,std::memory_order_release);
+            }
+            return *pData;
+        }
+    };
+
+    struct Global_t
+    {
+        std::mutex mLock;
+        std::vector<const char *> vNames;
+        std::vector<ThreadData_t *> vThreads;
+        std::vector<Totals_t> vRetired = std::vector<Totals_t>(kMaxScopes);
+        std::atomic<bool> bEnabled{true};
+        double fTicksPerUs;
+
+        Global_t()
+        {
+            LARGE_INTEGER liFreq;
+            QueryPerformanceFrequency(&liFreq);
+            fTicksPerUs = (double) liFreq.QuadPart/1000000.0;
+        }
+    };
+
+    static Global_t & GetGlobal()
+    {
+        static Global_t stGlobal;
+        return stGlobal;
+    }
+
+    static ThreadData_t & GetThreadData()
+    {
+        static thread_local ThreadData_t stThreadData;
+        return stThreadData;
+    }
+
+    static __forceinline int HighBit(uint64_t uValue)
+    {
+#if defined(_MSC_VER)
+        unsigned long ulIndex;
+        _BitScanReverse64(&ulIndex,uValue);
+        return (int) ulIndex;
+#else
+        return 63 - __builtin_clzll(uValue);
+#endif
+    }
+
+    static __forceinline int GetBucket(uint64_t iTicks)
+    {
+        if (iTicks < (2ull << kSubBits)) return (int) iTicks;
+        int iShift = HighBit(iTicks) - kSubBits;
+        if (iShift > kMaxShift) return kBuckets - 1;
+        return (iShift << kSubBits) + (int) (iTicks >> iShift);
+    }
+
+    // Returns the middle of bucket iBucket, in ticks
+
+    static double GetBucketValue(int iBucket)
+    {
+        if (iBucket < (2 << kSubBits)) return (double) iBucket;
+        int iShift = (iBucket >> kSubBits) - 1;
+        uint64_t iLow = (uint64_t) (iBucket - (iShift << kSubBits)) << iShift;
+        return (double) iLow + (double) (1ull << iShift)/2.0;
+    }
+
+    static double GetPercentile(const Totals_t & stTotals,double fPercent)
+    {
+        uint64_t iTarget = (uint64_t) std::ceil(fPercent/100.0*(double) stTotals.iCount);
+        if (iTarget < 1) iTarget = 1;
+
+        uint64_t iSeen = 0;
+        for (int i=0;i<kBuckets;i++)
+        {
+            iSeen += stTotals.vBuckets[i];
+            if (iSeen >= iTarget) return (std::min)((std::max)(GetBucketValue(i),(double) stTotals.iMin),(double) stTotals.iMax);
+        }
+        return (double) stTotals.iMax;
+    }
+
+    static __forceinline uint64_t GetTicks()
+    {
+        LARGE_INTEGER liTime;
+        QueryPerformanceCounter(&liTime);
+        return (uint64_t) liTime.QuadPart;
+    }
+
+public:
+    // Scope -- times from construction to destruction.  Usually used through SageProfileScope().
+
+    class Scope
+    {
+        int m_iScope;
+        uint64_t m_iStart;
+    public:
+        __forceinline Scope(int iScope) : m_iScope(GetGlobal().bEnabled.load(std::memory_order_relaxed) ? iScope : -1)
+        {
+            m_iStart = m_iScope >= 0 ? GetTicks() : 0;
+        }
+        __forceinline ~Scope()
+        {
+            if (m_iScope >= 0) GetThreadData().GetScope(m_iScope).Record(GetTicks() - m_iStart);
+        }
+        Scope(const Scope &) = delete;
+        Scope & operator = (const Scope &) = delete;
+    };
+
+    /// <summary>
+    /// Registers a scope name and returns its index (the same index for the same name).  Returns -1 if kMaxScopes names are
+    /// already registered, in which case the scope is not timed.
+    /// </summary>
+    static int RegisterScope(const char * sName)
+    {
+        auto & stGlobal = GetGlobal();
+        std::lock_guard<std::mutex> lock(stGlobal.mLock);
+        for (int i=0;i<(int) stGlobal.vNames.size();i++) if (!strcmp(stGlobal.vNames[i],sName)) return i;
+        if ((int) stGlobal.vNames.size() >= kMaxScopes) return -1;
+        stGlobal.vNames.push_back(sName);
+        return (int) stGlobal.vNames.size() - 1;
+    }
+
+    /// <summary>
+    /// Records a time (in microseconds) for a scope directly, i.e. for times measured some other way.
+    /// </summary>
+    static void Record(int iScope,double fMicroseconds)
+    {
+        if (iScope < 0 || iScope >= kMaxScopes || fMicroseconds < 0) return;
+        GetThreadData().GetScope(iScope).Record((uint64_t) (fMicroseconds*GetGlobal().fTicksPerUs));
+    }
+
+    static void SetEnabled(bool bEnabled = true) { GetGlobal().bEnabled = bEnabled; }
+    static bool isEnabled() { return GetGlobal().bEnabled; }
+
+    /// <summary>
+    /// Merges all threads' data and returns one entry per scope that has been timed, sorted by total time (highest first).
+    /// </summary>
+    static std::vector<ScopeReport_t> GetReport()
+    {
+        auto & stGlobal = GetGlobal();
+        std::lock_guard<std::mutex> lock(stGlobal.mLock);
+
+        std::vector<ScopeReport_t> vReport;
+        double fTicksPerUs = stGlobal.fTicksPerUs;
+
+        for (int i=0;i<(int) stGlobal.vNames.size();i++)
+        {
+            Totals_t stTotals = stGlobal.vRetired[i];
+            for (auto pThread : stGlobal.vThreads)
+            {
+                auto pData = pThread->pScopes[i].load(std::memory_order_acquire);
+                if (pData) stTotals.Merge(*pData);
+            }
+            if (!stTotals.iCount) continue;
+
+            ScopeReport_t stReport;
+            stReport.sName      = stGlobal.vNames[i];
+            stReport.iCount     = stTotals.iCount;
+            stReport.fTotalMs   = (double) stTotals.iTotal/fTicksPerUs/1000.0;
+            stReport.fMinUs     = (double) stTotals.iMin/fTicksPerUs;
+            stReport.fMaxUs     = (double) stTotals.iMax/fTicksPerUs;
+            stReport.fMeanUs    = (double) stTotals.iTotal/(double) stTotals.iCount/fTicksPerUs;
+            stReport.fP50Us     = GetPercentile(stTotals,50)/fTicksPerUs;
+            stReport.fP99Us     = GetPercentile(stTotals,99)/fTicksPerUs;
+            vReport.push_back(std::move(stReport));
+        }
+
+        std::sort(vReport.begin(),vReport.end(),[](const ScopeReport_t & a,const ScopeReport_t & b) { return a.fTotalMs > b.fTotalMs; });
+        return vReport;
+    }
+
+    /// <summary>
+    /// Clears all times (scope names stay registered).
+    /// </summary>
+    static void Reset()
+    {
+        auto & stGlobal = GetGlobal();
+        std::lock_guard<std::mutex> lock(stGlobal.mLock);
+        for (auto & stTotals : stGlobal.vRetired) stTotals = Totals_t();
+        for (auto pThread : stGlobal.vThreads) for (int i=0;i<kMaxScopes;i++)
+        {
+            auto pData = pThread->pScopes[i].load(std::memory_order_acquire);
+            if (!pData) continue;
+            pData->iCount = 0;
+            pData->iTotal = 0;
+            pData->iMin = UINT64_MAX;
+            pData->iMax = 0;
+            for (auto & iBucket : pData->iBuckets) iBucket = 0;
+        }
+    }
+
+    /// <summary>
+    /// Writes the report as CSV (one line per scope, times in microseconds except total in milliseconds).
+    /// </summary>
+    static bool WriteCSV(FILE * fOut)
+    {
+        if (!fOut) return false;
+        fprintf(fOut,"name,count,total_ms,min_us,mean_us,p50_us,p99_us,max_us\n");
+        for (auto & r : GetReport())
+        {
+            std::string sName = r.sName;
+            for (size_t i=0;i<sName.size();i++) if (sName[i] == '"') sName.insert(i++,1,'"');
+            fprintf(fOut,"\"%s\",%llu,%.3f,%.3f,%.3f,%.3f,%.3f,%.3f\n",sName.c_str(),(unsigned long long) r.iCount,r.fTotalMs,r.fMinUs,r.fMeanUs,r.fP50Us,r.fP99Us,r.fMaxUs);
+        }
+        return true;
+    }
+
+    /// <summary>
+    /// Writes the report as a JSON array of objects with the same fields as WriteCSV().
+    /// </summary>
+    static bool WriteJSON(FILE * fOut)
+    {
+        if (!fOut) return false;
+        auto vReport = GetReport();
+        fprintf(fOut,"[\n");
+        for (size_t i=0;i<vReport.size();i++)
+        {
+            auto & r = vReport[i];
+            std::string sName;
+            for (char c : r.sName)
+            {
+                if (c == '"' || c == '\\') sName += '\\';
+                if ((unsigned char) c >= 0x20) sName += c;
+            }
+            fprintf(fOut,"  { \"name\": \"%s\", \"count\": %llu, \"total_ms\": %.3f, \"min_us\": %.3f, \"mean_us\": %.3f, \"p50_us\": %.3f, \"p99_us\": %.3f, \"max_us\": %.3f }%s\n",
+                    sName.c_str(),(unsigned long long) r.iCount,r.fTotalMs,r.fMinUs,r.fMeanUs,r.fP50Us,r.fP99Us,r.fMaxUs,i + 1 < vReport.size() ? "," : "");
+        }
+        fprintf(fOut,"]\n");
+        return true;
+    }
+
+    static bool WriteCSV(const char * sPath)
+    {
+        FILE * fOut = sPath ? fopen(sPath,"w") : nullptr;
+        bool bResult = WriteCSV(fOut);
+        if (fOut) fclose(fOut);
+        return bResult;
+    }
+
+    static bool WriteJSON(const char * sPath)
+    {
+        FILE * fOut = sPath ? fopen(sPath,"w") : nullptr;
+        bool bResult = WriteJSON(fOut);
+        if (fOut) fclose(fOut);
+        return bResult;
+    }
+
+    /// <summary>
+    /// Prints the report as a table (to the console by default).
+    /// </summary>
+    static void PrintReport(FILE * fOut = stdout)
+    {
+        fprintf(fOut,"%-32s %10s %12s %10s %10s %10s %10s %10s\n","Scope","Count","Total(ms)","Min(us)","Mean(us)","p50(us)","p99(us)","Max(us)");
+        for (auto & r : GetReport())
+            fprintf(fOut,"%-32s %10llu %12.3f %10.2f %10.2f %10.2f %10.2f %10.2f\n",r.sName.c_str(),(unsigned long long) r.iCount,r.fTotalMs,r.fMinUs,r.fMeanUs,r.fP50Us,r.fP99Us,r.fMaxUs);
+    }
+};
+
+#define _SageProfileCat2(a,b) a##b
+#define _SageProfileCat(a,b) _SageProfileCat2(a,b)
+
+#if defined(SAGE_PROFILE_DISABLE)
+#define SageProfileScope(sName)
+#else
+#define SageProfileScope(sName) static const int _SageProfileCat(_iSageProfileScope,__LINE__) = Sage::CSageProfile::RegisterScope(sName); \
+                                Sage::CSageProfile::Scope _SageProfileCat(_cSageProfileScope,__LINE__)(_SageProfileCat(_iSageProfileScope,__LINE__))
+#endif
+
+} // namespace Sage
+#endif // _CSageProfile_H_
@@ -0,0 +1,356 @@
+// This file copyright(c) 2021 Rob Nelson, All Rights Reserved.    E-mail rob@projectsagebox.com for more information.
+//
+
+#pragma once
+#if !defined(_CSageResize_H_)
+#define _CSageResize_H_
+
+#include "Sage.h"
+#include "CRawBitmap.h"
+#include "CThreadPool.h"
+#include "SimdClass.h"
+#include <cmath>
+#include <vector>
+#include <memory>
+#include <mutex>
+
+namespace Sage
+{
+
+// CSageResize -- Multi-threaded Lanczos and Bilinear resize for 24-bit bitmaps, for repeated resizing of same-size images
+//
+// This is the engine behind the CSageTools::ResizeLanzcos() and CSageTools::BilinearResize() overloads that take a destination
+// CBitmap.  It is meant for resizing video/camera frames every frame, where the source and destination sizes stay the same:
+//
+//      1. Weights are computed once per (source size, destination size, filter) and cached, so repeated calls only filter.
+//      2. The destination is split into bands of rows processed across the CThreadPool threads.  Each band runs the horizontal
+//         pass for only the source rows it needs (into per-thread scratch), then the vertical pass, so the intermediate image
+//         stays in cache and is never allocated as a whole.
+//      3. When the destination bitmap is already the right size, and the scratch buffers have been sized by an earlier call,
+//         nothing is allocated -- steady-state calls do no memory allocation.
+//
+// The filter is separable.  Edge pixels are clamped (i.e. repeated), and weights are normalized so flat areas stay exactly flat.
+// When shrinking, the Lanczos filter is widened by the scale factor so it averages all source pixels (rather than skipping them).
+// Bilinear is the standard 2-tap filter in both directions.
+//
+// Example:
+//
+//      CSageResize cResize;       // Or use CSageResize::GetDefault()
+//      CBitmap cFrame;
+//
+//      while(GetFrame(cCamera))
+//      {
+//          cResize.Resize(cCamera,1920,1080,cFrame);      // cFrame is only allocated the first time
+//          cWin.DisplayBitmap(cFrame);
+//      }
+//
+// Resize() calls on one CSageResize object are serialized (the scratch buffers belong to the object), so use one object per
+// thread if frames are resized on multiple threads at the same time.
+//
+class CSageResize
+{
+public:
+    enum class Filter
+    {
+        Lanczos,        // Lanczos-3
+        Bilinear,
+    };
+
+    static constexpr int kBandRows  = 32;      // Destination rows per task
+    static constexpr int kMaxPlans  = 8;       // Cached (source size, destination size, filter) combinations
+
+private:
+
+    // Weights for one axis.  Each output has iTaps weights starting at source index vStart[i] (always within the source, with
+    // edge clamping folded into the weights)
+
+    struct Axis_t
+    {
+        int iTaps = 0;
+        std::vector<int> vStart;
+        std::vector<float> vWeights;
+    };
+
+    struct Plan_t
+    {
+        int iSrcWidth, iSrcHeight, iDestWidth, iDestHeight;
+        Filter eFilter;
+        Axis_t stX, stY;
+        int iBands;
+        int iMaxBandRows;           // Most source rows any one band needs (sizes the scratch buffers)
+    };
+
+    std::mutex m_mResize;
+    std::mutex m_mPlans;
+    std::vector<std::shared_ptr<Plan_t>> m_vPlans;     // Most recently used first
+    std::vector<std::vector<float>> m_vScratch;        // One per pool thread
+    CThreadPool & m_cPool;
+
+    static double Sinc(double fx) { if (fx == 0) return 1.0; fx *= 3.14159265358979323846; return std::sin(fx)/fx; }
+
+    static void BuildAxis(Axis_t & stAxis,int iSrc,int iDest,Filter eFilter)
+    {
+        double fScale   = (double) iSrc/(double) iDest;
+        double fStretch = eFilter == Filter::Lanczos && fScale > 1.0 ? fScale : 1.0;      // Widen the filter when shrinking
+        double fSupport = (eFilter == Filter::Lanczos ? 3.0 : 1.0)*fStretch;
+
+        int iTaps = (int) std::ceil(fSupport*2.0) + 1;
+        if (iTaps > iSrc) iTaps = iSrc;
+
+        stAxis.iTaps = iTaps;
+        stAxis.vStart.resize(iDest);
+        stAxis.vWeights.assign((size_t) iDest*iTaps,0.0f);
+
+        std::vector<double> vAccum(iSrc > 0 ? iSrc : 1);
+
+        for (int i=0;i<iDest;i++)
+        {
+            double fCenter = ((double) i + 0.5)*fScale - 0.5;
+
+            int iLeft   = (int) std::floor(fCenter - fSupport);
+            int iRight  = (int) std::ceil(fCenter + fSupport);
+
+            // Accumulate clamped taps, tracking the range of source pixels actually used
+
+            int iMin = iSrc, iMax = -1;
+            double fTotal = 0;
+            for (int j=iLeft;j<=iRight;j++)
+            {
+                double fx = ((double) j - fCenter)/fStretch;
+                double fWeight = eFilter == Filter::Lanczos ? (std::fabs(fx) < 3.0 ? Sinc(fx)*Sinc(fx/3.0) : 0.0) : (std::fabs(fx) < 1.0 ? 1.0 - std::fabs(fx) : 0.0);
+                if (fWeight == 0.0) continue;
+
+                // j increases, so the clamped index k never goes down
+
+                int k = j < 0 ? 0 : j >= iSrc ? iSrc-1 : j;
+                if (iMax < 0) iMin = iMax = k, vAccum[k] = 0;
+                while (iMax < k) vAccum[++iMax] = 0;
+                vAccum[k] += fWeight;
+                fTotal += fWeight;
+            }
+
+            if (iMax < 0) { iMin = iMax = (int) (fCenter < 0 ? 0 : fCenter >= iSrc ? iSrc-1 : fCenter); vAccum[iMin] = fTotal = 1.0; }
+
+            // Fit iTaps weights inside the source
+
+            int iStart = iMin;
+            if (iStart + iTaps > iSrc) iStart = iSrc - iTaps;
+
+            stAxis.vStart[i] = iStart;
+            float * fWeights = &stAxis.vWeights[(size_t) i*iTaps];
+            for (int k=iMin;k<=iMax;k++) fWeights[k-iStart] = (float) (vAccum[k]/fTotal);
+        }
+    }
+
+    std::shared_ptr<Plan_t> GetPlan(int iSrcWidth,int iSrcHeight,int iDestWidth,int iDestHeight,Filter eFilter)
+    {
+        std::lock_guard<std::mutex> lock(m_mPlans);
+
+        for (size_t i=0;i<m_vPlans.size();i++)
+        {
+            auto & p = m_vPlans[i];
+            if (p->iSrcWidth == iSrcWidth && p->iSrcHeight == iSrcHeight && p->iDestWidth == iDestWidth && p->iDestHeight == iDestHeight && p->eFilter == eFilter)
+            {
+                auto pPlan = p;
+                if (i) { m_vPlans.erase(m_vPlans.begin()+i); m_vPlans.insert(m_vPlans.begin(),pPlan); }
+                return pPlan;
+            }
+        }
+
+        auto pPlan = std::make_shared<Plan_t>();
+        *pPlan = { iSrcWidth,iSrcHeight,iDestWidth,iDestHeight,eFilter };
+
+        BuildAxis(pPlan->stX,iSrcWidth,iDestWidth,eFilter);
+        BuildAxis(pPlan->stY,iSrcHeight,iDestHeight,eFilter);
+
+        pPlan->iBands       = (iDestHeight + kBandRows-1)/kBandRows;
+        pPlan->iMaxBandRows = 0;
+        for (int i=0;i<pPlan->iBands;i++)
+        {
+            int iFirst  = i*kBandRows;
+            int iLast   = (iFirst + kBandRows < iDestHeight ? iFirst + kBandRows : iDestHeight) - 1;
+            int iRows   = pPlan->stY.vStart[iLast] + pPlan->stY.iTaps - pPlan->stY.vStart[iFirst];
+            if (iRows > pPlan->iMaxBandRows) pPlan->iMaxBandRows = iRows;
+        }
+
+        m_vPlans.insert(m_vPlans.begin(),pPlan);
+        if ((int) m_vPlans.size() > kMaxPlans) m_vPlans.pop_back();
+        return pPlan;
+    }
+
+    // Horizontal pass of one source row into fOut (iDestWidth*3 floats).  The row is converted to float first (into fRow), since
+    // each source pixel is used by several outputs.
+    //
+    // Each tap is one 4-lane multiply-add on { B, G, R, (next B) }, so fRow has 1 float of padding, and the last output pixel
+    // is stored separately so the 4th lane doesn't write past the row.
+
+    static void FilterRow(const Plan_t & stPlan,const unsigned char * sRow,float * fRow,float * fOut)
+    {
+        for (int x=0;x<stPlan.iSrcWidth*3;x++) fRow[x] = (float) sRow[x];
+        fRow[stPlan.iSrcWidth*3] = 0;
+
+        const int iTaps = stPlan.stX.iTaps;
+        const float * fWeights = stPlan.stX.vWeights.data();
+
+        for (int x=0;x<stPlan.iDestWidth;x++,fWeights += iTaps)
+        {
+            const float * fIn = fRow + stPlan.stX.vStart[x]*3;
+            // Two sums, so each add doesn't wait on the previous one
+
+            auto vSum   = Simd128::Vecf(0.0f);
+            auto vSum2  = Simd128::Vecf(0.0f);
+            int t = 0;
+            for (;t<iTaps-1;t += 2,fIn += 6)
+            {
+                vSum    = Simd128::Add(vSum, Simd128::Mul(Simd128::Vecf(fWeights[t]),  Simd128::LoadU(fIn)));
+                vSum2   = Simd128::Add(vSum2,Simd128::Mul(Simd128::Vecf(fWeights[t+1]),Simd128::LoadU(fIn+3)));
+            }
+            if (t < iTaps) vSum = Simd128::Add(vSum,Simd128::Mul(Simd128::Vecf(fWeights[t]),Simd128::LoadU(fIn)));
+            vSum = Simd128::Add(vSum,vSum2);
+
+            if (x < stPlan.iDestWidth-1) Simd128::StoreU(fOut + x*3,vSum);
+            else
+            {
+                alignas(16) float fLast[4];
+                Simd128::Store(fLast,vSum);
+                fOut[x*3] = fLast[0]; fOut[x*3+1] = fLast[1]; fOut[x*3+2] = fLast[2];
+            }
+        }
+    }
+
+    // Resize one band of destination rows
+
+    static void ResizeBand(const Plan_t & stPlan,const RawBitmap_t & stSource,RawBitmap_t & stDest,int iBand,float * fScratch)
+    {
+        const int iRowFloats    = stPlan.iDestWidth*3;
+        const int iTaps         = stPlan.stY.iTaps;
+
+        int iFirst  = iBand*kBandRows;
+        int iLast   = (iFirst + kBandRows < stPlan.iDestHeight ? iFirst + kBandRows : stPlan.iDestHeight) - 1;
+        int iSrcY0  = stPlan.stY.vStart[iFirst];
+        int iSrcY1  = stPlan.stY.vStart[iLast] + iTaps;
+
+        // Scratch layout: iMaxBandRows horizontally-filtered rows, then the vertical accumulator row, then the float source row
+
+        float * fAccum  = fScratch + (size_t) stPlan.iMaxBandRows*iRowFloats;
+        float * fRow    = fAccum + iRowFloats;
+
+        for (int y=iSrcY0;y<iSrcY1;y++)
+            FilterRow(stPlan,stSource.stMem + (size_t) y*stSource.iWidthBytes,fRow,fScratch + (size_t) (y-iSrcY0)*iRowFloats);
+
+        // Vertical pass, a whole row at a time so the inner loops are contiguous (and vectorize)
+
+        for (int y=iFirst;y<=iLast;y++)
+        {
+            const float * fWeights  = &stPlan.stY.vWeights[(size_t) y*iTaps];
+            const float * fRows     = fScratch + (size_t) (stPlan.stY.vStart[y]-iSrcY0)*iRowFloats;
+            unsigned char * sOut    = stDest.stMem + (size_t) y*stDest.iWidthBytes;
+
+            const int iVec = iRowFloats & ~15;      // 16 floats -> 16 bytes per step, the rest is done one at a time
+
+            for (int x=0;x<iRowFloats;x++) fAccum[x] = 0.5f;        // Rounding
+            for (int t=0;t<iTaps;t++)
+            {
+                const float fWeight = fWeights[t];
+                const float * fRow  = fRows + (size_t) t*iRowFloats;
+                if (fWeight == 0.0f) continue;
+
+                auto vWeight = Simd128::Vecf(fWeight);
+                int x = 0;
+                for (;x<iVec;x += 4) Simd128::StoreU(fAccum+x,Simd128::Add(Simd128::LoadU(fAccum+x),Simd128::Mul(vWeight,Simd128::LoadU(fRow+x))));
+                for (;x<iRowFloats;x++) fAccum[x] += fWeight*fRow[x];
+            }
+
+            // Saturating packs clamp to 0-255 (SSE2 only)
+
+            int x = 0;
+            for (;x<iVec;x += 16)
+            {
+                auto v0 = Simd128::Packs_epi32(Simd128::CvttInt(Simd128::LoadU(fAccum+x)),  Simd128::CvttInt(Simd128::LoadU(fAccum+x+4)));
+                auto v1 = Simd128::Packs_epi32(Simd128::CvttInt(Simd128::LoadU(fAccum+x+8)),Simd128::CvttInt(Simd128::LoadU(fAccum+x+12)));
+                _mm_storeu_si128((__m128i *) (sOut+x),Simd128::Packus_epi16(v0,v1));
+            }
+            for (;x<iRowFloats;x++)
+            {
+                float fValue = fAccum[x];
+                sOut[x] = fValue <= 0.0f ? 0 : fValue >= 255.0f ? 255 : (unsigned char) fValue;
+            }
+        }
+    }
+
+public:
+    CSageResize(CThreadPool & cPool = CThreadPool::GetDefault()) : m_cPool(cPool) { }
+
+    /// <summary>
+    /// Resizes stSource into stDest, using the size of stDest as the new size.  Both must be valid 24-bit bitmaps.
+    /// <para></para>
+    /// --> Weights are cached by size, so repeated calls with the same sizes only do the filtering.
+    /// </summary>
+    /// <param name="stSource"> - Source bitmap</param>
+    /// <param name="stDest"> - Destination bitmap (already allocated at the new size)</param>
+    /// <param name="eFilter"> - [optional] Filter::Lanczos (default) or Filter::Bilinear</param>
+    /// <param name="iMaxThreads"> - [optional] Maximum threads to use.  0 (default) = all threads in the pool.</param>
+    /// <returns>true if the bitmap was resized, false if either bitmap is empty/invalid or they overlap.</returns>
+    bool Resize(const RawBitmap_t & stSource,RawBitmap_t & stDest,Filter eFilter = Filter::Lanczos,int iMaxThreads = 0)
+    {
+        if (!stSource.stMem || !stDest.stMem || stSource.iWidth <= 0 || stSource.iHeight <= 0 || stDest.iWidth <= 0 || stDest.iHeight <= 0) return false;
+        if (stSource.stMem == stDest.stMem) return false;
+
+        auto pPlan = GetPlan(stSource.iWidth,stSource.iHeight,stDest.iWidth,stDest.iHeight,eFilter);
+
+        std::lock_guard<std::mutex> lock(m_mResize);
+
+        size_t iScratch = (size_t) (pPlan->iMaxBandRows + 1)*pPlan->iDestWidth*3 + (size_t) pPlan->iSrcWidth*3 + 1;     // See ResizeBand()
+        if ((int) m_vScratch.size() < m_cPool.GetThreads()) m_vScratch.resize(m_cPool.GetThreads());
+        for (auto & vScratch : m_vScratch) if (vScratch.size() < iScratch) vScratch.resize(iScratch);
+
+        // One pointer is captured, so the std::function does not allocate.
+
+        struct Job_t { const Plan_t * pPlan; const RawBitmap_t * pSource; RawBitmap_t * pDest; std::vector<float> * pScratch; } stJob
+                        = { pPlan.get(), &stSource, &stDest, m_vScratch.data() };
+
+        m_cPool.ParallelFor(pPlan->iBands,[pJob = &stJob](int iBand,int iThread)
+            {
+                ResizeBand(*pJob->pPlan,*pJob->pSource,*pJob->pDest,iBand,pJob->pScratch[iThread].data());
+            },iMaxThreads);
+
+        return true;
+    }
+
+    /// <summary>
+    /// Resizes cSource to iNewWidth x iNewHeight into cDest.  cDest is only (re)allocated when it is not already iNewWidth x iNewHeight,
+    /// so calling this every frame with the same cDest does not allocate memory.
+    /// </summary>
+    /// <returns>true if the bitmap was resized, false if the source is empty/invalid or the new size is invalid.</returns>
+    bool Resize(CBitmap & cSource,int iNewWidth,int iNewHeight,CBitmap & cDest,Filter eFilter = Filter::Lanczos,int iMaxThreads = 0)
+    {
+        if (iNewWidth <= 0 || iNewHeight <= 0 || &cSource == &cDest) return false;
+        if (cDest.stBitmap.iWidth != iNewWidth || cDest.stBitmap.iHeight != iNewHeight || !cDest.stBitmap.stMem)
+        {
+            cDest.Delete();
+            if (!cDest.CreateBitmap(iNewWidth,iNewHeight)) return false;
+        }
+        return Resize(cSource.stBitmap,cDest.stBitmap,eFilter,iMaxThreads);
+    }
+
+    /// <summary>
+    /// Drops all cached weights.  (They are also dropped automatically, oldest first, after kMaxPlans different sizes are used)
+    /// </summary>
+    void ClearCache()
+    {
+        std::lock_guard<std::mutex> lock(m_mPlans);
+        m_vPlans.clear();
+    }
+
+    /// <summary>
+    /// Returns the process-wide CSageResize object used by CSageTools, using CThreadPool::GetDefault().
+    /// </summary>
+    static CSageResize & GetDefault()
+    {
+        static CSageResize cResize;
+        return cResize;
+    }
+};
+
+} // namespace Sage
+#endif // _CSageResize_H_
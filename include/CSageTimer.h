@@ -17,7 +17,7 @@ public:
     int m_iAvgPlace = 0;
     bool AllocateAvgData(int iSize = -1)  // $$ move to .cpp file
     {
-        if (m_AvgData) delete m_AvgData; 
+        if (m_AvgData) delete [] m_AvgData; 
         m_AvgData = nullptr;
         if (iSize < 0) iSize = iDefaultAvgWidth; 
         if (!iSize) return true;
@@ -59,9 +59,10 @@ public:
     {
         if (!m_AvgData) return 0;
         int iCount = m_bAvgReady ? m_iAvgWidth : m_iAvgCount;
+        if (!iCount) return 0;
         long long llAvg = 0;
 
-        for (int i=0;i<iCount++;i++) llAvg += (long long) m_AvgData[i];
+        for (int i=0;i<iCount;i++) llAvg += (long long) m_AvgData[i];
         return (double) llAvg/(double) iCount; 
     }
 
@@ -20,6 +20,8 @@
 #include "CDavinci.h"
 #include "Sage.h"
 #include "Point3D.h"
+#include "CSageResize.h"
+#include "CSageBlur.h"
 #include <cmath>
 
 namespace Sage
@@ -59,8 +61,26 @@ public:
 	static CBitmap BilinearResize(RawBitmap_t & stSource,int iNewWidth,int iNewHeight,bool * bSuccess = nullptr);
 	static CBitmap BilinearResize(CBitmap & cSource,int iNewWidth,int iNewHeight,bool * bSuccess = nullptr);
 	static bool BilinearResize(int iOrgWidth,int iOrgHeight,int iNewWidth,int iNewHeight,const unsigned char *sInputMem,unsigned char * sOutputMem);
+
+    // Multi-threaded versions for repeated resizing (i.e. video frames).  Filter weights are cached by size, and cDest is only
+    // (re)allocated when it is not already iNewWidth x iNewHeight, so steady-state calls allocate nothing.  See CSageResize.h
+
+    static bool ResizeLanzcos(CBitmap & cSource,int iNewWidth,int iNewHeight,CBitmap & cDest,int iMaxThreads = 0)
+        { return CSageResize::GetDefault().Resize(cSource,iNewWidth,iNewHeight,cDest,CSageResize::Filter::Lanczos,iMaxThreads); }
+    static bool BilinearResize(CBitmap & cSource,int iNewWidth,int iNewHeight,CBitmap & cDest,int iMaxThreads = 0)
+        { return CSageResize::GetDefault().Resize(cSource,iNewWidth,iNewHeight,cDest,CSageResize::Filter::Bilinear,iMaxThreads); }
     static bool GaussianBlurStd(CBitmap & cInput,CBitmap & cOutput,double fRadius);
     static CBitmap GaussianBlurStd(CBitmap & cInput,double fRadius,bool * bRetError = nullptr);
+
+    // GaussianBlurStd() with a choice of method.  BlurMode::Box is an iPasses box-blur approximation whose cost does not
+    // depend on fRadius (the Gaussian sigma), multi-threaded, and cOutput is only (re)allocated when its size changes.
+    // BlurMode::Exact is the GaussianBlurStd() above.  See CSageBlur.h
+
+    static bool GaussianBlurStd(CBitmap & cInput,CBitmap & cOutput,double fRadius,CSageBlur::BlurMode eMode,int iPasses = CSageBlur::kDefaultPasses,int iMaxThreads = 0)
+    {
+        if (eMode == CSageBlur::BlurMode::Exact) return GaussianBlurStd(cInput,cOutput,fRadius);
+        return CSageBlur::GetDefault().Blur(cInput,cOutput,fRadius,iPasses,iMaxThreads);
+    }
     static bool NormalizeBitmap(RawBitmap_t & stInput,RawBitmap_t & stOutput,double fUpperThreshold = 1,double fLowerThreshold = 0);
 };
 };// namespace Sage
@@ -0,0 +1,422 @@
+// This file copyright(c) 2021 Rob Nelson, All Rights Reserved.    E-mail rob@projectsagebox.com for more information.
+//
+
+#pragma once
+#if !defined(_CShardedValues_H_)
+#define _CShardedValues_H_
+
+#include <vector>
+#include <memory>
+#include <shared_mutex>
+#include <mutex>
+#include <string>
+#include <cstring>
+#include <algorithm>
+
+namespace Sage
+{
+
+// CShardedValues -- Thread-safe named and indexed value store, with the same functions as CStoreValues
+//
+// CStoreValues (the store behind SetGlobalValue()/GetGlobalValue() and Sagebox::DebugValues) is built into the library with
+// fixed tables and names of up to 50 characters.  CShardedValues is a separate, header-only store for programs that set and
+// read many values from many threads.
+//
+// Values are kept in an open-addressing hash table, split into kShards shards by the hash of the name or index, each with its
+// own reader/writer lock -- threads setting or reading different values rarely wait on each other, and readers of the same
+// shard never wait on each other.  There is no fixed number of values or maximum name length; each shard grows as needed.
+//
+// Each slot holds the name (stored once, when the value is first added), the value, and strings of up to kInlineString
+// characters inline, so setting a short string doesn't allocate.
+//
+// Keys:
+//
+//      Values can be set and read by name or by index (names and indexes are separate, i.e. "1" and 1 are different values).
+//      For values set and read often (i.e. telemetry published by worker threads every frame), make a Key_t once with
+//      MakeKey() -- this hashes the name once rather than on every call:
+//
+//          static const auto stKey = CShardedValues::MakeKey("FrameTime");
+//          cStore.AddValue(stKey,fFrameTime);
+//
+// Notes:
+//
+//      1. All functions can be called from any thread.
+//      2. GetString() returns a copy of the string in a buffer kept for the calling thread, which is valid until the next
+//         GetString() call on the same thread (since another thread can change or delete the value at any time).
+//
+class CShardedValues
+{
+public:
+    static constexpr int kShards        = 64;       // Power of 2
+    static constexpr int kInlineString  = 39;       // Longest string kept in the slot (longer strings are allocated)
+
+    enum class StoreType
+    {
+        Value,
+        String
+    };
+
+    // A name or index with its hash, from MakeKey().  The name is not copied, so it must stay valid while the key is used.
+
+    struct Key_t
+    {
+        unsigned long long uHash;
+        const char * sName;         // nullptr for index keys
+        int iIndex;
+    };
+
+private:
+    struct stValue_t
+    {
+        union un
+        {
+            double          fdValue;
+            float           fValue;
+            int             iValue;
+            unsigned int    uiValue;
+            unsigned long long ui64Value;
+            long long llValue;
+            void * vPointer;
+        };
+        un Values;
+    };
+
+    enum class SlotState : unsigned char
+    {
+        Empty,
+        Used,
+        Deleted,
+    };
+
+    struct Slot_t
+    {
+        unsigned long long uHash;
+        std::unique_ptr<char[]> sName;          // nullptr for index values
+        std::unique_ptr<char[]> sLongString;    // Strings longer than kInlineString
+        long long vValue;                       // N/A if string type
+        int iIndex;
+        SlotState eState = SlotState::Empty;
+        StoreType eStoreType;
+        char sString[kInlineString+1];
+
+        const char * GetString() const { return sLongString ? sLongString.get() : sString; }
+
+        void SetString(const char * sValue)
+        {
+            size_t iLength = strlen(sValue);
+            if (iLength <= (size_t) kInlineString)
+            {
+                memcpy(sString,sValue,iLength+1);
+                sLongString.reset();
+            }
+            else
+            {
+                sLongString.reset(new char[iLength+1]);
+                memcpy(sLongString.get(),sValue,iLength+1);
+                sString[0] = 0;
+            }
+        }
+    };
+
+    struct alignas(64) Shard_t
+    {
+        mutable std::shared_mutex mLock;
+        std::vector<Slot_t> vSlots;             // Power of 2 size, or empty
+        int iUsed = 0;
+        int iDeleted = 0;
+    };
+
+    Shard_t m_stShards[kShards];
+
+    static unsigned long long Mix(unsigned long long uValue)
+    {
+        uValue ^= uValue >> 33;
+        uValue *= 0xff51afd7ed558ccdULL;
+        uValue ^= uValue >> 33;
+        uValue *= 0xc4ceb9fe1a85ec53ULL;
+        uValue ^= uValue >> 33;
+        return uValue;
+    }
+
+    static bool Matches(const Slot_t & stSlot,const Key_t & stKey)
+    {
+        if (stSlot.uHash != stKey.uHash) return false;
+        if (!stKey.sName) return !stSlot.sName && stSlot.iIndex == stKey.iIndex;
+        return stSlot.sName && !strcmp(stSlot.sName.get(),stKey.sName);
+    }
+
+    Shard_t & GetShard(const Key_t & stKey) { return m_stShards[stKey.uHash >> 58]; }      // Top 6 bits (kShards = 64)
+
+    // Returns the slot holding stKey, or nullptr.  The shard must be locked (shared or exclusive).
+
+    static Slot_t * FindSlot(const Shard_t & stShard,const Key_t & stKey)
+    {
+        if (stShard.vSlots.empty()) return nullptr;
+        size_t uMask = stShard.vSlots.size() - 1;
+        for (size_t i=(size_t) stKey.uHash & uMask;;i = (i + 1) & uMask)
+        {
+            auto & stSlot = stShard.vSlots[i];
+            if (stSlot.eState == SlotState::Empty) return nullptr;
+            if (stSlot.eState == SlotState::Used && Matches(stSlot,stKey)) return const_cast<Slot_t *>(&stSlot);
+        }
+    }
+
+    // Rebuilds the shard's table with iSize slots, dropping deleted slots.  The shard must be locked exclusively.
+
+    static void Rehash(Shard_t & stShard,size_t iSize)
+    {
+        std::vector<Slot_t> vOld(iSize);
+        vOld.swap(stShard.vSlots);
+
+        size_t uMask = iSize - 1;
+        for (auto & stSlot : vOld)
+        {
+            if (stSlot.eState != SlotState::Used) continue;
+            size_t i = (size_t) stSlot.uHash & uMask;
+            while (stShard.vSlots[i].eState != SlotState::Empty) i = (i + 1) & uMask;
+            stShard.vSlots[i] = std::move(stSlot);
+        }
+        stShard.iDeleted = 0;
+    }
+
+    // Returns the slot for stKey, adding it if it isn't there.  The shard must be locked exclusively.
+
+    static Slot_t & GetSlot(Shard_t & stShard,const Key_t & stKey)
+    {
+        if (auto pSlot = FindSlot(stShard,stKey)) return *pSlot;
+
+        // Keep the table at most 3/4 full, counting deleted slots (which still end probes)
+
+        size_t iSize = stShard.vSlots.size();
+        if ((size_t) (stShard.iUsed + stShard.iDeleted + 1)*4 > iSize*3)
+            Rehash(stShard,!iSize ? 16 : (size_t) (stShard.iUsed + 1)*2 > iSize ? iSize*2 : iSize);
+
+        size_t uMask = stShard.vSlots.size() - 1;
+        size_t i = (size_t) stKey.uHash & uMask;
+        while (stShard.vSlots[i].eState == SlotState::Used) i = (i + 1) & uMask;
+
+        auto & stSlot = stShard.vSlots[i];
+        if (stSlot.eState == SlotState::Deleted) stShard.iDeleted--;
+        stShard.iUsed++;
+
+        stSlot.eState   = SlotState::Used;
+        stSlot.uHash    = stKey.uHash;
+        stSlot.iIndex   = stKey.iIndex;
+        stSlot.sName.reset();
+        if (stKey.sName)
+        {
+            size_t iLength = strlen(stKey.sName);
+            stSlot.sName.reset(new char[iLength+1]);
+            memcpy(stSlot.sName.get(),stKey.sName,iLength+1);
+        }
+        return stSlot;
+    }
+
+public:
+
+    /// <summary>
+    /// Returns the key for a name, to use with the Key_t functions.  The name isn't copied, so it must stay valid while the key
+    /// is used (i.e. a string literal).
+    /// </summary>
+    static Key_t MakeKey(const char * sName)
+    {
+        if (!sName) sName = "";
+        unsigned long long uHash = 0xcbf29ce484222325ULL;      // FNV-1a
+        for (const unsigned char * s = (const unsigned char *) sName;*s;s++) uHash = (uHash ^ *s)*0x100000001b3ULL;
+        return { Mix(uHash),sName,0 };
+    }
+
+    /// <summary>
+    /// Returns the key for an index, to use with the Key_t functions.
+    /// </summary>
+    static Key_t MakeKey(int iIndex) { return { Mix((unsigned long long) (unsigned int) iIndex ^ 0x9e3779b97f4a7c15ULL),nullptr,iIndex }; }
+
+    bool AddValue(const Key_t & stKey,long long uiValue)
+    {
+        auto & stShard = GetShard(stKey);
+        std::unique_lock<std::shared_mutex> lock(stShard.mLock);
+
+        auto & stSlot       = GetSlot(stShard,stKey);
+        stSlot.eStoreType   = StoreType::Value;
+        stSlot.vValue       = uiValue;
+        stSlot.sLongString.reset();
+        return true;
+    }
+
+    bool AddValue(const Key_t & stKey,const char * sString)
+    {
+        if (!sString) sString = "";
+        auto & stShard = GetShard(stKey);
+        std::unique_lock<std::shared_mutex> lock(stShard.mLock);
+
+        auto & stSlot       = GetSlot(stShard,stKey);
+        stSlot.eStoreType   = StoreType::String;
+        stSlot.vValue       = 0;
+        stSlot.SetString(sString);
+        return true;
+    }
+
+    bool DeleteValue(const Key_t & stKey)
+    {
+        auto & stShard = GetShard(stKey);
+        std::unique_lock<std::shared_mutex> lock(stShard.mLock);
+
+        auto pSlot = FindSlot(stShard,stKey);
+        if (!pSlot) return false;
+
+        pSlot->eState = SlotState::Deleted;
+        pSlot->sName.reset();
+        pSlot->sLongString.reset();
+        stShard.iUsed--;
+        stShard.iDeleted++;
+        return true;
+    }
+
+    /// <summary>
+    /// Returns the value, or 0 if it hasn't been set (or is a string).
+    /// </summary>
+    long long GetValue(const Key_t & stKey)
+    {
+        auto & stShard = GetShard(stKey);
+        std::shared_lock<std::shared_mutex> lock(stShard.mLock);
+
+        auto pSlot = FindSlot(stShard,stKey);
+        return pSlot && pSlot->eStoreType == StoreType::Value ? pSlot->vValue : 0;
+    }
+
+    /// <summary>
+    /// Returns a copy of the string (valid until the next GetString() on this thread), or nullptr if it hasn't been set (or is a
+    /// value rather than a string).
+    /// </summary>
+    const char * GetString(const Key_t & stKey)
+    {
+        thread_local std::string sCopy;
+
+        auto & stShard = GetShard(stKey);
+        std::shared_lock<std::shared_mutex> lock(stShard.mLock);
+
+        auto pSlot = FindSlot(stShard,stKey);
+        if (!pSlot || pSlot->eStoreType != StoreType::String) return nullptr;
+        sCopy = pSlot->GetString();
+        return sCopy.c_str();
+    }
+
+    /// <summary>
+    /// Copies the string into sBuffer (up to iBufferSize-1 characters).  Returns false if it hasn't been set (or is a value).
+    /// </summary>
+    bool GetString(const Key_t & stKey,char * sBuffer,int iBufferSize)
+    {
+        if (!sBuffer || iBufferSize <= 0) return false;
+
+        auto & stShard = GetShard(stKey);
+        std::shared_lock<std::shared_mutex> lock(stShard.mLock);
+
+        auto pSlot = FindSlot(stShard,stKey);
+        if (!pSlot || pSlot->eStoreType != StoreType::String) return false;
+
+        const char * sString = pSlot->GetString();
+        size_t iLength = (std::min)(strlen(sString),(size_t) iBufferSize - 1);
+        memcpy(sBuffer,sString,iLength);
+        sBuffer[iLength] = 0;
+        return true;
+    }
+
+    bool isValue(const Key_t & stKey)
+    {
+        auto & stShard = GetShard(stKey);
+        std::shared_lock<std::shared_mutex> lock(stShard.mLock);
+        return FindSlot(stShard,stKey) != nullptr;
+    }
+
+    bool AddValue(int iIndex,long long uiValue)             { return AddValue(MakeKey(iIndex),uiValue); }
+    bool AddValue(int iIndex,const char * sString)          { return AddValue(MakeKey(iIndex),sString); }
+    bool AddValue(const char * sName,long long uiValue)     { return AddValue(MakeKey(sName),uiValue); }
+    bool AddValue(const char * sName,const char * sString)  { return AddValue(MakeKey(sName),sString); }
+    bool DeleteValue(int iIndex)                            { return DeleteValue(MakeKey(iIndex)); }
+    bool DeleteValue(const char * sName)                    { return DeleteValue(MakeKey(sName)); }
+    long long GetValue(int iIndex)                          { return GetValue(MakeKey(iIndex)); }
+    long long GetValue(const char * sName)                  { return GetValue(MakeKey(sName)); }
+    const char * GetString(const char * sName)              { return GetString(MakeKey(sName)); }
+    const char * GetString(int iIndex)                      { return GetString(MakeKey(iIndex)); }
+
+    // Passthrough functions to specify different types easily
+
+#define _CShardedValues_AddValue(_stn)  stValue_t stValue{}; stValue.Values._stn = Value; return AddValue(iIndex,*reinterpret_cast<long long *>(&stValue));
+#define _CShardedValues_AddValueS(_stn)  stValue_t stValue{}; stValue.Values._stn = Value; return AddValue(sName,*reinterpret_cast<long long *>(&stValue));
+#define _CShardedValues_AddValueK(_stn)  stValue_t stValue{}; stValue.Values._stn = Value; return AddValue(stKey,*reinterpret_cast<long long *>(&stValue));
+
+    bool AddValue(int iIndex,double Value)              { _CShardedValues_AddValue(fdValue); };
+    bool AddValue(int iIndex,int Value)                 { _CShardedValues_AddValue(iValue); };
+    bool AddValue(int iIndex,unsigned int Value)        { _CShardedValues_AddValue(uiValue); };
+    bool AddValue(int iIndex,unsigned long long Value)  { _CShardedValues_AddValue(ui64Value); };
+    bool AddValue(int iIndex,void * Value)              { _CShardedValues_AddValue(vPointer); };
+
+    bool AddValue(const char * sName,double Value)              { _CShardedValues_AddValueS(fdValue); };
+    bool AddValue(const char * sName,int Value)                 { _CShardedValues_AddValueS(iValue); };
+    bool AddValue(const char * sName,unsigned int Value)        { _CShardedValues_AddValueS(uiValue); };
+    bool AddValue(const char * sName,unsigned long long Value)  { _CShardedValues_AddValueS(ui64Value); };
+    bool AddValue(const char * sName,void * Value)  { _CShardedValues_AddValueS(vPointer); };
+
+    bool AddValue(const Key_t & stKey,double Value)                { _CShardedValues_AddValueK(fdValue); };
+    bool AddValue(const Key_t & stKey,int Value)                   { _CShardedValues_AddValueK(iValue); };
+    bool AddValue(const Key_t & stKey,unsigned int Value)          { _CShardedValues_AddValueK(uiValue); };
+    bool AddValue(const Key_t & stKey,unsigned long long Value)    { _CShardedValues_AddValueK(ui64Value); };
+    bool AddValue(const Key_t & stKey,void * Value)                { _CShardedValues_AddValueK(vPointer); };
+
+#define _CShardedValues_GetValue(_stn) stValue_t stValue;  stValue.Values.llValue = GetValue(iIndex); return stValue.Values._stn;
+#define _CShardedValues_GetValueS(_stn) stValue_t stValue;  stValue.Values.llValue = GetValue(sName); return stValue.Values._stn;
+#define _CShardedValues_GetValueK(_stn) stValue_t stValue;  stValue.Values.llValue = GetValue(stKey); return stValue.Values._stn;
+
+    void * GetValuePointer         (int iIndex) { _CShardedValues_GetValue(vPointer); }
+    double GetValueDouble           (int iIndex) { _CShardedValues_GetValue(fdValue); }
+    int GetValueInt              (int iIndex) { _CShardedValues_GetValue(iValue); }
+    unsigned int GetValueUnsignedInt      (int iIndex) { _CShardedValues_GetValue(uiValue); }
+    unsigned long long GetValueUnsignedLongLong (int iIndex) { _CShardedValues_GetValue(ui64Value); }
+
+    void * GetValuePointer         (const char * sName) { _CShardedValues_GetValueS(vPointer); }
+    double GetValueDouble           (const char * sName) { _CShardedValues_GetValueS(fdValue); }
+    int GetValueInt              (const char * sName) { _CShardedValues_GetValueS(iValue); }
+    unsigned int GetValueUnsignedInt      (const char * sName) { _CShardedValues_GetValueS(uiValue); }
+    unsigned long long GetValueUnsignedLongLong (const char * sName) { _CShardedValues_GetValueS(ui64Value); }
+
+    void * GetValuePointer         (const Key_t & stKey) { _CShardedValues_GetValueK(vPointer); }
+    double GetValueDouble           (const Key_t & stKey) { _CShardedValues_GetValueK(fdValue); }
+    int GetValueInt              (const Key_t & stKey) { _CShardedValues_GetValueK(iValue); }
+    unsigned int GetValueUnsignedInt      (const Key_t & stKey) { _CShardedValues_GetValueK(uiValue); }
+    unsigned long long GetValueUnsignedLongLong (const Key_t & stKey) { _CShardedValues_GetValueK(ui64Value); }
+
+    /// <summary>
+    /// Returns the number of values (and strings) stored.
+    /// </summary>
+    int GetCount() const
+    {
+        int iCount = 0;
+        for (auto & stShard : m_stShards)
+        {
+            std::shared_lock<std::shared_mutex> lock(stShard.mLock);
+            iCount += stShard.iUsed;
+        }
+        return iCount;
+    }
+
+    /// <summary>
+    /// Deletes all values and strings.
+    /// </summary>
+    void Clear()
+    {
+        for (auto & stShard : m_stShards)
+        {
+            std::unique_lock<std::shared_mutex> lock(stShard.mLock);
+            stShard.vSlots.clear();
+            stShard.iUsed = 0;
+            stShard.iDeleted = 0;
+        }
+    }
+
+    CShardedValues() = default;
+    CShardedValues(const CShardedValues &) = delete;
+    CShardedValues & operator = (const CShardedValues &) = delete;
+};
+
+} // namespace Sage
+#endif // _CShardedValues_H_
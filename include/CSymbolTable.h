@@ -0,0 +1,563 @@
+// This file copyright(c) 2021 Rob Nelson, All Rights Reserved.    E-mail rob@projectsagebox.com for more information.
+//
+
+#pragma once
+#if !defined(_CSymbolTable_H_)
+#define _CSymbolTable_H_
+
+#include "CToken.h"
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <vector>
+#include <mutex>
+#include <shared_mutex>
+#include <unordered_map>
+#include <unordered_set>
+
+namespace Sage
+{
+
+// ----------------------
+// Scoped symbol tables
+// ----------------------
+//
+// The script compiler's variables (CVars), functions (CFunc) and type names (CVarTypeBase) are kept in linked lists, so each
+// name reference is a search of every list it could be in -- with thousands of globals and functions, compiling a script is
+// quadratic.  The classes here replace the searches:
+//
+//      CSymbolNames        Interned names: each distinct name is stored once, so a name is identified by its pointer.
+//      CSymbolScope<T>     One scope's symbols, hashed by interned name, with a parent scope searched when a name isn't
+//                          found -- i.e. block -> function -> globals.  A name can have more than one symbol (overloads),
+//                          kept in the order they were added.
+//      CCompilerSymbols    The tables for one compilation -- vars, functions, type names and overloads -- kept beside the
+//                          CVars, CFunc and CVarTypeBase objects (which are built into the library, so they can't hold them).
+//
+// A lookup hashes the name once (to find its interned pointer), then is one probe per scope, so it's O(1) on average no
+// matter how many symbols there are.  A name that was never interned can't be in any scope, so it fails after the hash.
+//
+//      CSymbolNames cNames;
+//      CSymbolScope<stVARSTRUCT> cGlobals(cNames);
+//      CSymbolScope<stVARSTRUCT> cLocals(cNames,&cGlobals);
+//
+//      cGlobals.Add("iCount",stVar);
+//      auto stFound = cLocals.Find("iCount");      // Not in cLocals, found in cGlobals
+//
+
+// CSymbolNames -- Name interner
+//
+// Intern() returns the stored copy of a name, the same pointer for every call with the same name.  Names are kept until the
+// CSymbolNames object is deleted (or Clear() is called), so it should live as long as the scopes using it -- i.e. one per
+// compilation, as in CCompilerSymbols.  With bCaseSensitive = false, names that differ only in case are the same name (the
+// first spelling is the one kept).
+//
+// Intern() and Find() can be called from any thread.
+//
+class CSymbolNames
+{
+    struct Slot_t
+    {
+        const char * sName;
+        unsigned int uHash;
+        int iLength;
+    };
+
+    static constexpr size_t kBlockBytes = 64*1024;
+
+    bool m_bCaseSensitive;
+    std::vector<Slot_t> m_vSlots;
+    int m_iCount = 0;
+
+    std::vector<std::unique_ptr<char[]>> m_vBlocks;
+    char * m_pPos   = nullptr;
+    size_t m_uLeft  = 0;
+
+    mutable std::shared_mutex m_mLock;
+
+    static char Upper(char c) { return c >= 'a' && c <= 'z' ? (char) (c - 'a' + 'A') : c; }
+
+    unsigned int Hash(const char * sName,int iLength) const
+    {
+        unsigned int uHash = 2166136261u;
+        if (m_bCaseSensitive) for (int i=0;i<iLength;i++) uHash = (uHash ^ (unsigned char) sName[i])*16777619u;
+        else for (int i=0;i<iLength;i++) uHash = (uHash ^ (unsigned char) Upper(sName[i]))*16777619u;
+        return uHash;
+    }
+
+    bool Equal(const Slot_t & stSlot,const char * sName,int iLength,unsigned int uHash) const
+    {
+        if (stSlot.uHash != uHash || stSlot.iLength != iLength) return false;
+        if (m_bCaseSensitive) return !memcmp(stSlot.sName,sName,iLength);
+        for (int i=0;i<iLength;i++) if (Upper(stSlot.sName[i]) != Upper(sName[i])) return false;
+        return true;
+    }
+
+    const Slot_t * FindSlot(const char * sName,int iLength,unsigned int uHash) const
+    {
+        if (m_vSlots.empty()) return nullptr;
+        size_t uMask = m_vSlots.size() - 1;
+        for (size_t i = uHash & uMask;;i = (i + 1) & uMask)
+        {
+            auto & stSlot = m_vSlots[i];
+            if (!stSlot.sName) return nullptr;
+            if (Equal(stSlot,sName,iLength,uHash)) return &stSlot;
+        }
+    }
+
+    void Insert(const Slot_t & stNew)
+    {
+        size_t uMask = m_vSlots.size() - 1;
+        size_t i = stNew.uHash & uMask;
+        while (m_vSlots[i].sName) i = (i + 1) & uMask;
+        m_vSlots[i] = stNew;
+    }
+
+    void Grow()
+    {
+        std::vector<Slot_t> vOld;
+        vOld.swap(m_vSlots);
+        m_vSlots.resize(vOld.empty() ? 256 : vOld.size()*2,Slot_t{});
+        for (auto & stSlot : vOld) if (stSlot.sName) Insert(stSlot);
+    }
+
+    const char * Store(const char * sName,int iLength)
+    {
+        size_t uBytes = (size_t) iLength + 1;
+        if (uBytes > m_uLeft)
+        {
+            size_t uSize = uBytes > kBlockBytes ? uBytes : kBlockBytes;
+            m_vBlocks.push_back(std::make_unique<char[]>(uSize));
+            m_pPos  = m_vBlocks.back().get();
+            m_uLeft = uSize;
+        }
+        char * sCopy = m_pPos;
+        memcpy(sCopy,sName,iLength);
+        sCopy[iLength] = 0;
+        m_pPos  += uBytes;
+        m_uLeft -= uBytes;
+        return sCopy;
+    }
+
+public:
+    CSymbolNames(bool bCaseSensitive = true) : m_bCaseSensitive(bCaseSensitive) { }
+    CSymbolNames(const CSymbolNames &) = delete;
+    CSymbolNames & operator = (const CSymbolNames &) = delete;
+
+    /// <summary>
+    /// Returns the interned copy of sName (iLength characters, or up to the terminating 0 when iLength is -1), adding it if
+    /// it isn't there.  Returns nullptr for a nullptr name.
+    /// </summary>
+    const char * Intern(const char * sName,int iLength = -1)
+    {
+        if (!sName) return nullptr;
+        if (iLength < 0) iLength = (int) strlen(sName);
+        unsigned int uHash = Hash(sName,iLength);
+
+        {
+            std::shared_lock<std::shared_mutex> lock(m_mLock);
+            if (auto pSlot = FindSlot(sName,iLength,uHash)) return pSlot->sName;
+        }
+
+        std::unique_lock<std::shared_mutex> lock(m_mLock);
+        if (auto pSlot = FindSlot(sName,iLength,uHash)) return pSlot->sName;        // Added by another thread
+
+        if ((size_t) (m_iCount + 1)*4 > m_vSlots.size()*3) Grow();
+        Slot_t stSlot{ Store(sName,iLength),uHash,iLength };
+        Insert(stSlot);
+        m_iCount++;
+        return stSlot.sName;
+    }
+
+    /// <summary>
+    /// Returns the interned copy of sName, or nullptr if the name has never been interned (so it isn't in any scope).
+    /// </summary>
+    const char * Find(const char * sName,int iLength = -1) const
+    {
+        if (!sName) return nullptr;
+        if (iLength < 0) iLength = (int) strlen(sName);
+        unsigned int uHash = Hash(sName,iLength);
+
+        std::shared_lock<std::shared_mutex> lock(m_mLock);
+        auto pSlot = FindSlot(sName,iLength,uHash);
+        return pSlot ? pSlot->sName : nullptr;
+    }
+
+    /// <summary>
+    /// Frees all names.  Pointers returned by Intern() are no longer valid, so scopes using the names must be cleared too.
+    /// </summary>
+    void Clear()
+    {
+        std::unique_lock<std::shared_mutex> lock(m_mLock);
+        m_vSlots.clear();
+        m_vBlocks.clear();
+        m_pPos      = nullptr;
+        m_uLeft     = 0;
+        m_iCount    = 0;
+    }
+
+    bool isCaseSensitive() const { return m_bCaseSensitive; }
+
+    int GetCount() const
+    {
+        std::shared_lock<std::shared_mutex> lock(m_mLock);
+        return m_iCount;
+    }
+};
+
+// CSymbolScope<T> -- The symbols (T *) of one scope, hashed by interned name, with an optional parent scope
+//
+// Notes:
+//
+//      1. The scope doesn't own its symbols -- they stay in (and are freed with) the lists they are already in.
+//      2. Find() searches this scope, then each parent in turn, and returns the first symbol added under the name in the
+//         nearest scope that has it (the same symbol a search of the linked lists in declaration order finds).
+//      3. The parent must exist as long as the scope uses it.  A scope is used by one thread at a time.
+//      4. A parent can use a different CSymbolNames (i.e. case-insensitive) -- the name is looked up in each scope's own names.
+//
+template<typename T>
+class CSymbolScope
+{
+    struct Slot_t
+    {
+        const char * sName;             // Interned name, or nullptr for an empty slot
+        std::vector<T *> vSymbols;      // Symbols added with the name, in order (empty once they've all been removed)
+    };
+
+    CSymbolNames * m_pNames;
+    CSymbolScope * m_pParent;
+    std::vector<Slot_t> m_vSlots;
+    int m_iNames    = 0;                // Names with a slot (including those whose symbols were all removed)
+    int m_iSymbols  = 0;
+
+    static size_t HashName(const char * sName)
+    {
+        auto uValue = (unsigned long long) (uintptr_t) sName;
+        uValue ^= uValue >> 29;
+        uValue *= 0xbf58476d1ce4e5b9ull;
+        return (size_t) (uValue ^ (uValue >> 32));
+    }
+
+    Slot_t * FindSlot(const char * sName)
+    {
+        if (!sName || m_vSlots.empty()) return nullptr;
+        size_t uMask = m_vSlots.size() - 1;
+        for (size_t i = HashName(sName) & uMask;;i = (i + 1) & uMask)
+        {
+            auto & stSlot = m_vSlots[i];
+            if (stSlot.sName == sName) return &stSlot;
+            if (!stSlot.sName) return nullptr;
+        }
+    }
+
+    Slot_t & AddSlot(const char * sName)
+    {
+        if ((size_t) (m_iNames + 1)*4 > m_vSlots.size()*3)
+        {
+            std::vector<Slot_t> vOld;
+            vOld.swap(m_vSlots);
+            m_vSlots.resize(vOld.empty() ? 16 : vOld.size()*2);
+            for (auto & stOld : vOld) if (stOld.sName) PlaceSlot(stOld.sName) = std::move(stOld);
+        }
+        auto & stSlot = PlaceSlot(sName);
+        stSlot.sName = sName;
+        m_iNames++;
+        return stSlot;
+    }
+
+    Slot_t & PlaceSlot(const char * sName)
+    {
+        size_t uMask = m_vSlots.size() - 1;
+        size_t i = HashName(sName) & uMask;
+        while (m_vSlots[i].sName) i = (i + 1) & uMask;
+        return m_vSlots[i];
+    }
+
+    const char * Lookup(const char * sName) const { return m_pNames->Find(sName); }
+
+public:
+    CSymbolScope(CSymbolNames & cNames,CSymbolScope * pParent = nullptr) : m_pNames(&cNames), m_pParent(pParent) { }
+
+    void SetParent(CSymbolScope * pParent) { m_pParent = pParent; }
+    CSymbolScope * GetParent() const { return m_pParent; }
+    CSymbolNames & GetNames() const { return *m_pNames; }
+
+    /// <summary>
+    /// Adds pSymbol under sName in this scope.  If the name already has symbols here, pSymbol is added after them (an overload).
+    /// </summary>
+    void Add(const char * sName,T * pSymbol)
+    {
+        const char * sInterned = m_pNames->Intern(sName);
+        if (!sInterned || !pSymbol) return;
+
+        auto pSlot = FindSlot(sInterned);
+        (pSlot ? *pSlot : AddSlot(sInterned)).vSymbols.push_back(pSymbol);
+        m_iSymbols++;
+    }
+
+    /// <summary>
+    /// Removes pSymbol from sName in this scope.  Returns false if it wasn't there.
+    /// </summary>
+    bool Remove(const char * sName,T * pSymbol)
+    {
+        auto pSlot = FindSlot(Lookup(sName));
+        if (!pSlot) return false;
+
+        auto & vSymbols = pSlot->vSymbols;
+        for (size_t i=0;i<vSymbols.size();i++)
+        {
+            if (vSymbols[i] == pSymbol)
+            {
+                vSymbols.erase(vSymbols.begin() + i);
+                m_iSymbols--;
+                return true;
+            }
+        }
+        return false;
+    }
+
+    /// <summary>
+    /// Returns the first symbol named sName in this scope only, or nullptr.
+    /// </summary>
+    T * FindLocal(const char * sName)
+    {
+        auto pSlot = FindSlot(Lookup(sName));
+        return pSlot && !pSlot->vSymbols.empty() ? pSlot->vSymbols.front() : nullptr;
+    }
+
+    /// <summary>
+    /// Returns the first symbol named sName in the nearest scope that has one (this scope, then its parents), or nullptr.
+    /// </summary>
+    T * Find(const char * sName)
+    {
+        auto pAll = FindAll(sName);
+        return pAll ? pAll->front() : nullptr;
+    }
+
+    /// <summary>
+    /// Returns all symbols named sName (i.e. overloads) in the nearest scope that has one, in the order they were added, or
+    /// nullptr if there are none.
+    /// </summary>
+    const std::vector<T *> * FindAll(const char * sName)
+    {
+        // A name missing from this scope's names may still be in a parent's (different) names, so the search goes on
+
+        const char * sInterned = Lookup(sName);
+
+        for (auto pScope = this;pScope;pScope = pScope->m_pParent)
+        {
+            auto pSlot = pScope->m_pNames == m_pNames ? pScope->FindSlot(sInterned) : pScope->FindSlot(pScope->Lookup(sName));
+            if (pSlot && !pSlot->vSymbols.empty()) return &pSlot->vSymbols;
+        }
+        return nullptr;
+    }
+
+    /// <summary>
+    /// Returns the symbol named sName added after pCurrent (the next overload), or nullptr if pCurrent is the last one.
+    /// </summary>
+    T * FindNext(const char * sName,T * pCurrent)
+    {
+        for (auto pScope = this;pScope;pScope = pScope->m_pParent)
+        {
+            auto pSlot = pScope->FindSlot(pScope->Lookup(sName));
+            if (!pSlot) continue;
+
+            auto & vSymbols = pSlot->vSymbols;
+            for (size_t i=0;i<vSymbols.size();i++) if (vSymbols[i] == pCurrent) return i + 1 < vSymbols.size() ? vSymbols[i + 1] : nullptr;
+        }
+        return nullptr;
+    }
+
+    void Clear()
+    {
+        m_vSlots.clear();
+        m_iNames    = 0;
+        m_iSymbols  = 0;
+    }
+
+    // Number of symbols in this scope (not including parents)
+
+    int GetCount() const { return m_iSymbols; }
+};
+
+// CCompilerSymbols -- The hashed symbol tables for one compilation
+//
+// CVars::FindVar(), CFunc::FindFunc() and CVarTypeBase::isVarType() search linked lists.  The compiler owns a CCompilerSymbols
+// for the length of a compilation and declares through it, so each declaration is also indexed, then looks names up with it:
+//
+//      CCompilerSymbols cSymbols(bCaseSensitive);
+//
+//      cSymbols.AddVar(*cVars,sName,sOrgName,iTypeIndex);      // CVars::AddVar(), then indexes the new var
+//      auto stVar = cSymbols.FindVar(cVars,sName);             // cVars, then stPreviousCvar, and so on to cGlobals
+//      cSymbols.DeleteVars(*cVars,iCount);                     // Unindexes the last iCount vars, then CVars::DeleteVars()
+//
+//      cSymbols.AddFunc(cFunc);                                // Once the function's name is set
+//      auto cFound = cSymbols.FindFunc(sName);                 // FindNextFunc(cFound) for the next overload
+//
+// Notes:
+//
+//      1. Names are freed with the CCompilerSymbols (or Clear()).  It holds pointers to the compiler's objects without owning
+//         them, so when a CVars or CFunc is deleted before the compilation ends, call RemoveVars() or RemoveFunc() for it first.
+//      2. Vars and functions are matched by their processed names (spName), with case.  Type names use the case sensitivity
+//         given to the constructor, which should be the CVarTypeBase's (false for Pascal, true for C).
+//      3. AddVar() indexes the var CVars::AddVar() leaves in stCurrent (the one FillVarData() fills in).  Vars, types and
+//         functions added some other way (i.e. CVars::DeclareGlobalString()) can be indexed with IndexVar(), IndexVarType()
+//         and AddFunc().
+//      4. A CCompilerSymbols is used by one thread at a time, as are the compiler objects.
+//
+class CCompilerSymbols
+{
+    struct VarScope_t
+    {
+        std::unique_ptr<CSymbolScope<stVARSTRUCT>> cScope;
+        std::vector<stVARSTRUCT *> vVars;                                       // In the order added, for DeleteVars()
+    };
+
+    CSymbolNames m_cNames;                                                      // Var and function names
+    CSymbolNames m_cTypeNames;
+    CSymbolScope<CFunc> m_cFuncs;
+    CSymbolScope<stVARTYPE> m_cTypes;
+
+    std::unordered_map<const CVars *,VarScope_t> m_mVarScopes;
+    std::unordered_map<unsigned long long,stOVERLOADS *> m_mOverloads;          // First overload added for each key
+    std::unordered_set<const stOVERLOADS *> m_sOverloads;                      // Overloads already indexed
+
+    static const char * SymbolName(const stVARSTRUCT * stVar) { return stVar->spName ? stVar->spName : stVar->sName; }
+    static const char * SymbolName(const CFunc * cFunc) { return cFunc->spName ? cFunc->spName : cFunc->sName; }
+
+    static unsigned long long OverloadKey(int iSourceType,int iSourcePointerDepth,eNODETYPE eNodeType,int iOverloadType,int iOverloadPointerDepth)
+    {
+        return (unsigned long long) (unsigned int) iSourceType << 40 | (unsigned long long) (iSourcePointerDepth & 0xff) << 32 |
+               (unsigned long long) (eNodeType & 0xff) << 24 | (unsigned long long) (iOverloadType & 0xffff) << 8 | (iOverloadPointerDepth & 0xff);
+    }
+
+    // The scope for cVars, created (with its parent scopes) the first time it is needed
+
+    VarScope_t & GetVarScope(CVars & cVars)
+    {
+        auto & stScope = m_mVarScopes[&cVars];
+        if (!stScope.cScope)
+        {
+            auto cParent = cVars.stPreviousCvar ? cVars.stPreviousCvar : (cVars.cGlobals != &cVars ? cVars.cGlobals : nullptr);
+            stScope.cScope = std::make_unique<CSymbolScope<stVARSTRUCT>>(m_cNames,cParent ? GetVarScope(*cParent).cScope.get() : nullptr);
+        }
+        return stScope;
+    }
+
+public:
+    CCompilerSymbols(bool bCaseSensitive) : m_cNames(true), m_cTypeNames(bCaseSensitive), m_cFuncs(m_cNames), m_cTypes(m_cTypeNames) { }
+
+    /// <summary>
+    /// Calls cVars.AddVar() and indexes the new var.
+    /// </summary>
+    void AddVar(CVars & cVars,char * sName,char * sOrgName,int iTypeIndex = 0,int iArraySize = 0,int iPointerDepth = 0,
+                int iDecLineNo = 0,stCODEBLOCK * stCodeBlock = nullptr)
+    {
+        cVars.AddVar(sName,sOrgName,iTypeIndex,iArraySize,iPointerDepth,iDecLineNo,stCodeBlock);
+        IndexVar(cVars,cVars.stCurrent);
+    }
+
+    void IndexVar(CVars & cVars,stVARSTRUCT * stVar)
+    {
+        if (!stVar) return;
+        auto & stScope = GetVarScope(cVars);
+        stScope.cScope->Add(SymbolName(stVar),stVar);
+        stScope.vVars.push_back(stVar);
+    }
+
+    /// <summary>
+    /// Unindexes the last iNumtoDelete vars added to cVars, then calls cVars.DeleteVars().
+    /// </summary>
+    void DeleteVars(CVars & cVars,int iNumtoDelete)
+    {
+        auto & stScope = GetVarScope(cVars);
+        for (int i=0;i<iNumtoDelete && !stScope.vVars.empty();i++)
+        {
+            auto stVar = stScope.vVars.back();
+            stScope.cScope->Remove(SymbolName(stVar),stVar);
+            stScope.vVars.pop_back();
+        }
+        cVars.DeleteVars(iNumtoDelete);
+    }
+
+    /// <summary>
+    /// Returns the var named sVarName in cThis, or the nearest of its parents that has one (as CVars::FindVar()), or nullptr.
+    /// </summary>
+    stVARSTRUCT * FindVar(CVars * cThis,const char * sVarName) { return cThis ? GetVarScope(*cThis).cScope->Find(sVarName) : nullptr; }
+
+    /// <summary>
+    /// Drops the scope for cVars (before cVars is deleted).  Scopes of CVars that use it as a parent must be removed first.
+    /// </summary>
+    void RemoveVars(const CVars * cVars) { m_mVarScopes.erase(cVars); }
+
+    void AddFunc(CFunc * cFunc) { if (cFunc) m_cFuncs.Add(SymbolName(cFunc),cFunc); }
+    void RemoveFunc(CFunc * cFunc) { if (cFunc) m_cFuncs.Remove(SymbolName(cFunc),cFunc); }
+
+    // FindFunc() -- the first function added with the name; FindNextFunc() -- the next function with cFunc's name (an overload)
+
+    CFunc * FindFunc(const char * sFunc) { return m_cFuncs.Find(sFunc); }
+    CFunc * FindNextFunc(CFunc * cFunc) { return cFunc ? m_cFuncs.FindNext(SymbolName(cFunc),cFunc) : nullptr; }
+
+    /// <summary>
+    /// Calls cVarTypeBase.AddVarType() and indexes each name of the new type.  Returns what AddVarType() returns.
+    /// </summary>
+    int AddVarType(CVarTypeBase & cVarTypeBase,char * sVarName,int iWidth,bool bSigned,int iPointerDepth,stARRAYDATA * stArrayData,int bStrict = 0)
+    {
+        int iType = cVarTypeBase.AddVarType(sVarName,iWidth,bSigned,iPointerDepth,stArrayData,bStrict);
+        IndexVarType(cVarTypeBase.GetVarType(iType));
+        return iType;
+    }
+
+    void IndexVarType(stVARTYPE * stVarType)
+    {
+        if (!stVarType) return;
+        for (auto stName = &stVarType->stVarNameList;stName;stName = stName->stNext) m_cTypes.Add(stName->spName ? stName->spName : stName->sName,stVarType);
+    }
+
+    stVARTYPE * FindVarType(const char * sVarString) { return m_cTypes.Find(sVarString); }
+
+    /// <summary>
+    /// Calls cVarTypeBase.AddOverload() and indexes the source type's new overloads.  Returns what AddOverload() returns.
+    /// </summary>
+    int AddOverload(CVarTypeBase & cVarTypeBase,int iSourceType,int iSourcePointerDepth,eNODETYPE eNodeType,char * sType,
+                    char * sReturnType,COverload * * cOverload)
+    {
+        int iResult = cVarTypeBase.AddOverload(iSourceType,iSourcePointerDepth,eNodeType,sType,sReturnType,cOverload);
+        IndexOverloads(iSourceType,cVarTypeBase.GetVarType(iSourceType));
+        return iResult;
+    }
+
+    void IndexOverloads(int iSourceType,stVARTYPE * stVarType)
+    {
+        if (!stVarType) return;
+        for (auto stOverload = stVarType->stOverloads;stOverload;stOverload = stOverload->stNext)
+        {
+            if (!m_sOverloads.insert(stOverload).second) continue;
+            m_mOverloads.emplace(OverloadKey(iSourceType,stOverload->iSourcePointerDepth,stOverload->eOpNodeType,stOverload->iOverloadType,
+                                             stOverload->iOverloadPointerDepth),stOverload);
+        }
+    }
+
+    stOVERLOADS * FindOverload(int iSourceType,int iSourcePointerDepth,eNODETYPE eNodeType,int iOverloadType,int iOverloadPointerDepth)
+    {
+        auto it = m_mOverloads.find(OverloadKey(iSourceType,iSourcePointerDepth,eNodeType,iOverloadType,iOverloadPointerDepth));
+        return it != m_mOverloads.end() ? it->second : nullptr;
+    }
+
+    /// <summary>
+    /// Drops all tables and frees the names (i.e. between compilations).
+    /// </summary>
+    void Clear()
+    {
+        m_mVarScopes.clear();
+        m_cFuncs.Clear();
+        m_cTypes.Clear();
+        m_mOverloads.clear();
+        m_sOverloads.clear();
+        m_cNames.Clear();
+        m_cTypeNames.Clear();
+    }
+};
+
+} // namespace Sage
+#endif // _CSymbolTable_H_
@@ -0,0 +1,161 @@
+// This file copyright(c) 2021 Rob Nelson, All Rights Reserved.    E-mail rob@projectsagebox.com for more information.
+//
+
+#pragma once
+#if !defined(_CThreadPool_H_)
+#define _CThreadPool_H_
+
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include <functional>
+#include <vector>
+
+namespace Sage
+{
+
+// CThreadPool -- Simple persistent worker pool for splitting image and array work across cores
+//
+// The pool runs one job at a time.  A job is a number of tasks (i.e. bands of rows) and a function called for each task:
+//
+//      CThreadPool::GetDefault().ParallelFor(iBands,[&](int iTask,int iThread) { ProcessBand(iTask,vScratch[iThread]); });
+//
+// Tasks are handed out dynamically (an atomic counter), so uneven tasks balance themselves.  The calling thread works on
+// tasks too, and ParallelFor() returns when all tasks are done.
+//
+// iThread is 0 for the calling thread and 1 to GetThreads()-1 for workers, so it can be used to index per-thread scratch
+// buffers allocated once up front (see GetThreads()).
+//
+// Notes:
+//
+//      1. ParallelFor() called from inside a task (i.e. nested) runs the nested tasks on the calling thread rather than deadlocking.
+//      2. Multiple threads may call ParallelFor() on the same pool -- jobs are run one after the other.
+//      3. The threads are created when the pool is created and sleep between jobs.  GetDefault() creates one pool for the process,
+//         sized to the number of cores, the first time it is used.
+//
+class CThreadPool
+{
+    std::vector<std::thread> m_vThreads;
+
+    std::mutex m_mJob;                      // Serializes ParallelFor() callers
+    std::mutex m_mLock;
+    std::condition_variable m_cvWork;
+    std::condition_variable m_cvDone;
+
+    const std::function<void(int,int)> * m_fnTask = nullptr;
+    std::atomic<int> m_iNextTask{0};
+    int m_iTasks        = 0;
+    int m_iMaxThreads   = 0;                // Threads allowed to work on the current job (including the caller)
+    int m_iBusy         = 0;                // Workers still in the current job
+    unsigned int m_uJob = 0;                // Incremented for each job so workers know there's new work
+    bool m_bExit        = false;
+
+    static inline thread_local bool m_bInTask = false;
+
+    void RunTasks(int iThread)
+    {
+        m_bInTask = true;
+        for (int iTask;(iTask = m_iNextTask.fetch_add(1)) < m_iTasks;) (*m_fnTask)(iTask,iThread);
+        m_bInTask = false;
+    }
+
+    void Worker(int iThread)
+    {
+        unsigned int uLastJob = 0;
+        for (;;)
+        {
+            {
+                std::unique_lock<std::mutex> lock(m_mLock);
+                m_cvWork.wait(lock,[&] { return m_bExit || m_uJob != uLastJob; });
+                if (m_bExit) return;
+                uLastJob = m_uJob;
+            }
+
+            if (iThread < m_iMaxThreads) RunTasks(iThread);
+
+            std::lock_guard<std::mutex> lock(m_mLock);
+            if (!--m_iBusy) m_cvDone.notify_one();
+        }
+    }
+
+public:
+    /// <summary>
+    /// Creates a pool with iThreads total threads (including the thread calling ParallelFor()).  0 = one per core.
+    /// </summary>
+    CThreadPool(int iThreads = 0)
+    {
+        if (iThreads <= 0) iThreads = (int) std::thread::hardware_concurrency();
+        if (iThreads <= 0) iThreads = 1;
+        for (int i=1;i<iThreads;i++) m_vThreads.emplace_back([this,i] { Worker(i); });
+    }
+
+    ~CThreadPool()
+    {
+        {
+            std::lock_guard<std::mutex> lock(m_mLock);
+            m_bExit = true;
+        }
+        m_cvWork.notify_all();
+        for (auto & cThread : m_vThreads) cThread.join();
+    }
+
+    CThreadPool(const CThreadPool &) = delete;
+    CThreadPool & operator = (const CThreadPool &) = delete;
+
+    /// <summary>
+    /// Returns the number of threads that can work on a job, including the calling thread.  iThread values passed to tasks are
+    /// 0 to GetThreads()-1.
+    /// </summary>
+    int GetThreads() const { return (int) m_vThreads.size() + 1; }
+
+    /// <summary>
+    /// Calls fnTask(iTask,iThread) for iTask = 0 to iTasks-1 across the pool, returning when all tasks have completed.
+    /// </summary>
+    /// <param name="iTasks"> - Number of tasks</param>
+    /// <param name="fnTask"> - Function called for each task.  iThread is 0 to GetThreads()-1 (0 is the calling thread)</param>
+    /// <param name="iMaxThreads"> - [optional] Maximum threads to use (including the caller).  0 = all threads in the pool.</param>
+    void ParallelFor(int iTasks,const std::function<void(int iTask,int iThread)> & fnTask,int iMaxThreads = 0)
+    {
+        if (iTasks <= 0) return;
+        if (iMaxThreads <= 0 || iMaxThreads > GetThreads()) iMaxThreads = GetThreads();
+
+        // Single thread, single task, or nested -- just run it here.
+
+        if (iMaxThreads == 1 || iTasks == 1 || m_bInTask)
+        {
+            for (int i=0;i<iTasks;i++) fnTask(i,0);
+            return;
+        }
+
+        std::lock_guard<std::mutex> jobLock(m_mJob);
+        {
+            std::lock_guard<std::mutex> lock(m_mLock);
+            m_fnTask        = &fnTask;
+            m_iTasks        = iTasks;
+            m_iMaxThreads   = iMaxThreads;
+            m_iNextTask     = 0;
+            m_iBusy         = (int) m_vThreads.size();
+            m_uJob++;
+        }
+        m_cvWork.notify_all();
+
+        RunTasks(0);
+
+        std::unique_lock<std::mutex> lock(m_mLock);
+        m_cvDone.wait(lock,[&] { return !m_iBusy; });
+        m_fnTask = nullptr;
+    }
+
+    /// <summary>
+    /// Returns the process-wide pool (one thread per core), creating it on first use.
+    /// </summary>
+    static CThreadPool & GetDefault()
+    {
+        static CThreadPool cPool;
+        return cPool;
+    }
+};
+
+} // namespace Sage
+#endif // _CThreadPool_H_
@@ -18,6 +18,7 @@
 #include <cstdio>
 #include <stdlib.h>
 #include <memory>
+#include "CNodeArena.h"
 //#pragma warning( disable : 4996) 
 
 namespace Sage
@@ -32,9 +33,93 @@ extern int gMessagesOff;
 const int TokenInsert_File   = 1;
 const int TokenInsert_Define = 2;
 
+enum TokenType
+{
+	tNULL=0, 
+	tAdd, 
+	tMul, 
+	tSub, 
+ 	tDiv, 
+	tAnd, 
+	tOr, 
+	tVar,
+	tFunc,
+	tNum, 
+	tFloat,
+	tlogAnd, 
+	tlogOr, 
+	txor,
+	tMod,
+	tneg,
+	tlparen, 
+	trparen, 
+	tLineDelimit,
+	tVarDelim,	// Only used with Pascal, I think, i.e. var : Integer;
+	tDelimExpr,
+	tAssign,
+	tPtr,
+	tTakeAddress,
+// Comparison operator tokens
+
+	tNot,
+	tEqualto,
+	tGreaterThan,
+	tLessThan,
+	tPlusEqual,
+	tNotEqualto,
+	tLessThanEqual,
+	tGreaterThanEqual,
+	tAddr,
+	tComma,
+	tColon,
+	tClass,
+	tEOF,
+	tBad,
+
+	tInt,
+	tWord,
+	tLong,
+	tChar,
+	tUnsigned,
+	
+// Web-driver tokens
+
+	tVarDecl,
+	tProcedureDecl,
+	tFunctionDecl,
+	tOverload,
+	tThreadDecl,
+	tBegin,
+	tReturn,
+	tIf,
+	tThen,
+	tElse,
+	tFor,
+	tRepeat,
+	tUntil,
+	tTo,
+	tDo,
+	tStep,
+	tStopCompile,
+	tEnd,
+
+	tInclude,		// Differs from Relaxed Pascal to Pascal or C.. i.e. C= #include (not sure what
+					// Pascal Does), RPascal is just "include". 
+
+
+	tBreakCompile,
+	tLiteral,
+	tStopCalc,			// Used to stop the parser cold. 
+
+	tTypeArithOps = 0x1000,
+	tTypeLogicalOps,
+	tTypeValueTokens,
+	tTypeUnaryPrefixOps,
+};
+
 struct stTOKENOPERATORLOOKUP
 { 
-	char * sToken;
+	const char * sToken;
 	enum	TokenType eToken;
 }; 
 struct TokenInsert_t
@@ -60,7 +145,7 @@ struct MultiWordTokens_t
 {
 	enum TokenType eSourceToken; 
 	enum TokenType eDestToken; 
-	char * sString;
+	const char * sString;
 };
 
 
@@ -255,96 +340,13 @@ union suTOKENDATA
 };
 
 
-enum TokenType
-{
-	tNULL=0, 
-	tAdd, 
-	tMul, 
-	tSub, 
- 	tDiv, 
-	tAnd, 
-	tOr, 
-	tVar,
-	tFunc,
-	tNum, 
-	tFloat,
-	tlogAnd, 
-	tlogOr, 
-	txor,
-	tMod,
-	tneg,
-	tlparen, 
-	trparen, 
-	tLineDelimit,
-	tVarDelim,	// Only used with Pascal, I think, i.e. var : Integer;
-	tDelimExpr,
-	tAssign,
-	tPtr,
-	tTakeAddress,
-// Comparison operator tokens
-
-	tNot,
-	tEqualto,
-	tGreaterThan,
-	tLessThan,
-	tPlusEqual,
-	tNotEqualto,
-	tLessThanEqual,
-	tGreaterThanEqual,
-	tAddr,
-	tComma,
-	tColon,
-	tClass,
-	tEOF,
-	tBad,
-
-	tInt,
-	tWord,
-	tLong,
-	tChar,
-	tUnsigned,
-	
-// Web-driver tokens
-
-	tVarDecl,
-	tProcedureDecl,
-	tFunctionDecl,
-	tOverload,
-	tThreadDecl,
-	tBegin,
-	tReturn,
-	tIf,
-	tThen,
-	tElse,
-	tFor,
-	tRepeat,
-	tUntil,
-	tTo,
-	tDo,
-	tStep,
-	tStopCompile,
-	tEnd,
-
-	tInclude,		// Differs from Relaxed Pascal to Pascal or C.. i.e. C= #include (not sure what
-					// Pascal Does), RPascal is just "include". 
-
-
-	tBreakCompile,
-	tLiteral,
-	tStopCalc,			// Used to stop the parser cold. 
-
-	tTypeArithOps = 0x1000,
-	tTypeLogicalOps,
-	tTypeValueTokens,
-	tTypeUnaryPrefixOps,
-};
 const struct MultiWordTokens_t stMultiWordTokens[] = 
 {
 	tOr,tlogOr,"IF",
 	tAnd,tlogAnd,"IF",
 	tNULL,tNULL,NULL
 };
-const struct stTOKENOPERATORLOOKUP stTokenAlphaLookup[] = 
+constexpr struct stTOKENOPERATORLOOKUP stTokenAlphaLookup[] = 
 {
 	"!VAR",tVarDecl,
 	"!VARS",tVarDecl,
@@ -385,7 +387,7 @@ const struct stTOKENOPERATORLOOKUP stTokenAlphaLookup[] =
 	NULL,tNULL
 };
 
-const struct stTOKENOPERATORLOOKUP stTokenOperatorLookup[] = {
+constexpr struct stTOKENOPERATORLOOKUP stTokenOperatorLookup[] = {
 	"-",tSub,
 	"+",tAdd,
 	"*",tMul,
@@ -640,6 +642,23 @@ public:
 
 	stNODE * CreateNode();
 
+	// AllocNode(), AllocNodeData() -- Zeroed node memory for CreateNode() and the parser: from the thread's current CNodeArena
+	// when there is one (so the whole tree is freed with the arena -- see CNodeArena.h), otherwise from the heap.
+	// FreeNode()/FreeNodeData() free heap nodes only; nodes from an arena (CNodeArena::Owns()) are left for the arena, in or out of its scope.
+
+	static stNODE * AllocNode()
+	{
+		auto pArena = CNodeArena::GetCurrent();
+		return pArena ? pArena->New<stNODE>() : (stNODE *) calloc(1,sizeof(stNODE));
+	}
+	static stNODEDATA * AllocNodeData()
+	{
+		auto pArena = CNodeArena::GetCurrent();
+		return pArena ? pArena->New<stNODEDATA>() : (stNODEDATA *) calloc(1,sizeof(stNODEDATA));
+	}
+	static void FreeNode(stNODE * stNode) { if (!CNodeArena::Owns(stNode)) free(stNode); }
+	static void FreeNodeData(stNODEDATA * stNodeData) { if (!CNodeArena::Owns(stNodeData)) free(stNodeData); }
+
 	stNODE * stMaster;
 	stNODE * stCurrent;
 	stNODE * stKey;			// Original tree
@@ -688,7 +707,7 @@ public:
 	//stNODEDATA * getNodeData() { return stNodeData; } 
 	stNODEDATA *  GetLiteralString();
 	CToken(char * sString,CVars * cMainVar=NULL);
-	int CToken::CheckforEmptyParens(void);
+	int CheckforEmptyParens(void);
 	void Reverse() { bReverse = 1; }
 	void SetVars(CVars * cMainVar) { cVar = cMainVar; }
 	void SetCodeBlock(CCodeBlock * cCodeBlock) { this->cCodeBlock = cCodeBlock; }
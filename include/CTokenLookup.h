@@ -0,0 +1,241 @@
+// This file copyright(c) 2021 Rob Nelson, All Rights Reserved.    E-mail rob@projectsagebox.com for more information.
+//
+
+#pragma once
+#if !defined(_CTokenLookup_H_)
+#define _CTokenLookup_H_
+
+#include "CToken.h"
+#include <cstddef>
+#include <cstring>
+
+namespace Sage
+{
+
+// ---------------------------------
+// Perfect-hash token lookup tables
+// ---------------------------------
+//
+// CToken resolves keywords and operators by comparing the token against each entry of stTokenAlphaLookup and
+// stTokenOperatorLookup in turn.  CTokenHash builds a perfect hash of a table instead -- every key has its own slot, found with
+// one hash -- so a lookup is one hash and at most one string compare, whether or not the token is in the table (most tokens in
+// a script are identifiers, which aren't).
+//
+// The default tables are built at compile time from stTokenAlphaLookup and stTokenOperatorLookup (CTokenLookup::GetAlpha() and
+// GetOperators()).  The alternate tables given to
+// CToken::SetAltTokens() can be built at run time with the same class:
+//
+//      CTokenHash<> cAltAlpha(stAltAlphaLookup,true);                      // Table ends with a NULL entry
+//      CTokenHash<> cAltOperators(stAltOperatorLookup,false,iAltOpSize);   // Table has iAltOpSize entries
+//
+// Keyword tables (bPrefixed = true) use the same convention as stTokenAlphaLookup: a leading '!' means the key is not
+// case-sensitive (i.e. "begin" or "BEGIN"), a leading '*' means it is case-sensitive.  Operator tables (bPrefixed = false)
+// have no prefix -- "!=" and "*" are operators -- and are matched exactly.
+//
+// Notes:
+//
+//      1. When a key is in a table more than once, the first entry is used, as with the linear search.
+//      2. If no perfect hash is found for a table, Find() searches it linearly, so results are always the same as CToken's
+//         search.  Tables larger than iMaxKeys need a larger iMaxKeys (only the first iMaxKeys keys are searched).
+//
+
+// TokenKey_t -- One key for CTokenHash, in the same form as stTOKENOPERATORLOOKUP
+
+struct TokenKey_t
+{
+    const char * sToken;
+    TokenType eToken;
+};
+
+template<int iMaxKeys = 64>
+class CTokenHash
+{
+public:
+    static constexpr int kMaxSlots = [] { int i = 1; while (i < iMaxKeys*4) i <<= 1; return i; }();
+    static constexpr unsigned int kMaxSeeds = 20000;
+
+private:
+    struct Slot_t
+    {
+        const char * sKey;          // Key without its '!' or '*', or nullptr for an empty slot
+        int iLength;
+        TokenType eToken;
+        bool bCaseSensitive;
+    };
+
+    Slot_t m_stSlots[kMaxSlots]{};
+    Slot_t m_stKeys[iMaxKeys]{};    // Keys in table order, for the linear search when there is no perfect hash
+    int m_iKeys         = 0;
+    unsigned int m_uMask = 0;
+    unsigned int m_uSeed = 0;
+    bool m_bPerfect     = false;
+
+    static constexpr char Upper(char c) { return c >= 'a' && c <= 'z' ? (char) (c - 'a' + 'A') : c; }
+
+    static constexpr bool Equal(const Slot_t & stSlot,const char * sToken,int iLength)
+    {
+        if (stSlot.iLength != iLength) return false;
+        for (int i=0;i<iLength;i++)
+        {
+            if (stSlot.bCaseSensitive ? stSlot.sKey[i] != sToken[i] : Upper(stSlot.sKey[i]) != Upper(sToken[i])) return false;
+        }
+        return true;
+    }
+
+    // Keys are hashed without case, so a case-insensitive key has the same slot however it is typed
+
+    static constexpr unsigned int Hash(const char * sKey,int iLength,unsigned int uSeed)
+    {
+        unsigned int uHash = 2166136261u ^ uSeed;
+        for (int i=0;i<iLength;i++) uHash = (uHash ^ (unsigned char) Upper(sKey[i]))*16777619u;
+        uHash ^= uHash >> 15;
+        uHash *= 0x2c1b3c6du;
+        uHash ^= uHash >> 12;
+        return uHash;
+    }
+
+    static constexpr int Length(const char * sKey) { int i = 0; while (sKey[i]) i++; return i; }
+
+    constexpr void AddKey(const char * sToken,TokenType eToken,bool bPrefixed)
+    {
+        Slot_t stKey{};
+        stKey.bCaseSensitive = !bPrefixed || *sToken != '!';
+        if (bPrefixed && (*sToken == '!' || *sToken == '*')) sToken++;
+        stKey.sKey      = sToken;
+        stKey.iLength   = Length(sToken);
+        stKey.eToken    = eToken;
+
+        for (int i=0;i<m_iKeys;i++) if (Equal(m_stKeys[i],stKey.sKey,stKey.iLength)) return;     // Duplicate -- the first one is used
+        if (m_iKeys < iMaxKeys) m_stKeys[m_iKeys] = stKey;
+        m_iKeys++;
+    }
+
+    constexpr bool TrySeed(unsigned int uSeed)
+    {
+        for (int i=0;i<=(int) m_uMask;i++) m_stSlots[i] = Slot_t{};
+        for (int i=0;i<m_iKeys;i++)
+        {
+            auto & stSlot = m_stSlots[Hash(m_stKeys[i].sKey,m_stKeys[i].iLength,uSeed) & m_uMask];
+            if (stSlot.sKey) return false;
+            stSlot = m_stKeys[i];
+        }
+        return true;
+    }
+
+    constexpr void Build()
+    {
+        if (m_iKeys > iMaxKeys) return;                 // Too many keys: Find() searches the first iMaxKeys, then reports tNULL
+
+        m_uMask = 1;
+        while ((int) m_uMask < m_iKeys*4 && (int) m_uMask < kMaxSlots) m_uMask <<= 1;
+        m_uMask--;
+
+        for (unsigned int uSeed=0;uSeed<kMaxSeeds;uSeed++)
+        {
+            if (TrySeed(uSeed))
+            {
+                m_uSeed = uSeed;
+                m_bPerfect = true;
+                return;
+            }
+        }
+    }
+
+public:
+    /// <summary>
+    /// Builds the table from an array of TokenKey_t with iKeys entries (bPrefixed is true for keyword tables, whose keys start
+    /// with '!' or '*').  This can be evaluated at compile time.
+    /// </summary>
+    constexpr CTokenHash(const TokenKey_t * stKeys,int iKeys,bool bPrefixed)
+    {
+        for (int i=0;i<iKeys && stKeys[i].sToken;i++) AddKey(stKeys[i].sToken,stKeys[i].eToken,bPrefixed);
+        Build();
+    }
+
+    template<int iKeys>
+    constexpr CTokenHash(const TokenKey_t (&stKeys)[iKeys],bool bPrefixed) : CTokenHash(stKeys,iKeys,bPrefixed) { }
+
+    /// <summary>
+    /// Builds the table from a stTOKENOPERATORLOOKUP table (i.e. the tables given to CToken::SetAltTokens()), with iKeys
+    /// entries, or up to the first NULL entry when iKeys is -1.  The table's strings must stay valid while CTokenHash is used.
+    /// </summary>
+    constexpr CTokenHash(const stTOKENOPERATORLOOKUP * stTable,bool bPrefixed,int iKeys = -1)
+    {
+        for (int i=0;(iKeys < 0 || i < iKeys) && stTable[i].sToken;i++) AddKey(stTable[i].sToken,stTable[i].eToken,bPrefixed);
+        Build();
+    }
+
+    /// <summary>
+    /// Returns the token for the iLength characters at sToken, or tNULL if they aren't a key in the table.
+    /// </summary>
+    constexpr TokenType Find(const char * sToken,int iLength) const
+    {
+        if (m_bPerfect)
+        {
+            auto & stSlot = m_stSlots[Hash(sToken,iLength,m_uSeed) & m_uMask];
+            return stSlot.sKey && Equal(stSlot,sToken,iLength) ? stSlot.eToken : tNULL;
+        }
+
+        int iKeys = m_iKeys < iMaxKeys ? m_iKeys : iMaxKeys;
+        for (int i=0;i<iKeys;i++) if (Equal(m_stKeys[i],sToken,iLength)) return m_stKeys[i].eToken;
+        return tNULL;
+    }
+
+    TokenType Find(const char * sToken) const { return sToken ? Find(sToken,(int) strlen(sToken)) : tNULL; }
+
+    /// <summary>
+    /// Finds the longest key (up to iMaxLength characters) at the start of sSource, i.e. "<=" rather than "<".  Returns the
+    /// token and sets iLength to its length, or returns tNULL (and sets iLength to 0) if no key matches.
+    /// </summary>
+    constexpr TokenType FindLongest(const char * sSource,int & iLength,int iMaxLength = 2) const
+    {
+        for (iLength = iMaxLength;iLength > 0;iLength--)
+        {
+            int i = 0;
+            while (i < iLength && sSource[i]) i++;
+            if (i < iLength) continue;
+
+            auto eToken = Find(sSource,iLength);
+            if (eToken != tNULL) return eToken;
+        }
+        return tNULL;
+    }
+
+    int GetCount() const { return m_iKeys; }
+    int GetSlots() const { return (int) m_uMask + 1; }
+
+    // isPerfect() -- true when the table is hashed; false when Find() searches linearly (see notes above)
+
+    constexpr bool isPerfect() const { return m_bPerfect; }
+};
+
+// CTokenLookup -- The default keyword and operator tables, as compile-time perfect hashes
+//
+// The hashes are built from stTokenAlphaLookup and stTokenOperatorLookup in CToken.h, so they always match CToken's tables.
+//
+class CTokenLookup
+{
+public:
+    static constexpr int kOperatorCount = (int) (sizeof(stTokenOperatorLookup)/sizeof(stTokenOperatorLookup[0]));
+    static constexpr int kMaxOperatorLength = 2;
+
+    static constexpr CTokenHash<64> stAlpha{stTokenAlphaLookup,true};                       // Ends with a NULL entry
+    static constexpr CTokenHash<64> stOperators{stTokenOperatorLookup,false,kOperatorCount};
+
+    static_assert(stAlpha.isPerfect() && stOperators.isPerfect(),"CTokenLookup -- no perfect hash found for the default tables");
+
+    // FindAlpha() -- the keyword token for an identifier (i.e. tBegin for "begin"), or tNULL if it isn't a keyword
+
+    static constexpr TokenType FindAlpha(const char * sToken,int iLength) { return stAlpha.Find(sToken,iLength); }
+    static TokenType FindAlpha(const char * sToken) { return stAlpha.Find(sToken); }
+
+    // FindOperator() -- the longest operator at the start of sSource, setting iLength to its length (tNULL and 0 if none)
+
+    static constexpr TokenType FindOperator(const char * sSource,int & iLength) { return stOperators.FindLongest(sSource,iLength,kMaxOperatorLength); }
+
+    static const CTokenHash<64> & GetAlpha() { return stAlpha; }
+    static const CTokenHash<64> & GetOperators() { return stOperators; }
+};
+
+} // namespace Sage
+#endif // _CTokenLookup_H_
@@ -3,6 +3,8 @@
 
 #include "Sage.h"
 #include "Point3D.h"
+#include "CPointCloud3D.h"
+#include "CThreadPool.h"
 
 namespace Sage
 {
@@ -105,6 +107,220 @@ public:
     return { pNew.fX*fMul, pNew.fY*fMul, fMul };
 
     }
+
+    // ---------------------------------------------------------------------------------------------------------------------
+    // Batch functions -- TranslateView(), Translate2DPoint() and lighting for a whole CPointCloud3D (or x/y/z float arrays)
+    // ---------------------------------------------------------------------------------------------------------------------
+    //
+    // These work in float precision, SimdBatch::kSimdBytes32 points at a time, and split large clouds into kBatchChunk point
+    // chunks run on CThreadPool::GetDefault().  They give the same results as calling TranslateView() and Translate2DPoint()
+    // for each point, within float precision.
+    //
+    // The view transform is read once per call from TranslateView() itself (see GetViewTransform()), so the batch functions
+    // always follow the current viewpoint, viewer angles and TranslateView() implementation.
+    //
+    // SimdBatch is the widest Simd backend the compiler is set to generate (i.e. /arch:AVX2 or -mavx2 for Simd256).  The
+    // Batch functions can also be called with a specific backend, i.e. Translate2DBatch<Simd128>(...).
+
+#if defined(__AVX512F__)
+    using SimdBatch = Simd512;
+#elif defined(__AVX2__)
+    using SimdBatch = Simd256;
+#else
+    using SimdBatch = Simd128;
+#endif
+
+    static constexpr int kBatchChunk = 65536;       // Points per thread pool task (multiple of CPointCloud3D::kSimdPad)
+
+    // Affine form of TranslateView():  view = fOffset + fCol[0]*x + fCol[1]*y + fCol[2]*z
+    //
+    // fDistBase is fViewDistance/m_fTanAngle - fOffset.z, kept out of the per-point math so the large viewer distance
+    // doesn't cost float precision.
+
+    struct ViewTransform_t
+    {
+        Point3Df_t  fCol[3];
+        Point3Df_t  fOffset;
+        float       fDistBase;
+        float       fViewDiv;
+    };
+
+    /// <summary>
+    /// Returns the current view as an affine transform, found by translating the origin and the three unit vectors with
+    /// TranslateView().
+    /// </summary>
+    ViewTransform_t GetViewTransform() const
+    {
+        Point3D_t pOrigin = TranslateView({ 0,0,0 });
+        Point3D_t pX = TranslateView({ 1,0,0 }) - pOrigin;
+        Point3D_t pY = TranslateView({ 0,1,0 }) - pOrigin;
+        Point3D_t pZ = TranslateView({ 0,0,1 }) - pOrigin;
+
+        ViewTransform_t stView;
+        stView.fCol[0]      = { (float) pX.fX,(float) pX.fY,(float) pX.fZ };
+        stView.fCol[1]      = { (float) pY.fX,(float) pY.fY,(float) pY.fZ };
+        stView.fCol[2]      = { (float) pZ.fX,(float) pZ.fY,(float) pZ.fZ };
+        stView.fOffset      = { (float) pOrigin.fX,(float) pOrigin.fY,(float) pOrigin.fZ };
+        stView.fDistBase    = (float) (fViewDistance/m_fTanAngle - pOrigin.fZ);
+        stView.fViewDiv     = (float) m_fViewDiv;
+        return stView;
+    }
+
+private:
+    enum class BatchOp { View, Project2D, Light };
+
+    // Runs iCount points from iStart.  The main loop uses Simd; the remaining points use SimdScalar.  For Light, fX/fY/fZ
+    // are the normals and only fOutX is written.
+
+    template<class Simd>
+    static void BatchKernel(BatchOp eOp,const ViewTransform_t & stView,const Point3Df_t & fLight,const float * fX,const float * fY,const float * fZ,
+                            float * fOutX,float * fOutY,float * fOutZ,int iStart,int iCount)
+    {
+        using V = typename Simd::vFloat;
+
+        V m00 = Simd::Vecf(stView.fCol[0].fX), m01 = Simd::Vecf(stView.fCol[1].fX), m02 = Simd::Vecf(stView.fCol[2].fX);
+        V m10 = Simd::Vecf(stView.fCol[0].fY), m11 = Simd::Vecf(stView.fCol[1].fY), m12 = Simd::Vecf(stView.fCol[2].fY);
+        V m20 = Simd::Vecf(stView.fCol[0].fZ), m21 = Simd::Vecf(stView.fCol[1].fZ), m22 = Simd::Vecf(stView.fCol[2].fZ);
+        V vOffX = Simd::Vecf(stView.fOffset.fX), vOffY = Simd::Vecf(stView.fOffset.fY), vOffZ = Simd::Vecf(stView.fOffset.fZ);
+        V vDistBase = Simd::Vecf(stView.fDistBase), vViewDiv = Simd::Vecf(stView.fViewDiv);
+        V vLX = Simd::Vecf(fLight.fX), vLY = Simd::Vecf(fLight.fY), vLZ = Simd::Vecf(fLight.fZ);
+        V vZero = Simd::Vecf(0.0f), vSignBit = Simd::Vecf(-0.0f);
+
+        int iEnd = iStart + iCount;
+        int iVecEnd = iStart + (iCount & ~Simd::kSimdAnd32);
+
+        for (int i=iStart;i<iVecEnd;i += Simd::kSimdBytes32)
+        {
+            V x = Simd::LoadU(fX+i), y = Simd::LoadU(fY+i), z = Simd::LoadU(fZ+i);
+
+            V rx = Simd::Add(Simd::Add(Simd::Mul(m00,x),Simd::Mul(m01,y)),Simd::Mul(m02,z));
+            V ry = Simd::Add(Simd::Add(Simd::Mul(m10,x),Simd::Mul(m11,y)),Simd::Mul(m12,z));
+            V rz = Simd::Add(Simd::Add(Simd::Mul(m20,x),Simd::Mul(m21,y)),Simd::Mul(m22,z));
+
+            if (eOp == BatchOp::Light)
+            {
+                // Lambert: max(0,n.L) with the normal rotated into view space and renormalized
+
+                V vDot = Simd::Add(Simd::Add(Simd::Mul(rx,vLX),Simd::Mul(ry,vLY)),Simd::Mul(rz,vLZ));
+                V vMag = Simd::Sqrt(Simd::Add(Simd::Add(Simd::Mul(rx,rx),Simd::Mul(ry,ry)),Simd::Mul(rz,rz)));
+                V vShade = Simd::Select(Simd::CmpGt(vMag,vZero),vZero,Simd::Div(vDot,vMag));
+                Simd::StoreU(fOutX+i,Simd::Max(vShade,vZero));
+                continue;
+            }
+
+            rx = Simd::Add(rx,vOffX);
+            ry = Simd::Add(ry,vOffY);
+
+            if (eOp == BatchOp::View)
+            {
+                Simd::StoreU(fOutX+i,rx);
+                Simd::StoreU(fOutY+i,ry);
+                Simd::StoreU(fOutZ+i,Simd::Add(rz,vOffZ));
+                continue;
+            }
+
+            // Translate2DPoint(): fMul = |fViewDiv/fDist|, or 0 when fDist is 0
+
+            V vDist = Simd::Sub(vDistBase,rz);
+            V vMul  = Simd::AndNot(vSignBit,Simd::Div(vViewDiv,vDist));
+            vMul    = Simd::Select(Simd::CmpEq(vDist,vZero),vMul,vZero);
+
+            Simd::StoreU(fOutX+i,Simd::Mul(rx,vMul));
+            Simd::StoreU(fOutY+i,Simd::Mul(ry,vMul));
+            Simd::StoreU(fOutZ+i,vMul);
+        }
+
+        if constexpr (Simd::kSimdBytes32 > 1)
+            if (iVecEnd < iEnd) BatchKernel<SimdScalar>(eOp,stView,fLight,fX,fY,fZ,fOutX,fOutY,fOutZ,iVecEnd,iEnd - iVecEnd);
+    }
+
+    template<class Simd>
+    void RunBatch(BatchOp eOp,const float * fX,const float * fY,const float * fZ,int iCount,float * fOutX,float * fOutY,float * fOutZ,int iMaxThreads) const
+    {
+        if (iCount <= 0) return;
+
+        ViewTransform_t stView = GetViewTransform();
+        Point3Df_t fLight = { (float) pLightNormalized.fX,(float) pLightNormalized.fY,(float) pLightNormalized.fZ };
+
+        int iChunks = (iCount + kBatchChunk - 1)/kBatchChunk;
+        if (iChunks == 1 || iMaxThreads == 1)
+        {
+            BatchKernel<Simd>(eOp,stView,fLight,fX,fY,fZ,fOutX,fOutY,fOutZ,0,iCount);
+            return;
+        }
+
+        CThreadPool::GetDefault().ParallelFor(iChunks,[&](int iTask,int)
+        {
+            int iStart = iTask*kBatchChunk;
+            BatchKernel<Simd>(eOp,stView,fLight,fX,fY,fZ,fOutX,fOutY,fOutZ,iStart,(std::min)(kBatchChunk,iCount - iStart));
+        },iMaxThreads);
+    }
+
+public:
+    /// <summary>
+    /// TranslateView() for iCount points in x/y/z arrays, written to fOutX/fOutY/fOutZ (which may be the input arrays).
+    /// </summary>
+    /// <param name="iMaxThreads"> - [optional] Maximum threads to use (0 = all cores, 1 = calling thread only)</param>
+    template<class Simd = SimdBatch>
+    void TranslateViewBatch(const float * fX,const float * fY,const float * fZ,int iCount,float * fOutX,float * fOutY,float * fOutZ,int iMaxThreads = 0) const
+    {
+        RunBatch<Simd>(BatchOp::View,fX,fY,fZ,iCount,fOutX,fOutY,fOutZ,iMaxThreads);
+    }
+
+    /// <summary>
+    /// Translate2DPoint() for iCount points in x/y/z arrays.  fOutX/fOutY receive the 2D point and fOutMul the 2D multiplier
+    /// (the Z value returned by Translate2DPoint()).  The output arrays may be the input arrays.
+    /// </summary>
+    /// <param name="iMaxThreads"> - [optional] Maximum threads to use (0 = all cores, 1 = calling thread only)</param>
+    template<class Simd = SimdBatch>
+    void Translate2DBatch(const float * fX,const float * fY,const float * fZ,int iCount,float * fOutX,float * fOutY,float * fOutMul,int iMaxThreads = 0) const
+    {
+        RunBatch<Simd>(BatchOp::Project2D,fX,fY,fZ,iCount,fOutX,fOutY,fOutMul,iMaxThreads);
+    }
+
+    /// <summary>
+    /// Lambert lighting for iCount normals: fOutLight[i] = max(0,n.pLightNormalized), where n is the normal rotated into view
+    /// space and normalized (0 for a 0-length normal).
+    /// </summary>
+    /// <param name="iMaxThreads"> - [optional] Maximum threads to use (0 = all cores, 1 = calling thread only)</param>
+    template<class Simd = SimdBatch>
+    void LightBatch(const float * fNX,const float * fNY,const float * fNZ,int iCount,float * fOutLight,int iMaxThreads = 0) const
+    {
+        RunBatch<Simd>(BatchOp::Light,fNX,fNY,fNZ,iCount,fOutLight,nullptr,nullptr,iMaxThreads);
+    }
+
+    /// <summary>
+    /// TranslateView() for every point in cCloud.  cOut is resized to cCloud.size() and may be cCloud.
+    /// </summary>
+    template<class Simd = SimdBatch>
+    void TranslateViewBatch(const CPointCloud3D & cCloud,CPointCloud3D & cOut,int iMaxThreads = 0) const
+    {
+        cOut.Resize(cCloud.size());
+        TranslateViewBatch<Simd>(cCloud.GetX(),cCloud.GetY(),cCloud.GetZ(),cCloud.size(),cOut.GetX(),cOut.GetY(),cOut.GetZ(),iMaxThreads);
+    }
+
+    /// <summary>
+    /// Translate2DPoint() for every point in cCloud.  cOut is resized to cCloud.size() and receives the same values as
+    /// Translate2DPoint(): X,Y = 2D point, Z = 2D multiplier.  cOut may be cCloud.
+    /// </summary>
+    template<class Simd = SimdBatch>
+    void Translate2DBatch(const CPointCloud3D & cCloud,CPointCloud3D & cOut,int iMaxThreads = 0) const
+    {
+        cOut.Resize(cCloud.size());
+        Translate2DBatch<Simd>(cCloud.GetX(),cCloud.GetY(),cCloud.GetZ(),cCloud.size(),cOut.GetX(),cOut.GetY(),cOut.GetZ(),iMaxThreads);
+    }
+
+    /// <summary>
+    /// Lighting (see LightBatch() above) for the normals of cCloud.  fOutLight must hold cCloud.size() floats.  Returns false
+    /// if cCloud has no normals.
+    /// </summary>
+    template<class Simd = SimdBatch>
+    bool LightBatch(const CPointCloud3D & cCloud,float * fOutLight,int iMaxThreads = 0) const
+    {
+        if (!cCloud.hasNormals()) return false;
+        LightBatch<Simd>(cCloud.GetNX(),cCloud.GetNY(),cCloud.GetNZ(),cCloud.size(),fOutLight,iMaxThreads);
+        return true;
+    }
 };
 
 } // namespace Sage
@@ -52,6 +52,10 @@
 #include "CQuickForm.h"
 #include "PolyTransfer.h"
 #include "MouseRegions.h"
+#include "CDirtyRegion.h"
+#include "CWindowAttach.h"
+#include "CEventQueue.h"
+#include <atomic>
 
 #ifdef __SageGDIPlusSupport
 #include <gdiplus.h>
@@ -139,6 +143,76 @@ namespace Sage
     };
 
 
+// CEventQueueHandler -- Window handler that copies mouse and key messages into a CEventQueue
+//
+// This is installed by CWindow::EnableEventQueue() as the admin handler, so it sees every message without replacing a handler
+// set with SetMessageHandler().  It runs on the window's message thread (one of the queue's producers).
+//
+// Each message is passed on to the admin handler given to EnableEventQueue() (if any), so a handler that was already installed
+// with __SetAdminHandler() keeps working.
+//
+// One CEventQueueHandler is kept per window (see CWindowAttach.h) and lives until the window is deleted, so disabling the
+// queue while the message thread is in the handler, or while another thread is in PostEvent(), is safe.
+//
+class CEventQueueHandler : public CWindowHandler
+{
+    CEventQueue m_cQueue;
+    std::atomic<bool> m_bEnabled{false};
+    std::atomic<CWindowHandler *> m_cChain{nullptr};
+
+    void Push(SageEvent eEvent,int iX = 0,int iY = 0,int iValue = 0) { if (m_bEnabled.load(std::memory_order_relaxed)) m_cQueue.Push(eEvent,iX,iY,iValue); }
+
+    CWindowHandler * GetChain()
+    {
+        auto cChain = m_cChain.load(std::memory_order_acquire);
+        if (cChain) cChain->SetPostProcess(m_bPostProcess);
+        return cChain;
+    }
+public:
+    CEventQueueHandler(int iCapacity) : m_cQueue(iCapacity) { }
+
+    CEventQueue & GetQueue() { return m_cQueue; }
+
+    bool isEnabled() { return m_bEnabled.load(std::memory_order_acquire); }
+    void SetEnabled(bool bEnable) { m_bEnabled.store(bEnable,std::memory_order_release); }
+
+    CWindowHandler * GetChainHandler() { return m_cChain.load(std::memory_order_acquire); }
+    void SetChainHandler(CWindowHandler * cChain) { m_cChain.store(cChain,std::memory_order_release); }
+
+    bool PostEvent(SageEvent eEvent,int iX,int iY,int iValue) { return isEnabled() ? m_cQueue.Push(eEvent,iX,iY,iValue) : false; }
+
+    MsgStatus OnMouseMove(int iMouseX,int iMouseY) override      { Push(SageEvent::MouseMoved,iMouseX,iMouseY);              auto c = GetChain(); return c ? c->OnMouseMove(iMouseX,iMouseY) : MsgStatus::Ok; }
+    MsgStatus OnLButtonDown(int iMouseX,int iMouseY) override    { Push(SageEvent::MouseLButtonClicked,iMouseX,iMouseY);     auto c = GetChain(); return c ? c->OnLButtonDown(iMouseX,iMouseY) : MsgStatus::Ok; }
+    MsgStatus OnLButtonUp(int iMouseX,int iMouseY) override      { Push(SageEvent::MouseLButtonUnclicked,iMouseX,iMouseY);   auto c = GetChain(); return c ? c->OnLButtonUp(iMouseX,iMouseY) : MsgStatus::Ok; }
+    MsgStatus OnRButtonDown(int iMouseX,int iMouseY) override    { Push(SageEvent::MouseRButtonClicked,iMouseX,iMouseY);     auto c = GetChain(); return c ? c->OnRButtonDown(iMouseX,iMouseY) : MsgStatus::Ok; }
+    MsgStatus OnRButtonUp(int iMouseX,int iMouseY) override      { Push(SageEvent::MouseRButtonUnclicked,iMouseX,iMouseY);   auto c = GetChain(); return c ? c->OnRButtonUp(iMouseX,iMouseY) : MsgStatus::Ok; }
+    MsgStatus OnMouseWheel(int iDelta,int iX,int iY) override    { Push(SageEvent::MouseWheel,iX,iY,iDelta);                 auto c = GetChain(); return c ? c->OnMouseWheel(iDelta,iX,iY) : MsgStatus::Ok; }
+    MsgStatus OnChar(char cChar,int iCount) override             { for (int i=0;i<iCount;i++) Push(SageEvent::KeyPress,0,0,(unsigned char) cChar); auto c = GetChain(); return c ? c->OnChar(cChar,iCount) : MsgStatus::Ok; }
+    MsgStatus OnSize(int iWidth,int iHeight) override            { Push(SageEvent::WindowResize,iWidth,iHeight);             auto c = GetChain(); return c ? c->OnSize(iWidth,iHeight) : MsgStatus::Ok; }
+    MsgStatus OnClose() override                                 { Push(SageEvent::CloseWindowPressed);                      auto c = GetChain(); return c ? c->OnClose() : MsgStatus::Ok; }
+
+    // Messages that are only passed on
+
+    MsgStatus OnCaptureChanged() override                        { auto c = GetChain(); return c ? c->OnCaptureChanged() : MsgStatus::Ok; }
+    MsgStatus OnNCLButtonDown(int iMouseX,int iMouseY) override  { auto c = GetChain(); return c ? c->OnNCLButtonDown(iMouseX,iMouseY) : MsgStatus::Ok; }
+    MsgStatus OnNCMouseMove(int iMouseX,int iMouseY) override    { auto c = GetChain(); return c ? c->OnNCMouseMove(iMouseX,iMouseY) : MsgStatus::Ok; }
+    MsgStatus OnControlKey(Sage::ControlKey key,int iCount) override { auto c = GetChain(); return c ? c->OnControlKey(key,iCount) : MsgStatus::Ok; }
+    MsgStatus OnWidgetMessage(void * cWidget,int iMessage) override  { auto c = GetChain(); return c ? c->OnWidgetMessage(cWidget,iMessage) : MsgStatus::Ok; }
+    MsgStatus OnSageEvent() override                             { auto c = GetChain(); return c ? c->OnSageEvent() : MsgStatus::Ok; }
+    MsgStatus OnGlobalEvent(int iEvent) override                 { auto c = GetChain(); return c ? c->OnGlobalEvent(iEvent) : MsgStatus::Ok; }
+    MsgStatus OnMove(int iX,int iY) override                     { auto c = GetChain(); return c ? c->OnMove(iX,iY) : MsgStatus::Ok; }
+    MsgStatus OnSizing(int iWidth,int iHeight) override          { auto c = GetChain(); return c ? c->OnSizing(iWidth,iHeight) : MsgStatus::Ok; }
+    MsgStatus OnSysCommand(int iCommand) override                { auto c = GetChain(); return c ? c->OnSysCommand(iCommand) : MsgStatus::Ok; }
+    MsgStatus OnSysMenu(int iMenuItem) override                  { auto c = GetChain(); return c ? c->OnSysMenu(iMenuItem) : MsgStatus::Ok; }
+    MsgStatus OnMenu(int iMenuID) override                       { auto c = GetChain(); return c ? c->OnMenu(iMenuID) : MsgStatus::Ok; }
+
+    WinMsgStatus OnWinMessage(unsigned int uiMessage,WPARAM wParam,LPARAM lParam,unsigned int & uiReturnCode) override
+    {
+        auto c = GetChain();
+        return c ? c->OnWinMessage(uiMessage,wParam,lParam,uiReturnCode) : WinMsgStatus::Ok;
+    }
+};
+
 // ---------------------------------
 // CWindow -- The main CWindow class
 // ---------------------------------
@@ -1740,6 +1814,142 @@ public:
     //
     bool UpdateRegion(int iX,int iY,RawBitmap_t stBitmap,int iUpdateMS = 0);                                                                                // $QC
 
+    // EnableDirtyRegions() -- Keep track of the changed parts of the window so UpdateDirty() only copies those to the screen
+    //
+    // When enabled, the areas given to MarkDirty() are merged into a short list of rectangles (see CDirtyRegion.h).  UpdateDirty()
+    // then updates only those rectangles, which is much faster than Update() when a few small items change on a large canvas
+    // (i.e. gauges on a 4K canvas set with SetCanvasSize()).
+    //
+    // Marking is manual: drawing functions don't mark the areas they draw to, so call MarkDirty() for each area you change
+    // (or MarkDirty() with no parameters after drawing over most of the window) before calling UpdateDirty().
+    //
+    // The dirty region is kept outside of the window (see CWindowAttach.h) and is deleted with the window.
+    //
+    void EnableDirtyRegions(bool bEnable = true)
+    {
+        if (bEnable) CWindowAttach<CDirtyRegion>::Get(*this).Enable(true);
+        else if (auto pRegion = CWindowAttach<CDirtyRegion>::Find(this)) pRegion->Enable(false);
+    }
+    bool isDirtyRegionsEnabled() { auto pRegion = CWindowAttach<CDirtyRegion>::Find(this); return pRegion && pRegion->isEnabled(); }
+
+    // MarkDirty() -- Add an area of the window to the list of changed areas used by UpdateDirty().  Does nothing if
+    // EnableDirtyRegions() has not been called.  MarkDirty() with no parameters marks the whole window.
+    //
+    void MarkDirty(int iX,int iY,int iWidth,int iHeight) { if (auto pRegion = CWindowAttach<CDirtyRegion>::Find(this)) pRegion->Add(iX,iY,iWidth,iHeight); }
+    void MarkDirty(const RECT & rRegion) { if (auto pRegion = CWindowAttach<CDirtyRegion>::Find(this)) pRegion->Add(rRegion); }
+    void MarkDirty() { if (auto pRegion = CWindowAttach<CDirtyRegion>::Find(this)) pRegion->SetAll(); }
+
+    // UpdateDirty() -- Update only the areas of the window marked with MarkDirty() (see EnableDirtyRegions())
+    //
+    // Each merged rectangle is updated with UpdateRegion(); when most of the window has changed, Update() is used.  When dirty regions
+    // are not enabled, this is the same as Update().
+    //
+    // iUpdateMS works the same as with Update(): changes keep collecting until at least iUpdateMS milliseconds have passed since
+    // the last UpdateDirty(), so a last UpdateDirty() with no iUpdateMS is needed to make sure the last changes are shown.
+    //
+    // Returns false if nothing was updated (nothing was marked or iUpdateMS has not passed)
+    //
+    bool UpdateDirty(int iUpdateMS = 0)
+    {
+        auto pRegion = CWindowAttach<CDirtyRegion>::Find(this);
+        if (!pRegion || !pRegion->isEnabled()) { Update(iUpdateMS); return true; }
+        if (pRegion->isEmpty() || !pRegion->ReadyToPresent(GetTickCount64(),iUpdateMS)) return false;
+
+        SIZE szCanvas = GetCanvasSize();
+        pRegion->SetBounds((int) szCanvas.cx,(int) szCanvas.cy);
+
+        if (pRegion->isAll()) Update();
+        else
+        {
+            RECT rRects[CDirtyRegion::kMaxRects];
+            int iCount = pRegion->GetRects(rRects);
+            for (int i=0;i<iCount;i++) UpdateRegion(rRects[i]);
+        }
+        pRegion->Clear();
+        return true;
+    }
+
+    // EnableEventQueue() -- Keep every mouse, key and size event for the window, in order and with its time (see CEventQueue.h)
+    //
+    // GetEvent() and the event functions (MouseMoved(), MouseClicked(), etc.) only show the latest state when they are called, so
+    // mouse positions and clicks between two calls are lost.  With the event queue enabled, each event is also added to a lock-free
+    // queue as it is received, and can be read in order with GetInputEvent() or DrainEvents(), i.e. for drawing with a tablet:
+    //
+    //      MyWindow.EnableEventQueue();
+    //      while (MyWindow.GetEvent())
+    //      {
+    //          InputEvent_t stEvent;
+    //          while (MyWindow.GetInputEvent(stEvent))
+    //              if (stEvent.eEvent == SageEvent::MouseMoved && MyWindow.MouseButtonDown()) AddStroke(stEvent.iX,stEvent.iY,stEvent.ullTimeUs);
+    //      }
+    //
+    // Events are only read by one thread (the thread calling GetEvent()), but other threads may add their own with PostEvent().
+    // iCapacity is the number of events kept before new ones are dropped (see GetDroppedEvents()); it is set the first time the
+    // queue is enabled.
+    //
+    // The queue is read through the window's admin handler.  The admin handler can't be read back from the window, so if you have set
+    // one with __SetAdminHandler(), pass it as cChainHandler: it is called for every message as before, and is set back as the admin
+    // handler when the queue is disabled.
+    //
+    // Disabling the queue stops new events; events already in the queue can still be read.  The queue is kept (see CWindowAttach.h)
+    // until the window is deleted.
+    //
+    bool EnableEventQueue(bool bEnable = true,int iCapacity = CEventQueue::kDefaultCapacity,CWindowHandler * cChainHandler = nullptr)
+    {
+        if (!bEnable)
+        {
+            auto pHandler = CWindowAttach<CEventQueueHandler>::Find(this);
+            if (!pHandler || !pHandler->isEnabled()) return true;
+            pHandler->SetEnabled(false);
+            return __SetAdminHandler(pHandler->GetChainHandler());
+        }
+
+        auto & cHandler = CWindowAttach<CEventQueueHandler>::Get(*this,iCapacity);
+        if (cHandler.isEnabled()) return true;
+
+        cHandler.SetChainHandler(cChainHandler);
+        cHandler.SetEnabled(true);
+        return __SetAdminHandler(&cHandler);
+    }
+
+    bool isEventQueueEnabled() { auto pHandler = CWindowAttach<CEventQueueHandler>::Find(this); return pHandler && pHandler->isEnabled(); }
+
+    // GetInputEvent() -- Remove the oldest event from the event queue into stEvent.  Returns false when there are no more
+    // events (or EnableEventQueue() has not been called).
+    //
+    bool GetInputEvent(InputEvent_t & stEvent) { auto pHandler = CWindowAttach<CEventQueueHandler>::Find(this); return pHandler ? pHandler->GetQueue().Pop(stEvent) : false; }
+
+    // GetInputEvent() -- Same as GetInputEvent() above, but only returns events that pass eFilter (i.e. EventMask::AnyMouse).  Events
+    // that don't pass the filter are removed from the queue and skipped.
+    //
+    bool GetInputEvent(InputEvent_t & stEvent,EventFilter eFilter)
+    {
+        auto pHandler = CWindowAttach<CEventQueueHandler>::Find(this);
+        if (pHandler) while (pHandler->GetQueue().Pop(stEvent)) if (eFilter.Accepts(stEvent.eEvent)) return true;
+        return false;
+    }
+
+    // DrainEvents() -- Remove up to iMaxEvents events from the event queue, oldest first.  Returns the number of events.
+    //
+    int DrainEvents(InputEvent_t * pEvents,int iMaxEvents) { auto pHandler = CWindowAttach<CEventQueueHandler>::Find(this); return pHandler ? pHandler->GetQueue().Drain(pEvents,iMaxEvents) : 0; }
+
+    // DrainEvents() -- Remove events from the event queue into an array, i.e. InputEvent_t stEvents[256]; int iCount = DrainEvents(stEvents); 
+    //
+    template<int iSize> int DrainEvents(InputEvent_t (&stEvents)[iSize]) { return DrainEvents(stEvents,iSize); }
+
+    // DrainEvents() -- Append all events in the event queue to vEvents.  Returns the number of events added.
+    //
+    int DrainEvents(std::vector<InputEvent_t> & vEvents) { auto pHandler = CWindowAttach<CEventQueueHandler>::Find(this); return pHandler ? pHandler->GetQueue().Drain(vEvents) : 0; }
+
+    // PostEvent() -- Add an event to the event queue from any thread (i.e. a tablet or sensor thread).  The time is set to now.
+    // Returns false if the event queue is not enabled or is full.
+    //
+    bool PostEvent(SageEvent eEvent,int iX = 0,int iY = 0,int iValue = 0) { auto pHandler = CWindowAttach<CEventQueueHandler>::Find(this); return pHandler ? pHandler->PostEvent(eEvent,iX,iY,iValue) : false; }
+
+    // GetDroppedEvents() -- Number of events lost because the event queue was full (GetInputEvent()/DrainEvents() were not called often enough)
+    //
+    unsigned int GetDroppedEvents() { auto pHandler = CWindowAttach<CEventQueueHandler>::Find(this); return pHandler ? pHandler->GetQueue().GetDropped() : 0; }
+
     // GetTextSize() -- Get the text size of the text using the current font.
     //
     // This returns the size the text will use in the window.  This can help with the placement of the text or controls around the text.
@@ -13676,6 +13886,11 @@ public:
         //        
         WaitEvent WaitforEvent(const char * sEvent = nullptr);
 
+        // WaitforEvent() -- Same as WaitforEvent() above, with an EventFilter, i.e. WaitforEvent(EventMask::Button | EventMask::MouseMove).
+        // The filter is passed as its cwfEvent option string (see EventFilter::GetOptString()).
+        //
+        WaitEvent WaitforEvent(EventFilter eFilter) { return WaitforEvent(eFilter.GetOptString()); }
+
         // EventLoop() -- Wait for a user event, such as a mouse move, mouse click, button press, slider press, or any control or widget event.
         //
         // This is the Main Event Loop for procedurally-driven programs to capture events without using event callbacks.
@@ -18337,6 +18552,12 @@ public:
     // only events are returned and it is not caught in a spining loop. 
     //
     WaitEvent WaitforEvent(cwfEvent & cwEvent) { return WaitforEvent(*cwEvent); } // $QCC
+
+    // WaitforEvent() -- Same as WaitforEvent() above, with an EventFilter (see EventOpt.h), i.e. WaitforEvent(EventMask::Button | EventMask::MouseMove).
+    // The filter is passed as its cwfEvent option string (see EventFilter::GetOptString()), so this is a convenience; filtering
+    // without an option string is done with the event queue (see GetInputEvent()).
+    //
+    WaitEvent WaitforEvent(EventFilter eFilter) { return WaitforEvent(eFilter.GetOptString()); } // $QCC
  
     
     // EventLoop() -- Wait for a user event, such as a mouse move, mouse click, button press, slider press, or any control or widget event.
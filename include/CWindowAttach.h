@@ -0,0 +1,96 @@
+// This file copyright(c) 2021 Rob Nelson, All Rights Reserved.    E-mail rob@projectsagebox.com for more information.
+//
+
+#pragma once
+#if !defined(_CWindowAttach_H_)
+#define _CWindowAttach_H_
+
+#include <mutex>
+#include <unordered_map>
+#include <utility>
+
+namespace Sage
+{
+
+// CWindowAttach<T> -- One T per window, kept outside of the window object
+//
+// CWindow is built into the library, so header-only features can't add members to it without changing its layout.
+// CWindowAttach<T> keeps a table of T objects keyed by the window instead.  The T is created the first time Get() is called
+// for a window, and is deleted with the window through CWindow::AttachDeleter():
+//
+//      if (auto pRegion = CWindowAttach<CDirtyRegion>::Find(this)) pRegion->Add(...);     // nullptr until Get() has been called
+//      CWindowAttach<CDirtyRegion>::Get(*this).Enable();                                  // Creates it if needed
+//
+// Notes:
+//
+//      1. Find() and Get() can be called from any thread.  The T itself is not locked -- T must be thread-safe if more than
+//         one thread uses it.
+//      2. A T lives until the window is deleted, so a pointer returned by Find() or Get() is valid for as long as the window is.
+//
+template<class T>
+class CWindowAttach
+{
+    struct Entry_t
+    {
+        const void * pWindow;
+        T cObject;
+
+        template<typename... Args>
+        Entry_t(const void * pOwner,Args&&... args) : pWindow(pOwner), cObject(std::forward<Args>(args)...) { }
+    };
+
+    std::mutex m_mLock;
+    std::unordered_map<const void *,Entry_t *> m_mEntries;
+
+    static CWindowAttach & GetTable()
+    {
+        static CWindowAttach cTable;
+        return cTable;
+    }
+
+    // Called by the window when it is deleted
+
+    static void DeleteEntry(void * pEntry)
+    {
+        auto stEntry = (Entry_t *) pEntry;
+        {
+            auto & cTable = GetTable();
+            std::lock_guard<std::mutex> lock(cTable.m_mLock);
+            cTable.m_mEntries.erase(stEntry->pWindow);
+        }
+        delete stEntry;
+    }
+
+public:
+    /// <summary>
+    /// Returns the T for the window, or nullptr if Get() has not been called for it.
+    /// </summary>
+    static T * Find(const void * pWindow)
+    {
+        auto & cTable = GetTable();
+        std::lock_guard<std::mutex> lock(cTable.m_mLock);
+        auto it = cTable.m_mEntries.find(pWindow);
+        return it == cTable.m_mEntries.end() ? nullptr : &it->second->cObject;
+    }
+
+    /// <summary>
+    /// Returns the T for the window, creating it with args (and attaching it to the window, to be deleted with it) if there isn't one.
+    /// </summary>
+    template<class W,typename... Args>
+    static T & Get(W & cWindow,Args&&... args)
+    {
+        auto & cTable = GetTable();
+        Entry_t * stEntry;
+        {
+            std::lock_guard<std::mutex> lock(cTable.m_mLock);
+            auto & stSlot = cTable.m_mEntries[&cWindow];
+            if (stSlot) return stSlot->cObject;
+            stSlot = stEntry = new Entry_t(&cWindow,std::forward<Args>(args)...);
+        }
+        cWindow.AttachDeleter(stEntry,&DeleteEntry);
+        return stEntry->cObject;
+    }
+};
+
+} // namespace Sage
+#endif // _CWindowAttach_H_
@@ -18,6 +18,7 @@
 #include <math.h>
 #include <cstdlib>
 #include <memory>
+#include "Sage.h"
 
 namespace Sage
 {
@@ -93,5 +94,158 @@ namespace OptEvent
 	static cwfEvent EditBox			() { return cwfEvent().EditBox			();	};
 	static cwfEvent AnyKey			() { return cwfEvent().AnyKey			();	};
 };
+
+// EventFilter -- Compile-time bitmask version of cwfEvent
+//
+// An EventFilter is one unsigned int with a bit for each of the cwfEvent options, so filters are combined with | at compile time.
+// With the event queue (see CWindow::EnableEventQueue()), checking an event against a filter is a single AND, with no option
+// string built or parsed:
+//
+//      constexpr auto eFilter = EventMask::Button | EventMask::MouseMove;
+//
+//      MyWindow.GetInputEvent(stEvent,eFilter);                // Only events that pass the filter
+//      if (eFilter.Accepts(stEvent.eEvent)) ...
+//
+// WaitforEvent(eFilter) is also accepted, for convenience.  The library's WaitforEvent() takes an option string, so it is given
+// the cwfEvent string for the filter (see GetOptString()) and parses it as before -- it is the same as
+// WaitforEvent(OptEvent::Button() | OptEvent::MouseMove()), without the cost of adding the strings together on each call.
+//
+class EventFilter
+{
+    unsigned int m_uBits = 0;
+
+    constexpr explicit EventFilter(unsigned int uBits) : m_uBits(uBits) { }
+
+public:
+    enum Bits : unsigned int
+    {
+        kShowEvents     = 1u << 0,
+        kShowErrors     = 1u << 1,
+        kShowTimerError = 1u << 2,
+        kButton         = 1u << 3,
+        kSlider         = 1u << 4,
+        kAny            = 1u << 5,
+        kTimer          = 1u << 6,
+        kButtonPress    = 1u << 7,
+        kMouseClick     = 1u << 8,
+        kAnyMouse       = 1u << 9,
+        kMouseMove      = 1u << 10,
+        kMouseDown      = 1u << 11,
+        kMouseUp        = 1u << 12,
+        kWindowClose    = 1u << 13,
+        kMouseWheel     = 1u << 14,
+        kAnyMenu        = 1u << 15,
+        kEditBox        = 1u << 16,
+        kAnyKey         = 1u << 17,
+        kNumBits        = 18,
+    };
+
+    constexpr EventFilter() = default;
+    static constexpr EventFilter FromBits(unsigned int uBits) { return EventFilter(uBits); }
+
+    constexpr EventFilter operator | (EventFilter eFilter) const { return EventFilter(m_uBits | eFilter.m_uBits); }
+    constexpr EventFilter operator & (EventFilter eFilter) const { return EventFilter(m_uBits & eFilter.m_uBits); }
+    EventFilter & operator |= (EventFilter eFilter) { m_uBits |= eFilter.m_uBits; return *this; }
+    constexpr bool operator == (EventFilter eFilter) const { return m_uBits == eFilter.m_uBits; }
+    constexpr bool operator != (EventFilter eFilter) const { return m_uBits != eFilter.m_uBits; }
+
+    constexpr unsigned int GetBits() const { return m_uBits; }
+    constexpr bool isEmpty() const { return !m_uBits; }
+    constexpr bool Has(EventFilter eFilter) const { return (m_uBits & eFilter.m_uBits) != 0; }
+
+    /// <summary>
+    /// Returns the filter bits an event of type eEvent passes.  Each event also carries its group bits (i.e. AnyMouse for
+    /// mouse events) and Any, so a filter passes an event when any of its bits match (see Accepts()).
+    /// </summary>
+    static constexpr EventFilter FromSageEvent(SageEvent eEvent)
+    {
+        switch (eEvent)
+        {
+            case SageEvent::ButtonPress:            return EventFilter(kAny | kButton | kButtonPress);
+            case SageEvent::ButtonUnpress:          return EventFilter(kAny | kButton);
+            case SageEvent::MouseMoved:             return EventFilter(kAny | kAnyMouse | kMouseMove);
+            case SageEvent::MouseLButtonClicked:    return EventFilter(kAny | kAnyMouse | kMouseClick | kMouseDown);
+            case SageEvent::MouseRButtonClicked:    return EventFilter(kAny | kAnyMouse | kMouseDown);
+            case SageEvent::MouseLButtonUnclicked:  
+            case SageEvent::MouseRButtonUnclicked:  return EventFilter(kAny | kAnyMouse | kMouseUp);
+            case SageEvent::MouseWheel:             return EventFilter(kAny | kAnyMouse | kMouseWheel);
+            case SageEvent::KeyPress:               return EventFilter(kAny | kAnyKey);
+            case SageEvent::CloseWindowPressed:     return EventFilter(kAny | kWindowClose);
+            default:                                return EventFilter(kAny);
+        }
+    }
+
+    /// <summary>
+    /// Returns true if an event of type eEvent passes the filter.  An empty filter (no bits) passes everything, the same as
+    /// WaitforEvent() with no options.
+    /// </summary>
+    constexpr bool Accepts(SageEvent eEvent) const { return !m_uBits || (m_uBits & FromSageEvent(eEvent).m_uBits) != 0; }
+
+    /// <summary>
+    /// Fills cOpt with the cwfEvent options for the filter bits.
+    /// </summary>
+    void ToOpt(cwfEvent & cOpt) const
+    {
+        using OptFunc = cwfEvent (cwfEvent::*)();
+        static constexpr OptFunc fnOpts[kNumBits] =
+        {
+            &cwfEvent::ShowEvents,  &cwfEvent::ShowErrors,  &cwfEvent::ShowTimerError,  &cwfEvent::Button,      &cwfEvent::Slider,
+            &cwfEvent::Any,         &cwfEvent::Timer,       &cwfEvent::ButtonPress,     &cwfEvent::MouseClick,  &cwfEvent::AnyMouse,
+            &cwfEvent::MouseMove,   &cwfEvent::MouseDown,   &cwfEvent::MouseUp,         &cwfEvent::WindowClose, &cwfEvent::MouseWheel,
+            &cwfEvent::AnyMenu,     &cwfEvent::EditBox,     &cwfEvent::AnyKey,
+        };
+
+        cOpt.ClearMem();
+        for (int i=0;i<(int) kNumBits;i++)
+            if (m_uBits & (1u << i))
+            {
+                cwfEvent cAdd = (cwfEvent().*fnOpts[i])();
+                cOpt.AddOpt(cAdd);
+            }
+    }
+
+    /// <summary>
+    /// Returns the cwfEvent option string for the filter (nullptr for an empty filter), for the WaitforEvent() functions that take a
+    /// string.  The string is kept until GetOptString() is called with a different filter on the same thread.
+    /// </summary>
+    const char * GetOptString() const
+    {
+        if (!m_uBits) return nullptr;
+
+        thread_local unsigned int uLastBits = 0;
+        thread_local cwfEvent cLastOpt;
+
+        if (uLastBits != m_uBits)
+        {
+            ToOpt(cLastOpt);
+            uLastBits = m_uBits;
+        }
+        return *cLastOpt;
+    }
+};
+
+// EventMask -- constexpr EventFilter values, the same options as OptEvent, i.e. WaitforEvent(EventMask::Button | EventMask::Slider)
+
+namespace EventMask
+{
+	constexpr EventFilter ShowEvents		= EventFilter::FromBits(EventFilter::kShowEvents);
+	constexpr EventFilter ShowErrors		= EventFilter::FromBits(EventFilter::kShowErrors);
+	constexpr EventFilter ShowTimerError	= EventFilter::FromBits(EventFilter::kShowTimerError);
+	constexpr EventFilter Button			= EventFilter::FromBits(EventFilter::kButton);
+	constexpr EventFilter Slider			= EventFilter::FromBits(EventFilter::kSlider);
+	constexpr EventFilter Any				= EventFilter::FromBits(EventFilter::kAny);
+	constexpr EventFilter Timer				= EventFilter::FromBits(EventFilter::kTimer);
+	constexpr EventFilter ButtonPress		= EventFilter::FromBits(EventFilter::kButtonPress);
+	constexpr EventFilter MouseClick		= EventFilter::FromBits(EventFilter::kMouseClick);
+	constexpr EventFilter AnyMouse			= EventFilter::FromBits(EventFilter::kAnyMouse);
+	constexpr EventFilter MouseMove			= EventFilter::FromBits(EventFilter::kMouseMove);
+	constexpr EventFilter MouseDown			= EventFilter::FromBits(EventFilter::kMouseDown);
+	constexpr EventFilter MouseUp			= EventFilter::FromBits(EventFilter::kMouseUp);
+	constexpr EventFilter WindowClose		= EventFilter::FromBits(EventFilter::kWindowClose);
+	constexpr EventFilter MouseWheel		= EventFilter::FromBits(EventFilter::kMouseWheel);
+	constexpr EventFilter AnyMenu			= EventFilter::FromBits(EventFilter::kAnyMenu);
+	constexpr EventFilter EditBox			= EventFilter::FromBits(EventFilter::kEditBox);
+	constexpr EventFilter AnyKey			= EventFilter::FromBits(EventFilter::kAnyKey);
+};
 }; // namespace Sage
 #endif // _EventOpt_h_
\ No newline at end of file
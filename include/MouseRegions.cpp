@@ -1,11 +1,35 @@
 #include "stdafx.h"
 #include "Sagebox.h"
 #include "MouseRegions.h"
+#include "CRegionIndex.h"
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
 
 #include "keywords\opt2_keyfuncs.h"
 
 namespace Sage
 {
+// Hit indexes (see EnableHitIndex()) are kept here, keyed by the MouseRegion, rather than in MouseRegion, whose layout is shared
+// with code already built against it.  The MouseRegion constructor erases any index left at its address by a deleted
+// MouseRegion, and g_iHitIndexes (the number of indexes) lets GetHitIndex() return without the lock when none are enabled.
+
+namespace
+{
+    std::mutex g_mHitIndexLock;
+    std::unordered_map<const void *,std::unique_ptr<CRegionIndex>> g_mHitIndexes;
+    std::atomic<int> g_iHitIndexes{0};
+
+    // Erases the index for a MouseRegion (g_mHitIndexLock must be held)
+
+    void EraseHitIndex(const void * pRegion)
+    {
+        g_mHitIndexes.erase(pRegion);
+        g_iHitIndexes.store((int) g_mHitIndexes.size(),std::memory_order_release);
+    }
+}
+
 // $$ Old version -- deprecated (probably)
 #if 0
 MouseRegion::Region * MouseRegion::FindRegion(int iRegion)
@@ -126,6 +150,9 @@ bool MouseRegion::ResetPoints()
 {
     m_iActiveRegions = 0;
     m_vRegions.clear();
+    m_pDisplayTop = nullptr;    // Don't leave the display list pointing into the cleared storage
+    m_pDisplayBot = nullptr;
+    if (auto pIndex = GetHitIndex()) pIndex->Clear();
     return true;
 }
 int MouseRegion::GetDisplayPosIndex(int iIndex)
@@ -172,8 +199,99 @@ bool MouseRegion::BringtoTop(Region & r)
     }
 
     m_pDisplayTop = &r;
+    if (auto pIndex = GetHitIndex()) pIndex->Raise(r.iPhysicalIndex);
+    return true;
+}
+
+CRegionIndex * MouseRegion::GetHitIndex()
+{
+    if (!g_iHitIndexes.load(std::memory_order_acquire)) return nullptr;      // No MouseRegion has an index
+
+    std::lock_guard<std::mutex> lock(g_mHitIndexLock);
+    auto it = g_mHitIndexes.find(this);
+    return it == g_mHitIndexes.end() ? nullptr : it->second.get();
+}
+
+bool MouseRegion::isHitIndexEnabled()
+{
+    return !this ? false : GetHitIndex() != nullptr;
+}
+
+void MouseRegion::UpdateHitIndex(InternalRegion & r)
+{
+    auto pIndex = GetHitIndex();
+    if (!pIndex) return;
+
+    // Use the same rectangle as the display-list walk in UpdatePoints()
+
+    int iX = (int) r.fx;
+    int iY = (int) r.fy;
+
+    if (r.bDisplayOOB)
+    { 
+        iX = (int) r.cfDisplayOOB.x;
+        iY = (int) r.cfDisplayOOB.y;
+    }
+    pIndex->Update(r.iPhysicalIndex,iX,iY,(int) r.fWidth,(int) r.fHeight);
+}
+
+bool MouseRegion::EnableHitIndex(bool bEnable,int iCellSize)
+{
+    if (!this) return false;
+
+    {
+        std::lock_guard<std::mutex> lock(g_mHitIndexLock);
+        EraseHitIndex(this);
+        if (!bEnable) return true;
+
+        auto & cIndex = g_mHitIndexes[this];
+        cIndex = std::make_unique<CRegionIndex>();
+        cIndex->SetCellSize(iCellSize > 0 ? iCellSize : CRegionIndex::kDefaultCellSize);
+        g_iHitIndexes.store((int) g_mHitIndexes.size(),std::memory_order_release);
+    }
+
+    // Add from the bottom of the display order up, so the display order stamps in the index match the display list
+
+    auto pos = m_pDisplayTop;
+    while (pos && pos->pDisplayNext) pos = pos->pDisplayNext;
+
+    while (pos)
+    {
+        UpdateHitIndex(*pos);
+        pos = pos->pDisplayPrev;
+    }
+    m_bPreprocess = true;   // Re-check the highlight on the next UpdatePoints()
     return true;
 }
+
+void MouseRegion::GrowRegions()
+{
+    if (m_vRegions.size() < m_vRegions.capacity()) return;
+
+    // The display order is a linked list of pointers into m_vRegions, so save it as indexes before the storage moves.
+
+    auto ToIndex = [&](InternalRegion * p) { return p ? (int) (p - m_vRegions.data()) : -1; };
+    
+    std::vector<std::pair<int,int>> vLinks(m_vRegions.size());
+    for (size_t i=0;i<m_vRegions.size();i++) vLinks[i] = { ToIndex(m_vRegions[i].pDisplayPrev), ToIndex(m_vRegions[i].pDisplayNext) };
+
+    int iTop = ToIndex(m_pDisplayTop);
+    int iBot = ToIndex(m_pDisplayBot);
+
+    m_vRegions.reserve(m_vRegions.capacity()*2 > kMaxMouseRegions ? m_vRegions.capacity()*2 : kMaxMouseRegions);
+
+    auto ToPointer = [&](int iIndex) { return iIndex < 0 ? nullptr : &m_vRegions[iIndex]; };
+
+    for (size_t i=0;i<m_vRegions.size();i++)
+    {
+        m_vRegions[i].pDisplayPrev = ToPointer(vLinks[i].first);
+        m_vRegions[i].pDisplayNext = ToPointer(vLinks[i].second);
+    }
+    m_pDisplayTop = ToPointer(iTop);
+    m_pDisplayBot = ToPointer(iBot);
+
+    // The hit index is keyed on region indexes, so it stays valid as the storage moves
+}
 #if 1
 POINT MouseRegion::AdjusttoRect(int iRegion,RECT rRect)
 {
@@ -232,6 +350,7 @@ POINT MouseRegion::AdjusttoSizeRect(Region & r,SizeRect sizeRect,bool * bAdjuste
             m_bMovePending = true; 
             m_cfPending = { fxNew, fyNew };
         }
+        UpdateHitIndex(r);
     }
     if (bAdjusted) *bAdjusted = bSet;
     return { (decltype(std::declval<POINT>().x)) r.fx, (decltype(std::declval<POINT>().x)) r.fy };
@@ -264,6 +383,7 @@ bool MouseRegion::SetPos(int iIndex,POINT pLoc)
 
         region.fxOrg = region.fx;
         region.fyOrg = region.fy; 
+        UpdateHitIndex(region);
     }
     else
     {
@@ -299,6 +419,7 @@ void MouseRegion::EndMouseDrag()
             r.fy = r.fyOrg = m_cfPending.y; 
 
             m_bMovePending = false;
+            UpdateHitIndex(r);
         }
     }
 };
@@ -397,6 +518,7 @@ void MouseRegion::UpdatePoints()
 
             if (r.bisOOB) r.cfOOB = cfOld;
         }
+        UpdateHitIndex(r);
 //        SageDebug::printf("{g}{%.2f,%.2f}, {y}{%.2f,%.2f}\n",r.fx,r.fy,r.cfOOB.x,r.cfOOB.y);
 
     }
@@ -407,6 +529,14 @@ void MouseRegion::UpdatePoints()
 
         auto * pr = m_pDisplayTop; 
 
+        // With the hit index, go straight to the topmost point/region under the mouse (if any)
+
+        if (auto pIndex = GetHitIndex())
+        {
+            int iHit = pIndex->HitTest(pMouse.x,pMouse.y);
+            pr = iHit >= 0 ? &v[iHit] : nullptr;
+        }
+
         //for (int i=0;i<m_iActiveRegions;i++)
         while (pr)
         {
@@ -466,6 +596,7 @@ void MouseRegion::UpdatePoints()
                     r.bisOOB = false; // if the object was out-of-bounds, then set it to the current point.
                     r.bDisplayOOB = false;
                     r.cfOOB = { r.fx, r.fy };
+                    UpdateHitIndex(r);
                     // SageDebug::printf("Mouse Click = {r}%d,%d\n",i,(int) r.ulInternalID); 
                     m_stEvents.ulClicked    = r.ulInternalID;
                     m_stEvents.ulSelected   = r.ulInternalID;
@@ -529,7 +660,7 @@ int MouseRegion::AddPoint(const SizeRect & sizeRect,const kwOpt & keywords)
 
 int MouseRegion::AddPoint(const POINT pLoc,const SIZE szSize,const kwOpt & keywords)
 {
-    if (m_iActiveRegions >= kMaxMouseRegions) return -1; 
+    GrowRegions();
    
     // Stop certain processes -- Mouse dragging, etc.
 
@@ -584,6 +715,7 @@ int MouseRegion::AddPoint(const POINT pLoc,const SIZE szSize,const kwOpt & keywo
    // if (m_pDisplayTop) pv->pDisplayPrev = pv;
 
     m_pDisplayTop = pv; 
+    UpdateHitIndex(*pv);
     
 
     if (opBoundingSR) SetBoundBox(rg.ulInternalID ,*opBoundingSR);
@@ -683,6 +815,7 @@ bool MouseRegion::AutoDrawIndex(int iIndex)
             if (fy + fWidth < 5.0f) { fy = -fHeight+5.0f; bDisplayOOB = true; }
             pos->bDisplayOOB = bDisplayOOB;
             pos->cfDisplayOOB = { fx, fy };
+            UpdateHitIndex(*pos);
 
             // Convert circles to squares when display OOB, since circles can be hidden in corners. 
 
@@ -715,7 +848,7 @@ int MouseRegion::AddRegion(const SizeRect & sizeRect,const kwOpt & keywords)
 
 int MouseRegion::AddRegion(const POINT pLoc,const SIZE szSize,const kwOpt & keywords) 
 {
-    if (m_iActiveRegions >= kMaxMouseRegions) return -1; 
+    GrowRegions();
 
     // Stop certain processes -- Mouse dragging, etc.
 
@@ -766,6 +899,7 @@ int MouseRegion::AddRegion(const POINT pLoc,const SIZE szSize,const kwOpt & keyw
    // if (m_pDisplayTop) pv->pDisplayPrev = pv;
 
     m_pDisplayTop = pv; 
+    UpdateHitIndex(*pv);
     
 
 
@@ -1257,6 +1391,10 @@ MouseRegion::MouseRegion(CWindow & cWin,const kwOpt & keywords) : m_cWin(cWin)
 {
     m_bValid = m_cWin.isValid(); 
     m_vRegions.reserve(kMaxMouseRegions); 
+    {
+        std::lock_guard<std::mutex> lock(g_mHitIndexLock);
+        EraseHitIndex(this);                // Left by a deleted MouseRegion at the same address
+    }
     SetOptions(keywords);
 }
 
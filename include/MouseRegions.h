@@ -1,6 +1,7 @@
 #pragma once
 namespace Sage
 {
+class CRegionIndex;
 
     class CWindow;
 
@@ -93,8 +94,8 @@ private:
 
     static inline AutoDrawDef m_stOrgAutoDrawDefaults = m_stAutoDrawDefaults;                   // Set initial defaults
 
-    static constexpr int kMaxMouseRegions = 1000;                                               // Current maxium number of mouse points.
-                                                                                                // Later to be changed to something more dynamic.
+    static constexpr int kMaxMouseRegions = 1000;                                               // Initial reservation for mouse points.  Storage grows past this
+                                                                                                // as needed (see GrowRegions())
     // Tracking the mouse events so we know what to report at any given time.
     //  
     struct EventTrack_t
@@ -219,6 +220,9 @@ private:
 
     InternalRegion * FindRegion(int iRegion);       // $$ Deprecated
     bool BringtoTop(InternalRegion & r);            // Brings the point/region to the top of the display order.
+    CRegionIndex * GetHitIndex();                   // Returns the hit index (see EnableHitIndex()), or nullptr when it is not enabled.  Kept outside of MouseRegion.
+    void UpdateHitIndex(InternalRegion & r);        // Updates the hit index for a point/region that may have moved (no-op if the index is not enabled)
+    void GrowRegions();                             // Grows region storage when full, re-linking the display order pointers
     
     MouseRegion(const MouseRegion &p);	    // Privatize copy-constructor to keep copies from happening
                                             // more specifically, to cause a compiler error on auto mr = cWin.GetMouseRegion(), vs. 
@@ -636,6 +640,27 @@ public:
     /// </summary>
     void UpdatePoints();
 
+    /// <summary>
+    /// Enables or disables the spatial hit index used to find the point or region under the mouse.
+    /// <para></para>
+    /// By default, UpdatePoints() walks the display order of all points and regions on every mouse move and click.  With many points (i.e. thousands
+    /// or more), this can become noticeable.  With the hit index enabled, the topmost point or region under the mouse is found in roughly constant time,
+    /// regardless of the number of points and regions.
+    /// <para></para>
+    /// --> The index is kept up-to-date automatically as points are added, moved (SetPos(), dragging), and brought to the top of the display order.
+    /// <para></para>
+    /// --> Results are the same as without the index -- the topmost point/region in the display order is always the one selected.
+    /// </summary>
+    /// <param name="bEnable"> - true to enable the index (default), false to go back to walking the display list.</param>
+    /// <param name="iCellSize"> - [optional] Grid cell size in pixels.  Use a size close to that of the typical point or region.  0 = default (64)</param>
+    /// <returns>true if ok, false if the Mouse Region is not valid.</returns>
+    bool EnableHitIndex(bool bEnable = true,int iCellSize = 0);
+
+    /// <summary>
+    /// Returns true if the spatial hit index is enabled.  See EnableHitIndex()
+    /// </summary>
+    bool isHitIndexEnabled();
+
     /// <summary>
     /// Returns true of the highlight Changed since the last call to HighlightChanged().
     /// <para></para>
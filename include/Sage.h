@@ -397,6 +397,13 @@ namespace Math
         MouseRButtonClicked,
         CloseWindowPressed,
 
+        // Input events stored by CEventQueue (see CWindow::EnableEventQueue()).  These are added at the end so the values above don't change.
+
+        MouseLButtonUnclicked,
+        MouseRButtonUnclicked,
+        MouseWheel,
+        KeyPress,
+
         // This list in-progress.  Not all events may be processed with ClearEvent() -- WindowResize is currently the only one intended, but others will follow. 
 
     };
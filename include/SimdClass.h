@@ -1,32 +1,139 @@
 #pragma once
 
+// SimdClass.h -- Simd128, Simd256, Simd512 and SimdScalar backend classes
+//
+// Each class exposes the same static interface (Add, Mul, CmpLt, Pack16us, Cvtu8Intf, Sin, Cos, etc.) over its native
+// vector type, so kernels can be written once as a template on the backend class and instantiated for each instruction set:
+//
+//      template<class Simd> void Gain(const unsigned char * sIn,unsigned char * sOut,int iCount,float fGain)
+//      {
+//          auto vGain = Simd::Vecf(fGain);
+//          for (int i=0;i<iCount;i += Simd::kSimdBytes32)
+//              Simd::StoreU8Int(sOut+i,Simd::CvttInt(Simd::Mul(Simd::CvtFloat(Simd::LoadU8Int(sIn+i)),vGain)));
+//      }
+//
+//      Gain<Simd256>(...);     Gain<SimdScalar>(...);    etc.
+//
+// Common interface (all four classes):
+//
+//      vFloat, vInt                        -- native float and int vector types (float and int for SimdScalar)
+//      kSimdBits, kSimdBytes32             -- vector width in bits, and number of 32-bit lanes
+//      Vecf, Vecii                         -- broadcast a float or int value
+//      Load/Store, LoadU/StoreU            -- aligned and unaligned float loads/stores
+//      LoadU8Int, StoreU8Int               -- load kSimdBytes32 unsigned chars as int lanes, and store int lanes back as
+//                                             unsigned chars (saturated to 0-255)
+//      Add, Sub, Mul, Div, Min, Max, Sqrt, RoundTrunc
+//      And, AndNot, Or, Xor                -- bitwise operations on float vectors (i.e. for compare masks)
+//      CmpLt, CmpGt, CmpEq                 -- return an all-ones/all-zeros float mask per lane
+//      Select(mask,a,b)                    -- b where mask is set, a where it is not
+//      CvtFloat, CvttInt                   -- int -> float and float -> int (truncated)
+//      Pack32us, Pack16us, Cvtu8Intf       -- saturating packs and unsigned char -> int conversion
+//      Sin, Cos                            -- with MSVC, the SVML functions (_mm_sin_ps, etc.) as before; with GCC and Clang,
+//                                             which have no SVML, the same as SinPoly and CosPoly.  SimdScalar uses std::sin/cos
+//      SinPoly, CosPoly                    -- polynomial approximations (see SimdSinCos() below), max error approx. 1e-7 for
+//                                             |x| < 8192, with the same results on every compiler and backend
+//
+// Portability
+//
+//      This file compiles with MSVC, GCC and Clang.  With GCC and Clang, the instruction set for a backend must be enabled
+//      (i.e. -mavx2, -mavx512f -mavx512bw or -march=native) in the translation unit that uses that backend.  Backends that are
+//      not used do not need to be enabled.
+//
+
+#if defined(_MSC_VER)
 #include "intrin.h"
+#else
+#include <immintrin.h>
+#endif
 #include "xmmintrin.h"
+#include <type_traits>
+#include <cstring>
+#include <cmath>
+
+#if !defined(_MSC_VER) && !defined(__forceinline)
+#define __forceinline inline __attribute__((always_inline))
+#endif
 
 //#define Vec256(_x) { _x,_x,_x,_x,_x,_x,_x,_x }
 
 #define SetSimd128
 
+// SimdSinCos() -- Sin/Cos polynomial approximation shared by all Simd backends
+//
+// This is the Cephes sinf/cosf method: the argument is reduced to [-pi/4,pi/4] with an extended-precision pi/4, then either
+// the sin or cos minimax polynomial is selected by octant.  It is written only with float operations (RoundTrunc, CmpEq, etc.)
+// so the same code works for every backend, including SimdScalar.
+//
+template<class Simd,class V>
+static __forceinline V SimdSinCos(V x,bool bCos)
+{
+    const V vSignBit    = Simd::Vecf(-0.0f);
+    const V vAbs        = Simd::AndNot(vSignBit,x);
+
+    // Octant, rounded up to even
+
+    V y = Simd::RoundTrunc(Simd::Mul(vAbs,Simd::Vecf(1.27323954473516f)));      // 4/pi
+    y = Simd::Add(y,Simd::Sub(y,Simd::Mul(Simd::Vecf(2.0f),Simd::RoundTrunc(Simd::Mul(y,Simd::Vecf(0.5f))))));
+
+    // Quadrant (0,2,4,6).  cos(x) = sin(x + pi/2), so cos shifts the quadrant by 2.
+
+    V q = bCos ? Simd::Add(y,Simd::Vecf(2.0f)) : y;
+    q = Simd::Sub(q,Simd::Mul(Simd::Vecf(8.0f),Simd::RoundTrunc(Simd::Mul(q,Simd::Vecf(0.125f)))));
+
+    V vUseCos   = Simd::CmpEq(Simd::Sub(q,Simd::Mul(Simd::Vecf(4.0f),Simd::RoundTrunc(Simd::Mul(q,Simd::Vecf(0.25f))))),Simd::Vecf(2.0f));
+    V vSign     = Simd::And(Simd::CmpGt(q,Simd::Vecf(3.0f)),vSignBit);
+    if (!bCos) vSign = Simd::Xor(vSign,Simd::And(x,vSignBit));                   // sin is odd, cos is even
+
+    // Extended precision reduction: r = ((|x| - y*DP1) - y*DP2) - y*DP3
+
+    V r = Simd::Sub(vAbs,Simd::Mul(y,Simd::Vecf(0.78515625f)));
+    r   = Simd::Sub(r,Simd::Mul(y,Simd::Vecf(2.4187564849853515625e-4f)));
+    r   = Simd::Sub(r,Simd::Mul(y,Simd::Vecf(3.77489497744594108e-8f)));
 
+    V z = Simd::Mul(r,r);
+
+    V vCos = Simd::Add(Simd::Mul(Simd::Vecf(2.443315711809948e-5f),z),Simd::Vecf(-1.388731625493765e-3f));
+    vCos = Simd::Add(Simd::Mul(vCos,z),Simd::Vecf(4.166664568298827e-2f));
+    vCos = Simd::Mul(Simd::Mul(vCos,z),z);
+    vCos = Simd::Add(Simd::Sub(vCos,Simd::Mul(z,Simd::Vecf(0.5f))),Simd::Vecf(1.0f));
+
+    V vSin = Simd::Add(Simd::Mul(Simd::Vecf(-1.9515295891e-4f),z),Simd::Vecf(8.3321608736e-3f));
+    vSin = Simd::Add(Simd::Mul(vSin,z),Simd::Vecf(-1.6666654611e-1f));
+    vSin = Simd::Add(Simd::Mul(Simd::Mul(vSin,z),r),r);
+
+    return Simd::Xor(Simd::Select(vUseCos,vSin,vCos),vSign);
+}
 
 class Simd128
 {
 public:
+    using vFloat = __m128;
+    using vInt   = __m128i;
+
     static constexpr unsigned int kSimdBits = 128;
     static constexpr int kSimdBytes32 = 4;
     static constexpr int kSimdAnd32   = 3;
 
 static constexpr __m128 Vec128(float _x) { return  __m128{ _x,_x,_x,_x }; }
-static constexpr __m128i Vec128i(int _x1,  int _x2, int _x3,  int _x4) 
+#if defined(_MSC_VER)
+static constexpr __m128i Vec128i(int _x1,  int _x2, int _x3,  int _x4)
         { return  __m128i{ (char) _x1,(char) _x2,(char) _x3,(char) _x4, (char) _x1, (char) _x2, (char) _x3,(char) _x4,
                            (char) _x1,(char) _x2,(char) _x3,(char) _x4, (char) _x1, (char) _x2, (char) _x3,(char) _x4 }; }
 
 static constexpr __m256 Vec256(float _x) { return  __m256{ _x,_x,_x,_x, _x,_x,_x,_x }; }
-static constexpr __m256i Vec256i(int _x1,  int _x2, int _x3,  int _x4) 
+static constexpr __m256i Vec256i(int _x1,  int _x2, int _x3,  int _x4)
     { return  __m256i{  (char) _x1,(char) _x2,(char) _x3,(char) _x4, (char) _x1, (char) _x2, (char) _x3,(char) _x4,
                         (char) _x1,(char) _x2,(char) _x3,(char) _x4, (char) _x1, (char) _x2, (char) _x3,(char) _x4,
                         (char) _x1,(char) _x2,(char) _x3,(char) _x4, (char) _x1, (char) _x2, (char) _x3,(char) _x4,
                         (char) _x1,(char) _x2,(char) _x3,(char) _x4, (char) _x1, (char) _x2, (char) _x3,(char) _x4 }; }
+#else
+    // GCC/Clang integer vectors are 64-bit element vectors and can't be brace-constructed from chars
+
+    static __forceinline __m128i Vec128i(int _x1,  int _x2, int _x3,  int _x4)
+        { return _mm_setr_epi8((char) _x1,(char) _x2,(char) _x3,(char) _x4, (char) _x1, (char) _x2, (char) _x3,(char) _x4,
+                               (char) _x1,(char) _x2,(char) _x3,(char) _x4, (char) _x1, (char) _x2, (char) _x3,(char) _x4); }
+    static constexpr __m256 Vec256(float _x) { return  __m256{ _x,_x,_x,_x, _x,_x,_x,_x }; }
+#endif
 
 
 
@@ -35,8 +142,10 @@ static constexpr __m256i Vec256i(int _x1,  int _x2, int _x3,  int _x4)
     static __forceinline __m128 And(__m128 a,__m128 b)           { return _mm_and_ps(a,b); };
     static __forceinline __m128 CmpLt(__m128 a,__m128 b)         { return _mm_cmplt_ps(a,b); };
     static __forceinline __m128 CmpGt(__m128 a,__m128 b)         { return _mm_cmpgt_ps(a,b); };
+    static __forceinline __m128 CmpEq(__m128 a,__m128 b)         { return _mm_cmpeq_ps(a,b); };
     static __forceinline __m128  AndNot(__m128 a,__m128 b)       { return _mm_andnot_ps(a,b); };
     static __forceinline __m128 Or(__m128 a,__m128 b)            { return _mm_or_ps(a,b); };
+    static __forceinline __m128 Select(__m128 m,__m128 a,__m128 b) { return _mm_or_ps(_mm_and_ps(m,b),_mm_andnot_ps(m,a)); };
     static __forceinline __m128 RoundTrunc(__m128 a)             { return _mm_round_ps(a,_MM_FROUND_TRUNC); };
     static __forceinline __m128 Sub(__m128 a,__m128 b)           { return _mm_sub_ps(a,b); };
     static __forceinline __m128 Add(__m128 a,__m128 b)           { return _mm_add_ps(a,b); };
@@ -46,29 +155,61 @@ static constexpr __m256i Vec256i(int _x1,  int _x2, int _x3,  int _x4)
     static __forceinline __m128 Sqrt(__m128 a)                   { return _mm_sqrt_ps(a); };
     static __forceinline __m128i Cvttps_Epi32(__m128 a)          { return _mm_cvttps_epi32(a); };
     static __forceinline __m128 Min(__m128 a,__m128 b)           { return _mm_min_ps(a,b); };
+    static __forceinline __m128 Max(__m128 a,__m128 b)           { return _mm_max_ps(a,b); };
     static __forceinline __m128i Unpackhi_epi32(__m128i a,__m128i b)   { return _mm_unpackhi_epi32(a,b); };
     static __forceinline __m128i Unpacklo_epi32(__m128i a,__m128i b)   { return _mm_unpacklo_epi32(a,b); };
     static __forceinline __m128i Packs_epi32(__m128i a,__m128i b)   { return _mm_packs_epi32(a,b); };
     static __forceinline __m128i Packus_epi16(__m128i a,__m128i b)   { return _mm_packus_epi16(a,b); };
+#if defined(_MSC_VER)
     static __forceinline __m128 Sin(__m128 a)                   { return _mm_sin_ps(a); };
     static __forceinline __m128 Cos(__m128 a)                   { return _mm_cos_ps(a); };
+#else
+    static __forceinline __m128 Sin(__m128 a)                   { return SimdSinCos<Simd128>(a,false); };
+    static __forceinline __m128 Cos(__m128 a)                   { return SimdSinCos<Simd128>(a,true); };
+#endif
+    static __forceinline __m128 SinPoly(__m128 a)               { return SimdSinCos<Simd128>(a,false); };
+    static __forceinline __m128 CosPoly(__m128 a)               { return SimdSinCos<Simd128>(a,true); };
 
     static __forceinline __m128i Veci64(int iValue)             { return _mm_set1_epi64x(iValue); }
     static __forceinline __m128i Veci(int iValue)               { return _mm_set1_epi32(iValue); }
+    static __forceinline __m128i Vecii(int iValue)              { return _mm_set1_epi32(iValue); }
     static __forceinline __m128d Vecd(double fValue)            { return _mm_set1_pd(fValue); }
     static __forceinline __m128  Vecf(float fValue)             { return _mm_set1_ps(fValue); }
     static __forceinline __m128i Vecic(char cValue)             { return _mm_set1_epi8(cValue); };
     static __forceinline __m128i Veciuc(unsigned char ucValue)  { return _mm_set1_epi8((char) ucValue); };
-    static __forceinline __m128  Load(float * fAddr)                { return _mm_load_ps(fAddr); };
+    static __forceinline __m128  Load(const float * fAddr)                { return _mm_load_ps(fAddr); };
     static __forceinline void    Store(float * fAddr,__m128 fValue) { return _mm_store_ps(fAddr,fValue); };
+    static __forceinline __m128  LoadU(const float * fAddr)                { return _mm_loadu_ps(fAddr); };
+    static __forceinline void    StoreU(float * fAddr,__m128 fValue) { return _mm_storeu_ps(fAddr,fValue); };
     static __forceinline __m128  Load1(float * fAddr)                { return _mm_load1_ps(fAddr); };
     static __forceinline __m128d  Load1(double * fAddr)             { return _mm_load1_pd(fAddr); };
 
+    static __forceinline __m128  CvtFloat(__m128i a)                { return _mm_cvtepi32_ps(a); }
+    static __forceinline __m128i CvttInt(__m128 a)                  { return _mm_cvttps_epi32(a); }
+    static __forceinline __m128i Pack32us(__m128i a,__m128i b)      { return _mm_packus_epi32(a,b); }
+    static __forceinline __m128i Pack32us(__m128i a)                { return _mm_packus_epi32(a,a); }
+    static __forceinline __m128i Pack16us(__m128i a,__m128i b)      { return _mm_packus_epi16(a,b); }
+    static __forceinline __m128i Pack16us(__m128i a)                { return _mm_packus_epi16(a,a); }
+    static __forceinline __m128i Cvtu8Intf(__m128i a)               { return _mm_cvtepu8_epi32(a); }
+
+    static __forceinline __m128i LoadU8Int(const unsigned char * sAddr)
+    {
+        int iValue; memcpy(&iValue,sAddr,sizeof(iValue));
+        return _mm_cvtepu8_epi32(_mm_cvtsi32_si128(iValue));
+    }
+    static __forceinline void StoreU8Int(unsigned char * sAddr,__m128i a)
+    {
+        int iValue = _mm_cvtsi128_si32(Pack16us(Pack32us(a)));
+        memcpy(sAddr,&iValue,sizeof(iValue));
+    }
 };
 
 class Simd256
 {
 public:
+    using vFloat = __m256;
+    using vInt   = __m256i;
+
     static constexpr unsigned int kSimdBits     = 256;
     static constexpr int kSimdCharBytes  = 32;
     static constexpr int kSimdBytes32    = 8;
@@ -78,24 +219,31 @@ public:
     static constexpr int kSimdCharAnd    = 31;
 
     template<typename T>
-    static constexpr const int GetSimdBytes()
+    static constexpr int GetSimdBytes()
     {
         return std::is_same<float,T>::value ? kSimdBytes32 : kSimdBytes64;
     }
     static constexpr __m128 Vec128(float _x) { return  __m128{ _x,_x,_x,_x }; }
-static constexpr __m128i Vec128i(int _x1,  int _x2, int _x3,  int _x4) 
+#if defined(_MSC_VER)
+static constexpr __m128i Vec128i(int _x1,  int _x2, int _x3,  int _x4)
         { return  __m128i{ (char) _x1,(char) _x2,(char) _x3,(char) _x4, (char) _x1, (char) _x2, (char) _x3,(char) _x4,
                            (char) _x1,(char) _x2,(char) _x3,(char) _x4, (char) _x1, (char) _x2, (char) _x3,(char) _x4 }; }
+#endif
 
 static constexpr __m256 Vec256f(float _x) { return  __m256{ _x,_x,_x,_x, _x,_x,_x,_x }; }
 static constexpr __m256 Vec256(float _x) { return  __m256{ _x,_x,_x,_x, _x,_x,_x,_x }; }
 static constexpr __m256d Vec256(double _x) { return  __m256d{ _x,_x,_x,_x, }; }
 static constexpr __m256d Vec256d(double _x) { return  __m256d{ _x,_x,_x,_x }; }
-static constexpr __m256i Vec256i(int _x1,  int _x2, int _x3,  int _x4) 
+#if defined(_MSC_VER)
+static constexpr __m256i Vec256i(int _x1,  int _x2, int _x3,  int _x4)
     { return  __m256i{  (char) _x1,(char) _x2,(char) _x3,(char) _x4, (char) _x1, (char) _x2, (char) _x3,(char) _x4,
                         (char) _x1,(char) _x2,(char) _x3,(char) _x4, (char) _x1, (char) _x2, (char) _x3,(char) _x4,
                         (char) _x1,(char) _x2,(char) _x3,(char) _x4, (char) _x1, (char) _x2, (char) _x3,(char) _x4,
                         (char) _x1,(char) _x2,(char) _x3,(char) _x4, (char) _x1, (char) _x2, (char) _x3,(char) _x4 }; }
+#else
+    static __forceinline __m256i Vec256i(int _x1,  int _x2, int _x3,  int _x4)
+        { return _mm256_set1_epi32((int) ((_x1 & 0xFF) | (_x2 & 0xFF) << 8 | (_x3 & 0xFF) << 16 | (unsigned int) (_x4 & 0xFF) << 24)); }
+#endif
 
 
 
@@ -104,8 +252,10 @@ static constexpr __m256i Vec256i(int _x1,  int _x2, int _x3,  int _x4)
     static __forceinline __m256 And(__m256 a,__m256 b)           { return _mm256_and_ps(a,b); };
     static __forceinline __m256 CmpLt(__m256 a,__m256 b)         { return _mm256_cmp_ps(a,b,_CMP_LT_OQ); };
     static __forceinline __m256 CmpGt(__m256 a,__m256 b)         { return _mm256_cmp_ps(a,b,_CMP_GT_OQ); };
+    static __forceinline __m256 CmpEq(__m256 a,__m256 b)         { return _mm256_cmp_ps(a,b,_CMP_EQ_OQ); };
     static __forceinline __m256  AndNot(__m256 a,__m256 b)       { return _mm256_andnot_ps(a,b); };
     static __forceinline __m256 Or(__m256 a,__m256 b)            { return _mm256_or_ps(a,b); };
+    static __forceinline __m256 Select(__m256 m,__m256 a,__m256 b) { return _mm256_blendv_ps(a,b,m); };
     static __forceinline __m256 RoundTrunc(__m256 a)             { return _mm256_round_ps(a,_MM_FROUND_TRUNC); };
     static __forceinline __m256 Sub(__m256 a,__m256 b)           { return _mm256_sub_ps(a,b); };
     static __forceinline __m256 Add(__m256 a,__m256 b)           { return _mm256_add_ps(a,b); };
@@ -115,12 +265,20 @@ static constexpr __m256i Vec256i(int _x1,  int _x2, int _x3,  int _x4)
     static __forceinline __m256 Sqrt(__m256 a)                   { return _mm256_sqrt_ps(a); };
     static __forceinline __m256i Cvttps_Epi32(__m256 a)          { return _mm256_cvttps_epi32(a); };
     static __forceinline __m256 Min(__m256 a,__m256 b)           { return _mm256_min_ps(a,b); };
+    static __forceinline __m256 Max(__m256 a,__m256 b)           { return _mm256_max_ps(a,b); };
     static __forceinline __m256i Unpackhi_epi32(__m256i a,__m256i b)   { return _mm256_unpackhi_epi32(a,b); };
     static __forceinline __m256i Unpacklo_epi32(__m256i a,__m256i b)   { return _mm256_unpacklo_epi32(a,b); };
     static __forceinline __m256i Packs_epi32(__m256i a,__m256i b)   { return _mm256_packs_epi32(a,b); };
     static __forceinline __m256i Packus_epi16(__m256i a,__m256i b)   { return _mm256_packus_epi16(a,b); };
+#if defined(_MSC_VER)
     static __forceinline __m256 Sin(__m256 a)                   { return _mm256_sin_ps(a); };
     static __forceinline __m256 Cos(__m256 a)                   { return _mm256_cos_ps(a); };
+#else
+    static __forceinline __m256 Sin(__m256 a)                   { return SimdSinCos<Simd256>(a,false); };
+    static __forceinline __m256 Cos(__m256 a)                   { return SimdSinCos<Simd256>(a,true); };
+#endif
+    static __forceinline __m256 SinPoly(__m256 a)               { return SimdSinCos<Simd256>(a,false); };
+    static __forceinline __m256 CosPoly(__m256 a)               { return SimdSinCos<Simd256>(a,true); };
 
     static __forceinline __m256i Veci64(int iValue)                 { return _mm256_set1_epi64x(iValue); }
     static __forceinline __m256i Vecii(int iValue)                  { return _mm256_set1_epi32(iValue); }
@@ -130,7 +288,9 @@ static constexpr __m256i Vec256i(int _x1,  int _x2, int _x3,  int _x4)
     static __forceinline __m256i Veciuc(unsigned char ucValue)      { return _mm256_set1_epi8((char) ucValue); };
     static __forceinline __m256  Load(const float * fAddr)                { return _mm256_load_ps(fAddr); };
     static __forceinline void    Store(float * fAddr,__m256 fValue) { return _mm256_store_ps(fAddr,fValue); };
-    
+    static __forceinline __m256  LoadU(const float * fAddr)                { return _mm256_loadu_ps(fAddr); };
+    static __forceinline void    StoreU(float * fAddr,__m256 fValue) { return _mm256_storeu_ps(fAddr,fValue); };
+
     // double functions (added as needed, so this will be incomplete for longer than float versions above)
 
     static __forceinline __m256d Vecfd(double fValue)                   { return _mm256_set1_pd(fValue); }
@@ -169,10 +329,10 @@ static constexpr __m256i Vec256i(int _x1,  int _x2, int _x3,  int _x4)
 
     template<typename inType = float>
     static __forceinline __m256i Cvtu8Int(__m128i a)    { return std::is_same<float,inType>::value ? _mm256_cvtepu8_epi32(a) : _mm256_cvtepu8_epi64(a); }
-    
+
     template<typename inType = float>
     static __forceinline __m256i Cvtu8Int(__m128 a)     { return std::is_same<float,inType>::value ?  _mm256_cvtepu8_epi32(_mm_castps_si128(a)) :  _mm256_cvtepu8_epi64(_mm_castps_si128(a)); }
-    
+
     template<typename inType = float>
     static __forceinline __m256i Cvtu8Int(__m128d a)    { return std::is_same<float,inType>::value ?  _mm256_cvtepu8_epi32(_mm_castpd_si128(a)) :  _mm256_cvtepu8_epi64(_mm_castpd_si128(a)) ; }
 
@@ -187,6 +347,17 @@ static constexpr __m256i Vec256i(int _x1,  int _x2, int _x3,  int _x4)
     static __forceinline __m256i Cvtu8Intf(__m128 a)     { return _mm256_cvtepu8_epi32(_mm_castps_si128(a)); }
     static __forceinline __m256i Cvtu8Intf(__m128d a)    { return _mm256_cvtepu8_epi32(_mm_castpd_si128(a)) ; }
 
+    static __forceinline __m256i LoadU8Int(const unsigned char * sAddr) { return _mm256_cvtepu8_epi32(_mm_loadl_epi64((const __m128i *) sAddr)); }
+
+    // The 256-bit packs work within each 128-bit lane, so the low 4 bytes of each lane hold the result.
+
+    static __forceinline void StoreU8Int(unsigned char * sAddr,__m256i a)
+    {
+        __m256i b = _mm256_packus_epi16(_mm256_packus_epi32(a,a),_mm256_setzero_si256());
+        int iValue[2] = { _mm_cvtsi128_si32(_mm256_castsi256_si128(b)), _mm_cvtsi128_si32(_mm256_extracti128_si256(b,1)) };
+        memcpy(sAddr,iValue,sizeof(iValue));
+    }
+
     template<int i>
     static __forceinline int Extract16(__m256i a) { return _mm256_extract_epi16(a,i); }
 
@@ -202,17 +373,20 @@ static constexpr __m256i Vec256i(int _x1,  int _x2, int _x3,  int _x4)
 class Simd512
 {
 public:
+    using vFloat = __m512;
+    using vInt   = __m512i;
+
     static constexpr unsigned int kSimdBits     = 512;
     static constexpr int kSimdBytes32    = 16;
     static constexpr int kSimdAnd32      = 15;
 
 //    static constexpr __m128 Vec128(float _x) { return  __m128{ _x,_x,_x,_x }; }
-//static constexpr __m128i Vec128i(int _x1,  int _x2, int _x3,  int _x4) 
+//static constexpr __m128i Vec128i(int _x1,  int _x2, int _x3,  int _x4)
 //        { return  __m128i{ (char) _x1,(char) _x2,(char) _x3,(char) _x4, (char) _x1, (char) _x2, (char) _x3,(char) _x4,
 //                           (char) _x1,(char) _x2,(char) _x3,(char) _x4, (char) _x1, (char) _x2, (char) _x3,(char) _x4 }; }
 //
 //static constexpr __m256 Vec256(float _x) { return  __m256{ _x,_x,_x,_x, _x,_x,_x,_x }; }
-//static constexpr __m256i Vec256i(int _x1,  int _x2, int _x3,  int _x4) 
+//static constexpr __m256i Vec256i(int _x1,  int _x2, int _x3,  int _x4)
 //    { return  __m256i{  (char) _x1,(char) _x2,(char) _x3,(char) _x4, (char) _x1, (char) _x2, (char) _x3,(char) _x4,
 //                        (char) _x1,(char) _x2,(char) _x3,(char) _x4, (char) _x1, (char) _x2, (char) _x3,(char) _x4,
 //                        (char) _x1,(char) _x2,(char) _x3,(char) _x4, (char) _x1, (char) _x2, (char) _x3,(char) _x4,
@@ -220,7 +394,7 @@ public:
 //
 //
 static constexpr __m512 Vec512(float _x) { return  __m512{ _x,_x,_x,_x, _x,_x,_x,_x, _x,_x,_x,_x, _x,_x,_x,_x }; }
-//static constexpr __m512i Vec512i(int _x1,  int _x2, int _x3,  int _x4) 
+//static constexpr __m512i Vec512i(int _x1,  int _x2, int _x3,  int _x4)
 //    { return  __m512i{  (char) _x1,(char) _x2,(char) _x3,(char) _x4, (char) _x1, (char) _x2, (char) _x3,(char) _x4,
 //                        (char) _x1,(char) _x2,(char) _x3,(char) _x4, (char) _x1, (char) _x2, (char) _x3,(char) _x4,
 //                        (char) _x1,(char) _x2,(char) _x3,(char) _x4, (char) _x1, (char) _x2, (char) _x3,(char) _x4,
@@ -234,26 +408,40 @@ static constexpr __m512 Vec512(float _x) { return  __m512{ _x,_x,_x,_x, _x,_x,_x
 
  //   static __forceinline __m256 Vec(float a) { return Vec256(a); }
  //   static __forceinline __m256i Veci(int x1,int x2,int x3,int x4) { return Vec256i(x1,x2,x3,x4); }
-    static __forceinline __m512 And(__m512 a,__m512 b)           { return _mm512_and_ps(a,b); };
-    static __forceinline __m512 CmpLt(__m512 a,__m512 b)         { return _mm512_castsi512_ps(_mm512_maskz_set1_epi32(_mm512_cmp_ps_mask(a,b,_CMP_LT_OQ),0xFFFFFFFF)); };
-    static __forceinline __m512 CmpGt(__m512 a,__m512 b)         { return _mm512_castsi512_ps(_mm512_maskz_set1_epi32(_mm512_cmp_ps_mask(a,b,_CMP_GT_OQ),0xFFFFFFFF)); };
-    static __forceinline __m512  AndNot(__m512 a,__m512 b)       { return _mm512_andnot_ps(a,b); };
-    static __forceinline __m512 Or(__m512 a,__m512 b)            { return _mm512_or_ps(a,b); };
-    static __forceinline __m512 RoundTrunc(__m512 a)             { return _mm512_trunc_ps(a); };
+
+    // Note: the float bitwise operations are done as integer operations so that only AVX512F is required
+    //       (_mm512_and_ps, etc. are AVX512DQ)
+
+    static __forceinline __m512 And(__m512 a,__m512 b)           { return _mm512_castsi512_ps(_mm512_and_si512(_mm512_castps_si512(a),_mm512_castps_si512(b))); };
+    static __forceinline __m512 CmpLt(__m512 a,__m512 b)         { return _mm512_castsi512_ps(_mm512_maskz_set1_epi32(_mm512_cmp_ps_mask(a,b,_CMP_LT_OQ),(int) 0xFFFFFFFF)); };
+    static __forceinline __m512 CmpGt(__m512 a,__m512 b)         { return _mm512_castsi512_ps(_mm512_maskz_set1_epi32(_mm512_cmp_ps_mask(a,b,_CMP_GT_OQ),(int) 0xFFFFFFFF)); };
+    static __forceinline __m512 CmpEq(__m512 a,__m512 b)         { return _mm512_castsi512_ps(_mm512_maskz_set1_epi32(_mm512_cmp_ps_mask(a,b,_CMP_EQ_OQ),(int) 0xFFFFFFFF)); };
+    static __forceinline __m512  AndNot(__m512 a,__m512 b)       { return _mm512_castsi512_ps(_mm512_andnot_si512(_mm512_castps_si512(a),_mm512_castps_si512(b))); };
+    static __forceinline __m512 Or(__m512 a,__m512 b)            { return _mm512_castsi512_ps(_mm512_or_si512(_mm512_castps_si512(a),_mm512_castps_si512(b))); };
+    static __forceinline __m512 Select(__m512 m,__m512 a,__m512 b) { return _mm512_mask_blend_ps(_mm512_movepi32_mask_f(m),a,b); };
+    static __forceinline __m512 RoundTrunc(__m512 a)             { return _mm512_roundscale_ps(a,_MM_FROUND_TO_ZERO | _MM_FROUND_NO_EXC); };
     static __forceinline __m512 Sub(__m512 a,__m512 b)           { return _mm512_sub_ps(a,b); };
     static __forceinline __m512 Add(__m512 a,__m512 b)           { return _mm512_add_ps(a,b); };
     static __forceinline __m512 Div(__m512 a,__m512 b)           { return _mm512_div_ps(a,b); };
     static __forceinline __m512 Mul(__m512 a,__m512 b)           { return _mm512_mul_ps(a,b); };
-    static __forceinline __m512 Xor(__m512 a,__m512 b)           { return _mm512_xor_ps(a,b); };
+    static __forceinline __m512 Xor(__m512 a,__m512 b)           { return _mm512_castsi512_ps(_mm512_xor_si512(_mm512_castps_si512(a),_mm512_castps_si512(b))); };
     static __forceinline __m512 Sqrt(__m512 a)                   { return _mm512_sqrt_ps(a); };
     static __forceinline __m512i Cvttps_Epi32(__m512 a)          { return _mm512_cvttps_epi32(a); };
     static __forceinline __m512 Min(__m512 a,__m512 b)           { return _mm512_min_ps(a,b); };
+    static __forceinline __m512 Max(__m512 a,__m512 b)           { return _mm512_max_ps(a,b); };
     static __forceinline __m512i Unpackhi_epi32(__m512i a,__m512i b)   { return _mm512_unpackhi_epi32(a,b); };
     static __forceinline __m512i Unpacklo_epi32(__m512i a,__m512i b)   { return _mm512_unpacklo_epi32(a,b); };
     static __forceinline __m512i Packs_epi32(__m512i a,__m512i b)   { return _mm512_packs_epi32(a,b); };
     static __forceinline __m512i Packus_epi16(__m512i a,__m512i b)   { return _mm512_packus_epi16(a,b); };
+#if defined(_MSC_VER)
     static __forceinline __m512 Sin(__m512 a)                   { return _mm512_sin_ps(a); };
     static __forceinline __m512 Cos(__m512 a)                   { return _mm512_cos_ps(a); };
+#else
+    static __forceinline __m512 Sin(__m512 a)                   { return SimdSinCos<Simd512>(a,false); };
+    static __forceinline __m512 Cos(__m512 a)                   { return SimdSinCos<Simd512>(a,true); };
+#endif
+    static __forceinline __m512 SinPoly(__m512 a)               { return SimdSinCos<Simd512>(a,false); };
+    static __forceinline __m512 CosPoly(__m512 a)               { return SimdSinCos<Simd512>(a,true); };
 
     static __forceinline __m512i Veci64(int iValue)             { return _mm512_set1_epi64(iValue); }
     static __forceinline __m512i Vecii(int iValue)               { return _mm512_set1_epi32(iValue); }
@@ -261,10 +449,91 @@ static constexpr __m512 Vec512(float _x) { return  __m512{ _x,_x,_x,_x, _x,_x,_x
     static __forceinline __m512  Vecf(float fValue)             { return _mm512_set1_ps(fValue); }
     static __forceinline __m512i Vecic(char cValue)             { return _mm512_set1_epi8(cValue); };
     static __forceinline __m512i Veciuc(unsigned char ucValue)  { return _mm512_set1_epi8((char) ucValue); };
-    static __forceinline __m512  Load(float * fAddr)             { return _mm512_load_ps(fAddr); };
+    static __forceinline __m512  Load(const float * fAddr)             { return _mm512_load_ps(fAddr); };
     static __forceinline void Store(float * fAddr,__m512 fValue) { return _mm512_store_ps(fAddr,fValue); };
+    static __forceinline __m512  LoadU(const float * fAddr)             { return _mm512_loadu_ps(fAddr); };
+    static __forceinline void StoreU(float * fAddr,__m512 fValue) { return _mm512_storeu_ps(fAddr,fValue); };
+
+    static __forceinline __m512  CvtFloat(__m512i a)                { return _mm512_cvtepi32_ps(a); }
+    static __forceinline __m512i CvttInt(__m512 a)                  { return _mm512_cvttps_epi32(a); }
+    static __forceinline __m512i Pack32us(__m512i a,__m512i b)      { return _mm512_packus_epi32(a,b); }
+    static __forceinline __m512i Pack16us(__m512i a,__m512i b)      { return _mm512_packus_epi16(a,b); }
+    static __forceinline __m512i Pack16us(__m512i a)                { return _mm512_packus_epi16(a,a); }
+    static __forceinline __m512i Cvtu8Intf(__m128i a)               { return _mm512_cvtepu8_epi32(a); }
+
+    static __forceinline __m512i LoadU8Int(const unsigned char * sAddr) { return _mm512_cvtepu8_epi32(_mm_loadu_si128((const __m128i *) sAddr)); }
+    static __forceinline void StoreU8Int(unsigned char * sAddr,__m512i a)
+    {
+        _mm_storeu_si128((__m128i *) sAddr,_mm512_cvtusepi32_epi8(_mm512_max_epi32(a,_mm512_setzero_si512())));
+    }
 
+private:
+    // Sign bit of each 32-bit lane to a mask register, using AVX512F only (_mm512_movepi32_mask() is AVX512DQ)
 
+    static __forceinline __mmask16 _mm512_movepi32_mask_f(__m512 m) { return _mm512_cmplt_epi32_mask(_mm512_castps_si512(m),_mm512_setzero_si512()); }
+public:
 
     #define Extractf128_si256(a,iIndex)  _mm256_extractf128_si256(a,iIndex)
 };
+
+// SimdScalar -- one-lane backend with the same interface as Simd128/256/512
+//
+// This is the reference implementation for kernels templated on the Simd classes.  It needs no particular instruction set,
+// so it can be used as the fallback path, for remainders, and as the baseline when benchmarking the vector backends.
+//
+// Masks follow the vector conventions: compares return a float with all bits set (true) or all bits clear (false).
+//
+class SimdScalar
+{
+    static __forceinline unsigned int Bits(float f)         { unsigned int u; memcpy(&u,&f,sizeof(u)); return u; }
+    static __forceinline float Float(unsigned int u)        { float f; memcpy(&f,&u,sizeof(f)); return f; }
+    static __forceinline float Mask(bool b)                 { return Float(b ? 0xFFFFFFFF : 0); }
+
+public:
+    using vFloat = float;
+    using vInt   = int;
+
+    static constexpr unsigned int kSimdBits = 32;
+    static constexpr int kSimdBytes32 = 1;
+    static constexpr int kSimdAnd32   = 0;
+
+    static __forceinline float And(float a,float b)             { return Float(Bits(a) & Bits(b)); };
+    static __forceinline float CmpLt(float a,float b)           { return Mask(a < b); };
+    static __forceinline float CmpGt(float a,float b)           { return Mask(a > b); };
+    static __forceinline float CmpEq(float a,float b)           { return Mask(a == b); };
+    static __forceinline float AndNot(float a,float b)          { return Float(~Bits(a) & Bits(b)); };
+    static __forceinline float Or(float a,float b)              { return Float(Bits(a) | Bits(b)); };
+    static __forceinline float Select(float m,float a,float b)  { return Bits(m) ? b : a; };
+    static __forceinline float RoundTrunc(float a)              { return std::trunc(a); };
+    static __forceinline float Sub(float a,float b)             { return a-b; };
+    static __forceinline float Add(float a,float b)             { return a+b; };
+    static __forceinline float Div(float a,float b)             { return a/b; };
+    static __forceinline float Mul(float a,float b)             { return a*b; };
+    static __forceinline float Xor(float a,float b)             { return Float(Bits(a) ^ Bits(b)); };
+    static __forceinline float Sqrt(float a)                    { return std::sqrt(a); };
+    static __forceinline int   Cvttps_Epi32(float a)            { return (int) a; };
+    static __forceinline float Min(float a,float b)             { return b < a ? b : a; };      // Same operand order as minps (returns b on NaN)
+    static __forceinline float Max(float a,float b)             { return b > a ? b : a; };
+    static __forceinline float Sin(float a)                     { return std::sin(a); };
+    static __forceinline float Cos(float a)                     { return std::cos(a); };
+    static __forceinline float SinPoly(float a)                 { return SimdSinCos<SimdScalar>(a,false); };
+    static __forceinline float CosPoly(float a)                 { return SimdSinCos<SimdScalar>(a,true); };
+
+    static __forceinline int   Vecii(int iValue)                { return iValue; }
+    static __forceinline int   Veci(int iValue)                 { return iValue; }
+    static __forceinline float Vecf(float fValue)               { return fValue; }
+    static __forceinline float Load(const float * fAddr)        { return *fAddr; };
+    static __forceinline void  Store(float * fAddr,float fValue) { *fAddr = fValue; };
+    static __forceinline float LoadU(const float * fAddr)       { return *fAddr; };
+    static __forceinline void  StoreU(float * fAddr,float fValue) { *fAddr = fValue; };
+    static __forceinline float Load1(float * fAddr)             { return *fAddr; };
+
+    static __forceinline float CvtFloat(int a)                  { return (float) a; }
+    static __forceinline int   CvttInt(float a)                 { return (int) a; }
+    static __forceinline int   Pack32us(int a)                  { return a < 0 ? 0 : a > 65535 ? 65535 : a; }
+    static __forceinline int   Pack16us(int a)                  { return a < 0 ? 0 : a > 255 ? 255 : a; }
+    static __forceinline int   Cvtu8Intf(int a)                 { return a & 0xFF; }
+
+    static __forceinline int   LoadU8Int(const unsigned char * sAddr)   { return *sAddr; }
+    static __forceinline void  StoreU8Int(unsigned char * sAddr,int a)  { *sAddr = (unsigned char) Pack16us(a); }
+};
@@ -1,6 +1,11 @@
 #pragma once
 
 #include "Sagebox.h"
+#include "CDisplayList.h"
+#include "CWindowAttach.h"
+#include <memory>
+#include <mutex>
+#include <unordered_map>
 
 namespace Sage
 {
@@ -92,6 +97,114 @@ private:
     bool AddDrawTrackLine(const CfPointf & p1,const CfPointf & p2);
     bool AddDrawTrackEllipse(const CfPointf & p,int iRadiusX,int iRadiusY,int iSweepAngle,float fStartAngle);
 
+    // Display list for redraw() -- kept outside of TurtleShell (which is built into the library, so it can't hold it or free
+    // it in its destructor).  Each turtle's list is in its own slot in a table attached to the window, and is deleted with
+    // the window or by free_redraw().  The list is filled from m_drawTrack, adding the strokes drawn since the last redraw().
+    //
+    // Since the slot is found by the turtle's address, a slot left by a deleted turtle can be found by a new turtle at the
+    // same address.  The slot records the track it was filled from (its address, and the first and last strokes in the list),
+    // and starts over when the turtle's track doesn't match.
+
+    using DrawTrackList = CDisplayList<DrawTrack>;
+
+    struct TrackList_t
+    {
+        DrawTrackList cList;
+        const DrawTrack * pTrack = nullptr;         // m_drawTrack the list was filled from
+        int iSynced = 0;                            // Strokes of m_drawTrack in the list
+        DrawTrack stFirst{};                        // Copies of the first and last strokes in the list (when iSynced > 0)
+        DrawTrack stLast{};
+    };
+
+    struct TrackLists_t
+    {
+        std::mutex mLock;
+        std::unordered_map<const TurtleShell *,std::unique_ptr<TrackList_t>> mLists;
+    };
+
+    TrackList_t & GetTrackList()
+    {
+        auto & stLists = CWindowAttach<TrackLists_t>::Get(m_cWin);
+        std::lock_guard<std::mutex> lock(stLists.mLock);
+        auto & pList = stLists.mLists[this];
+        if (!pList) pList = std::make_unique<TrackList_t>();
+        return *pList;
+    }
+
+    static bool SameTrack(const DrawTrack & stEntry1,const DrawTrack & stEntry2)
+    {
+        return stEntry1.drawType == stEntry2.drawType && stEntry1.fPenSize == stEntry2.fPenSize &&
+               stEntry1.p1.x == stEntry2.p1.x && stEntry1.p1.y == stEntry2.p1.y && stEntry1.p2.x == stEntry2.p2.x && stEntry1.p2.y == stEntry2.p2.y;
+    }
+
+    DrawTrackList & SyncTrackList()
+    {
+        auto & stTrack = GetTrackList();
+        int iCount = m_drawTrack ? (std::min)(m_iDrawTrackCount,kMaxDrawTrackSize) : 0;
+        if (stTrack.pTrack != m_drawTrack || iCount < stTrack.iSynced ||
+            (stTrack.iSynced && (!SameTrack(stTrack.stFirst,m_drawTrack[0]) || !SameTrack(stTrack.stLast,m_drawTrack[stTrack.iSynced-1]))))
+        {
+            stTrack.cList.Clear();
+            stTrack.pTrack  = m_drawTrack;
+            stTrack.iSynced = 0;
+        }
+        for (;stTrack.iSynced < iCount;stTrack.iSynced++) stTrack.cList.Add(m_drawTrack[stTrack.iSynced],GetTrackBounds(m_drawTrack[stTrack.iSynced]));
+        if (iCount)
+        {
+            stTrack.stFirst = m_drawTrack[0];
+            stTrack.stLast  = m_drawTrack[iCount-1];
+        }
+        return stTrack.cList;
+    }
+
+    // Bounding box of a stroke, with room for the pen and anti-aliasing
+
+    static DrawTrackList::Bounds_t GetTrackBounds(const DrawTrack & stEntry)
+    {
+        float fPad = stEntry.fPenSize + 1.0f;
+        float fRX = stEntry.drawType == DrawType::Ellipse ? (float) stEntry.iRadiusX : 0.0f;
+        float fRY = stEntry.drawType == DrawType::Ellipse ? (float) stEntry.iRadiusY : 0.0f;
+        auto & p1 = stEntry.p1;
+        auto & p2 = stEntry.drawType == DrawType::Ellipse ? stEntry.p1 : stEntry.p2;
+        return { (std::min)(p1.x,p2.x) - fRX - fPad,(std::min)(p1.y,p2.y) - fRY - fPad,(std::max)(p1.x,p2.x) + fRX + fPad,(std::max)(p1.y,p2.y) + fRY + fPad };
+    }
+
+    // Draws one stroke (onto the window, or onto a tile -- CBitmap memory is BGR, the same as GDI+ 24-bit bitmaps)
+
+    void DrawTrackEntry(Gdiplus::Graphics & cGdi,const DrawTrack & stEntry)
+    {
+        auto & rgb = stEntry.rgbColor;
+        Gdiplus::Pen cPen(Gdiplus::Color((byte) rgb.iAlpha,(byte) rgb.iRed,(byte) rgb.iGreen,(byte) rgb.iBlue),(real) stEntry.fPenSize);
+        cPen.SetLineCap(Gdiplus::LineCapRound,Gdiplus::LineCapRound,Gdiplus::DashCapRound);
+
+        if (stEntry.drawType == DrawType::Line) cGdi.DrawLine(&cPen,(real) stEntry.p1.x,(real) stEntry.p1.y,(real) stEntry.p2.x,(real) stEntry.p2.y);
+        else cGdi.DrawArc(&cPen,(real) (stEntry.p1.x - stEntry.iRadiusX),(real) (stEntry.p1.y - stEntry.iRadiusY),(real) stEntry.iRadiusX*2,
+                          (real) stEntry.iRadiusY*2,(real) stEntry.fStartAngle,(real) stEntry.iSweepAngle);
+    }
+
+    // Tile cache functions (see set_tile_cache())
+
+    void InitTrackTile(CBitmap & cTile)
+    {
+        RgbColor rgbBg = m_cWin.GetBgColor();
+        auto & stBitmap = cTile.stBitmap;
+        for (int y=0;y<stBitmap.iHeight;y++)
+        {
+            unsigned char * sOut = stBitmap.stMem + y*stBitmap.iWidthBytes;
+            for (int x=0;x<stBitmap.iWidth;x++,sOut += 3) sOut[0] = (byte) rgbBg.iBlue, sOut[1] = (byte) rgbBg.iGreen, sOut[2] = (byte) rgbBg.iRed;
+        }
+    }
+
+    void RenderTrackTile(CBitmap & cTile,int iTileX,int iTileY,const std::vector<const DrawTrack *> & vEntries)
+    {
+        auto & stBitmap = cTile.stBitmap;
+        Gdiplus::Bitmap cBitmap(stBitmap.iWidth,stBitmap.iHeight,stBitmap.iWidthBytes,PixelFormat24bppRGB,stBitmap.stMem);
+        Gdiplus::Graphics cGdi(&cBitmap);
+        cGdi.SetSmoothingMode(Gdiplus::SmoothingModeAntiAlias);
+        cGdi.TranslateTransform((real) -iTileX,(real) -iTileY);
+        for (auto * pEntry : vEntries) DrawTrackEntry(cGdi,*pEntry);
+    }
+
 public:
     TurtleShell(CWindow & cWin);
     ~TurtleShell();
@@ -318,6 +431,82 @@ public:
     /// </summary>
     /// <returns> - Current position.</returns>
     CfPointf get_pos();
+
+    /// <summary>
+    /// Redraws the strokes drawn so far that touch the given area of the window (or the whole window when no area is given), e.g. after
+    /// the window has been cleared or drawn over.  Strokes outside of the area are skipped without drawing, and nothing is drawn outside of the area.
+    /// <para></para>
+    /// When the tile cache is enabled (see set_tile_cache()), completed parts of the drawing are copied from the cached tiles, and only the most recent strokes are drawn.
+    /// <para></para>
+    /// The window is not updated -- use the window's Update() function (or wait for the next automatic update) to show the result.
+    /// <para></para>
+    /// --> Only the first 1M strokes (the size of the turtle's stroke record) can be redrawn.  See get_stroke_count().
+    /// </summary>
+    /// <returns> - Number of strokes and tiles drawn</returns>
+    int redraw(int iX,int iY,int iWidth,int iHeight)
+    {
+        if (iWidth <= 0 || iHeight <= 0) return 0;
+        auto & cList = SyncTrackList();
+        auto & cGdi = m_cWin.GetGdiGraphics();
+        cGdi.SetClip(Gdiplus::Rect(iX,iY,iWidth,iHeight));
+
+        size_t iDrawn = cList.ReplayTiled(DrawTrackList::Bounds_t::FromRect(iX,iY,iWidth,iHeight),
+                                    [&](CBitmap & cTile,int iDestX,int iDestY,int iSrcX,int iSrcY,int iCopyWidth,int iCopyHeight)
+                                    { m_cWin.DisplayBitmapEx(cTile,{ iDestX,iDestY },{ iSrcX,iSrcY },{ iCopyWidth,iCopyHeight }); },
+                                    [&](const DrawTrack & stEntry) { DrawTrackEntry(cGdi,stEntry); });
+
+        cGdi.ResetClip();
+        return (int) iDrawn;
+    }
+
+    /// <summary>
+    /// Redraws all strokes drawn so far.  See redraw(iX,iY,iWidth,iHeight) for more information.
+    /// </summary>
+    int redraw() { auto szSize = m_cWin.GetCanvasSize(); return redraw(0,0,szSize.cx,szSize.cy); }
+
+    /// <summary>
+    /// Caches completed parts of the drawing as bitmap tiles, so redraw() copies them instead of drawing every stroke again.
+    /// <para></para>
+    /// Strokes are cached in groups of 4096, so the time to redraw stays about the same as drawings (i.e. fractals, L-systems) grow.
+    /// Tiles start with the window's background color.
+    /// <para></para>
+    /// set_tile_cache(false) turns off the cache and frees the tiles.
+    /// </summary>
+    void set_tile_cache(bool bEnable = true)
+    {
+        auto & cList = SyncTrackList();
+        if (!bEnable) { cList.DisableTileCache(); return; }
+        auto szSize = m_cWin.GetCanvasSize();
+        cList.EnableTileCache(szSize.cx,szSize.cy,
+                              [this](CBitmap & cTile,int iTileX,int iTileY,const std::vector<const DrawTrack *> & vEntries) { RenderTrackTile(cTile,iTileX,iTileY,vEntries); },
+                              [this](CBitmap & cTile,int,int) { InitTrackTile(cTile); });
+    }
+
+    /// <summary>
+    /// Returns the number of strokes (lines, circles and arcs) drawn so far that redraw() can draw.
+    /// <para></para>
+    /// --> The turtle records up to 1M (1024*1024) strokes, so this stops at 1M.  Strokes drawn after that are not recorded or redrawn.
+    /// </summary>
+    int get_stroke_count() { return m_drawTrack ? (std::min)(m_iDrawTrackCount,kMaxDrawTrackSize) : 0; }
+
+    /// <summary>
+    /// Frees the redraw() display list and tile cache for this turtle.  They are built again on the next redraw().
+    /// <para></para>
+    /// --> These are otherwise kept until the window is closed.  Call free_redraw() before deleting a turtle whose window stays open.
+    /// </summary>
+    void free_redraw()
+    {
+        auto pLists = CWindowAttach<TrackLists_t>::Find(&m_cWin);
+        if (!pLists) return;
+        std::unique_ptr<TrackList_t> pList;
+        {
+            std::lock_guard<std::mutex> lock(pLists->mLock);
+            auto it = pLists->mLists.find(this);
+            if (it == pLists->mLists.end()) return;
+            pList = std::move(it->second);
+            pLists->mLists.erase(it);
+        }
+    }
  
 }; // class TurtleShell
 